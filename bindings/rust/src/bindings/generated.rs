@@ -63,6 +63,25 @@ pub enum C_KZG_RET {
     #[doc = "< Could not allocate memory."]
     C_KZG_MALLOC = 3,
 }
+#[doc = " A reusable scratch arena for the temporaries of one call at a time.\n\n While a `_ctx` function runs, c_kzg_malloc() and c_kzg_calloc() take memory from the context\n rather than the heap, and c_kzg_free() hands it back. When something does not fit, it comes from\n the heap instead, and the arena is grown to fit before the next call. So after a call or two,\n calls make no heap allocations at all.\n\n A context must only be used by one thread at a time. Create one per thread with\n init_kzg_context() and release it with free_kzg_context()."]
+#[repr(C)]
+#[derive(Debug, Copy, Clone, Hash, PartialEq, Eq)]
+pub struct KZGContext {
+    #[doc = " The heap block backing the arena."]
+    buffer: *mut ::std::os::raw::c_void,
+    #[doc = " The start of the arena, aligned to a cache line."]
+    base: *mut u8,
+    #[doc = " The number of bytes available from the start of the arena."]
+    capacity: usize,
+    #[doc = " The number of bytes in use from the start of the arena."]
+    used: usize,
+    #[doc = " The offset of the most recent block in the arena."]
+    top: usize,
+    #[doc = " The number of bytes taken from the heap during this call, since they did not fit."]
+    overflow: usize,
+    #[doc = " The most bytes that a call has needed, which the arena is grown to."]
+    peak: usize,
+}
 #[doc = " An array of 32 bytes. Represents an untrusted (potentially invalid) field element."]
 #[repr(C)]
 #[derive(Debug, Copy, Clone, Hash, PartialEq, Eq)]
@@ -81,16 +100,63 @@ pub struct Bytes48 {
 pub struct Blob {
     bytes: [u8; 131072usize],
 }
+#[doc = " The choices made when computing multi-scalar multiplications.\n\n The best choices depend on the machine, see autotune_msm_strategy(). This is a plain structure so\n that a strategy can be saved and later restored with set_msm_strategy()."]
+#[repr(C)]
+#[derive(Debug, Copy, Clone, Hash, PartialEq, Eq)]
+pub struct MSMStrategy {
+    #[doc = " MSMs with fewer points than this are computed naively instead of with Pippenger."]
+    naive_threshold: u64,
+    #[doc = " The window size for the FK20 fixed-base MSM tables, or zero to use Pippenger instead."]
+    wbits: u64,
+}
+#[doc = " The precomputed tables for the FK20 fixed-base MSMs, one per circulant row."]
+#[repr(C)]
+#[derive(Debug, Copy, Clone, Hash, PartialEq, Eq)]
+pub struct FK20Tables {
+    #[doc = " The table for each row, NULL for rows which use Pippenger instead."]
+    tables: *mut *mut blst_p1_affine,
+    #[doc = " The window size of each row's table, zero for rows without a table."]
+    wbits: *mut usize,
+    #[doc = " The memory holding every row's table, NULL if the tables are in a shared mapping."]
+    block: *mut ::std::os::raw::c_void,
+    #[doc = " The number of bytes in the block."]
+    block_size: usize,
+    #[doc = " The size of the block's mapping, zero if it is from the heap."]
+    mapped_size: usize,
+    #[doc = " The number of NUMA nodes with their own copy of the block, zero if there are no copies."]
+    num_nodes: usize,
+    #[doc = " The copy of the block for each node, the first is the block itself."]
+    node_blocks: *mut *mut ::std::os::raw::c_void,
+    #[doc = " The size of each copy's mapping, zero if it is from the heap."]
+    node_mapped_sizes: *mut usize,
+}
+#[doc = " What lets the FK20 tables be replaced while other threads compute proofs, see setup/prover.c.\n\n Each call which reads the tables counts itself as a reader of the current epoch, and the thread\n which replaces the tables starts a new epoch, then waits for the readers of the old one before\n freeing the old tables."]
+#[repr(C)]
+#[derive(Debug, Copy, Clone, Hash, PartialEq, Eq)]
+pub struct TableEpochs {
+    #[doc = " The epoch, incremented each time the tables are replaced."]
+    epoch: u64,
+    #[doc = " The number of calls reading the tables which started in an even and in an odd epoch."]
+    readers: [u64; 2usize],
+    #[doc = " One while a thread is replacing the tables, so that only one does at a time."]
+    writer: u64,
+}
+#[doc = " What a verification profile keeps to load the rest of the setup, see setup/prover.c."]
+#[repr(C)]
+#[derive(Debug, Copy, Clone)]
+pub struct LazyProver {
+    _unused: [u8; 0],
+}
 #[doc = " Stores the setup and parameters needed for computing KZG proofs."]
 #[repr(C)]
 #[derive(Debug, Hash, PartialEq, Eq)]
 pub struct KZGSettings {
-    #[doc = " Roots of unity for the subgroup of size `FIELD_ELEMENTS_PER_EXT_BLOB`.\n\n The array contains `FIELD_ELEMENTS_PER_EXT_BLOB + 1` elements.\n The array starts and ends with Fr::one()."]
-    roots_of_unity: *mut fr_t,
+    #[doc = " Roots of unity for the subgroup of size `FIELD_ELEMENTS_PER_EXT_BLOB`.\n\n The array contains `FIELD_ELEMENTS_PER_EXT_BLOB + 1` elements.\n The array starts and ends with Fr::one().\n It is compiled in, like the other two arrays of roots, and is shared by every setup."]
+    roots_of_unity: *const fr_t,
     #[doc = " Roots of unity for the subgroup of size `FIELD_ELEMENTS_PER_EXT_BLOB` in bit-reversed order.\n\n This array is derived by applying a bit-reversal permutation to `roots_of_unity`\n excluding the last element. Essentially:\n   `brp_roots_of_unity = bit_reversal_permutation(roots_of_unity[:-1])`\n\n The array contains `FIELD_ELEMENTS_PER_EXT_BLOB` elements."]
-    brp_roots_of_unity: *mut fr_t,
+    brp_roots_of_unity: *const fr_t,
     #[doc = " Roots of unity for the subgroup of size `FIELD_ELEMENTS_PER_EXT_BLOB` in reversed order.\n\n It is the reversed version of `roots_of_unity`. Essentially:\n    `reverse_roots_of_unity = reverse(roots_of_unity)`\n\n This array is primarily used in FFTs.\n The array contains `FIELD_ELEMENTS_PER_EXT_BLOB + 1` elements.\n The array starts and ends with Fr::one()."]
-    reverse_roots_of_unity: *mut fr_t,
+    reverse_roots_of_unity: *const fr_t,
     #[doc = " G1 group elements from the trusted setup in monomial form.\n The array contains `NUM_G1_POINTS = FIELD_ELEMENTS_PER_BLOB` elements."]
     g1_values_monomial: *mut g1_t,
     #[doc = " G1 group elements from the trusted setup in Lagrange form and bit-reversed order.\n The array contains `NUM_G1_POINTS = FIELD_ELEMENTS_PER_BLOB` elements."]
@@ -99,12 +165,34 @@ pub struct KZGSettings {
     g2_values_monomial: *mut g2_t,
     #[doc = " Data used during FK20 proof generation."]
     x_ext_fft_columns: *mut *mut g1_t,
-    #[doc = " The precomputed tables for fixed-base MSM."]
-    tables: *mut *mut blst_p1_affine,
-    #[doc = " The window size for the fixed-base MSM."]
+    #[doc = " The single allocation which holds all of the arrays above."]
+    slab: *mut ::std::os::raw::c_void,
+    #[doc = " The rest of the setup for a verification profile, NULL for the full profile."]
+    lazy: *mut LazyProver,
+    #[doc = " The shared file the arrays are in when attached with attach_shared_settings(), or NULL."]
+    mapping: *mut ::std::os::raw::c_void,
+    #[doc = " The size of the mapping, zero if it was read into the heap instead."]
+    mapping_size: usize,
+    #[doc = " The precomputed tables for fixed-base MSM, NULL if there are none."]
+    tables: *mut FK20Tables,
+    #[doc = " What synchronizes replacing the tables with reading them, NULL without FK20 columns."]
+    table_epochs: *mut TableEpochs,
+    #[doc = " Where the tables are placed in memory, a combination of the KZG_TABLES_* flags."]
+    table_placement: u64,
+    #[doc = " The window size for the fixed-base MSM, the largest one if rows use different sizes."]
     wbits: usize,
     #[doc = " The scratch size for the fixed-base MSM."]
     scratch_size: usize,
+    #[doc = " MSMs with fewer points than this are computed naively instead of with Pippenger."]
+    naive_threshold: usize,
+    #[doc = " A hash of the trusted setup's compressed points, see load_precomputed_settings()."]
+    setup_hash: Bytes32,
+}
+#[doc = " A blob parsed once so that several calls can share the work, see eip4844/polynomial.h."]
+#[repr(C)]
+#[derive(Debug, Copy, Clone)]
+pub struct KZGPolynomial {
+    _unused: [u8; 0],
 }
 #[doc = " A single cell for a blob."]
 #[repr(C)]
@@ -112,12 +200,27 @@ pub struct KZGSettings {
 pub struct Cell {
     bytes: [u8; 2048usize],
 }
+#[doc = " Cell proofs to verify together later, see new_cell_proof_accumulator()."]
+#[repr(C)]
+#[derive(Debug, Copy, Clone)]
+pub struct CellProofAccumulator {
+    _unused: [u8; 0],
+}
 unsafe extern "C" {
     pub fn blob_to_kzg_commitment(
         out: *mut KZGCommitment,
         blob: *const Blob,
         s: *const KZGSettings,
     ) -> C_KZG_RET;
+    pub fn update_kzg_commitment(
+        out: *mut KZGCommitment,
+        commitment_bytes: *const Bytes48,
+        indices: *const u64,
+        old_fields: *const Bytes32,
+        new_fields: *const Bytes32,
+        n: u64,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
     pub fn compute_kzg_proof(
         proof_out: *mut KZGProof,
         y_out: *mut Bytes32,
@@ -125,6 +228,14 @@ unsafe extern "C" {
         z_bytes: *const Bytes32,
         s: *const KZGSettings,
     ) -> C_KZG_RET;
+    pub fn compute_kzg_proofs_multi(
+        proofs_out: *mut KZGProof,
+        ys_out: *mut Bytes32,
+        blob: *const Blob,
+        zs_bytes: *const Bytes32,
+        n: u64,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
     pub fn compute_blob_kzg_proof(
         out: *mut KZGProof,
         blob: *const Blob,
@@ -154,12 +265,176 @@ unsafe extern "C" {
         n: u64,
         s: *const KZGSettings,
     ) -> C_KZG_RET;
+    pub fn verify_blob_kzg_proof_batch_locate(
+        ok: *mut bool,
+        invalid_out: *mut u64,
+        num_invalid_out: *mut u64,
+        blobs: *const Blob,
+        commitments_bytes: *const Bytes48,
+        proofs_bytes: *const Bytes48,
+        n: u64,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn blob_to_kzg_commitment_ctx(
+        ctx: *mut KZGContext,
+        out: *mut KZGCommitment,
+        blob: *const Blob,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn update_kzg_commitment_ctx(
+        ctx: *mut KZGContext,
+        out: *mut KZGCommitment,
+        commitment_bytes: *const Bytes48,
+        indices: *const u64,
+        old_fields: *const Bytes32,
+        new_fields: *const Bytes32,
+        n: u64,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn compute_kzg_proof_ctx(
+        ctx: *mut KZGContext,
+        proof_out: *mut KZGProof,
+        y_out: *mut Bytes32,
+        blob: *const Blob,
+        z_bytes: *const Bytes32,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn compute_kzg_proofs_multi_ctx(
+        ctx: *mut KZGContext,
+        proofs_out: *mut KZGProof,
+        ys_out: *mut Bytes32,
+        blob: *const Blob,
+        zs_bytes: *const Bytes32,
+        n: u64,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn compute_blob_kzg_proof_ctx(
+        ctx: *mut KZGContext,
+        out: *mut KZGProof,
+        blob: *const Blob,
+        commitment_bytes: *const Bytes48,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn verify_kzg_proof_ctx(
+        ctx: *mut KZGContext,
+        ok: *mut bool,
+        commitment_bytes: *const Bytes48,
+        z_bytes: *const Bytes32,
+        y_bytes: *const Bytes32,
+        proof_bytes: *const Bytes48,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn verify_blob_kzg_proof_ctx(
+        ctx: *mut KZGContext,
+        ok: *mut bool,
+        blob: *const Blob,
+        commitment_bytes: *const Bytes48,
+        proof_bytes: *const Bytes48,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn verify_blob_kzg_proof_batch_ctx(
+        ctx: *mut KZGContext,
+        ok: *mut bool,
+        blobs: *const Blob,
+        commitments_bytes: *const Bytes48,
+        proofs_bytes: *const Bytes48,
+        n: u64,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn verify_blob_kzg_proof_batch_locate_ctx(
+        ctx: *mut KZGContext,
+        ok: *mut bool,
+        invalid_out: *mut u64,
+        num_invalid_out: *mut u64,
+        blobs: *const Blob,
+        commitments_bytes: *const Bytes48,
+        proofs_bytes: *const Bytes48,
+        n: u64,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn new_kzg_polynomial(out: *mut *mut KZGPolynomial, blob: *const Blob) -> C_KZG_RET;
+    pub fn free_kzg_polynomial(poly: *mut *mut KZGPolynomial);
+    pub fn blob_to_kzg_commitment_poly(
+        out: *mut KZGCommitment,
+        poly: *const KZGPolynomial,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn compute_kzg_proof_poly(
+        proof_out: *mut KZGProof,
+        y_out: *mut Bytes32,
+        poly: *const KZGPolynomial,
+        z_bytes: *const Bytes32,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn compute_blob_kzg_proof_poly(
+        out: *mut KZGProof,
+        poly: *const KZGPolynomial,
+        commitment_bytes: *const Bytes48,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn compute_kzg_proofs_multi_poly(
+        proofs_out: *mut KZGProof,
+        ys_out: *mut Bytes32,
+        poly: *const KZGPolynomial,
+        zs_bytes: *const Bytes32,
+        n: u64,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
     pub fn compute_cells_and_kzg_proofs(
         cells: *mut Cell,
         proofs: *mut KZGProof,
         blob: *const Blob,
         s: *const KZGSettings,
     ) -> C_KZG_RET;
+    pub fn compute_cells_and_kzg_proofs_batch(
+        cells: *mut Cell,
+        proofs: *mut KZGProof,
+        blobs: *const Blob,
+        num_blobs: u64,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn compute_cells_and_kzg_proofs_poly(
+        cells: *mut Cell,
+        proofs: *mut KZGProof,
+        poly: *mut KZGPolynomial,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn compute_blob_sidecar(
+        commitment_out: *mut KZGCommitment,
+        proof_out: *mut KZGProof,
+        cells: *mut Cell,
+        proofs: *mut KZGProof,
+        blob: *const Blob,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn compute_cells_for_indices(
+        cells: *mut Cell,
+        blob: *const Blob,
+        cell_indices: *const u64,
+        num_cells: u64,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn compute_cells_for_indices_poly(
+        cells: *mut Cell,
+        poly: *mut KZGPolynomial,
+        cell_indices: *const u64,
+        num_cells: u64,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn compute_cell_kzg_proofs_for_indices(
+        proofs: *mut KZGProof,
+        blob: *const Blob,
+        cell_indices: *const u64,
+        num_cells: u64,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn compute_cell_kzg_proofs_for_indices_poly(
+        proofs: *mut KZGProof,
+        poly: *mut KZGPolynomial,
+        cell_indices: *const u64,
+        num_cells: u64,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
     pub fn recover_cells_and_kzg_proofs(
         recovered_cells: *mut Cell,
         recovered_proofs: *mut KZGProof,
@@ -177,6 +452,128 @@ unsafe extern "C" {
         num_cells: u64,
         s: *const KZGSettings,
     ) -> C_KZG_RET;
+    pub fn verify_cell_kzg_proof_batch_locate(
+        ok: *mut bool,
+        invalid_out: *mut u64,
+        num_invalid_out: *mut u64,
+        commitments_bytes: *const Bytes48,
+        cell_indices: *const u64,
+        cells: *const Cell,
+        proofs_bytes: *const Bytes48,
+        num_cells: u64,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn verify_cell_kzg_proof_batch_unique(
+        ok: *mut bool,
+        commitments_bytes: *const Bytes48,
+        num_commitments: u64,
+        commitment_indices: *const u64,
+        cell_indices: *const u64,
+        cells: *const Cell,
+        proofs_bytes: *const Bytes48,
+        num_cells: u64,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn new_cell_proof_accumulator(
+        out: *mut *mut CellProofAccumulator,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn free_cell_proof_accumulator(acc: *mut *mut CellProofAccumulator);
+    pub fn add_to_cell_proof_accumulator(
+        acc: *mut CellProofAccumulator,
+        commitments_bytes: *const Bytes48,
+        cell_indices: *const u64,
+        cells: *const Cell,
+        proofs_bytes: *const Bytes48,
+        num_cells: u64,
+    ) -> C_KZG_RET;
+    pub fn finalize_cell_proof_accumulator(
+        ok: *mut bool,
+        acc: *const CellProofAccumulator,
+    ) -> C_KZG_RET;
+    pub fn compute_cells_and_kzg_proofs_ctx(
+        ctx: *mut KZGContext,
+        cells: *mut Cell,
+        proofs: *mut KZGProof,
+        blob: *const Blob,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn compute_cells_and_kzg_proofs_batch_ctx(
+        ctx: *mut KZGContext,
+        cells: *mut Cell,
+        proofs: *mut KZGProof,
+        blobs: *const Blob,
+        num_blobs: u64,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn compute_blob_sidecar_ctx(
+        ctx: *mut KZGContext,
+        commitment_out: *mut KZGCommitment,
+        proof_out: *mut KZGProof,
+        cells: *mut Cell,
+        proofs: *mut KZGProof,
+        blob: *const Blob,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn compute_cells_for_indices_ctx(
+        ctx: *mut KZGContext,
+        cells: *mut Cell,
+        blob: *const Blob,
+        cell_indices: *const u64,
+        num_cells: u64,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn compute_cell_kzg_proofs_for_indices_ctx(
+        ctx: *mut KZGContext,
+        proofs: *mut KZGProof,
+        blob: *const Blob,
+        cell_indices: *const u64,
+        num_cells: u64,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn recover_cells_and_kzg_proofs_ctx(
+        ctx: *mut KZGContext,
+        recovered_cells: *mut Cell,
+        recovered_proofs: *mut KZGProof,
+        cell_indices: *const u64,
+        cells: *const Cell,
+        num_cells: u64,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn verify_cell_kzg_proof_batch_ctx(
+        ctx: *mut KZGContext,
+        ok: *mut bool,
+        commitments_bytes: *const Bytes48,
+        cell_indices: *const u64,
+        cells: *const Cell,
+        proofs_bytes: *const Bytes48,
+        num_cells: u64,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn verify_cell_kzg_proof_batch_locate_ctx(
+        ctx: *mut KZGContext,
+        ok: *mut bool,
+        invalid_out: *mut u64,
+        num_invalid_out: *mut u64,
+        commitments_bytes: *const Bytes48,
+        cell_indices: *const u64,
+        cells: *const Cell,
+        proofs_bytes: *const Bytes48,
+        num_cells: u64,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn verify_cell_kzg_proof_batch_unique_ctx(
+        ctx: *mut KZGContext,
+        ok: *mut bool,
+        commitments_bytes: *const Bytes48,
+        num_commitments: u64,
+        commitment_indices: *const u64,
+        cell_indices: *const u64,
+        cells: *const Cell,
+        proofs_bytes: *const Bytes48,
+        num_cells: u64,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
     pub fn load_trusted_setup(
         out: *mut KZGSettings,
         g1_monomial_bytes: *const u8,
@@ -187,10 +584,50 @@ unsafe extern "C" {
         num_g2_monomial_bytes: u64,
         precompute: u64,
     ) -> C_KZG_RET;
+    pub fn load_trusted_setup_profile(
+        out: *mut KZGSettings,
+        g1_monomial_bytes: *const u8,
+        num_g1_monomial_bytes: u64,
+        g1_lagrange_bytes: *const u8,
+        num_g1_lagrange_bytes: u64,
+        g2_monomial_bytes: *const u8,
+        num_g2_monomial_bytes: u64,
+        precompute: u64,
+        profile: u64,
+    ) -> C_KZG_RET;
     pub fn load_trusted_setup_file(
         out: *mut KZGSettings,
         in_: *mut FILE,
         precompute: u64,
     ) -> C_KZG_RET;
+    pub fn load_trusted_setup_file_profile(
+        out: *mut KZGSettings,
+        in_: *mut FILE,
+        precompute: u64,
+        profile: u64,
+    ) -> C_KZG_RET;
+    pub fn save_trusted_setup_binary(s: *const KZGSettings, out: *mut FILE) -> C_KZG_RET;
+    pub fn serialize_trusted_setup_uncompressed(
+        out: *mut *mut u8,
+        hash_out: *mut Bytes32,
+        s: *const KZGSettings,
+    ) -> C_KZG_RET;
+    pub fn load_trusted_setup_uncompressed(
+        out: *mut KZGSettings,
+        bytes: *const u8,
+        num_bytes: u64,
+        trusted_hash: *const Bytes32,
+        precompute: u64,
+    ) -> C_KZG_RET;
     pub fn free_trusted_setup(s: *mut KZGSettings);
+    pub fn autotune_msm_strategy(
+        out: *mut MSMStrategy,
+        s: *const KZGSettings,
+        max_wbits: u64,
+    ) -> C_KZG_RET;
+    pub fn get_msm_strategy(out: *mut MSMStrategy, s: *const KZGSettings);
+    pub fn set_msm_strategy(s: *mut KZGSettings, strategy: *const MSMStrategy) -> C_KZG_RET;
+    pub fn set_precompute(s: *mut KZGSettings, precompute: u64) -> C_KZG_RET;
+    pub fn set_precompute_budget(s: *mut KZGSettings, budget: u64) -> C_KZG_RET;
+    pub fn set_table_placement(s: *mut KZGSettings, placement: u64) -> C_KZG_RET;
 }
@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+
+import argparse
+from typing import List, TextIO
+
+# The scalar field modulus of BLS12-381.
+BLS_MODULUS = 52435875175126190479447740508185965837690552500527637822603658699938581184513
+
+# The generator of the multiplicative group of the scalar field.
+PRIMITIVE_ROOT_OF_UNITY = 7
+
+# The number of roots of unity, which is FIELD_ELEMENTS_PER_EXT_BLOB.
+FIELD_ELEMENTS_PER_EXT_BLOB = 8192
+
+# The Montgomery factor of blst's fr_t, which has four 64-bit limbs.
+MONTGOMERY_R = pow(2, 256, BLS_MODULUS)
+
+HEADER = """/*
+ * Copyright 2024 Benjamin Edgington
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * This file is generated by scripts/generate_roots_of_unity.py, run `make roots` to regenerate
+ * it. Do not edit it by hand.
+ */
+
+#include "setup/roots.h"
+
+/* clang-format off */
+"""
+
+FOOTER = """
+/* clang-format on */
+"""
+
+
+def roots_of_unity() -> List[int]:
+    """
+    The roots of unity of order FIELD_ELEMENTS_PER_EXT_BLOB, with one more at the end.
+    """
+    order = FIELD_ELEMENTS_PER_EXT_BLOB.bit_length() - 1
+    root = pow(PRIMITIVE_ROOT_OF_UNITY, (BLS_MODULUS - 1) // (2**order), BLS_MODULUS)
+    roots = [1]
+    for _ in range(FIELD_ELEMENTS_PER_EXT_BLOB):
+        roots.append(roots[-1] * root % BLS_MODULUS)
+    assert roots[-1] == 1 and roots[FIELD_ELEMENTS_PER_EXT_BLOB // 2] != 1
+    return roots
+
+
+def bit_reversal_permutation(values: List[int]) -> List[int]:
+    """
+    Reorder values by the bit-reversal of their indices.
+    """
+    bits = len(values).bit_length() - 1
+    return [values[int(f"{i:0{bits}b}"[::-1], 2)] for i in range(len(values))]
+
+
+def fr_initializer(value: int) -> str:
+    """
+    An fr_t initializer, in Montgomery form with the least significant limb first.
+    """
+    montgomery = value * MONTGOMERY_R % BLS_MODULUS
+    limbs = [(montgomery >> (64 * i)) & 0xFFFFFFFFFFFFFFFF for i in range(4)]
+    return "{{" + ", ".join(f"0x{limb:016x}L" for limb in limbs) + "}}"
+
+
+def write_table(out: TextIO, doc: str, name: str, size: str, values: List[int]) -> None:
+    """
+    Write a table of fr_t values.
+    """
+    print(file=out)
+    print(f"/** {doc} */", file=out)
+    print(f"const fr_t {name}[{size}] = {{", file=out)
+    for value in values:
+        print(f"    {fr_initializer(value)},", file=out)
+    print("};", file=out)
+
+
+def generate(out: TextIO) -> None:
+    """
+    Generate the source file with the roots of unity.
+    """
+    roots = roots_of_unity()
+    out.write(HEADER)
+    write_table(
+        out,
+        "The roots of unity, starting and ending with one.",
+        "ROOTS_OF_UNITY",
+        "FIELD_ELEMENTS_PER_EXT_BLOB + 1",
+        roots,
+    )
+    write_table(
+        out,
+        "The roots of unity without the last one, in bit-reversed order.",
+        "BRP_ROOTS_OF_UNITY",
+        "FIELD_ELEMENTS_PER_EXT_BLOB",
+        bit_reversal_permutation(roots[:-1]),
+    )
+    write_table(
+        out,
+        "The roots of unity in reversed order, starting and ending with one.",
+        "REVERSE_ROOTS_OF_UNITY",
+        "FIELD_ELEMENTS_PER_EXT_BLOB + 1",
+        roots[::-1],
+    )
+    out.write(FOOTER)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        description="Generate the tables of roots of unity as C source.",
+    )
+    parser.add_argument(
+        "--output",
+        required=True,
+        type=argparse.FileType("w"),
+        help="the C source file to write",
+    )
+    args = parser.parse_args()
+
+    try:
+        generate(args.output)
+    finally:
+        args.output.close()
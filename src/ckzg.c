@@ -15,10 +15,12 @@
  */
 
 #include "common/alloc.c"
+#include "common/atomic.c"
 #include "common/bytes.c"
 #include "common/ec.c"
 #include "common/fr.c"
 #include "common/lincomb.c"
+#include "common/pages.c"
 #include "common/utils.c"
 #include "eip4844/blob.c"
 #include "eip4844/eip4844.c"
@@ -28,4 +30,7 @@
 #include "eip7594/fk20.c"
 #include "eip7594/poly.c"
 #include "eip7594/recovery.c"
+#include "setup/prover.c"
+#include "setup/roots.c"
+#include "setup/shared.c"
 #include "setup/setup.c"
@@ -19,3 +19,4 @@
 #include "eip4844/eip4844.h"
 #include "eip7594/eip7594.h"
 #include "setup/setup.h"
+#include "setup/shared.h"
@@ -20,7 +20,162 @@
 
 #include <stdbool.h> /* For bool */
 #include <stddef.h>  /* For size_t & NULL */
+#include <stdint.h>  /* For SIZE_MAX & uintptr_t */
 #include <stdlib.h>  /* For malloc */
+#include <string.h>  /* For memset */
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Macros
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** The alignment of blocks in a context, and the space reserved for each block's header. */
+#define CONTEXT_ALIGNMENT 64
+
+/** Allocations at least this large are given an alignment hint of a cache line. */
+#define LARGE_ALLOCATION 4096
+
+/** The value of KZGContext::top when there are no blocks. */
+#define NO_BLOCK SIZE_MAX
+
+/** Storage class for the context of the current thread. */
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Types
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** The header in front of each block in a context. */
+typedef struct {
+    /** The offset of the previous block, or NO_BLOCK. */
+    size_t prev;
+    /** Non-zero once the block has been released. */
+    size_t released;
+} ContextBlock;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Globals
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** The context that this thread's allocations are taken from, if any. */
+static THREAD_LOCAL KZGContext *active_context = NULL;
+
+/** The allocator for the heap, all NULL to use the C library. */
+static KZGAllocator heap_allocator = {NULL, NULL, NULL, NULL};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Heap Helper Functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Get the alignment hint for an allocation.
+ *
+ * @param[in]   size    The number of bytes to be allocated
+ */
+static size_t alignment_hint(size_t size) {
+    return size >= LARGE_ALLOCATION ? CONTEXT_ALIGNMENT : 0;
+}
+
+/**
+ * Allocate memory from the heap allocator.
+ *
+ * @param[in]   size    The number of bytes to be allocated
+ */
+static void *heap_malloc(size_t size) {
+    if (heap_allocator.malloc_fn == NULL) return malloc(size);
+    return heap_allocator.malloc_fn(heap_allocator.opaque, size, alignment_hint(size));
+}
+
+/**
+ * Allocate zeroed memory from the heap allocator.
+ *
+ * @param[in]   count   The number of elements
+ * @param[in]   size    The size of each element
+ */
+static void *heap_calloc(size_t count, size_t size) {
+    void *p;
+
+    if (heap_allocator.malloc_fn == NULL) return calloc(count, size);
+    if (count > SIZE_MAX / size) return NULL;
+    if (heap_allocator.calloc_fn != NULL) {
+        return heap_allocator.calloc_fn(
+            heap_allocator.opaque, count, size, alignment_hint(count * size)
+        );
+    }
+    p = heap_allocator.malloc_fn(heap_allocator.opaque, count * size, alignment_hint(count * size));
+    if (p != NULL) memset(p, 0, count * size);
+    return p;
+}
+
+/**
+ * Release memory to the heap allocator.
+ *
+ * @param[in]   p   The pointer to the allocated space, may be NULL
+ */
+static void heap_free(void *p) {
+    if (heap_allocator.free_fn == NULL) {
+        free(p);
+    } else if (p != NULL) {
+        heap_allocator.free_fn(heap_allocator.opaque, p);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Context Helper Functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Take a block from the active context.
+ *
+ * @param[in]   ctx     The active context
+ * @param[in]   size    The number of bytes to be allocated
+ *
+ * @return A pointer to the block, or NULL if it does not fit.
+ *
+ * @remark Blocks which do not fit are counted, so that the arena can grow before the next call.
+ */
+static void *context_alloc(KZGContext *ctx, size_t size) {
+    ContextBlock *block;
+    void *ptr = NULL;
+    size_t start = ctx->used, needed;
+
+    /* The size of the block, including its header */
+    if (size > SIZE_MAX / 2) return NULL;
+    needed = CONTEXT_ALIGNMENT + (size + CONTEXT_ALIGNMENT - 1) / CONTEXT_ALIGNMENT *
+                                     CONTEXT_ALIGNMENT;
+
+    if (needed > ctx->capacity - start) {
+        /* Overestimates a little, as these bytes are never given back */
+        ctx->overflow += needed;
+    } else {
+        block = (ContextBlock *)(void *)&ctx->base[start];
+        block->prev = ctx->top;
+        block->released = 0;
+        ctx->top = start;
+        ctx->used = start + needed;
+        ptr = &ctx->base[start + CONTEXT_ALIGNMENT];
+    }
+
+    if (ctx->used + ctx->overflow > ctx->peak) {
+        ctx->peak = ctx->used + ctx->overflow;
+    }
+    return ptr;
+}
+
+/**
+ * Check if a pointer was taken from a context.
+ *
+ * @param[in]   ctx     The context
+ * @param[in]   p       The pointer
+ */
+static bool context_owns(const KZGContext *ctx, const void *p) {
+    uintptr_t start = (uintptr_t)ctx->base;
+    uintptr_t addr = (uintptr_t)p;
+    return ctx->base != NULL && addr >= start && addr < start + ctx->capacity;
+}
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Memory Allocation
@@ -37,7 +192,8 @@
 C_KZG_RET c_kzg_malloc(void **out, size_t size) {
     *out = NULL;
     if (size == 0) return C_KZG_BADARGS;
-    *out = malloc(size);
+    if (active_context != NULL) *out = context_alloc(active_context, size);
+    if (*out == NULL) *out = heap_malloc(size);
     return *out != NULL ? C_KZG_OK : C_KZG_MALLOC;
 }
 
@@ -53,10 +209,65 @@ C_KZG_RET c_kzg_malloc(void **out, size_t size) {
 C_KZG_RET c_kzg_calloc(void **out, size_t count, size_t size) {
     *out = NULL;
     if (count == 0 || size == 0) return C_KZG_BADARGS;
-    *out = calloc(count, size);
+    if (active_context != NULL && count <= SIZE_MAX / size) {
+        *out = context_alloc(active_context, count * size);
+        if (*out != NULL) memset(*out, 0, count * size);
+    }
+    if (*out == NULL) *out = heap_calloc(count, size);
     return *out != NULL ? C_KZG_OK : C_KZG_MALLOC;
 }
 
+/**
+ * Set the allocator that the library takes heap memory from.
+ *
+ * Every heap allocation goes through this allocator, including the trusted setup and its tables,
+ * and the arenas of contexts.
+ *
+ * @param[in]   allocator   The allocator, or NULL to use the C library again
+ *
+ * @remark Will return C_KZG_BADARGS if the allocator has no malloc_fn or free_fn.
+ * @remark The allocator is copied. Only change it while nothing allocated by the library is in use,
+ * as memory is always given back to the allocator in place at the time.
+ */
+C_KZG_RET set_kzg_allocator(const KZGAllocator *allocator) {
+    if (allocator == NULL) {
+        heap_allocator = (KZGAllocator){NULL, NULL, NULL, NULL};
+        return C_KZG_OK;
+    }
+    if (allocator->malloc_fn == NULL || allocator->free_fn == NULL) return C_KZG_BADARGS;
+    heap_allocator = *allocator;
+    return C_KZG_OK;
+}
+
+/**
+ * Release memory from c_kzg_malloc() or c_kzg_calloc().
+ *
+ * @param[in]   p   The pointer to the allocated space, may be NULL
+ *
+ * @remark Use the c_kzg_free() macro rather than calling this directly.
+ * @remark Blocks from a context are reused once every block after them has been released too.
+ */
+void c_kzg_release(void *p) {
+    KZGContext *ctx = active_context;
+    ContextBlock *block;
+
+    if (ctx == NULL || !context_owns(ctx, p)) {
+        heap_free(p);
+        return;
+    }
+
+    block = (ContextBlock *)(void *)((uint8_t *)p - CONTEXT_ALIGNMENT);
+    block->released = 1;
+
+    /* Give back the most recent blocks, as far as they have all been released */
+    while (ctx->top != NO_BLOCK) {
+        block = (ContextBlock *)(void *)&ctx->base[ctx->top];
+        if (!block->released) break;
+        ctx->used = ctx->top;
+        ctx->top = block->prev;
+    }
+}
+
 /**
  * Allocate memory for an array of G1 group elements.
  *
@@ -104,3 +315,134 @@ C_KZG_RET new_fr_array(fr_t **x, size_t n) {
 C_KZG_RET new_bool_array(bool **x, size_t n) {
     return c_kzg_calloc((void **)x, n, sizeof(bool));
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Contexts
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Replace the arena of a context with one of a given size.
+ *
+ * @param[in,out]   ctx     The context, which must not be active
+ * @param[in]       size    The number of bytes the arena should hold
+ */
+static C_KZG_RET context_resize(KZGContext *ctx, size_t size) {
+    void *buffer;
+
+    if (size > SIZE_MAX - CONTEXT_ALIGNMENT) return C_KZG_MALLOC;
+    buffer = heap_malloc(size + CONTEXT_ALIGNMENT);
+    if (buffer == NULL) return C_KZG_MALLOC;
+
+    heap_free(ctx->buffer);
+    ctx->buffer = buffer;
+    ctx->base = (uint8_t *)buffer +
+                (CONTEXT_ALIGNMENT - (uintptr_t)buffer % CONTEXT_ALIGNMENT) % CONTEXT_ALIGNMENT;
+    ctx->capacity = size;
+    return C_KZG_OK;
+}
+
+/**
+ * Create a scratch context.
+ *
+ * @param[out]  ctx     The new context
+ * @param[in]   size    The number of bytes to reserve now, may be zero
+ *
+ * @remark The context grows as needed, so the size only saves the growth in the first calls.
+ * @remark Free the context later using free_kzg_context().
+ */
+C_KZG_RET init_kzg_context(KZGContext *ctx, size_t size) {
+    if (ctx == NULL) return C_KZG_BADARGS;
+
+    ctx->buffer = NULL;
+    ctx->base = NULL;
+    ctx->capacity = 0;
+    ctx->used = 0;
+    ctx->top = NO_BLOCK;
+    ctx->overflow = 0;
+    ctx->peak = size;
+
+    if (size == 0) return C_KZG_OK;
+    return context_resize(ctx, size);
+}
+
+/**
+ * Free a scratch context.
+ *
+ * @param[in]   ctx     The context to free, which must not be active
+ */
+void free_kzg_context(KZGContext *ctx) {
+    if (ctx == NULL) return;
+    heap_free(ctx->buffer);
+    ctx->buffer = NULL;
+    ctx->base = NULL;
+    ctx->capacity = 0;
+    ctx->used = 0;
+    ctx->top = NO_BLOCK;
+    ctx->overflow = 0;
+    ctx->peak = 0;
+}
+
+/**
+ * Make a context the source of this thread's allocations.
+ *
+ * If an earlier call needed more than the arena holds, the arena is grown first. Should that fail,
+ * the arena is left as it was and the call takes what does not fit from the heap.
+ *
+ * @param[in,out]   ctx     The context
+ *
+ * @remark Will return C_KZG_BADARGS if this thread already has an active context.
+ * @remark Every call to this must be matched with a call to leave_kzg_context().
+ */
+C_KZG_RET enter_kzg_context(KZGContext *ctx) {
+    if (ctx == NULL || active_context != NULL) return C_KZG_BADARGS;
+
+    if (ctx->peak > ctx->capacity) {
+        /* Not being able to grow is not an error, it only means using the heap */
+        (void)context_resize(ctx, ctx->peak);
+    }
+
+    ctx->used = 0;
+    ctx->top = NO_BLOCK;
+    ctx->overflow = 0;
+    active_context = ctx;
+    return C_KZG_OK;
+}
+
+/**
+ * Stop taking this thread's allocations from a context.
+ *
+ * @param[in,out]   ctx     The context given to enter_kzg_context()
+ *
+ * @remark Everything taken from the context is given back, so nothing allocated while it was active
+ * may be used afterwards.
+ */
+void leave_kzg_context(KZGContext *ctx) {
+    active_context = NULL;
+    ctx->used = 0;
+    ctx->top = NO_BLOCK;
+    ctx->overflow = 0;
+}
+
+/**
+ * Take this thread's allocations from the heap again while a context is active, for memory which
+ * outlives the call, such as a setup which is loaded once and kept.
+ *
+ * @return The context which was active, or NULL, to give to resume_kzg_context()
+ *
+ * @remark Every call to this must be matched with a call to resume_kzg_context(), and nothing
+ * taken from the context may be freed in between.
+ */
+KZGContext *suspend_kzg_context(void) {
+    KZGContext *ctx = active_context;
+    active_context = NULL;
+    return ctx;
+}
+
+/**
+ * Take this thread's allocations from a context again, after suspend_kzg_context().
+ *
+ * @param[in]   ctx     The context returned by suspend_kzg_context(), which may be NULL
+ */
+void resume_kzg_context(KZGContext *ctx) {
+    active_context = ctx;
+}
@@ -22,7 +22,7 @@
 
 #include <stdbool.h> /* For bool */
 #include <stddef.h>  /* For size_t */
-#include <stdlib.h>  /* For free */
+#include <stdint.h>  /* For uint8_t */
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Macros
@@ -34,10 +34,61 @@
  */
 #define c_kzg_free(p) \
     do { \
-        free(p); \
+        c_kzg_release(p); \
         (p) = NULL; \
     } while (0)
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Types
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A replacement for the C library's heap functions, see set_kzg_allocator().
+ *
+ * The alignment is a hint: zero means no preference, otherwise the library would like memory
+ * aligned to that many bytes. Memory must always be suitably aligned for any type, as with
+ * malloc().
+ * Allocation functions return NULL on failure.
+ */
+typedef struct {
+    /** Allocate size bytes. */
+    void *(*malloc_fn)(void *opaque, size_t size, size_t alignment);
+    /** Allocate count * size zeroed bytes, or NULL to use malloc_fn and clear the memory. */
+    void *(*calloc_fn)(void *opaque, size_t count, size_t size, size_t alignment);
+    /** Release memory from malloc_fn or calloc_fn, never called with NULL. */
+    void (*free_fn)(void *opaque, void *p);
+    /** Passed to each of the functions, for the allocator's own state. */
+    void *opaque;
+} KZGAllocator;
+
+/**
+ * A reusable scratch arena for the temporaries of one call at a time.
+ *
+ * While a `_ctx` function runs, c_kzg_malloc() and c_kzg_calloc() take memory from the context
+ * rather than the heap, and c_kzg_free() hands it back. When something does not fit, it comes from
+ * the heap instead, and the arena is grown to fit before the next call. So after a call or two,
+ * calls make no heap allocations at all.
+ *
+ * A context must only be used by one thread at a time. Create one per thread with
+ * init_kzg_context() and release it with free_kzg_context().
+ */
+typedef struct {
+    /** The heap block backing the arena. */
+    void *buffer;
+    /** The start of the arena, aligned to a cache line. */
+    uint8_t *base;
+    /** The number of bytes available from the start of the arena. */
+    size_t capacity;
+    /** The number of bytes in use from the start of the arena. */
+    size_t used;
+    /** The offset of the most recent block in the arena. */
+    size_t top;
+    /** The number of bytes taken from the heap during this call, since they did not fit. */
+    size_t overflow;
+    /** The most bytes that a call has needed, which the arena is grown to. */
+    size_t peak;
+} KZGContext;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Public Functions
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -46,13 +97,22 @@
 extern "C" {
 #endif
 
+C_KZG_RET set_kzg_allocator(const KZGAllocator *allocator);
 C_KZG_RET c_kzg_malloc(void **out, size_t size);
+void c_kzg_release(void *p);
 C_KZG_RET c_kzg_calloc(void **out, size_t count, size_t size);
 C_KZG_RET new_g1_array(g1_t **x, size_t n);
 C_KZG_RET new_g2_array(g2_t **x, size_t n);
 C_KZG_RET new_fr_array(fr_t **x, size_t n);
 C_KZG_RET new_bool_array(bool **x, size_t n);
 
+C_KZG_RET init_kzg_context(KZGContext *ctx, size_t size);
+void free_kzg_context(KZGContext *ctx);
+C_KZG_RET enter_kzg_context(KZGContext *ctx);
+void leave_kzg_context(KZGContext *ctx);
+KZGContext *suspend_kzg_context(void);
+void resume_kzg_context(KZGContext *ctx);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,179 @@
+/*
+ * Copyright 2024 Benjamin Edgington
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common/atomic.h"
+
+#include <stdbool.h> /* For bool */
+#include <stdint.h>  /* For uint64_t */
+
+#if defined(_MSC_VER)
+#include <intrin.h> /* For _InterlockedCompareExchangePointer */
+#elif !defined(__GNUC__)
+#error "Atomic operations are only implemented for GCC, Clang and MSVC"
+#endif
+
+#if defined(_WIN32)
+#include <windows.h> /* For SwitchToThread */
+#elif defined(__unix__) || defined(__APPLE__)
+#include <sched.h> /* For sched_yield */
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Atomic Pointers
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Load a pointer which another thread may store, with acquire ordering.
+ *
+ * @param[in]   p   The location of the pointer
+ *
+ * @return The pointer. Everything the storing thread wrote before storing it is visible.
+ */
+void *atomic_load_ptr(void *const *p) {
+#if defined(_MSC_VER)
+    /* A compare-exchange which never changes anything is a load with a full barrier */
+    return _InterlockedCompareExchangePointer((void *volatile *)p, NULL, NULL);
+#else
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/**
+ * Store a pointer which other threads may load, with release ordering.
+ *
+ * @param[out]  p       The location of the pointer
+ * @param[in]   value   The pointer to store
+ */
+void atomic_store_ptr(void **p, void *value) {
+#if defined(_MSC_VER)
+    _InterlockedExchangePointer((void *volatile *)p, value);
+#else
+    __atomic_store_n(p, value, __ATOMIC_RELEASE);
+#endif
+}
+
+/**
+ * Store a pointer, if the current pointer is the one expected.
+ *
+ * @param[in,out]   p           The location of the pointer
+ * @param[in]       expected    The pointer which must be there
+ * @param[in]       desired     The pointer to store
+ *
+ * @return True if the pointer was stored.
+ */
+bool atomic_cas_ptr(void **p, void *expected, void *desired) {
+#if defined(_MSC_VER)
+    return _InterlockedCompareExchangePointer((void *volatile *)p, desired, expected) == expected;
+#else
+    return __atomic_compare_exchange_n(
+        p, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE
+    );
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Atomic Counters
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * These are sequentially consistent, unlike the pointer functions, so that a thread can change one
+ * counter and then read another knowing that every thread sees the two in the same order.
+ */
+
+/**
+ * Load a counter which other threads may change.
+ *
+ * @param[in]   p   The location of the counter
+ *
+ * @return The counter.
+ */
+uint64_t atomic_load_u64(const uint64_t *p) {
+#if defined(_MSC_VER)
+    return (uint64_t)_InterlockedCompareExchange64((volatile __int64 *)p, 0, 0);
+#else
+    return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+#endif
+}
+
+/**
+ * Add to a counter which other threads may change.
+ *
+ * @param[in,out]   p       The location of the counter
+ * @param[in]       value   The amount to add
+ *
+ * @return The counter before the addition.
+ */
+uint64_t atomic_add_u64(uint64_t *p, uint64_t value) {
+#if defined(_MSC_VER)
+    return (uint64_t)_InterlockedExchangeAdd64((volatile __int64 *)p, (__int64)value);
+#else
+    return __atomic_fetch_add(p, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+/**
+ * Subtract from a counter which other threads may change.
+ *
+ * @param[in,out]   p       The location of the counter
+ * @param[in]       value   The amount to subtract
+ *
+ * @return The counter before the subtraction.
+ */
+uint64_t atomic_sub_u64(uint64_t *p, uint64_t value) {
+#if defined(_MSC_VER)
+    return (uint64_t)_InterlockedExchangeAdd64((volatile __int64 *)p, -(__int64)value);
+#else
+    return __atomic_fetch_sub(p, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+/**
+ * Store a counter, if the current value is the one expected.
+ *
+ * @param[in,out]   p           The location of the counter
+ * @param[in]       expected    The value which must be there
+ * @param[in]       desired     The value to store
+ *
+ * @return True if the value was stored.
+ */
+bool atomic_cas_u64(uint64_t *p, uint64_t expected, uint64_t desired) {
+#if defined(_MSC_VER)
+    return (uint64_t)_InterlockedCompareExchange64(
+               (volatile __int64 *)p, (__int64)desired, (__int64)expected
+           ) == expected;
+#else
+    return __atomic_compare_exchange_n(
+        p, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST
+    );
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Waiting
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Let other threads run, while waiting for one of them to change something.
+ *
+ * @remark Where there is no way to yield, this returns at once and the caller spins.
+ */
+void yield_thread(void) {
+#if defined(_WIN32)
+    SwitchToThread();
+#elif defined(__unix__) || defined(__APPLE__)
+    sched_yield();
+#endif
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright 2024 Benjamin Edgington
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdbool.h> /* For bool */
+#include <stdint.h>  /* For uint64_t */
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Public Functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void *atomic_load_ptr(void *const *p);
+void atomic_store_ptr(void **p, void *value);
+bool atomic_cas_ptr(void **p, void *expected, void *desired);
+uint64_t atomic_load_u64(const uint64_t *p);
+uint64_t atomic_add_u64(uint64_t *p, uint64_t value);
+uint64_t atomic_sub_u64(uint64_t *p, uint64_t value);
+bool atomic_cas_u64(uint64_t *p, uint64_t expected, uint64_t desired);
+void yield_thread(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -33,6 +33,23 @@ void bytes_from_uint64(uint8_t out[8], uint64_t n) {
     }
 }
 
+/**
+ * Deserialize a 64-bit unsigned integer from bytes.
+ *
+ * @param[in]   in  An 8-byte array holding the serialized integer
+ *
+ * @return The integer.
+ *
+ * @remark The input format is big-endian, as written by bytes_from_uint64().
+ */
+uint64_t bytes_to_uint64(const uint8_t in[8]) {
+    uint64_t n = 0;
+    for (int i = 0; i < 8; i++) {
+        n = n << 8 | in[i];
+    }
+    return n;
+}
+
 /**
  * Serialize a G1 group element into bytes.
  *
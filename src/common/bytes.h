@@ -64,6 +64,7 @@ extern "C" {
 #endif
 
 void bytes_from_uint64(uint8_t out[8], uint64_t n);
+uint64_t bytes_to_uint64(const uint8_t in[8]);
 void bytes_from_g1(Bytes48 *out, const g1_t *in);
 void bytes_from_bls_field(Bytes32 *out, const fr_t *in);
 C_KZG_RET bytes_to_bls_field(fr_t *out, const Bytes32 *b);
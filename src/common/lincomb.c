@@ -18,6 +18,159 @@
 #include "common/alloc.h"
 
 #include <stdlib.h> /* For NULL */
+#include <string.h> /* For memmove */
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Constants
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** Scalars with at most this many bits are multiplied in their own, shorter, MSM. */
+#define SHORT_SCALAR_BITS 64
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helper Functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Get the number of significant bits in a scalar.
+ *
+ * @param[in]   s   The scalar
+ *
+ * @return The position of the highest set bit plus one, or zero if the scalar is zero.
+ */
+static size_t scalar_bit_length(const blst_scalar *s) {
+    for (size_t i = sizeof(s->b); i > 0; i--) {
+        byte b = s->b[i - 1];
+        if (b != 0) {
+            size_t bits = (i - 1) * 8;
+            while (b != 0) {
+                b >>= 1;
+                bits++;
+            }
+            return bits;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Get the length below which MSMs are computed naively.
+ *
+ * @param[in]   s   The trusted setup
+ *
+ * @remark This is at least 2 since blst fails for 0 or 1.
+ */
+static size_t naive_threshold(const KZGSettings *s) {
+    return s->naive_threshold < 2 ? 2 : s->naive_threshold;
+}
+
+/**
+ * Calculate a linear combination of affine G1 points, using at most `nbits` bits of each scalar.
+ *
+ * @param[out]  out         The resulting sum-product
+ * @param[in]   points      Array of pointers to the points, length `len`
+ * @param[in]   scalars     Array of scalars, length `len`, which will be overwritten
+ * @param[in]   len         The number of points/scalars
+ * @param[in]   nbits       The bit length of the largest scalar
+ * @param[in]   threshold   The length below which the naive method is used
+ * @param[in]   scratch     Pippenger scratch space for at least `len` points
+ *
+ * @remark Short inputs are handled naively, since Pippenger only pays off for longer ones.
+ */
+static void g1_lincomb_bits(
+    g1_t *out,
+    const blst_p1_affine **points,
+    blst_scalar *scalars,
+    size_t len,
+    size_t nbits,
+    size_t threshold,
+    limb_t *scratch
+) {
+    if (len < threshold) {
+        g1_t point, tmp;
+        *out = G1_IDENTITY;
+        for (size_t i = 0; i < len; i++) {
+            blst_p1_from_affine(&point, points[i]);
+            blst_p1_mult(&tmp, &point, scalars[i].b, nbits);
+            blst_p1_add_or_double(out, out, &tmp);
+        }
+        return;
+    }
+
+    /* Pack the scalars, blst expects them to be exactly nbytes apart */
+    byte *packed = (byte *)scalars;
+    size_t nbytes = (nbits + 7) / 8;
+    if (nbytes != sizeof(blst_scalar)) {
+        for (size_t i = 0; i < len; i++) {
+            memmove(&packed[i * nbytes], scalars[i].b, nbytes);
+        }
+    }
+
+    const byte *scalars_arg[2] = {packed, NULL};
+    blst_p1s_mult_pippenger(out, points, len, scalars_arg, nbits, scratch);
+}
+
+/**
+ * Calculate a linear combination of affine G1 points, where zero scalars have been removed.
+ *
+ * The inputs are split in two, those with short scalars and those with long scalars, and each part
+ * is multiplied using only as many bits as its largest scalar needs.
+ *
+ * @param[out]  out         The resulting sum-product
+ * @param[in]   points      Array of pointers to the points, length `len`, which will be reordered
+ * @param[in]   scalars     Array of non-zero scalars, length `len`, which will be overwritten
+ * @param[in]   len         The number of points/scalars
+ * @param[in]   threshold   The length below which the naive method is used
+ * @param[in]   scratch     Pippenger scratch space for at least `len` points
+ */
+static void g1_lincomb_compacted(
+    g1_t *out,
+    const blst_p1_affine **points,
+    blst_scalar *scalars,
+    size_t len,
+    size_t threshold,
+    limb_t *scratch
+) {
+    size_t num_short = 0, short_bits = 0, long_bits = 0;
+
+    /* Move the short scalars to the front, keeping the points in step */
+    for (size_t i = 0; i < len; i++) {
+        size_t bits = scalar_bit_length(&scalars[i]);
+        if (bits <= SHORT_SCALAR_BITS) {
+            if (bits > short_bits) short_bits = bits;
+            if (i != num_short) {
+                blst_scalar tmp_scalar = scalars[i];
+                const blst_p1_affine *tmp_point = points[i];
+                scalars[i] = scalars[num_short];
+                points[i] = points[num_short];
+                scalars[num_short] = tmp_scalar;
+                points[num_short] = tmp_point;
+            }
+            num_short++;
+        } else if (bits > long_bits) {
+            long_bits = bits;
+        }
+    }
+
+    /* Splitting only pays off when there are enough short scalars */
+    if (num_short == len || num_short < threshold) {
+        size_t nbits = long_bits > short_bits ? long_bits : short_bits;
+        g1_lincomb_bits(out, points, scalars, len, nbits, threshold, scratch);
+        return;
+    }
+
+    g1_t long_sum;
+    size_t num_long = len - num_short;
+    g1_lincomb_bits(out, points, scalars, num_short, short_bits, threshold, scratch);
+    g1_lincomb_bits(
+        &long_sum, &points[num_short], &scalars[num_short], num_long, long_bits, threshold, scratch
+    );
+    blst_p1_add_or_double(out, out, &long_sum);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Public Functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
 /**
  * Calculate a linear combination of G1 group elements.
@@ -49,6 +202,7 @@ void g1_lincomb_naive(g1_t *out, const g1_t *p, const fr_t *coeffs, size_t len)
  * @param[in]   p       Array of G1 group elements, length `len`
  * @param[in]   coeffs  Array of field elements, length `len`
  * @param[in]   len     The number of group/field elements
+ * @param[in]   s       The trusted setup, which holds the MSM strategy
  *
  * @remark This function CAN be called with the point at infinity in `p`.
  * @remark While this function is significantly faster than g1_lincomb_naive(), we refrain from
@@ -63,53 +217,165 @@ void g1_lincomb_naive(g1_t *out, const g1_t *p, const fr_t *coeffs, size_t len)
  * 2. Pass an array where the first element is a pointer to the contiguous array of points and the
  *    second is null, and similarly for scalars.
  *
- * We do the second of these to save memory here.
+ * We pass the points in the first way, so that they can be reordered without being copied, and the
+ * scalars in the second way. Note that, in the second way, blst expects consecutive scalars to be
+ * `(nbits + 7) / 8` bytes apart, so shortened scalars must be packed before the call.
+ *
+ * @remark Zero scalars and points at infinity contribute nothing to the sum, so they are dropped
+ * before the points are converted to affine form. Blobs are often mostly zero padding, and this
+ * makes committing to them proportionally cheaper.
+ * @remark The bit length given to Pippenger is that of the largest scalar, rather than always
+ * `BITS_PER_FIELD_ELEMENT`. If most of the scalars are short, those are handled in a separate MSM
+ * so that a few full-width scalars do not make the whole computation full-width.
  */
-C_KZG_RET g1_lincomb_fast(g1_t *out, const g1_t *p, const fr_t *coeffs, size_t len) {
+C_KZG_RET g1_lincomb_fast(
+    g1_t *out, const g1_t *p, const fr_t *coeffs, size_t len, const KZGSettings *s
+) {
     C_KZG_RET ret;
     limb_t *scratch = NULL;
     blst_p1_affine *p_affine = NULL;
     blst_scalar *scalars = NULL;
-
-    /* Tunable parameter: must be at least 2 since blst fails for 0 or 1 */
-    const size_t min_length_threshold = 8;
+    const blst_p1 **p_used = NULL;
+    const blst_p1_affine **points = NULL;
+    size_t count = 0;
+    size_t threshold = naive_threshold(s);
 
     /* Use naive method if it's less than the threshold */
-    if (len < min_length_threshold) {
+    if (len < threshold) {
         g1_lincomb_naive(out, p, coeffs, len);
         ret = C_KZG_OK;
         goto out;
     }
 
+    /* Allocate space for arrays */
+    ret = c_kzg_calloc((void **)&scalars, len, sizeof(blst_scalar));
+    if (ret != C_KZG_OK) goto out;
+    ret = c_kzg_calloc((void **)&p_used, len, sizeof(blst_p1 *));
+    if (ret != C_KZG_OK) goto out;
+
+    /* Transform the field elements to 256-bit scalars, skipping terms which are zero */
+    for (size_t i = 0; i < len; i++) {
+        blst_scalar_from_fr(&scalars[count], &coeffs[i]);
+        if (scalar_bit_length(&scalars[count]) == 0 || blst_p1_is_inf(&p[i])) continue;
+        p_used[count++] = &p[i];
+    }
+
+    /* Nothing to do if every term is zero */
+    if (count == 0) {
+        *out = G1_IDENTITY;
+        goto out;
+    }
+
+    /* Allocate space for the remaining points */
+    ret = c_kzg_calloc((void **)&p_affine, count, sizeof(blst_p1_affine));
+    if (ret != C_KZG_OK) goto out;
+    ret = c_kzg_calloc((void **)&points, count, sizeof(blst_p1_affine *));
+    if (ret != C_KZG_OK) goto out;
+
+    /* Allocate space for Pippenger scratch */
+    size_t scratch_size = blst_p1s_mult_pippenger_scratch_sizeof(count);
+    ret = c_kzg_malloc((void **)&scratch, scratch_size);
+    if (ret != C_KZG_OK) goto out;
+
+    /* Transform the remaining points to affine representation */
+    blst_p1s_to_affine(p_affine, p_used, count);
+    for (size_t i = 0; i < count; i++) {
+        points[i] = &p_affine[i];
+    }
+
+    g1_lincomb_compacted(out, points, scalars, count, threshold, scratch);
+
+out:
+    c_kzg_free(scratch);
+    c_kzg_free(p_affine);
+    c_kzg_free(scalars);
+    c_kzg_free(p_used);
+    c_kzg_free(points);
+    return ret;
+}
+
+/**
+ * Calculate several linear combinations of the same G1 group elements.
+ *
+ * Calculates `out[j] = [coeffs_j_0]p_0 + [coeffs_j_1]p_1 + ... + [coeffs_j_n]p_n` for each `j`
+ * less than `num_vectors`, where `n` is `len - 1` and `coeffs_j_i` is `coeffs[j * len + i]`.
+ *
+ * @param[out]  out         The resulting sum-products, length `num_vectors`
+ * @param[in]   p           Array of G1 group elements, length `len`
+ * @param[in]   coeffs      Array of field elements, length `num_vectors * len`
+ * @param[in]   len         The number of group elements
+ * @param[in]   num_vectors The number of linear combinations
+ * @param[in]   s           The trusted setup, which holds the MSM strategy
+ *
+ * @remark This is equivalent to calling g1_lincomb_fast() once per vector, but the points are
+ * converted to affine form only once and the scratch space is shared between the calls.
+ * @remark The vectors do not share Pippenger's bucket passes. Filling one set of buckets per vector
+ * in a single pass over the points saves no additions, and is slower than blst's own buckets.
+ */
+C_KZG_RET g1_lincomb_fast_multi(
+    g1_t *out,
+    const g1_t *p,
+    const fr_t *coeffs,
+    size_t len,
+    size_t num_vectors,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+    limb_t *scratch = NULL;
+    blst_p1_affine *p_affine = NULL;
+    blst_scalar *scalars = NULL;
+    const blst_p1_affine **points = NULL;
+    size_t threshold = naive_threshold(s);
+
+    /* Use naive method if it's less than the threshold */
+    if (len < threshold) {
+        for (size_t j = 0; j < num_vectors; j++) {
+            g1_lincomb_naive(&out[j], p, &coeffs[j * len], len);
+        }
+        ret = C_KZG_OK;
+        goto out;
+    }
+
     /* Allocate space for arrays */
     ret = c_kzg_calloc((void **)&p_affine, len, sizeof(blst_p1_affine));
     if (ret != C_KZG_OK) goto out;
     ret = c_kzg_calloc((void **)&scalars, len, sizeof(blst_scalar));
     if (ret != C_KZG_OK) goto out;
+    ret = c_kzg_calloc((void **)&points, len, sizeof(blst_p1_affine *));
+    if (ret != C_KZG_OK) goto out;
 
     /* Allocate space for Pippenger scratch */
     size_t scratch_size = blst_p1s_mult_pippenger_scratch_sizeof(len);
     ret = c_kzg_malloc((void **)&scratch, scratch_size);
     if (ret != C_KZG_OK) goto out;
 
-    /* Transform the field elements to 256-bit scalars */
-    for (size_t i = 0; i < len; i++) {
-        blst_scalar_from_fr(&scalars[i], &coeffs[i]);
-    }
-
-    /* Transform the points to affine representation */
+    /* Transform the points to affine representation, once for all vectors */
     const blst_p1 *p_arg[2] = {p, NULL};
     blst_p1s_to_affine(p_affine, p_arg, len);
 
-    /* Call the Pippenger implementation */
-    const byte *scalars_arg[2] = {(byte *)scalars, NULL};
-    const blst_p1_affine *points_arg[2] = {p_affine, NULL};
-    blst_p1s_mult_pippenger(out, points_arg, len, scalars_arg, BITS_PER_FIELD_ELEMENT, scratch);
-    ret = C_KZG_OK;
+    for (size_t j = 0; j < num_vectors; j++) {
+        const fr_t *vector = &coeffs[j * len];
+        size_t count = 0;
+
+        /* Transform the field elements to 256-bit scalars, skipping terms which are zero */
+        for (size_t i = 0; i < len; i++) {
+            blst_scalar_from_fr(&scalars[count], &vector[i]);
+            if (scalar_bit_length(&scalars[count]) == 0) continue;
+            if (blst_p1_affine_is_inf(&p_affine[i])) continue;
+            points[count++] = &p_affine[i];
+        }
+
+        if (count == 0) {
+            out[j] = G1_IDENTITY;
+        } else {
+            g1_lincomb_compacted(&out[j], points, scalars, count, threshold, scratch);
+        }
+    }
 
 out:
     c_kzg_free(scratch);
     c_kzg_free(p_affine);
     c_kzg_free(scalars);
+    c_kzg_free(points);
     return ret;
 }
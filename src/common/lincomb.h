@@ -19,6 +19,14 @@
 #include "common/ec.h"
 #include "common/fr.h"
 #include "common/ret.h"
+#include "setup/settings.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Macros
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** The default length below which MSMs are computed naively, see KZGSettings. */
+#define DEFAULT_NAIVE_THRESHOLD 8
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Public Functions
@@ -29,7 +37,17 @@ extern "C" {
 #endif
 
 void g1_lincomb_naive(g1_t *out, const g1_t *p, const fr_t *coeffs, size_t len);
-C_KZG_RET g1_lincomb_fast(g1_t *out, const g1_t *p, const fr_t *coeffs, size_t len);
+C_KZG_RET g1_lincomb_fast(
+    g1_t *out, const g1_t *p, const fr_t *coeffs, size_t len, const KZGSettings *s
+);
+C_KZG_RET g1_lincomb_fast_multi(
+    g1_t *out,
+    const g1_t *p,
+    const fr_t *coeffs,
+    size_t len,
+    size_t num_vectors,
+    const KZGSettings *s
+);
 
 #ifdef __cplusplus
 }
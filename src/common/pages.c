@@ -0,0 +1,354 @@
+/*
+ * Copyright 2024 Benjamin Edgington
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common/pages.h"
+#include "common/alloc.h"
+
+#include <stdbool.h> /* For bool */
+#include <stddef.h>  /* For size_t & NULL */
+#include <stdint.h>  /* For uintptr_t */
+#include <stdio.h>   /* For FILE, fopen, fgets, fread & fseek */
+
+#if defined(__linux__)
+#include <sys/mman.h>    /* For mmap, madvise & munmap */
+#include <sys/stat.h>    /* For fstat */
+#include <sys/syscall.h> /* For SYS_mbind & SYS_getcpu */
+#include <unistd.h>      /* For syscall */
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Macros
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** Whether pages can be mapped directly, rather than taken from the heap. */
+#if defined(__linux__) && defined(MAP_ANONYMOUS)
+#define HAVE_MMAP 1
+#else
+#define HAVE_MMAP 0
+#endif
+
+/** The size of a huge page, and the alignment transparent huge pages need. */
+#define HUGE_PAGE_SIZE ((size_t)2 * 1024 * 1024)
+
+/** The size of a gigantic page, used for mappings at least this large. */
+#define GIGANTIC_PAGE_SIZE ((size_t)1024 * 1024 * 1024)
+
+/** The memory policy which prefers one node, but falls back to others when it is full. */
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED 1
+#endif
+
+/** The number of bits in each word of a node mask. */
+#define BITS_PER_MASK_WORD (8 * sizeof(unsigned long))
+
+#if HAVE_MMAP
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helper Functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Round a size up to a multiple of a page size.
+ *
+ * @param[in]   size        The size
+ * @param[in]   page_size   The page size, a power of two
+ *
+ * @return The rounded size, or zero if that would overflow.
+ */
+static size_t round_to_pages(size_t size, size_t page_size) {
+    if (size > SIZE_MAX - page_size) return 0;
+    return (size + page_size - 1) & ~(page_size - 1);
+}
+
+/**
+ * Map anonymous read/write memory.
+ *
+ * @param[in]   size    The number of bytes to map
+ * @param[in]   flags   Flags to add to MAP_PRIVATE | MAP_ANONYMOUS
+ *
+ * @return The mapping, or NULL on failure.
+ */
+static void *map_pages(size_t size, int flags) {
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+    return p == MAP_FAILED ? NULL : p;
+}
+
+/**
+ * Map memory aligned to a huge page, so that transparent huge pages can back all of it.
+ *
+ * @param[in]   size    The number of bytes to map, a multiple of HUGE_PAGE_SIZE
+ *
+ * @return The mapping, or NULL on failure.
+ */
+static void *map_aligned_pages(size_t size) {
+    uint8_t *raw, *aligned;
+    size_t head, tail;
+
+    if (size > SIZE_MAX - HUGE_PAGE_SIZE) return NULL;
+    raw = map_pages(size + HUGE_PAGE_SIZE, 0);
+    if (raw == NULL) return NULL;
+
+    /* Unmap the parts before and after the aligned range */
+    head = (HUGE_PAGE_SIZE - (uintptr_t)raw % HUGE_PAGE_SIZE) % HUGE_PAGE_SIZE;
+    tail = HUGE_PAGE_SIZE - head;
+    aligned = raw + head;
+    if (head != 0) munmap(raw, head);
+    if (tail != 0) munmap(aligned + size, tail);
+
+#ifdef MADV_HUGEPAGE
+    /* Only a hint, transparent huge pages may be disabled */
+    (void)madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+    return aligned;
+}
+
+/**
+ * Map memory on explicitly reserved huge pages.
+ *
+ * @param[out]  size_out    The size of the mapping
+ * @param[in]   size        The number of bytes needed
+ *
+ * @return The mapping, or NULL if there are not enough reserved huge pages.
+ */
+static void *map_huge_pages(size_t *size_out, size_t size) {
+    void *p = NULL;
+
+#ifdef MAP_HUGETLB
+#ifdef MAP_HUGE_1GB
+    if (size >= GIGANTIC_PAGE_SIZE) {
+        *size_out = round_to_pages(size, GIGANTIC_PAGE_SIZE);
+        if (*size_out != 0) p = map_pages(*size_out, MAP_HUGETLB | MAP_HUGE_1GB);
+    }
+#endif
+    if (p == NULL) {
+        *size_out = round_to_pages(size, HUGE_PAGE_SIZE);
+        if (*size_out != 0) p = map_pages(*size_out, MAP_HUGETLB);
+    }
+#else
+    (void)size_out;
+    (void)size;
+#endif
+    return p;
+}
+
+/**
+ * Ask for memory to be placed on a NUMA node, before it is first touched.
+ *
+ * @param[in]   p           The mapping
+ * @param[in]   size        The size of the mapping
+ * @param[in]   numa_node   The node
+ *
+ * @remark This is a preference, memory comes from other nodes if the node is full.
+ */
+static void bind_pages(void *p, size_t size, size_t numa_node) {
+#ifdef SYS_mbind
+    unsigned long mask[MAX_NUMA_NODES / BITS_PER_MASK_WORD] = {0};
+
+    if (numa_node >= MAX_NUMA_NODES) return;
+    mask[numa_node / BITS_PER_MASK_WORD] |= 1UL << (numa_node % BITS_PER_MASK_WORD);
+    (void)syscall(SYS_mbind, p, size, MPOL_PREFERRED, mask, MAX_NUMA_NODES + 1, 0);
+#else
+    (void)p;
+    (void)size;
+    (void)numa_node;
+#endif
+}
+
+#endif /* HAVE_MMAP */
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Pages
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate memory for large, long-lived tables.
+ *
+ * Where supported (Linux), the memory is mapped directly. With huge pages, it is first taken from
+ * reserved huge pages (1 GiB pages for mappings of at least that size, otherwise 2 MiB pages); if
+ * none are reserved, it is aligned and marked for transparent huge pages instead. With a NUMA
+ * node, the memory is placed on that node. Otherwise, or on other platforms, it comes from the
+ * heap like any other allocation.
+ *
+ * @param[out]  out             Pointer to the allocated space
+ * @param[out]  mapped_size_out The size of the mapping, zero if it came from the heap
+ * @param[in]   size            The number of bytes to be allocated
+ * @param[in]   huge_pages      Whether to use huge pages
+ * @param[in]   numa_node       The node to place the memory on, or ANY_NUMA_NODE
+ *
+ * @remark Mapped memory is zeroed, heap memory is not.
+ * @remark Free the space later using free_pages(), with the mapped size.
+ */
+C_KZG_RET new_pages(
+    void **out, size_t *mapped_size_out, size_t size, bool huge_pages, size_t numa_node
+) {
+    *out = NULL;
+    *mapped_size_out = 0;
+    if (size == 0) return C_KZG_BADARGS;
+
+#if HAVE_MMAP
+    if (huge_pages || numa_node != ANY_NUMA_NODE) {
+        void *p = NULL;
+        size_t mapped_size = 0;
+
+        if (huge_pages) {
+            p = map_huge_pages(&mapped_size, size);
+            if (p == NULL) {
+                mapped_size = round_to_pages(size, HUGE_PAGE_SIZE);
+                if (mapped_size == 0) return C_KZG_MALLOC;
+                p = map_aligned_pages(mapped_size);
+            }
+        } else {
+            mapped_size = size;
+            p = map_pages(mapped_size, 0);
+        }
+        if (p == NULL) return C_KZG_MALLOC;
+
+        if (numa_node != ANY_NUMA_NODE) bind_pages(p, mapped_size, numa_node);
+        *out = p;
+        *mapped_size_out = mapped_size;
+        return C_KZG_OK;
+    }
+#else
+    (void)huge_pages;
+    (void)numa_node;
+#endif
+
+    return c_kzg_malloc(out, size);
+}
+
+/**
+ * Free memory from new_pages().
+ *
+ * @param[in]   p           The pointer to the allocated space, may be NULL
+ * @param[in]   mapped_size The mapped size given by new_pages()
+ */
+void free_pages(void *p, size_t mapped_size) {
+    if (p == NULL) return;
+#if HAVE_MMAP
+    if (mapped_size != 0) {
+        munmap(p, mapped_size);
+        return;
+    }
+#else
+    (void)mapped_size;
+#endif
+    c_kzg_free(p);
+}
+
+/**
+ * Map a whole file read-only, so that every process which maps it shares the same memory.
+ *
+ * Where supported (Linux), the file is mapped directly and shared. Otherwise, it is read into
+ * memory from the heap, which works the same but is not shared.
+ *
+ * @param[out]  out             Pointer to the file's contents
+ * @param[out]  mapped_size_out The size of the mapping, zero if it came from the heap
+ * @param[out]  size_out        The size of the file
+ * @param[in]   in              The file, which can be closed afterwards
+ *
+ * @remark The contents must not be written to.
+ * @remark Free the contents later using free_pages(), with the mapped size.
+ */
+C_KZG_RET map_file(void **out, size_t *mapped_size_out, size_t *size_out, FILE *in) {
+    C_KZG_RET ret;
+    long end;
+    size_t size;
+
+    *out = NULL;
+    *mapped_size_out = 0;
+    *size_out = 0;
+
+#if HAVE_MMAP
+    struct stat st;
+    if (fstat(fileno(in), &st) == 0 && S_ISREG(st.st_mode)) {
+        if (st.st_size <= 0 || (uint64_t)st.st_size > SIZE_MAX) return C_KZG_BADARGS;
+        size = (size_t)st.st_size;
+        void *p = mmap(NULL, size, PROT_READ, MAP_SHARED, fileno(in), 0);
+        if (p != MAP_FAILED) {
+            *out = p;
+            *mapped_size_out = size;
+            *size_out = size;
+            return C_KZG_OK;
+        }
+    }
+#endif
+
+    /* Fall back to reading the file */
+    if (fseek(in, 0, SEEK_END) != 0) return C_KZG_BADARGS;
+    end = ftell(in);
+    if (end <= 0 || fseek(in, 0, SEEK_SET) != 0) return C_KZG_BADARGS;
+    size = (size_t)end;
+
+    ret = c_kzg_malloc(out, size);
+    if (ret != C_KZG_OK) return ret;
+    if (fread(*out, 1, size, in) != size) {
+        c_kzg_free(*out);
+        return C_KZG_BADARGS;
+    }
+    *size_out = size;
+    return C_KZG_OK;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// NUMA Nodes
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Get the number of NUMA nodes in the system.
+ *
+ * @return The highest online node number plus one, at most MAX_NUMA_NODES. This is one if the
+ * system is not NUMA or it cannot be told.
+ */
+size_t numa_node_count(void) {
+    size_t count = 1;
+#if HAVE_MMAP
+    char line[256];
+    size_t number = 0;
+    bool in_number = false;
+    FILE *fp = fopen("/sys/devices/system/node/online", "r");
+    if (fp == NULL) return 1;
+
+    /* The line is a list of ranges, such as "0-1,3" */
+    if (fgets(line, sizeof(line), fp) != NULL) {
+        for (size_t i = 0; line[i] != '\0'; i++) {
+            if (line[i] >= '0' && line[i] <= '9') {
+                number = number * 10 + (size_t)(line[i] - '0');
+                in_number = true;
+            } else {
+                if (in_number && number + 1 > count) count = number + 1;
+                number = 0;
+                in_number = false;
+            }
+        }
+        if (in_number && number + 1 > count) count = number + 1;
+    }
+    fclose(fp);
+#endif
+    return count < MAX_NUMA_NODES ? count : MAX_NUMA_NODES;
+}
+
+/**
+ * Get the NUMA node that the calling thread is running on.
+ *
+ * @return The node, or zero if it cannot be told.
+ */
+size_t current_numa_node(void) {
+#if HAVE_MMAP && defined(SYS_getcpu)
+    unsigned cpu = 0, node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) == 0) return node;
+#endif
+    return 0;
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2024 Benjamin Edgington
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "common/ret.h"
+
+#include <stdbool.h> /* For bool */
+#include <stddef.h>  /* For size_t */
+#include <stdint.h>  /* For SIZE_MAX */
+#include <stdio.h>   /* For FILE */
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Macros
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** Pass to new_pages() to not bind the memory to a NUMA node. */
+#define ANY_NUMA_NODE SIZE_MAX
+
+/** The most NUMA nodes that memory can be bound to. */
+#define MAX_NUMA_NODES 64
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Public Functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+C_KZG_RET new_pages(
+    void **out, size_t *mapped_size_out, size_t size, bool huge_pages, size_t numa_node
+);
+void free_pages(void *p, size_t mapped_size);
+C_KZG_RET map_file(void **out, size_t *mapped_size_out, size_t *size_out, FILE *in);
+size_t numa_node_count(void);
+size_t current_numa_node(void);
+
+#ifdef __cplusplus
+}
+#endif
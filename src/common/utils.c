@@ -194,3 +194,72 @@ bool pairings_verify(const g1_t *a1, const g2_t *a2, const g1_t *b1, const g2_t
 
     return blst_fp12_is_one(&gt_point);
 }
+
+/**
+ * Find the invalid items in a range of a batch which is known to fail, by bisection.
+ *
+ * @param[out]      invalid_out     The indices of the invalid items found, in order
+ * @param[in,out]   num_invalid_out The number of indices in `invalid_out`
+ * @param[in]       check           The check for a range of the batch
+ * @param[in]       batch           The batch, passed on to `check`
+ * @param[in]       lo              The first item of the range
+ * @param[in]       hi              One past the last item of the range
+ */
+static C_KZG_RET bisect_invalid_items(
+    uint64_t *invalid_out,
+    uint64_t *num_invalid_out,
+    check_range_fn check,
+    const void *batch,
+    size_t lo,
+    size_t hi
+) {
+    C_KZG_RET ret;
+    size_t mid = lo + (hi - lo) / 2;
+    bool left_ok, right_ok;
+
+    if (hi - lo == 1) {
+        invalid_out[(*num_invalid_out)++] = lo;
+        return C_KZG_OK;
+    }
+
+    ret = check(&left_ok, batch, lo, mid);
+    if (ret != C_KZG_OK) return ret;
+    if (!left_ok) {
+        ret = bisect_invalid_items(invalid_out, num_invalid_out, check, batch, lo, mid);
+        if (ret != C_KZG_OK) return ret;
+
+        ret = check(&right_ok, batch, mid, hi);
+        if (ret != C_KZG_OK) return ret;
+        if (right_ok) return C_KZG_OK;
+    }
+
+    /* If the left half passed, the right half must be what fails */
+    return bisect_invalid_items(invalid_out, num_invalid_out, check, batch, mid, hi);
+}
+
+/**
+ * Find the invalid items in a batch which failed verification.
+ *
+ * The batch is split in halves, and only the halves which fail are split further, so with a few
+ * invalid items this takes a number of checks which is logarithmic in the size of the batch.
+ *
+ * @param[out]  invalid_out     The indices of the invalid items, in order, length up to `n`
+ * @param[out]  num_invalid_out The number of invalid items
+ * @param[in]   check           The check for a range of the batch
+ * @param[in]   batch           The batch, passed on to `check`
+ * @param[in]   n               The number of items in the batch, which is not zero
+ *
+ * @remark The check must be linear in the items, like a random linear combination with the same
+ * weights for every range: then if a range fails and its left half passes, its right half fails
+ * without being checked.
+ */
+C_KZG_RET locate_invalid_items(
+    uint64_t *invalid_out,
+    uint64_t *num_invalid_out,
+    check_range_fn check,
+    const void *batch,
+    size_t n
+) {
+    *num_invalid_out = 0;
+    return bisect_invalid_items(invalid_out, num_invalid_out, check, batch, 0, n);
+}
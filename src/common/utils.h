@@ -23,6 +23,13 @@
 #include <stdbool.h>  /* For bool */
 #include <stddef.h>   /* For size_t */
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Types
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** Checks whether the items `[lo, hi)` of a batch are all valid, see locate_invalid_items(). */
+typedef C_KZG_RET (*check_range_fn)(bool *ok, const void *batch, size_t lo, size_t hi);
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Public Functions
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -38,6 +45,13 @@ uint64_t reverse_bits_limited(uint64_t n, uint64_t value);
 C_KZG_RET bit_reversal_permutation(void *values, size_t size, size_t n);
 void compute_powers(fr_t *out, const fr_t *x, size_t n);
 bool pairings_verify(const g1_t *a1, const g2_t *a2, const g1_t *b1, const g2_t *b2);
+C_KZG_RET locate_invalid_items(
+    uint64_t *invalid_out,
+    uint64_t *num_invalid_out,
+    check_range_fn check,
+    const void *batch,
+    size_t n
+);
 
 #ifdef __cplusplus
 }
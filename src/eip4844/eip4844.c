@@ -21,6 +21,8 @@
 #include "common/lincomb.h"
 #include "common/ret.h"
 #include "common/utils.h"
+#include "eip4844/polynomial.h"
+#include "setup/prover.h"
 #include "setup/settings.h"
 
 #include <assert.h> /* For assert */
@@ -37,6 +39,12 @@
 /* Input size to the Fiat-Shamir challenge computation. */
 #define CHALLENGE_INPUT_SIZE (DOMAIN_STR_LENGTH + 16 + BYTES_PER_BLOB + BYTES_PER_COMMITMENT)
 
+/**
+ * The most points that compute_kzg_proofs_multi() inverts and commits to at once. This bounds the
+ * scratch memory, which is about 400 KiB per point.
+ */
+#define POINTS_PER_PROOF_GROUP 16
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Constants
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -47,6 +55,26 @@ static const char *FIAT_SHAMIR_PROTOCOL_DOMAIN = "FSBLOBVERIFY_V1_";
 /** The domain separator for verify_blob_kzg_proof's random challenge. */
 static const char *RANDOM_CHALLENGE_DOMAIN_VERIFY_BLOB_KZG_PROOF_BATCH = "RCKZGBATCH___V1_";
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Types
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** A decoded batch of KZG proofs, and the weights to combine them with. */
+typedef struct {
+    /** The commitments, one for each proof. */
+    const g1_t *commitments_g1;
+    /** The evaluation points. */
+    const fr_t *zs_fr;
+    /** The evaluations. */
+    const fr_t *ys_fr;
+    /** The proofs. */
+    const g1_t *proofs_g1;
+    /** The powers of r for the whole batch. */
+    const fr_t *r_powers;
+    /** The trusted setup. */
+    const KZGSettings *s;
+} KZGProofBatch;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Helper Functions
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -251,7 +279,7 @@ out:
  * @param[in]   s       The trusted setup
  */
 static C_KZG_RET poly_to_kzg_commitment(g1_t *out, const fr_t *poly, const KZGSettings *s) {
-    return g1_lincomb_fast(out, s->g1_values_lagrange_brp, poly, FIELD_ELEMENTS_PER_BLOB);
+    return g1_lincomb_fast(out, s->g1_values_lagrange_brp, poly, FIELD_ELEMENTS_PER_BLOB, s);
 }
 
 /**
@@ -266,6 +294,10 @@ C_KZG_RET blob_to_kzg_commitment(KZGCommitment *out, const Blob *blob, const KZG
     fr_t *poly = NULL;
     g1_t commitment;
 
+    /* This needs the Lagrange points, which a verification profile may load on first use */
+    ret = get_prover_settings(&s, s, false);
+    if (ret != C_KZG_OK) goto out;
+
     ret = new_fr_array(&poly, FIELD_ELEMENTS_PER_BLOB);
     if (ret != C_KZG_OK) goto out;
     ret = blob_to_polynomial(poly, blob);
@@ -279,6 +311,83 @@ out:
     return ret;
 }
 
+/**
+ * Update a commitment for a blob in which some of the field elements have changed.
+ *
+ * The commitment is linear in the field elements, so only the changes need to be committed to:
+ * the result is the old commitment plus the MSM of `new - old` over the Lagrange points of the
+ * changed elements. The cost scales with `n` rather than with the size of the blob.
+ *
+ * @param[out]  out                 The commitment to the changed blob
+ * @param[in]   commitment_bytes    The commitment to the blob before the changes
+ * @param[in]   indices             The indices in the blob of the changed field elements, length
+ *                                  `n`
+ * @param[in]   old_fields          The field elements before the changes, length `n`
+ * @param[in]   new_fields          The field elements after the changes, length `n`
+ * @param[in]   n                   The number of changed field elements
+ * @param[in]   s                   The trusted setup
+ *
+ * @remark The result is only a commitment to the changed blob if `old_fields` are the elements
+ * that the blob held. An index can be given more than once, for changes made one after another.
+ */
+C_KZG_RET update_kzg_commitment(
+    KZGCommitment *out,
+    const Bytes48 *commitment_bytes,
+    const uint64_t *indices,
+    const Bytes32 *old_fields,
+    const Bytes32 *new_fields,
+    uint64_t n,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+    g1_t *points = NULL;
+    fr_t *deltas = NULL;
+    g1_t commitment, delta;
+    fr_t old_fr;
+
+    /* This needs the Lagrange points, which a verification profile may load on first use */
+    ret = get_prover_settings(&s, s, false);
+    if (ret != C_KZG_OK) goto out;
+
+    ret = bytes_to_kzg_commitment(&commitment, commitment_bytes);
+    if (ret != C_KZG_OK) goto out;
+
+    /* Nothing changed */
+    if (n == 0) {
+        bytes_from_g1(out, &commitment);
+        goto out;
+    }
+
+    ret = new_g1_array(&points, n);
+    if (ret != C_KZG_OK) goto out;
+    ret = new_fr_array(&deltas, n);
+    if (ret != C_KZG_OK) goto out;
+
+    /* Gather the Lagrange point and the difference of each changed element */
+    for (uint64_t i = 0; i < n; i++) {
+        if (indices[i] >= FIELD_ELEMENTS_PER_BLOB) {
+            ret = C_KZG_BADARGS;
+            goto out;
+        }
+        ret = bytes_to_bls_field(&old_fr, &old_fields[i]);
+        if (ret != C_KZG_OK) goto out;
+        ret = bytes_to_bls_field(&deltas[i], &new_fields[i]);
+        if (ret != C_KZG_OK) goto out;
+        blst_fr_sub(&deltas[i], &deltas[i], &old_fr);
+        points[i] = s->g1_values_lagrange_brp[indices[i]];
+    }
+
+    ret = g1_lincomb_fast(&delta, points, deltas, n, s);
+    if (ret != C_KZG_OK) goto out;
+    blst_p1_add_or_double(&commitment, &commitment, &delta);
+    bytes_from_g1(out, &commitment);
+
+out:
+    c_kzg_free(points);
+    c_kzg_free(deltas);
+    return ret;
+}
+
 /* Forward function declaration */
 static C_KZG_RET verify_kzg_proof_impl(
     bool *ok,
@@ -390,6 +499,10 @@ C_KZG_RET compute_kzg_proof(
     fr_t *poly = NULL;
     fr_t frz, fry;
 
+    /* This needs the Lagrange points, which a verification profile may load on first use */
+    ret = get_prover_settings(&s, s, false);
+    if (ret != C_KZG_OK) goto out;
+
     ret = new_fr_array(&poly, FIELD_ELEMENTS_PER_BLOB);
     if (ret != C_KZG_OK) goto out;
     ret = blob_to_polynomial(poly, blob);
@@ -481,7 +594,9 @@ static C_KZG_RET compute_kzg_proof_impl(
     }
 
     g1_t out_g1;
-    ret = g1_lincomb_fast(&out_g1, s->g1_values_lagrange_brp, q_poly, FIELD_ELEMENTS_PER_BLOB);
+    ret = g1_lincomb_fast(
+        &out_g1, s->g1_values_lagrange_brp, q_poly, FIELD_ELEMENTS_PER_BLOB, s
+    );
     if (ret != C_KZG_OK) goto out;
 
     bytes_from_g1(proof_out, &out_g1);
@@ -493,6 +608,187 @@ out:
     return ret;
 }
 
+/**
+ * Helper function for compute_kzg_proofs_multi() and compute_kzg_proofs_multi_poly().
+ *
+ * For each group of points, the denominators `ω_i - z` of every point are inverted together, and
+ * the quotients are committed to with one g1_lincomb_fast_multi() call, which converts the Lagrange
+ * points to affine form once for all of them.
+ *
+ * @param[out]  proofs_out  The proofs, length `n`
+ * @param[out]  ys_out      The evaluations of the polynomial at the points, length `n`
+ * @param[in]   poly        The polynomial in Lagrange form
+ * @param[in]   zs_bytes    The evaluation points, length `n`
+ * @param[in]   n           The number of evaluation points
+ * @param[in]   s           The trusted setup
+ */
+static C_KZG_RET compute_kzg_proofs_multi_impl(
+    KZGProof *proofs_out,
+    Bytes32 *ys_out,
+    const fr_t *poly,
+    const Bytes32 *zs_bytes,
+    uint64_t n,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+    fr_t *zs = NULL;
+    fr_t *inverses_in = NULL;
+    fr_t *inverses = NULL;
+    fr_t *q_polys = NULL;
+    g1_t *proofs_g1 = NULL;
+    const fr_t *brp_roots_of_unity = s->brp_roots_of_unity;
+    /* m != 0 indicates that the j-th point of the group equals root_of_unity[m-1] */
+    uint64_t in_domain[POINTS_PER_PROOF_GROUP];
+    size_t group_size;
+    fr_t tmp, y;
+
+    /* Nothing to do */
+    if (n == 0) return C_KZG_OK;
+
+    /* Do conversions first to fail fast */
+    ret = new_fr_array(&zs, n);
+    if (ret != C_KZG_OK) goto out;
+    for (uint64_t j = 0; j < n; j++) {
+        ret = bytes_to_bls_field(&zs[j], &zs_bytes[j]);
+        if (ret != C_KZG_OK) goto out;
+    }
+
+    /* Only allocate as much as the largest group needs */
+    group_size = n < POINTS_PER_PROOF_GROUP ? (size_t)n : POINTS_PER_PROOF_GROUP;
+    ret = new_fr_array(&inverses_in, group_size * FIELD_ELEMENTS_PER_BLOB);
+    if (ret != C_KZG_OK) goto out;
+    ret = new_fr_array(&inverses, group_size * FIELD_ELEMENTS_PER_BLOB);
+    if (ret != C_KZG_OK) goto out;
+    ret = new_fr_array(&q_polys, group_size * FIELD_ELEMENTS_PER_BLOB);
+    if (ret != C_KZG_OK) goto out;
+    ret = new_g1_array(&proofs_g1, group_size);
+    if (ret != C_KZG_OK) goto out;
+
+    for (uint64_t first = 0; first < n; first += group_size) {
+        size_t count = (size_t)(n - first) < group_size ? (size_t)(n - first) : group_size;
+
+        /* Collect the denominators of every point in the group, to invert them all at once */
+        for (size_t j = 0; j < count; j++) {
+            const fr_t *z = &zs[first + j];
+            fr_t *denominators = &inverses_in[j * FIELD_ELEMENTS_PER_BLOB];
+
+            in_domain[j] = 0;
+            for (size_t i = 0; i < FIELD_ELEMENTS_PER_BLOB; i++) {
+                if (fr_equal(z, &brp_roots_of_unity[i])) {
+                    /* Invert z in the unused slot, the in-domain quotient needs it */
+                    in_domain[j] = i + 1;
+                    denominators[i] = *z;
+                    continue;
+                }
+                blst_fr_sub(&denominators[i], &brp_roots_of_unity[i], z);
+            }
+        }
+
+        ret = fr_batch_inv(inverses, inverses_in, (int)(count * FIELD_ELEMENTS_PER_BLOB));
+        if (ret != C_KZG_OK) goto out;
+
+        for (size_t j = 0; j < count; j++) {
+            const fr_t *z = &zs[first + j];
+            const fr_t *inv = &inverses[j * FIELD_ELEMENTS_PER_BLOB];
+            fr_t *q_poly = &q_polys[j * FIELD_ELEMENTS_PER_BLOB];
+            uint64_t m = in_domain[j];
+
+            if (m == 0) {
+                /* y = (1 - z^n) / n * sum(p_i * ω_i / (ω_i - z)) */
+                y = FR_ZERO;
+                for (size_t i = 0; i < FIELD_ELEMENTS_PER_BLOB; i++) {
+                    blst_fr_mul(&tmp, &inv[i], &brp_roots_of_unity[i]);
+                    blst_fr_mul(&tmp, &tmp, &poly[i]);
+                    blst_fr_add(&y, &y, &tmp);
+                }
+                fr_from_uint64(&tmp, FIELD_ELEMENTS_PER_BLOB);
+                fr_div(&y, &y, &tmp);
+                fr_pow(&tmp, z, FIELD_ELEMENTS_PER_BLOB);
+                blst_fr_sub(&tmp, &FR_ONE, &tmp);
+                blst_fr_mul(&y, &y, &tmp);
+
+                // (p_i - y) / (ω_i - z)
+                for (size_t i = 0; i < FIELD_ELEMENTS_PER_BLOB; i++) {
+                    blst_fr_sub(&tmp, &poly[i], &y);
+                    blst_fr_mul(&q_poly[i], &tmp, &inv[i]);
+                }
+            } else { /* ω_{m-1} == z */
+                y = poly[--m];
+                q_poly[m] = FR_ZERO;
+                for (size_t i = 0; i < FIELD_ELEMENTS_PER_BLOB; i++) {
+                    if (i == m) continue;
+                    blst_fr_sub(&tmp, &poly[i], &y);
+                    blst_fr_mul(&q_poly[i], &tmp, &inv[i]);
+                    blst_fr_mul(&tmp, &q_poly[i], &brp_roots_of_unity[i]);
+                    blst_fr_add(&q_poly[m], &q_poly[m], &tmp);
+                }
+                /* Scale by -1/z, which makes each term (p_i - y) * ω_i / (z * (z - ω_i)) */
+                blst_fr_mul(&q_poly[m], &q_poly[m], &inv[m]);
+                blst_fr_cneg(&q_poly[m], &q_poly[m], true);
+            }
+
+            bytes_from_bls_field(&ys_out[first + j], &y);
+        }
+
+        ret = g1_lincomb_fast_multi(
+            proofs_g1, s->g1_values_lagrange_brp, q_polys, FIELD_ELEMENTS_PER_BLOB, count, s
+        );
+        if (ret != C_KZG_OK) goto out;
+
+        for (size_t j = 0; j < count; j++) {
+            bytes_from_g1(&proofs_out[first + j], &proofs_g1[j]);
+        }
+    }
+
+out:
+    c_kzg_free(zs);
+    c_kzg_free(inverses_in);
+    c_kzg_free(inverses);
+    c_kzg_free(q_polys);
+    c_kzg_free(proofs_g1);
+    return ret;
+}
+
+/**
+ * Compute KZG proofs for one blob at several points.
+ *
+ * This gives the same results as calling compute_kzg_proof() for each point, but the blob is only
+ * parsed once, the inversions are batched across the points, and the proofs' MSMs share the
+ * conversion of the Lagrange points to affine form.
+ *
+ * @param[out]  proofs_out  The proofs, length `n`
+ * @param[out]  ys_out      The evaluations of the polynomial at the points, length `n`
+ * @param[in]   blob        The blob (polynomial) to generate proofs for
+ * @param[in]   zs_bytes    The evaluation points, length `n`
+ * @param[in]   n           The number of evaluation points
+ * @param[in]   s           The trusted setup
+ */
+C_KZG_RET compute_kzg_proofs_multi(
+    KZGProof *proofs_out,
+    Bytes32 *ys_out,
+    const Blob *blob,
+    const Bytes32 *zs_bytes,
+    uint64_t n,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+    fr_t *poly = NULL;
+
+    /* This needs the Lagrange points, which a verification profile may load on first use */
+    ret = get_prover_settings(&s, s, false);
+    if (ret != C_KZG_OK) goto out;
+
+    ret = new_fr_array(&poly, FIELD_ELEMENTS_PER_BLOB);
+    if (ret != C_KZG_OK) goto out;
+    ret = blob_to_polynomial(poly, blob);
+    if (ret != C_KZG_OK) goto out;
+    ret = compute_kzg_proofs_multi_impl(proofs_out, ys_out, poly, zs_bytes, n, s);
+
+out:
+    c_kzg_free(poly);
+    return ret;
+}
+
 /**
  * Given a blob and a commitment, return the KZG proof that is used to verify it against the
  * commitment. This function does not verify that the commitment is correct with respect to the
@@ -512,6 +808,10 @@ C_KZG_RET compute_blob_kzg_proof(
     fr_t evaluation_challenge_fr;
     fr_t y;
 
+    /* This needs the Lagrange points, which a verification profile may load on first use */
+    ret = get_prover_settings(&s, s, false);
+    if (ret != C_KZG_OK) goto out;
+
     /* Allocate space for our polynomial */
     ret = new_fr_array(&poly, FIELD_ELEMENTS_PER_BLOB);
     if (ret != C_KZG_OK) goto out;
@@ -663,10 +963,68 @@ out:
     return ret;
 }
 
+/**
+ * Check a range of a batch of KZG proofs, with the weights for the whole batch.
+ *
+ * @param[out]  ok      True if the proofs in the range are valid, otherwise false
+ * @param[in]   batch   The batch, a KZGProofBatch
+ * @param[in]   lo      The first proof of the range
+ * @param[in]   hi      One past the last proof of the range
+ */
+static C_KZG_RET check_kzg_proof_range(bool *ok, const void *batch, size_t lo, size_t hi) {
+    C_KZG_RET ret;
+    const KZGProofBatch *b = batch;
+    const g1_t *proofs_g1 = &b->proofs_g1[lo];
+    const fr_t *r_powers = &b->r_powers[lo];
+    size_t n = hi - lo;
+    g1_t proof_lincomb, proof_z_lincomb, C_minus_y_lincomb, rhs_g1;
+    g1_t *C_minus_y = NULL;
+    fr_t *r_times_z = NULL;
+
+    *ok = false;
+
+    ret = new_g1_array(&C_minus_y, n);
+    if (ret != C_KZG_OK) goto out;
+    ret = new_fr_array(&r_times_z, n);
+    if (ret != C_KZG_OK) goto out;
+
+    /* Compute \sum r^i * Proof_i */
+    g1_lincomb_naive(&proof_lincomb, proofs_g1, r_powers, n);
+
+    for (size_t i = 0; i < n; i++) {
+        g1_t ys_encrypted;
+        /* Get [y_i] */
+        g1_mul(&ys_encrypted, blst_p1_generator(), &b->ys_fr[lo + i]);
+        /* Get C_i - [y_i] */
+        g1_sub(&C_minus_y[i], &b->commitments_g1[lo + i], &ys_encrypted);
+        /* Get r^i * z_i */
+        blst_fr_mul(&r_times_z[i], &r_powers[i], &b->zs_fr[lo + i]);
+    }
+
+    /* Get \sum r^i z_i Proof_i */
+    g1_lincomb_naive(&proof_z_lincomb, proofs_g1, r_times_z, n);
+    /* Get \sum r^i (C_i - [y_i]) */
+    g1_lincomb_naive(&C_minus_y_lincomb, C_minus_y, r_powers, n);
+    /* Get C_minus_y_lincomb + proof_z_lincomb */
+    blst_p1_add_or_double(&rhs_g1, &C_minus_y_lincomb, &proof_z_lincomb);
+
+    /* Do the pairing check! */
+    *ok = pairings_verify(
+        &proof_lincomb, &b->s->g2_values_monomial[1], &rhs_g1, blst_p2_generator()
+    );
+
+out:
+    c_kzg_free(C_minus_y);
+    c_kzg_free(r_times_z);
+    return ret;
+}
+
 /**
  * Helper function for verify_blob_kzg_proof_batch(): actually perform the verification.
  *
  * @param[out]  ok              True if the proofs are valid, otherwise false
+ * @param[out]  invalid_out     The indices of the invalid proofs, length up to `n`, or NULL
+ * @param[out]  num_invalid_out The number of invalid proofs, or NULL if `invalid_out` is NULL
  * @param[in]   commitments_g1  Array of commitments to verify
  * @param[in]   zs_fr           Array of evaluation points for the KZG proofs
  * @param[in]   ys_fr           Array of evaluation results for the KZG proofs
@@ -677,9 +1035,13 @@ out:
  * @remark This function only works for `n > 0`.
  * @remark This function assumes that `n` is trusted and that all input arrays contain `n` elements.
  * `n` should be the actual size of the arrays and not read off a length field in the protocol.
+ * @remark If the batch fails and `invalid_out` is not NULL, the invalid proofs are found by
+ * bisection, reusing the decoded points and the weights.
  */
 static C_KZG_RET verify_kzg_proof_batch(
     bool *ok,
+    uint64_t *invalid_out,
+    uint64_t *num_invalid_out,
     const g1_t *commitments_g1,
     const fr_t *zs_fr,
     const fr_t *ys_fr,
@@ -688,22 +1050,17 @@ static C_KZG_RET verify_kzg_proof_batch(
     const KZGSettings *s
 ) {
     C_KZG_RET ret;
-    g1_t proof_lincomb, proof_z_lincomb, C_minus_y_lincomb, rhs_g1;
     fr_t *r_powers = NULL;
-    g1_t *C_minus_y = NULL;
-    fr_t *r_times_z = NULL;
+    KZGProofBatch batch;
 
     assert(n > 0);
 
     *ok = false;
+    if (invalid_out != NULL) *num_invalid_out = 0;
 
     /* First let's allocate our arrays */
     ret = new_fr_array(&r_powers, n);
     if (ret != C_KZG_OK) goto out;
-    ret = new_g1_array(&C_minus_y, n);
-    if (ret != C_KZG_OK) goto out;
-    ret = new_fr_array(&r_times_z, n);
-    if (ret != C_KZG_OK) goto out;
 
     /* Compute the random lincomb challenges */
     ret = compute_r_powers_for_verify_kzg_proof_batch(
@@ -711,41 +1068,29 @@ static C_KZG_RET verify_kzg_proof_batch(
     );
     if (ret != C_KZG_OK) goto out;
 
-    /* Compute \sum r^i * Proof_i */
-    g1_lincomb_naive(&proof_lincomb, proofs_g1, r_powers, n);
-
-    for (size_t i = 0; i < n; i++) {
-        g1_t ys_encrypted;
-        /* Get [y_i] */
-        g1_mul(&ys_encrypted, blst_p1_generator(), &ys_fr[i]);
-        /* Get C_i - [y_i] */
-        g1_sub(&C_minus_y[i], &commitments_g1[i], &ys_encrypted);
-        /* Get r^i * z_i */
-        blst_fr_mul(&r_times_z[i], &r_powers[i], &zs_fr[i]);
-    }
+    batch.commitments_g1 = commitments_g1;
+    batch.zs_fr = zs_fr;
+    batch.ys_fr = ys_fr;
+    batch.proofs_g1 = proofs_g1;
+    batch.r_powers = r_powers;
+    batch.s = s;
 
-    /* Get \sum r^i z_i Proof_i */
-    g1_lincomb_naive(&proof_z_lincomb, proofs_g1, r_times_z, n);
-    /* Get \sum r^i (C_i - [y_i]) */
-    g1_lincomb_naive(&C_minus_y_lincomb, C_minus_y, r_powers, n);
-    /* Get C_minus_y_lincomb + proof_z_lincomb */
-    blst_p1_add_or_double(&rhs_g1, &C_minus_y_lincomb, &proof_z_lincomb);
+    ret = check_kzg_proof_range(ok, &batch, 0, n);
+    if (ret != C_KZG_OK || *ok || invalid_out == NULL) goto out;
 
-    /* Do the pairing check! */
-    *ok = pairings_verify(&proof_lincomb, &s->g2_values_monomial[1], &rhs_g1, blst_p2_generator());
+    ret = locate_invalid_items(invalid_out, num_invalid_out, check_kzg_proof_range, &batch, n);
 
 out:
     c_kzg_free(r_powers);
-    c_kzg_free(C_minus_y);
-    c_kzg_free(r_times_z);
     return ret;
 }
 
 /**
- * Given a list of blobs and blob KZG proofs, verify that they correspond to the provided
- * commitments.
+ * Helper function for verify_blob_kzg_proof_batch() and verify_blob_kzg_proof_batch_locate().
  *
  * @param[out]  ok                  True if the proofs are valid, otherwise false
+ * @param[out]  invalid_out         The indices of the invalid proofs, or NULL to not find them
+ * @param[out]  num_invalid_out     The number of invalid proofs, or NULL with `invalid_out`
  * @param[in]   blobs               Array of blobs to verify
  * @param[in]   commitments_bytes   Array of commitments to verify
  * @param[in]   proofs_bytes        Array of proofs used for verification
@@ -756,8 +1101,10 @@ out:
  * @remark This function assumes that `n` is trusted and that all input arrays contain `n` elements.
  * `n` should be the actual size of the arrays and not read off a length field in the protocol.
  */
-C_KZG_RET verify_blob_kzg_proof_batch(
+static C_KZG_RET verify_blob_kzg_proof_batch_impl(
     bool *ok,
+    uint64_t *invalid_out,
+    uint64_t *num_invalid_out,
     const Blob *blobs,
     const Bytes48 *commitments_bytes,
     const Bytes48 *proofs_bytes,
@@ -771,6 +1118,8 @@ C_KZG_RET verify_blob_kzg_proof_batch(
     fr_t *ys_fr = NULL;
     fr_t *poly = NULL;
 
+    if (invalid_out != NULL) *num_invalid_out = 0;
+
     /* Exit early if we are given zero blobs */
     if (n == 0) {
         *ok = true;
@@ -779,7 +1128,12 @@ C_KZG_RET verify_blob_kzg_proof_batch(
 
     /* For a single blob, just do a regular single verification */
     if (n == 1) {
-        return verify_blob_kzg_proof(ok, &blobs[0], &commitments_bytes[0], &proofs_bytes[0], s);
+        ret = verify_blob_kzg_proof(ok, &blobs[0], &commitments_bytes[0], &proofs_bytes[0], s);
+        if (ret == C_KZG_OK && !*ok && invalid_out != NULL) {
+            invalid_out[0] = 0;
+            *num_invalid_out = 1;
+        }
+        return ret;
     }
 
     /* We will need a bunch of arrays to store our objects... */
@@ -815,7 +1169,15 @@ C_KZG_RET verify_blob_kzg_proof_batch(
     }
 
     ret = verify_kzg_proof_batch(
-        ok, commitments_g1, evaluation_challenges_fr, ys_fr, proofs_g1, n, s
+        ok,
+        invalid_out,
+        num_invalid_out,
+        commitments_g1,
+        evaluation_challenges_fr,
+        ys_fr,
+        proofs_g1,
+        n,
+        s
     );
 
 out:
@@ -826,3 +1188,482 @@ out:
     c_kzg_free(poly);
     return ret;
 }
+
+/**
+ * Given a list of blobs and blob KZG proofs, verify that they correspond to the provided
+ * commitments.
+ *
+ * @param[out]  ok                  True if the proofs are valid, otherwise false
+ * @param[in]   blobs               Array of blobs to verify
+ * @param[in]   commitments_bytes   Array of commitments to verify
+ * @param[in]   proofs_bytes        Array of proofs used for verification
+ * @param[in]   n                   The number of blobs/commitments/proofs
+ * @param[in]   s                   The trusted setup
+ *
+ * @remark This function accepts if called with `n==0`.
+ * @remark This function assumes that `n` is trusted and that all input arrays contain `n` elements.
+ * `n` should be the actual size of the arrays and not read off a length field in the protocol.
+ */
+C_KZG_RET verify_blob_kzg_proof_batch(
+    bool *ok,
+    const Blob *blobs,
+    const Bytes48 *commitments_bytes,
+    const Bytes48 *proofs_bytes,
+    uint64_t n,
+    const KZGSettings *s
+) {
+    return verify_blob_kzg_proof_batch_impl(
+        ok, NULL, NULL, blobs, commitments_bytes, proofs_bytes, n, s
+    );
+}
+
+/**
+ * Same as verify_blob_kzg_proof_batch(), but if the batch fails, also find which proofs are
+ * invalid.
+ *
+ * @param[out]  ok                  True if the proofs are valid, otherwise false
+ * @param[out]  invalid_out         The indices of the invalid proofs, in order, length up to `n`
+ * @param[out]  num_invalid_out     The number of invalid proofs
+ * @param[in]   blobs               Array of blobs to verify
+ * @param[in]   commitments_bytes   Array of commitments to verify
+ * @param[in]   proofs_bytes        Array of proofs used for verification
+ * @param[in]   n                   The number of blobs/commitments/proofs
+ * @param[in]   s                   The trusted setup
+ *
+ * @remark The invalid proofs are found by bisection, which reuses the decoded points, challenges
+ * and evaluations. With a few invalid proofs, this takes a number of pairings which is
+ * logarithmic in `n`.
+ * @remark Like verify_blob_kzg_proof_batch(), this returns C_KZG_BADARGS if any input cannot be
+ * decoded, rather than reporting it as invalid.
+ */
+C_KZG_RET verify_blob_kzg_proof_batch_locate(
+    bool *ok,
+    uint64_t *invalid_out,
+    uint64_t *num_invalid_out,
+    const Blob *blobs,
+    const Bytes48 *commitments_bytes,
+    const Bytes48 *proofs_bytes,
+    uint64_t n,
+    const KZGSettings *s
+) {
+    return verify_blob_kzg_proof_batch_impl(
+        ok, invalid_out, num_invalid_out, blobs, commitments_bytes, proofs_bytes, n, s
+    );
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Polynomial Handles
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Parse a blob once, for calls which compute several things from the same blob.
+ *
+ * @param[out]  out     The parsed polynomial
+ * @param[in]   blob    The blob to parse
+ *
+ * @remark Free afterwards with free_kzg_polynomial().
+ * @remark The monomial form, which the cell functions need, is computed by the first call that
+ * needs it. This is safe to share between threads.
+ */
+C_KZG_RET new_kzg_polynomial(KZGPolynomial **out, const Blob *blob) {
+    C_KZG_RET ret;
+    KZGPolynomial *poly = NULL;
+
+    ret = c_kzg_malloc((void **)&poly, sizeof(KZGPolynomial));
+    if (ret != C_KZG_OK) goto out;
+    poly->monomial = NULL;
+
+    memcpy(&poly->blob, blob, sizeof(Blob));
+    ret = blob_to_polynomial(poly->evaluations, blob);
+    if (ret != C_KZG_OK) goto out;
+
+    *out = poly;
+    poly = NULL;
+
+out:
+    free_kzg_polynomial(&poly);
+    return ret;
+}
+
+/**
+ * Free a parsed polynomial.
+ *
+ * @param[in,out]   poly    The polynomial to free, set to NULL
+ *
+ * @remark This does nothing if `*poly` is NULL.
+ */
+void free_kzg_polynomial(KZGPolynomial **poly) {
+    KZGPolynomial *p = *poly;
+    if (p == NULL) return;
+    *poly = NULL;
+    c_kzg_free(p->monomial);
+    c_kzg_free(p);
+}
+
+/**
+ * Same as blob_to_kzg_commitment(), but for a parsed blob.
+ *
+ * @param[out]  out     The resulting commitment
+ * @param[in]   poly    The parsed blob
+ * @param[in]   s       The trusted setup
+ */
+C_KZG_RET blob_to_kzg_commitment_poly(
+    KZGCommitment *out, const KZGPolynomial *poly, const KZGSettings *s
+) {
+    C_KZG_RET ret;
+    g1_t commitment;
+
+    ret = get_prover_settings(&s, s, false);
+    if (ret != C_KZG_OK) return ret;
+    ret = poly_to_kzg_commitment(&commitment, poly->evaluations, s);
+    if (ret != C_KZG_OK) return ret;
+    bytes_from_g1(out, &commitment);
+    return C_KZG_OK;
+}
+
+/**
+ * Same as compute_kzg_proof(), but for a parsed blob.
+ *
+ * @param[out]  proof_out   The combined proof as a single G1 element
+ * @param[out]  y_out       The evaluation of the polynomial at the evaluation point z
+ * @param[in]   poly        The parsed blob
+ * @param[in]   z_bytes     The evaluation point
+ * @param[in]   s           The trusted setup
+ */
+C_KZG_RET compute_kzg_proof_poly(
+    KZGProof *proof_out,
+    Bytes32 *y_out,
+    const KZGPolynomial *poly,
+    const Bytes32 *z_bytes,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+    fr_t frz, fry;
+
+    ret = get_prover_settings(&s, s, false);
+    if (ret != C_KZG_OK) return ret;
+    ret = bytes_to_bls_field(&frz, z_bytes);
+    if (ret != C_KZG_OK) return ret;
+    ret = compute_kzg_proof_impl(proof_out, &fry, poly->evaluations, &frz, s);
+    if (ret != C_KZG_OK) return ret;
+    bytes_from_bls_field(y_out, &fry);
+    return C_KZG_OK;
+}
+
+/**
+ * Same as compute_blob_kzg_proof(), but for a parsed blob.
+ *
+ * @param[out]  out                 The resulting proof
+ * @param[in]   poly                The parsed blob
+ * @param[in]   commitment_bytes    Commitment to the blob
+ * @param[in]   s                   The trusted setup
+ */
+C_KZG_RET compute_blob_kzg_proof_poly(
+    KZGProof *out,
+    const KZGPolynomial *poly,
+    const Bytes48 *commitment_bytes,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+    g1_t commitment_g1;
+    fr_t evaluation_challenge_fr;
+    fr_t y;
+
+    ret = get_prover_settings(&s, s, false);
+    if (ret != C_KZG_OK) return ret;
+    ret = bytes_to_kzg_commitment(&commitment_g1, commitment_bytes);
+    if (ret != C_KZG_OK) return ret;
+
+    compute_challenge(&evaluation_challenge_fr, &poly->blob, &commitment_g1);
+    return compute_kzg_proof_impl(out, &y, poly->evaluations, &evaluation_challenge_fr, s);
+}
+
+/**
+ * Same as compute_kzg_proofs_multi(), but for a parsed blob.
+ *
+ * @param[out]  proofs_out  The proofs, length `n`
+ * @param[out]  ys_out      The evaluations of the polynomial at the points, length `n`
+ * @param[in]   poly        The parsed blob
+ * @param[in]   zs_bytes    The evaluation points, length `n`
+ * @param[in]   n           The number of evaluation points
+ * @param[in]   s           The trusted setup
+ */
+C_KZG_RET compute_kzg_proofs_multi_poly(
+    KZGProof *proofs_out,
+    Bytes32 *ys_out,
+    const KZGPolynomial *poly,
+    const Bytes32 *zs_bytes,
+    uint64_t n,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+
+    ret = get_prover_settings(&s, s, false);
+    if (ret != C_KZG_OK) return ret;
+    return compute_kzg_proofs_multi_impl(proofs_out, ys_out, poly->evaluations, zs_bytes, n, s);
+}
+
+/**
+ * Compute the commitment to a parsed blob and the blob proof for it together.
+ *
+ * This gives the same results as blob_to_kzg_commitment_poly() followed by
+ * compute_blob_kzg_proof_poly(), but the challenge is computed from the commitment in G1 rather
+ * than from its bytes, which saves decompressing and checking it.
+ *
+ * The quotient is computed from the monomial form, which the cells need anyway. Dividing by
+ * `x - z` is then one pass of synthetic division, rather than the inversion of every `ω_i - z`
+ * and the evaluation of the polynomial at `z` which the Lagrange form needs. The remainder of the
+ * division is `p(z)`, which the blob proof does not need.
+ *
+ * @param[out]  commitment_out  The commitment to the blob
+ * @param[out]  proof_out       The blob proof, for the commitment
+ * @param[in]   poly            The parsed blob
+ * @param[in]   monomial        The polynomial in monomial form, FIELD_ELEMENTS_PER_BLOB
+ *                              coefficients
+ * @param[in]   s               The trusted setup
+ */
+C_KZG_RET compute_commitment_and_blob_proof(
+    KZGCommitment *commitment_out,
+    KZGProof *proof_out,
+    const KZGPolynomial *poly,
+    const fr_t *monomial,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+    fr_t *q = NULL;
+    g1_t commitment_g1, proof_g1;
+    fr_t z, acc;
+
+    /* A verification profile only has the first FIELD_ELEMENTS_PER_CELL monomial points */
+    ret = get_prover_settings(&s, s, true);
+    if (ret != C_KZG_OK) goto out;
+    ret = poly_to_kzg_commitment(&commitment_g1, poly->evaluations, s);
+    if (ret != C_KZG_OK) goto out;
+    bytes_from_g1(commitment_out, &commitment_g1);
+
+    compute_challenge(&z, &poly->blob, &commitment_g1);
+
+    /* Divide from the top down: q[i] = p[i + 1] + z * q[i + 1] */
+    ret = new_fr_array(&q, FIELD_ELEMENTS_PER_BLOB - 1);
+    if (ret != C_KZG_OK) goto out;
+    acc = monomial[FIELD_ELEMENTS_PER_BLOB - 1];
+    for (size_t i = FIELD_ELEMENTS_PER_BLOB - 1; i-- > 0;) {
+        q[i] = acc;
+        blst_fr_mul(&acc, &acc, &z);
+        blst_fr_add(&acc, &acc, &monomial[i]);
+    }
+
+    ret = g1_lincomb_fast(&proof_g1, s->g1_values_monomial, q, FIELD_ELEMENTS_PER_BLOB - 1, s);
+    if (ret != C_KZG_OK) goto out;
+    bytes_from_g1(proof_out, &proof_g1);
+
+out:
+    c_kzg_free(q);
+    return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Context Variants
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Same as blob_to_kzg_commitment(), but takes the temporaries from a context.
+ *
+ * @param[in,out]   ctx     The scratch context for this thread
+ */
+C_KZG_RET blob_to_kzg_commitment_ctx(
+    KZGContext *ctx, KZGCommitment *out, const Blob *blob, const KZGSettings *s
+) {
+    C_KZG_RET ret;
+
+    ret = enter_kzg_context(ctx);
+    if (ret != C_KZG_OK) return ret;
+    ret = blob_to_kzg_commitment(out, blob, s);
+    leave_kzg_context(ctx);
+    return ret;
+}
+
+/**
+ * Same as update_kzg_commitment(), but takes the temporaries from a context.
+ *
+ * @param[in,out]   ctx     The scratch context for this thread
+ */
+C_KZG_RET update_kzg_commitment_ctx(
+    KZGContext *ctx,
+    KZGCommitment *out,
+    const Bytes48 *commitment_bytes,
+    const uint64_t *indices,
+    const Bytes32 *old_fields,
+    const Bytes32 *new_fields,
+    uint64_t n,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+
+    ret = enter_kzg_context(ctx);
+    if (ret != C_KZG_OK) return ret;
+    ret = update_kzg_commitment(out, commitment_bytes, indices, old_fields, new_fields, n, s);
+    leave_kzg_context(ctx);
+    return ret;
+}
+
+/**
+ * Same as compute_kzg_proof(), but takes the temporaries from a context.
+ *
+ * @param[in,out]   ctx     The scratch context for this thread
+ */
+C_KZG_RET compute_kzg_proof_ctx(
+    KZGContext *ctx,
+    KZGProof *proof_out,
+    Bytes32 *y_out,
+    const Blob *blob,
+    const Bytes32 *z_bytes,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+
+    ret = enter_kzg_context(ctx);
+    if (ret != C_KZG_OK) return ret;
+    ret = compute_kzg_proof(proof_out, y_out, blob, z_bytes, s);
+    leave_kzg_context(ctx);
+    return ret;
+}
+
+/**
+ * Same as compute_kzg_proofs_multi(), but takes the temporaries from a context.
+ *
+ * @param[in,out]   ctx     The scratch context for this thread
+ */
+C_KZG_RET compute_kzg_proofs_multi_ctx(
+    KZGContext *ctx,
+    KZGProof *proofs_out,
+    Bytes32 *ys_out,
+    const Blob *blob,
+    const Bytes32 *zs_bytes,
+    uint64_t n,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+
+    ret = enter_kzg_context(ctx);
+    if (ret != C_KZG_OK) return ret;
+    ret = compute_kzg_proofs_multi(proofs_out, ys_out, blob, zs_bytes, n, s);
+    leave_kzg_context(ctx);
+    return ret;
+}
+
+/**
+ * Same as compute_blob_kzg_proof(), but takes the temporaries from a context.
+ *
+ * @param[in,out]   ctx     The scratch context for this thread
+ */
+C_KZG_RET compute_blob_kzg_proof_ctx(
+    KZGContext *ctx,
+    KZGProof *out,
+    const Blob *blob,
+    const Bytes48 *commitment_bytes,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+
+    ret = enter_kzg_context(ctx);
+    if (ret != C_KZG_OK) return ret;
+    ret = compute_blob_kzg_proof(out, blob, commitment_bytes, s);
+    leave_kzg_context(ctx);
+    return ret;
+}
+
+/**
+ * Same as verify_kzg_proof(), but takes the temporaries from a context.
+ *
+ * @param[in,out]   ctx     The scratch context for this thread
+ */
+C_KZG_RET verify_kzg_proof_ctx(
+    KZGContext *ctx,
+    bool *ok,
+    const Bytes48 *commitment_bytes,
+    const Bytes32 *z_bytes,
+    const Bytes32 *y_bytes,
+    const Bytes48 *proof_bytes,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+
+    ret = enter_kzg_context(ctx);
+    if (ret != C_KZG_OK) return ret;
+    ret = verify_kzg_proof(ok, commitment_bytes, z_bytes, y_bytes, proof_bytes, s);
+    leave_kzg_context(ctx);
+    return ret;
+}
+
+/**
+ * Same as verify_blob_kzg_proof(), but takes the temporaries from a context.
+ *
+ * @param[in,out]   ctx     The scratch context for this thread
+ */
+C_KZG_RET verify_blob_kzg_proof_ctx(
+    KZGContext *ctx,
+    bool *ok,
+    const Blob *blob,
+    const Bytes48 *commitment_bytes,
+    const Bytes48 *proof_bytes,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+
+    ret = enter_kzg_context(ctx);
+    if (ret != C_KZG_OK) return ret;
+    ret = verify_blob_kzg_proof(ok, blob, commitment_bytes, proof_bytes, s);
+    leave_kzg_context(ctx);
+    return ret;
+}
+
+/**
+ * Same as verify_blob_kzg_proof_batch(), but takes the temporaries from a context.
+ *
+ * @param[in,out]   ctx     The scratch context for this thread
+ */
+C_KZG_RET verify_blob_kzg_proof_batch_ctx(
+    KZGContext *ctx,
+    bool *ok,
+    const Blob *blobs,
+    const Bytes48 *commitments_bytes,
+    const Bytes48 *proofs_bytes,
+    uint64_t n,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+
+    ret = enter_kzg_context(ctx);
+    if (ret != C_KZG_OK) return ret;
+    ret = verify_blob_kzg_proof_batch(ok, blobs, commitments_bytes, proofs_bytes, n, s);
+    leave_kzg_context(ctx);
+    return ret;
+}
+
+/**
+ * Same as verify_blob_kzg_proof_batch_locate(), but takes the temporaries from a context.
+ *
+ * @param[in,out]   ctx     The scratch context for this thread
+ */
+C_KZG_RET verify_blob_kzg_proof_batch_locate_ctx(
+    KZGContext *ctx,
+    bool *ok,
+    uint64_t *invalid_out,
+    uint64_t *num_invalid_out,
+    const Blob *blobs,
+    const Bytes48 *commitments_bytes,
+    const Bytes48 *proofs_bytes,
+    uint64_t n,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+
+    ret = enter_kzg_context(ctx);
+    if (ret != C_KZG_OK) return ret;
+    ret = verify_blob_kzg_proof_batch_locate(
+        ok, invalid_out, num_invalid_out, blobs, commitments_bytes, proofs_bytes, n, s
+    );
+    leave_kzg_context(ctx);
+    return ret;
+}
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "common/alloc.h"
 #include "common/bytes.h"
 #include "eip4844/blob.h"
 #include "setup/settings.h"
@@ -30,6 +31,9 @@ typedef Bytes48 KZGCommitment;
 /** A trusted (valid) KZG proof. */
 typedef Bytes48 KZGProof;
 
+/** A blob parsed once so that several calls can share the work, see eip4844/polynomial.h. */
+typedef struct KZGPolynomial KZGPolynomial;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Public Functions
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -40,6 +44,16 @@ extern "C" {
 
 C_KZG_RET blob_to_kzg_commitment(KZGCommitment *out, const Blob *blob, const KZGSettings *s);
 
+C_KZG_RET update_kzg_commitment(
+    KZGCommitment *out,
+    const Bytes48 *commitment_bytes,
+    const uint64_t *indices,
+    const Bytes32 *old_fields,
+    const Bytes32 *new_fields,
+    uint64_t n,
+    const KZGSettings *s
+);
+
 C_KZG_RET compute_kzg_proof(
     KZGProof *proof_out,
     Bytes32 *y_out,
@@ -48,6 +62,15 @@ C_KZG_RET compute_kzg_proof(
     const KZGSettings *s
 );
 
+C_KZG_RET compute_kzg_proofs_multi(
+    KZGProof *proofs_out,
+    Bytes32 *ys_out,
+    const Blob *blob,
+    const Bytes32 *zs_bytes,
+    uint64_t n,
+    const KZGSettings *s
+);
+
 C_KZG_RET compute_blob_kzg_proof(
     KZGProof *out, const Blob *blob, const Bytes48 *commitment_bytes, const KZGSettings *s
 );
@@ -78,6 +101,131 @@ C_KZG_RET verify_blob_kzg_proof_batch(
     const KZGSettings *s
 );
 
+C_KZG_RET verify_blob_kzg_proof_batch_locate(
+    bool *ok,
+    uint64_t *invalid_out,
+    uint64_t *num_invalid_out,
+    const Blob *blobs,
+    const Bytes48 *commitments_bytes,
+    const Bytes48 *proofs_bytes,
+    uint64_t n,
+    const KZGSettings *s
+);
+
+C_KZG_RET blob_to_kzg_commitment_ctx(
+    KZGContext *ctx, KZGCommitment *out, const Blob *blob, const KZGSettings *s
+);
+
+C_KZG_RET update_kzg_commitment_ctx(
+    KZGContext *ctx,
+    KZGCommitment *out,
+    const Bytes48 *commitment_bytes,
+    const uint64_t *indices,
+    const Bytes32 *old_fields,
+    const Bytes32 *new_fields,
+    uint64_t n,
+    const KZGSettings *s
+);
+
+C_KZG_RET compute_kzg_proof_ctx(
+    KZGContext *ctx,
+    KZGProof *proof_out,
+    Bytes32 *y_out,
+    const Blob *blob,
+    const Bytes32 *z_bytes,
+    const KZGSettings *s
+);
+
+C_KZG_RET compute_kzg_proofs_multi_ctx(
+    KZGContext *ctx,
+    KZGProof *proofs_out,
+    Bytes32 *ys_out,
+    const Blob *blob,
+    const Bytes32 *zs_bytes,
+    uint64_t n,
+    const KZGSettings *s
+);
+
+C_KZG_RET compute_blob_kzg_proof_ctx(
+    KZGContext *ctx,
+    KZGProof *out,
+    const Blob *blob,
+    const Bytes48 *commitment_bytes,
+    const KZGSettings *s
+);
+
+C_KZG_RET verify_kzg_proof_ctx(
+    KZGContext *ctx,
+    bool *ok,
+    const Bytes48 *commitment_bytes,
+    const Bytes32 *z_bytes,
+    const Bytes32 *y_bytes,
+    const Bytes48 *proof_bytes,
+    const KZGSettings *s
+);
+
+C_KZG_RET verify_blob_kzg_proof_ctx(
+    KZGContext *ctx,
+    bool *ok,
+    const Blob *blob,
+    const Bytes48 *commitment_bytes,
+    const Bytes48 *proof_bytes,
+    const KZGSettings *s
+);
+
+C_KZG_RET verify_blob_kzg_proof_batch_ctx(
+    KZGContext *ctx,
+    bool *ok,
+    const Blob *blobs,
+    const Bytes48 *commitments_bytes,
+    const Bytes48 *proofs_bytes,
+    uint64_t n,
+    const KZGSettings *s
+);
+
+C_KZG_RET verify_blob_kzg_proof_batch_locate_ctx(
+    KZGContext *ctx,
+    bool *ok,
+    uint64_t *invalid_out,
+    uint64_t *num_invalid_out,
+    const Blob *blobs,
+    const Bytes48 *commitments_bytes,
+    const Bytes48 *proofs_bytes,
+    uint64_t n,
+    const KZGSettings *s
+);
+
+C_KZG_RET new_kzg_polynomial(KZGPolynomial **out, const Blob *blob);
+void free_kzg_polynomial(KZGPolynomial **poly);
+
+C_KZG_RET blob_to_kzg_commitment_poly(
+    KZGCommitment *out, const KZGPolynomial *poly, const KZGSettings *s
+);
+
+C_KZG_RET compute_kzg_proof_poly(
+    KZGProof *proof_out,
+    Bytes32 *y_out,
+    const KZGPolynomial *poly,
+    const Bytes32 *z_bytes,
+    const KZGSettings *s
+);
+
+C_KZG_RET compute_blob_kzg_proof_poly(
+    KZGProof *out,
+    const KZGPolynomial *poly,
+    const Bytes48 *commitment_bytes,
+    const KZGSettings *s
+);
+
+C_KZG_RET compute_kzg_proofs_multi_poly(
+    KZGProof *proofs_out,
+    Bytes32 *ys_out,
+    const KZGPolynomial *poly,
+    const Bytes32 *zs_bytes,
+    uint64_t n,
+    const KZGSettings *s
+);
+
 #ifdef __cplusplus
 }
 #endif
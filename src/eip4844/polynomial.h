@@ -0,0 +1,60 @@
+/*
+ * Copyright 2024 Benjamin Edgington
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "common/fr.h"
+#include "common/ret.h"
+#include "eip4844/blob.h"
+#include "eip4844/eip4844.h"
+#include "setup/settings.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Types
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** A blob which has been parsed once, so that several calls can share the work. */
+struct KZGPolynomial {
+    /** A copy of the blob, which the Fiat-Shamir challenge hashes. */
+    Blob blob;
+    /** The polynomial in Lagrange form, in bit-reversed order. */
+    fr_t evaluations[FIELD_ELEMENTS_PER_BLOB];
+    /**
+     * The polynomial in monomial form, FIELD_ELEMENTS_PER_EXT_BLOB coefficients of which the upper
+     * half is zero. This is NULL until a call needs it, see get_poly_monomial().
+     */
+    fr_t *monomial;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Internal Functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+C_KZG_RET compute_commitment_and_blob_proof(
+    KZGCommitment *commitment_out,
+    KZGProof *proof_out,
+    const KZGPolynomial *poly,
+    const fr_t *monomial,
+    const KZGSettings *s
+);
+
+#ifdef __cplusplus
+}
+#endif
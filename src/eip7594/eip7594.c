@@ -19,10 +19,12 @@
 #include "common/fr.h"
 #include "common/lincomb.h"
 #include "common/utils.h"
+#include "eip4844/polynomial.h"
 #include "eip7594/fft.h"
 #include "eip7594/fk20.h"
 #include "eip7594/poly.h"
 #include "eip7594/recovery.h"
+#include "setup/prover.h"
 
 #include <assert.h> /* For assert */
 #include <string.h> /* For memcpy & strlen */
@@ -34,6 +36,93 @@
 /** Length of the domain string. */
 #define DOMAIN_STR_LENGTH 16
 
+/**
+ * The most blobs that compute_cells_and_kzg_proofs_batch() gives to the FK20 kernel at once. This
+ * bounds the scratch memory, which is about 600 KiB per blob.
+ */
+#define BLOBS_PER_FK20_GROUP 16
+
+/**
+ * The most cells that compute_cells_for_indices() evaluates one coset at a time. For more, one
+ * FFT over the whole extended domain is faster.
+ */
+#define MAX_CELLS_FOR_COSET_FFT 20
+
+/**
+ * The most cells that compute_cell_kzg_proofs_for_indices() computes proofs for one quotient at a
+ * time. For more, FK20 for all of the cells is faster.
+ */
+#define MAX_CELLS_FOR_DIRECT_PROOFS 4
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Types
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** The two sides of the pairing check for a range of a batch of cell proofs. */
+typedef struct {
+    /** The first cell of the range. */
+    size_t lo;
+    /** One past the last cell of the range. */
+    size_t hi;
+    /** The side which is paired with G2. */
+    g1_t lhs;
+    /** The side which is paired with [s^n]. */
+    g1_t proof_lincomb;
+} CellRangeSums;
+
+/** A decoded batch of cell proofs, and the weights to combine them with. */
+typedef struct {
+    /** The unique commitments, owned by the batch. */
+    g1_t *commitments_g1;
+    /** The number of unique commitments. */
+    size_t num_commitments;
+    /** The index of each cell's commitment. */
+    const uint64_t *commitment_indices;
+    /** The indices for the cells. */
+    const uint64_t *cell_indices;
+    /** The decoded cells, owned by the batch. NULL once they are interpolated. */
+    fr_t *cells_fr;
+    /**
+     * The interpolation polynomial of each cell scaled by its power of r, owned by the batch. NULL
+     * until interpolate_cell_proof_batch() is called, which converts the decoded cells in place.
+     */
+    fr_t *interpolation_polys;
+    /** The proofs for the cells, owned by the batch. */
+    g1_t *proofs_g1;
+    /** The powers of r for the whole batch, owned by the batch. */
+    fr_t *r_powers;
+    /** The number of cells. */
+    uint64_t num_cells;
+    /**
+     * The sums of the range checked last at each depth of a bisection, owned by the batch. NULL if
+     * the invalid proofs are not being located.
+     */
+    CellRangeSums *range_sums;
+    /** The trusted setup. */
+    const KZGSettings *s;
+} CellProofBatch;
+
+/**
+ * Cell proofs which have been added to be verified later, with one pairing for all of them.
+ *
+ * Each call to add_to_cell_proof_accumulator() is reduced to the two sides of its own pairing
+ * check, which are hashed into a running digest and then added to the running sums, weighted by a
+ * challenge taken from the digest. The weight of a call depends on what it added, so a later call
+ * cannot be chosen to cancel out an invalid proof from an earlier one.
+ */
+struct CellProofAccumulator {
+    /** The trusted setup. */
+    const KZGSettings *s;
+    /** The weighted sum of the sides of the checks which are paired with G2. */
+    g1_t lhs_sum;
+    /** The weighted sum of the sides of the checks which are paired with [s^n]. */
+    g1_t proof_sum;
+    /** The hash of the domain and all of the sides so far. */
+    Bytes32 digest;
+    /** The number of calls which added cells. */
+    uint64_t num_added;
+};
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Constants
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -41,10 +130,68 @@
 /** The domain separator for verify_cell_kzg_proof_batch's random challenge. */
 static const char *RANDOM_CHALLENGE_DOMAIN_VERIFY_CELL_KZG_PROOF_BATCH = "RCKZGCBATCH__V1_";
 
+/** The domain separator for the challenge which combines the calls to a CellProofAccumulator. */
+static const char *RANDOM_CHALLENGE_DOMAIN_CELL_PROOF_ACCUMULATOR = "RCKZGCACCUM__V1_";
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Compute
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Evaluate a polynomial over the extended domain and write the evaluations out as cells.
+ *
+ * @param[out]  cells       An array of CELLS_PER_EXT_BLOB cells
+ * @param[out]  data_fr     Scratch space for FIELD_ELEMENTS_PER_EXT_BLOB field elements
+ * @param[in]   monomial    The polynomial in monomial form, FIELD_ELEMENTS_PER_EXT_BLOB
+ *                          coefficients
+ * @param[in]   s           The trusted setup
+ */
+static C_KZG_RET monomial_to_cells(
+    Cell *cells, fr_t *data_fr, const fr_t *monomial, const KZGSettings *s
+) {
+    C_KZG_RET ret;
+
+    /* Get the data points via forward transformation */
+    ret = fr_fft(data_fr, monomial, FIELD_ELEMENTS_PER_EXT_BLOB, s);
+    if (ret != C_KZG_OK) return ret;
+
+    /* Bit-reverse the data points */
+    ret = bit_reversal_permutation(data_fr, sizeof(fr_t), FIELD_ELEMENTS_PER_EXT_BLOB);
+    if (ret != C_KZG_OK) return ret;
+
+    /* Convert all of the cells to byte-form */
+    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+        for (size_t j = 0; j < FIELD_ELEMENTS_PER_CELL; j++) {
+            size_t index = i * FIELD_ELEMENTS_PER_CELL + j;
+            size_t offset = j * BYTES_PER_FIELD_ELEMENT;
+            bytes_from_bls_field((Bytes32 *)&cells[i].bytes[offset], &data_fr[index]);
+        }
+    }
+
+    return C_KZG_OK;
+}
+
+/**
+ * Put the proofs of one blob, as computed by FK20, in order and convert them to bytes.
+ *
+ * @param[out]      proofs      An array of CELLS_PER_EXT_BLOB proofs
+ * @param[in,out]   proofs_g1   The CELLS_PER_EXT_BLOB proofs from FK20, which are reordered
+ */
+static C_KZG_RET proofs_from_g1(KZGProof *proofs, g1_t *proofs_g1) {
+    C_KZG_RET ret;
+
+    /* Bit-reverse the proofs */
+    ret = bit_reversal_permutation(proofs_g1, sizeof(g1_t), CELLS_PER_EXT_BLOB);
+    if (ret != C_KZG_OK) return ret;
+
+    /* Convert all of the proofs to byte-form */
+    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+        bytes_from_g1(&proofs[i], &proofs_g1[i]);
+    }
+
+    return C_KZG_OK;
+}
+
 /**
  * Given a blob, compute all of its cells and proofs.
  *
@@ -60,80 +207,116 @@ static const char *RANDOM_CHALLENGE_DOMAIN_VERIFY_CELL_KZG_PROOF_BATCH = "RCKZGC
 C_KZG_RET compute_cells_and_kzg_proofs(
     Cell *cells, KZGProof *proofs, const Blob *blob, const KZGSettings *s
 ) {
-    C_KZG_RET ret;
+    return compute_cells_and_kzg_proofs_batch(cells, proofs, blob, 1, s);
+}
+
+/**
+ * Given several blobs, compute all of their cells and proofs.
+ *
+ * This gives the same results as calling compute_cells_and_kzg_proofs() for each blob, but is
+ * faster for more than one blob. The proofs for a group of blobs are computed together, so that
+ * each of the FK20 tables (or bases) is read from memory once per group rather than once per blob.
+ *
+ * @param[out]  cells       An array of `num_blobs * CELLS_PER_EXT_BLOB` cells
+ * @param[out]  proofs      An array of `num_blobs * CELLS_PER_EXT_BLOB` proofs
+ * @param[in]   blobs       The blobs to get cells/proofs for
+ * @param[in]   num_blobs   The number of blobs
+ * @param[in]   s           The trusted setup
+ *
+ * @remark If cells is NULL, they won't be computed.
+ * @remark If proofs is NULL, they won't be computed.
+ * @remark Will return an error if both cells & proofs are NULL.
+ * @remark The cells/proofs for blob `i` start at index `i * CELLS_PER_EXT_BLOB`.
+ */
+C_KZG_RET compute_cells_and_kzg_proofs_batch(
+    Cell *cells, KZGProof *proofs, const Blob *blobs, uint64_t num_blobs, const KZGSettings *s
+) {
+    C_KZG_RET ret = C_KZG_OK;
     fr_t *poly_monomial = NULL;
     fr_t *poly_lagrange = NULL;
     fr_t *data_fr = NULL;
     g1_t *proofs_g1 = NULL;
+    const fr_t *polys[BLOBS_PER_FK20_GROUP];
+    size_t group_size;
 
     /* If both of these are null, something is wrong */
     if (cells == NULL && proofs == NULL) {
         return C_KZG_BADARGS;
     }
 
+    /* Nothing to do */
+    if (num_blobs == 0) return C_KZG_OK;
+
+    /* The proofs need the FK20 columns, which a verification profile loads on first use */
+    if (proofs != NULL) {
+        ret = get_prover_settings(&s, s, true);
+        if (ret != C_KZG_OK) return ret;
+    }
+
+    /* Only allocate as much as the largest group needs */
+    group_size = num_blobs < BLOBS_PER_FK20_GROUP ? (size_t)num_blobs : BLOBS_PER_FK20_GROUP;
+
     /* Allocate space fr-form arrays */
-    ret = new_fr_array(&poly_monomial, FIELD_ELEMENTS_PER_EXT_BLOB);
+    ret = new_fr_array(&poly_monomial, group_size * FIELD_ELEMENTS_PER_EXT_BLOB);
     if (ret != C_KZG_OK) goto out;
     ret = new_fr_array(&poly_lagrange, FIELD_ELEMENTS_PER_EXT_BLOB);
     if (ret != C_KZG_OK) goto out;
-
-    /*
-     * Convert the blob to a polynomial in lagrange form. Note that only the first 4096 fields of
-     * the polynomial will be set. The upper 4096 fields will remain zero. The extra space is
-     * required because the polynomial will be evaluated to the extended domain (8192 roots of
-     * unity).
-     */
-    ret = blob_to_polynomial(poly_lagrange, blob);
-    if (ret != C_KZG_OK) goto out;
-
-    /* We need the polynomial to be in monomial form */
-    ret = poly_lagrange_to_monomial(poly_monomial, poly_lagrange, FIELD_ELEMENTS_PER_BLOB, s);
-    if (ret != C_KZG_OK) goto out;
-
-    /* Ensure that only the first FIELD_ELEMENTS_PER_BLOB elements can be non-zero */
-    for (size_t i = FIELD_ELEMENTS_PER_BLOB; i < FIELD_ELEMENTS_PER_EXT_BLOB; i++) {
-        assert(fr_equal(&poly_monomial[i], &FR_ZERO));
-    }
-
     if (cells != NULL) {
         /* Allocate space for our data points */
         ret = new_fr_array(&data_fr, FIELD_ELEMENTS_PER_EXT_BLOB);
         if (ret != C_KZG_OK) goto out;
-
-        /* Get the data points via forward transformation */
-        ret = fr_fft(data_fr, poly_monomial, FIELD_ELEMENTS_PER_EXT_BLOB, s);
-        if (ret != C_KZG_OK) goto out;
-
-        /* Bit-reverse the data points */
-        ret = bit_reversal_permutation(data_fr, sizeof(fr_t), FIELD_ELEMENTS_PER_EXT_BLOB);
-        if (ret != C_KZG_OK) goto out;
-
-        /* Convert all of the cells to byte-form */
-        for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
-            for (size_t j = 0; j < FIELD_ELEMENTS_PER_CELL; j++) {
-                size_t index = i * FIELD_ELEMENTS_PER_CELL + j;
-                size_t offset = j * BYTES_PER_FIELD_ELEMENT;
-                bytes_from_bls_field((Bytes32 *)&cells[i].bytes[offset], &data_fr[index]);
-            }
-        }
     }
-
     if (proofs != NULL) {
         /* Allocate space for our proofs in g1-form */
-        ret = new_g1_array(&proofs_g1, CELLS_PER_EXT_BLOB);
+        ret = new_g1_array(&proofs_g1, group_size * CELLS_PER_EXT_BLOB);
         if (ret != C_KZG_OK) goto out;
+    }
 
-        /* Compute the proofs, only uses the first half of the polynomial */
-        ret = compute_fk20_cell_proofs(proofs_g1, poly_monomial, s);
-        if (ret != C_KZG_OK) goto out;
+    for (uint64_t first = 0; first < num_blobs; first += group_size) {
+        size_t count = (size_t)(num_blobs - first) < group_size ? (size_t)(num_blobs - first)
+                                                                : group_size;
 
-        /* Bit-reverse the proofs */
-        ret = bit_reversal_permutation(proofs_g1, sizeof(g1_t), CELLS_PER_EXT_BLOB);
-        if (ret != C_KZG_OK) goto out;
+        for (size_t b = 0; b < count; b++) {
+            uint64_t blob_index = first + b;
+            fr_t *monomial = &poly_monomial[b * FIELD_ELEMENTS_PER_EXT_BLOB];
+            polys[b] = monomial;
 
-        /* Convert all of the proofs to byte-form */
-        for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
-            bytes_from_g1(&proofs[i], &proofs_g1[i]);
+            /*
+             * Convert the blob to a polynomial in lagrange form. Note that only the first 4096
+             * fields of the polynomial will be set. The upper 4096 fields will remain zero. The
+             * extra space is required because the polynomial will be evaluated to the extended
+             * domain (8192 roots of unity).
+             */
+            ret = blob_to_polynomial(poly_lagrange, &blobs[blob_index]);
+            if (ret != C_KZG_OK) goto out;
+
+            /* We need the polynomial to be in monomial form */
+            ret = poly_lagrange_to_monomial(monomial, poly_lagrange, FIELD_ELEMENTS_PER_BLOB, s);
+            if (ret != C_KZG_OK) goto out;
+
+            /* Ensure that only the first FIELD_ELEMENTS_PER_BLOB elements can be non-zero */
+            for (size_t i = FIELD_ELEMENTS_PER_BLOB; i < FIELD_ELEMENTS_PER_EXT_BLOB; i++) {
+                assert(fr_equal(&monomial[i], &FR_ZERO));
+            }
+
+            if (cells != NULL) {
+                Cell *blob_cells = &cells[blob_index * CELLS_PER_EXT_BLOB];
+                ret = monomial_to_cells(blob_cells, data_fr, monomial, s);
+                if (ret != C_KZG_OK) goto out;
+            }
+        }
+
+        if (proofs != NULL) {
+            /* Compute the proofs for the group, only uses the first half of each polynomial */
+            ret = compute_fk20_cell_proofs_multi(proofs_g1, polys, count, s);
+            if (ret != C_KZG_OK) goto out;
+
+            for (size_t b = 0; b < count; b++) {
+                ret = proofs_from_g1(
+                    &proofs[(first + b) * CELLS_PER_EXT_BLOB], &proofs_g1[b * CELLS_PER_EXT_BLOB]
+                );
+                if (ret != C_KZG_OK) goto out;
+            }
         }
     }
 
@@ -145,681 +328,1765 @@ out:
     return ret;
 }
 
-////////////////////////////////////////////////////////////////////////////////////////////////////
-// Recover
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
 /**
- * Given some cells for a blob, recover all cells/proofs.
+ * Same as compute_cells_and_kzg_proofs(), but for a parsed blob.
  *
- * @param[out]  recovered_cells     An array of CELLS_PER_EXT_BLOB cells
- * @param[out]  recovered_proofs    An array of CELLS_PER_EXT_BLOB proofs
- * @param[in]   cell_indices        The cell indices for the available cells, length `num_cells`
- * @param[in]   cells               The available cells we recover from, length `num_cells`
- * @param[in]   num_cells           The number of available cells provided
- * @param[in]   s                   The trusted setup
+ * @param[out]      cells   An array of CELLS_PER_EXT_BLOB cells
+ * @param[out]      proofs  An array of CELLS_PER_EXT_BLOB proofs
+ * @param[in,out]   poly    The parsed blob, which keeps its monomial form for later calls
+ * @param[in]       s       The trusted setup
  *
- * @remark At least CELLS_PER_BLOB cells must be provided.
- * @remark Recovery is faster if there are fewer missing cells.
- * @remark If recovered_proofs is NULL, they will not be recomputed.
+ * @remark If cells is NULL, they won't be computed.
+ * @remark If proofs is NULL, they won't be computed.
+ * @remark Will return an error if both cells & proofs are NULL.
  */
-C_KZG_RET recover_cells_and_kzg_proofs(
-    Cell *recovered_cells,
-    KZGProof *recovered_proofs,
-    const uint64_t *cell_indices,
-    const Cell *cells,
-    uint64_t num_cells,
-    const KZGSettings *s
+C_KZG_RET compute_cells_and_kzg_proofs_poly(
+    Cell *cells, KZGProof *proofs, KZGPolynomial *poly, const KZGSettings *s
 ) {
     C_KZG_RET ret;
-    fr_t *recovered_cells_fr = NULL;
-    g1_t *recovered_proofs_g1 = NULL;
-
-    /* Ensure only one blob's worth of cells was provided */
-    if (num_cells > CELLS_PER_EXT_BLOB) {
-        ret = C_KZG_BADARGS;
-        goto out;
-    }
+    const fr_t *monomial;
+    fr_t *data_fr = NULL;
+    g1_t *proofs_g1 = NULL;
 
-    /* Check if it's possible to recover */
-    if (num_cells < CELLS_PER_BLOB) {
-        ret = C_KZG_BADARGS;
-        goto out;
+    /* If both of these are null, something is wrong */
+    if (cells == NULL && proofs == NULL) {
+        return C_KZG_BADARGS;
     }
 
-    /* Check that cell indices are valid */
-    for (size_t i = 0; i < num_cells; i++) {
-        if (cell_indices[i] >= CELLS_PER_EXT_BLOB) {
-            ret = C_KZG_BADARGS;
-            goto out;
-        }
+    /* The proofs need the FK20 columns, which a verification profile loads on first use */
+    if (proofs != NULL) {
+        ret = get_prover_settings(&s, s, true);
+        if (ret != C_KZG_OK) return ret;
     }
 
-    /* Do allocations */
-    ret = new_fr_array(&recovered_cells_fr, FIELD_ELEMENTS_PER_EXT_BLOB);
-    if (ret != C_KZG_OK) goto out;
-    ret = new_g1_array(&recovered_proofs_g1, CELLS_PER_EXT_BLOB);
+    ret = get_poly_monomial(&monomial, poly, s);
     if (ret != C_KZG_OK) goto out;
 
-    /* Initialize all cells as missing */
-    for (size_t i = 0; i < FIELD_ELEMENTS_PER_EXT_BLOB; i++) {
-        recovered_cells_fr[i] = FR_NULL;
-    }
-
-    /* Populate recovered_cells_fr with available cells at the right places */
-    for (size_t i = 0; i < num_cells; i++) {
-        size_t index = cell_indices[i] * FIELD_ELEMENTS_PER_CELL;
-        for (size_t j = 0; j < FIELD_ELEMENTS_PER_CELL; j++) {
-            fr_t *ptr = &recovered_cells_fr[index + j];
-
-            /*
-             * Check if the field has already been set. If it has, there was a duplicate cell index
-             * and we can return an error. The compiler will optimize this and the overhead is
-             * practically zero.
-             */
-            if (!fr_is_null(ptr)) {
-                ret = C_KZG_BADARGS;
-                goto out;
-            }
-
-            /* Convert the untrusted input bytes to a field element */
-            size_t offset = j * BYTES_PER_FIELD_ELEMENT;
-            ret = bytes_to_bls_field(ptr, (const Bytes32 *)&cells[i].bytes[offset]);
-            if (ret != C_KZG_OK) goto out;
-        }
-    }
-
-    if (num_cells == CELLS_PER_EXT_BLOB) {
-        /* Nothing to recover, copy the cells */
-        memcpy(recovered_cells, cells, CELLS_PER_EXT_BLOB * sizeof(Cell));
-    } else {
-        /* Perform cell recovery */
-        ret = recover_cells(recovered_cells_fr, cell_indices, num_cells, recovered_cells_fr, s);
+    if (cells != NULL) {
+        ret = new_fr_array(&data_fr, FIELD_ELEMENTS_PER_EXT_BLOB);
+        if (ret != C_KZG_OK) goto out;
+        ret = monomial_to_cells(cells, data_fr, monomial, s);
         if (ret != C_KZG_OK) goto out;
-
-        /* Convert the recovered data points to byte-form */
-        for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
-            for (size_t j = 0; j < FIELD_ELEMENTS_PER_CELL; j++) {
-                size_t index = i * FIELD_ELEMENTS_PER_CELL + j;
-                size_t offset = j * BYTES_PER_FIELD_ELEMENT;
-                bytes_from_bls_field(
-                    (Bytes32 *)&recovered_cells[i].bytes[offset], &recovered_cells_fr[index]
-                );
-            }
-        }
     }
 
-    if (recovered_proofs != NULL) {
-        /*
-         * Instead of converting the cells to a blob and back, we can just treat the cells as a
-         * polynomial. We are done with the fr-form recovered cells and we can safely mutate the
-         * array.
-         */
-        ret = poly_lagrange_to_monomial(
-            recovered_cells_fr, recovered_cells_fr, FIELD_ELEMENTS_PER_EXT_BLOB, s
-        );
+    if (proofs != NULL) {
+        ret = new_g1_array(&proofs_g1, CELLS_PER_EXT_BLOB);
         if (ret != C_KZG_OK) goto out;
-
-        /* Compute the proofs, only uses the first half of the polynomial */
-        ret = compute_fk20_cell_proofs(recovered_proofs_g1, recovered_cells_fr, s);
+        ret = compute_fk20_cell_proofs_multi(proofs_g1, &monomial, 1, s);
         if (ret != C_KZG_OK) goto out;
-
-        /* Bit-reverse the proofs */
-        ret = bit_reversal_permutation(recovered_proofs_g1, sizeof(g1_t), CELLS_PER_EXT_BLOB);
+        ret = proofs_from_g1(proofs, proofs_g1);
         if (ret != C_KZG_OK) goto out;
-
-        /* Convert all of the proofs to byte-form */
-        for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
-            bytes_from_g1(&recovered_proofs[i], &recovered_proofs_g1[i]);
-        }
     }
 
 out:
-    c_kzg_free(recovered_cells_fr);
-    c_kzg_free(recovered_proofs_g1);
+    c_kzg_free(data_fr);
+    c_kzg_free(proofs_g1);
     return ret;
 }
 
-////////////////////////////////////////////////////////////////////////////////////////////////////
-// Verify
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
 /**
- * Helper function to compare two commitments.
+ * Compute everything that is published with a blob: its commitment, its blob proof, and all of
+ * its cells and their proofs.
  *
- * @param[in]   a   The first commitment
- * @param[in]   b   The second commitment
+ * This gives the same results as blob_to_kzg_commitment(), compute_blob_kzg_proof() and
+ * compute_cells_and_kzg_proofs(), but the blob is only parsed and converted to monomial form once,
+ * the blob proof uses the commitment without decompressing it, and the blob proof's quotient is
+ * computed from the monomial form.
  *
- * @return True if the commitments are the same, otherwise false.
+ * @param[out]  commitment_out  The commitment to the blob
+ * @param[out]  proof_out       The blob proof, for the commitment
+ * @param[out]  cells           An array of CELLS_PER_EXT_BLOB cells
+ * @param[out]  proofs          An array of CELLS_PER_EXT_BLOB proofs
+ * @param[in]   blob            The blob
+ * @param[in]   s               The trusted setup
  */
-static bool commitments_equal(const Bytes48 *a, const Bytes48 *b) {
-    return memcmp(a->bytes, b->bytes, BYTES_PER_COMMITMENT) == 0;
-}
+C_KZG_RET compute_blob_sidecar(
+    KZGCommitment *commitment_out,
+    KZGProof *proof_out,
+    Cell *cells,
+    KZGProof *proofs,
+    const Blob *blob,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+    KZGPolynomial *poly = NULL;
+    const fr_t *monomial;
 
-/**
- * Helper function to copy one commitment's bytes to another.
- *
- * @param[in]   dst The destination commitment
- * @param[in]   src The source commitment
- */
-static void commitments_copy(Bytes48 *dst, const Bytes48 *src) {
-    memcpy(dst->bytes, src->bytes, BYTES_PER_COMMITMENT);
+    ret = new_kzg_polynomial(&poly, blob);
+    if (ret != C_KZG_OK) goto out;
+    ret = get_poly_monomial(&monomial, poly, s);
+    if (ret != C_KZG_OK) goto out;
+    ret = compute_commitment_and_blob_proof(commitment_out, proof_out, poly, monomial, s);
+    if (ret != C_KZG_OK) goto out;
+    ret = compute_cells_and_kzg_proofs_poly(cells, proofs, poly, s);
+    if (ret != C_KZG_OK) goto out;
+
+out:
+    free_kzg_polynomial(&poly);
+    return ret;
 }
 
 /**
- * Convert a list of commitments with potential duplicates to a list of unique commitments. Also
- * returns a list of indices which point to those new unique commitments.
+ * Evaluate a polynomial over the cosets of some cells only, and write the evaluations out as cells.
  *
- * @param[in,out]   commitments_out Updated to only contain unique commitments
- * @param[out]      indices_out     Used as map between old/new commitments
- * @param[in,out]   count_out       Number of commitments before and after
+ * The evaluations in cell `k` are those at `h_k * w^j`, where `w` is a root of unity of order
+ * FIELD_ELEMENTS_PER_CELL and `j` is in bit-reversed order. As `w^FIELD_ELEMENTS_PER_CELL` is one,
+ * the polynomial folds to FIELD_ELEMENTS_PER_CELL coefficients over each coset, and the cell is a
+ * small FFT of those. For many cells, one FFT over the whole extended domain is cheaper instead.
  *
- * @remark The input arrays are re-used.
- * @remark The number of commitments/indices must be the same.
- * @remark The length of `indices_out` is unchanged.
- * @remark `count_out` is updated to be the number of unique commitments.
+ * @param[out]  cells           An array of `num_cells` cells
+ * @param[in]   monomial        The polynomial in monomial form, FIELD_ELEMENTS_PER_EXT_BLOB
+ *                              coefficients of which the upper half is zero
+ * @param[in]   cell_indices    The indices of the cells, length `num_cells`
+ * @param[in]   num_cells       The number of cells
+ * @param[in]   s               The trusted setup
  */
-static void deduplicate_commitments(
-    Bytes48 *commitments_out, uint64_t *indices_out, size_t *count_out
+static C_KZG_RET monomial_to_cells_for_indices(
+    Cell *cells,
+    const fr_t *monomial,
+    const uint64_t *cell_indices,
+    uint64_t num_cells,
+    const KZGSettings *s
 ) {
-    /* Bail early if there are no commitments */
-    if (*count_out == 0) return;
+    C_KZG_RET ret;
+    fr_t *data_fr = NULL;
+    Cell *all_cells = NULL;
+    fr_t folded[FIELD_ELEMENTS_PER_CELL];
+    fr_t h_k, h_k_pow;
+
+    if (num_cells > MAX_CELLS_FOR_COSET_FFT) {
+        ret = new_fr_array(&data_fr, FIELD_ELEMENTS_PER_EXT_BLOB);
+        if (ret != C_KZG_OK) goto out;
+        ret = c_kzg_malloc((void **)&all_cells, CELLS_PER_EXT_BLOB * sizeof(Cell));
+        if (ret != C_KZG_OK) goto out;
+        ret = monomial_to_cells(all_cells, data_fr, monomial, s);
+        if (ret != C_KZG_OK) goto out;
+        for (uint64_t i = 0; i < num_cells; i++) {
+            cells[i] = all_cells[cell_indices[i]];
+        }
+        goto out;
+    }
 
-    /* The first commitment is always new */
-    indices_out[0] = 0;
-    size_t new_count = 1;
+    ret = new_fr_array(&data_fr, FIELD_ELEMENTS_PER_CELL);
+    if (ret != C_KZG_OK) goto out;
 
-    /* Create list of unique commitments & indices to them */
-    for (size_t i = 1; i < *count_out; i++) {
-        bool exist = false;
-        for (size_t j = 0; j < new_count; j++) {
-            if (commitments_equal(&commitments_out[i], &commitments_out[j])) {
-                /* This commitment already exists */
-                indices_out[i] = j;
-                exist = true;
-                break;
+    for (uint64_t i = 0; i < num_cells; i++) {
+        /* The coset factor h_k, and h_k^n which the folding multiplies by */
+        uint64_t cell_idx_rbl = reverse_bits_limited(CELLS_PER_EXT_BLOB, cell_indices[i]);
+        h_k = s->roots_of_unity[cell_idx_rbl];
+        h_k_pow = s->roots_of_unity[cell_idx_rbl * FIELD_ELEMENTS_PER_CELL];
+
+        /* folded[t] = sum(c[t + n * l] * h_k^(n * l)), by Horner's method over l */
+        for (size_t t = 0; t < FIELD_ELEMENTS_PER_CELL; t++) {
+            folded[t] = FR_ZERO;
+        }
+        for (size_t l = FIELD_ELEMENTS_PER_BLOB / FIELD_ELEMENTS_PER_CELL; l-- > 0;) {
+            const fr_t *coeffs = &monomial[l * FIELD_ELEMENTS_PER_CELL];
+            for (size_t t = 0; t < FIELD_ELEMENTS_PER_CELL; t++) {
+                blst_fr_mul(&folded[t], &folded[t], &h_k_pow);
+                blst_fr_add(&folded[t], &folded[t], &coeffs[t]);
             }
         }
-        if (!exist) {
-            /* This is a new commitment */
-            commitments_copy(&commitments_out[new_count], &commitments_out[i]);
-            indices_out[i] = new_count;
-            new_count++;
+
+        /* Multiply folded[t] by h_k^t, then evaluate over the subgroup */
+        shift_poly(folded, FIELD_ELEMENTS_PER_CELL, &h_k);
+        ret = fr_fft(data_fr, folded, FIELD_ELEMENTS_PER_CELL, s);
+        if (ret != C_KZG_OK) goto out;
+        ret = bit_reversal_permutation(data_fr, sizeof(fr_t), FIELD_ELEMENTS_PER_CELL);
+        if (ret != C_KZG_OK) goto out;
+
+        for (size_t j = 0; j < FIELD_ELEMENTS_PER_CELL; j++) {
+            size_t offset = j * BYTES_PER_FIELD_ELEMENT;
+            bytes_from_bls_field((Bytes32 *)&cells[i].bytes[offset], &data_fr[j]);
         }
     }
 
-    /* Update the count */
-    *count_out = new_count;
+out:
+    c_kzg_free(data_fr);
+    c_kzg_free(all_cells);
+    return ret;
 }
 
 /**
- * Compute random linear combination challenge scalars for verify_cell_kzg_proof_batch. In this, we
- * must hash EVERYTHING that the prover can control.
+ * Same as compute_cells_for_indices(), but for a parsed blob.
  *
- * @param[out]  r_powers_out        The output challenges, length `num_cells`
- * @param[in]   commitments_bytes   The input commitments, length `num_commitments`
- * @param[in]   num_commitments     The number of commitments
- * @param[in]   commitment_indices  The cell commitment indices, length `num_cells`
- * @param[in]   cell_indices        The cell indices, length `num_cells`
- * @param[in]   cells               The cell, length `num_cells`
- * @param[in]   proofs_bytes        The cell proof, length `num_cells`
- * @param[in]   num_cells           The number of cells
+ * @param[out]      cells           An array of `num_cells` cells
+ * @param[in,out]   poly            The parsed blob, which keeps its monomial form for later calls
+ * @param[in]       cell_indices    The indices of the cells to compute, length `num_cells`
+ * @param[in]       num_cells       The number of cells to compute
+ * @param[in]       s               The trusted setup
  */
-static C_KZG_RET compute_r_powers_for_verify_cell_kzg_proof_batch(
-    fr_t *r_powers_out,
-    const Bytes48 *commitments_bytes,
-    size_t num_commitments,
-    const uint64_t *commitment_indices,
+C_KZG_RET compute_cells_for_indices_poly(
+    Cell *cells,
+    KZGPolynomial *poly,
     const uint64_t *cell_indices,
-    const Cell *cells,
-    const Bytes48 *proofs_bytes,
-    uint64_t num_cells
+    uint64_t num_cells,
+    const KZGSettings *s
 ) {
     C_KZG_RET ret;
-    uint8_t *bytes = NULL;
-    Bytes32 r_bytes;
-    fr_t r;
-
-    /* Calculate the size of the data we're going to hash */
-    size_t input_size = DOMAIN_STR_LENGTH                          /* The domain separator */
-                        + sizeof(uint64_t)                         /* FIELD_ELEMENTS_PER_CELL */
-                        + sizeof(uint64_t)                         /* num_commitments */
-                        + sizeof(uint64_t)                         /* num_cells */
-                        + (num_commitments * BYTES_PER_COMMITMENT) /* commitment_bytes */
-                        + (num_cells * sizeof(uint64_t))           /* commitment_indices */
-                        + (num_cells * sizeof(uint64_t))           /* cell_indices */
-                        + (num_cells * BYTES_PER_CELL)             /* cells */
-                        + (num_cells * BYTES_PER_PROOF);           /* proofs_bytes */
-
-    /* Allocate space to copy this data into */
-    ret = c_kzg_malloc((void **)&bytes, input_size);
-    if (ret != C_KZG_OK) goto out;
+    const fr_t *monomial;
 
-    /* Pointer tracking `bytes` for writing on top of it */
-    uint8_t *offset = bytes;
+    for (uint64_t i = 0; i < num_cells; i++) {
+        if (cell_indices[i] >= CELLS_PER_EXT_BLOB) return C_KZG_BADARGS;
+    }
 
-    /* Ensure that the domain string is the correct length */
-    assert(strlen(RANDOM_CHALLENGE_DOMAIN_VERIFY_CELL_KZG_PROOF_BATCH) == DOMAIN_STR_LENGTH);
+    /* Nothing to do */
+    if (num_cells == 0) return C_KZG_OK;
 
-    /* Copy domain separator */
-    memcpy(offset, RANDOM_CHALLENGE_DOMAIN_VERIFY_CELL_KZG_PROOF_BATCH, DOMAIN_STR_LENGTH);
-    offset += DOMAIN_STR_LENGTH;
+    ret = get_poly_monomial(&monomial, poly, s);
+    if (ret != C_KZG_OK) return ret;
+    return monomial_to_cells_for_indices(cells, monomial, cell_indices, num_cells, s);
+}
 
-    /* Copy field elements per cell */
-    bytes_from_uint64(offset, FIELD_ELEMENTS_PER_CELL);
-    offset += sizeof(uint64_t);
+/**
+ * Given a blob, compute some of its cells.
+ *
+ * This gives the same cells as compute_cells_and_kzg_proofs(), at a cost which scales with the
+ * number of cells rather than with the size of the extended blob.
+ *
+ * @param[out]  cells           An array of `num_cells` cells
+ * @param[in]   blob            The blob to get cells for
+ * @param[in]   cell_indices    The indices of the cells to compute, length `num_cells`
+ * @param[in]   num_cells       The number of cells to compute
+ * @param[in]   s               The trusted setup
+ */
+C_KZG_RET compute_cells_for_indices(
+    Cell *cells,
+    const Blob *blob,
+    const uint64_t *cell_indices,
+    uint64_t num_cells,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+    KZGPolynomial *poly = NULL;
 
-    /* Copy number of commitments */
-    bytes_from_uint64(offset, num_commitments);
-    offset += sizeof(uint64_t);
+    ret = new_kzg_polynomial(&poly, blob);
+    if (ret != C_KZG_OK) goto out;
+    ret = compute_cells_for_indices_poly(cells, poly, cell_indices, num_cells, s);
 
-    /* Copy number of cells */
-    bytes_from_uint64(offset, num_cells);
-    offset += sizeof(uint64_t);
+out:
+    free_kzg_polynomial(&poly);
+    return ret;
+}
 
-    for (size_t i = 0; i < num_commitments; i++) {
-        /* Copy commitment */
-        memcpy(offset, &commitments_bytes[i], BYTES_PER_COMMITMENT);
-        offset += BYTES_PER_COMMITMENT;
-    }
+/* Forward function declaration */
+static void get_coset_shift_pow_for_cell(
+    fr_t *coset_factor_out, uint64_t cell_index, const KZGSettings *s
+);
 
-    for (size_t i = 0; i < num_cells; i++) {
-        /* Copy row id */
-        bytes_from_uint64(offset, commitment_indices[i]);
-        offset += sizeof(uint64_t);
+/**
+ * Compute the proofs of some cells of a polynomial directly, with one quotient for each cell.
+ *
+ * The proof for cell `k` is a commitment to the quotient of the polynomial by the vanishing
+ * polynomial of its coset, `x^n - h_k^n`. The division is one pass over the coefficients, and the
+ * quotients share one multi-vector MSM over the monomial points.
+ *
+ * @param[out]  proofs_g1       The proofs, length `num_cells`
+ * @param[in]   monomial        The polynomial in monomial form, FIELD_ELEMENTS_PER_BLOB
+ *                              coefficients
+ * @param[in]   cell_indices    The indices of the cells, length `num_cells`
+ * @param[in]   num_cells       The number of cells
+ * @param[in]   s               The trusted setup
+ */
+static C_KZG_RET compute_cell_proofs_direct(
+    g1_t *proofs_g1,
+    const fr_t *monomial,
+    const uint64_t *cell_indices,
+    uint64_t num_cells,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+    fr_t *quotients = NULL;
+    size_t len = FIELD_ELEMENTS_PER_BLOB - FIELD_ELEMENTS_PER_CELL;
+    fr_t h_k_pow;
 
-        /* Copy column id */
-        bytes_from_uint64(offset, cell_indices[i]);
-        offset += sizeof(uint64_t);
+    ret = new_fr_array(&quotients, num_cells * len);
+    if (ret != C_KZG_OK) goto out;
 
-        /* Copy cell */
-        memcpy(offset, &cells[i], BYTES_PER_CELL);
-        offset += BYTES_PER_CELL;
+    for (uint64_t i = 0; i < num_cells; i++) {
+        fr_t *q = &quotients[i * len];
+        get_coset_shift_pow_for_cell(&h_k_pow, cell_indices[i], s);
 
-        /* Copy proof */
-        memcpy(offset, &proofs_bytes[i], BYTES_PER_PROOF);
-        offset += BYTES_PER_PROOF;
+        /* Divide from the top down: q[j] = p[j + n] + h_k^n * q[j + n] */
+        for (size_t j = len; j-- > 0;) {
+            q[j] = monomial[j + FIELD_ELEMENTS_PER_CELL];
+            if (j + FIELD_ELEMENTS_PER_CELL < len) {
+                fr_t tmp;
+                blst_fr_mul(&tmp, &h_k_pow, &q[j + FIELD_ELEMENTS_PER_CELL]);
+                blst_fr_add(&q[j], &q[j], &tmp);
+            }
+        }
     }
 
-    /* Now let's create the challenge! */
-    blst_sha256(r_bytes.bytes, bytes, input_size);
-    hash_to_bls_field(&r, &r_bytes);
-
-    /* Raise power of r for each cell */
-    compute_powers(r_powers_out, &r, num_cells);
-
-    /* Make sure we wrote the entire buffer */
-    assert(offset == bytes + input_size);
+    ret = g1_lincomb_fast_multi(proofs_g1, s->g1_values_monomial, quotients, len, num_cells, s);
 
 out:
-    c_kzg_free(bytes);
+    c_kzg_free(quotients);
     return ret;
 }
 
 /**
- * Compute the sum of the commitments weighted by the powers of r.
+ * Same as compute_cell_kzg_proofs_for_indices(), but for a parsed blob.
  *
- * @param[out]  sum_of_commitments_out  The resulting G1 sum of the commitments
- * @param[in]   unique_commitments      Array of unique commitments, length `num_commitments`
- * @param[in]   commitment_indices      Indices mapping to unique commitments, length `num_cells`
- * @param[in]   r_powers                Array of powers of r used for weighting, length `num_cells`
- * @param[in]   num_commitments         The number of unique commitments
- * @param[in]   num_cells               The number of cells
+ * @param[out]      proofs          An array of `num_cells` proofs
+ * @param[in,out]   poly            The parsed blob, which keeps its monomial form for later calls
+ * @param[in]       cell_indices    The indices of the cells to compute proofs for, length
+ *                                  `num_cells`
+ * @param[in]       num_cells       The number of proofs to compute
+ * @param[in]       s               The trusted setup
  */
-static C_KZG_RET compute_weighted_sum_of_commitments(
-    g1_t *sum_of_commitments_out,
-    const Bytes48 *unique_commitments,
-    const uint64_t *commitment_indices,
-    const fr_t *r_powers,
-    size_t num_commitments,
-    uint64_t num_cells
+C_KZG_RET compute_cell_kzg_proofs_for_indices_poly(
+    KZGProof *proofs,
+    KZGPolynomial *poly,
+    const uint64_t *cell_indices,
+    uint64_t num_cells,
+    const KZGSettings *s
 ) {
     C_KZG_RET ret;
-    g1_t *commitments_g1 = NULL;
-    fr_t *commitment_weights = NULL;
+    const fr_t *monomial;
+    g1_t *proofs_g1 = NULL;
 
-    ret = new_fr_array(&commitment_weights, num_commitments);
+    for (uint64_t i = 0; i < num_cells; i++) {
+        if (cell_indices[i] >= CELLS_PER_EXT_BLOB) return C_KZG_BADARGS;
+    }
+
+    /* Nothing to do */
+    if (num_cells == 0) return C_KZG_OK;
+
+    /* Both ways need all of the monomial points, which a verification profile loads on first use */
+    ret = get_prover_settings(&s, s, true);
     if (ret != C_KZG_OK) goto out;
-    ret = new_g1_array(&commitments_g1, num_commitments);
+    ret = get_poly_monomial(&monomial, poly, s);
     if (ret != C_KZG_OK) goto out;
 
-    for (size_t i = 0; i < num_commitments; i++) {
-        /* Convert & validate commitment */
-        ret = bytes_to_kzg_commitment(&commitments_g1[i], &unique_commitments[i]);
+    if (num_cells <= MAX_CELLS_FOR_DIRECT_PROOFS) {
+        ret = new_g1_array(&proofs_g1, num_cells);
         if (ret != C_KZG_OK) goto out;
-
-        /* Initialize the weight to zero */
-        commitment_weights[i] = FR_ZERO;
-    }
-
-    /* Update commitment weights */
-    for (uint64_t i = 0; i < num_cells; i++) {
-        blst_fr_add(
-            &commitment_weights[commitment_indices[i]],
-            &commitment_weights[commitment_indices[i]],
-            &r_powers[i]
-        );
+        ret = compute_cell_proofs_direct(proofs_g1, monomial, cell_indices, num_cells, s);
+        if (ret != C_KZG_OK) goto out;
+        for (uint64_t i = 0; i < num_cells; i++) {
+            bytes_from_g1(&proofs[i], &proofs_g1[i]);
+        }
+    } else {
+        /* FK20 gives the proofs in bit-reversed order */
+        ret = new_g1_array(&proofs_g1, CELLS_PER_EXT_BLOB);
+        if (ret != C_KZG_OK) goto out;
+        ret = compute_fk20_cell_proofs_multi(proofs_g1, &monomial, 1, s);
+        if (ret != C_KZG_OK) goto out;
+        for (uint64_t i = 0; i < num_cells; i++) {
+            uint64_t index = reverse_bits_limited(CELLS_PER_EXT_BLOB, cell_indices[i]);
+            bytes_from_g1(&proofs[i], &proofs_g1[index]);
+        }
     }
 
-    /* Compute commitment sum */
-    ret = g1_lincomb_fast(
-        sum_of_commitments_out, commitments_g1, commitment_weights, num_commitments
-    );
-    if (ret != C_KZG_OK) goto out;
-
 out:
-    c_kzg_free(commitment_weights);
-    c_kzg_free(commitments_g1);
+    c_kzg_free(proofs_g1);
     return ret;
 }
 
 /**
- * Compute the inverse coset factor h_k^{-1},
- *  where `h_k` is the coset factor for cell with index `k`.
+ * Given a blob, compute the proofs of some of its cells.
  *
- * @param[out]  inv_coset_factor_out    Pointer to store the computed inverse coset factor
- * @param[in]   cell_index              The index of the cell
- * @param[in]   s                       The trusted setup
+ * This gives the same proofs as compute_cells_and_kzg_proofs(). For a few cells, each proof is
+ * computed directly from its own quotient; for more, FK20 computes all of them at once.
+ *
+ * @param[out]  proofs          An array of `num_cells` proofs
+ * @param[in]   blob            The blob to get proofs for
+ * @param[in]   cell_indices    The indices of the cells to compute proofs for, length `num_cells`
+ * @param[in]   num_cells       The number of proofs to compute
+ * @param[in]   s               The trusted setup
  */
-static void get_inv_coset_shift_for_cell(
-    fr_t *inv_coset_factor_out, uint64_t cell_index, const KZGSettings *s
+C_KZG_RET compute_cell_kzg_proofs_for_indices(
+    KZGProof *proofs,
+    const Blob *blob,
+    const uint64_t *cell_indices,
+    uint64_t num_cells,
+    const KZGSettings *s
 ) {
-    /*
-     * Get the cell index in reverse-bit order.
-     * This index points to this cell's coset factor h_k in the roots_of_unity array.
-     */
-    uint64_t cell_idx_rbl = reverse_bits_limited(CELLS_PER_EXT_BLOB, cell_index);
+    C_KZG_RET ret;
+    KZGPolynomial *poly = NULL;
 
-    /*
-     * Observe that for every element in roots_of_unity, we can find its inverse by
-     * accessing its reflected element.
-     *
-     * For example, consider a multiplicative subgroup with eight elements:
-     *   roots = {w^0, w^1, w^2, ... w^7, w^0}
-     * For a root of unity in roots[i], we can find its inverse in roots[-i].
-     */
-    assert(cell_idx_rbl <= FIELD_ELEMENTS_PER_EXT_BLOB);
-    uint64_t inv_coset_factor_idx = FIELD_ELEMENTS_PER_EXT_BLOB - cell_idx_rbl;
+    ret = new_kzg_polynomial(&poly, blob);
+    if (ret != C_KZG_OK) goto out;
+    ret = compute_cell_kzg_proofs_for_indices_poly(proofs, poly, cell_indices, num_cells, s);
 
-    /* Get h_k^{-1} using the index */
-    assert(inv_coset_factor_idx < FIELD_ELEMENTS_PER_EXT_BLOB + 1);
-    *inv_coset_factor_out = s->roots_of_unity[inv_coset_factor_idx];
-}
+out:
+    free_kzg_polynomial(&poly);
+    return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Recover
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Given some cells for a blob, recover all cells/proofs.
+ *
+ * @param[out]  recovered_cells     An array of CELLS_PER_EXT_BLOB cells
+ * @param[out]  recovered_proofs    An array of CELLS_PER_EXT_BLOB proofs
+ * @param[in]   cell_indices        The cell indices for the available cells, length `num_cells`
+ * @param[in]   cells               The available cells we recover from, length `num_cells`
+ * @param[in]   num_cells           The number of available cells provided
+ * @param[in]   s                   The trusted setup
+ *
+ * @remark At least CELLS_PER_BLOB cells must be provided.
+ * @remark Recovery is faster if there are fewer missing cells.
+ * @remark If recovered_proofs is NULL, they will not be recomputed.
+ */
+C_KZG_RET recover_cells_and_kzg_proofs(
+    Cell *recovered_cells,
+    KZGProof *recovered_proofs,
+    const uint64_t *cell_indices,
+    const Cell *cells,
+    uint64_t num_cells,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+    fr_t *recovered_cells_fr = NULL;
+    g1_t *recovered_proofs_g1 = NULL;
+
+    /* Ensure only one blob's worth of cells was provided */
+    if (num_cells > CELLS_PER_EXT_BLOB) {
+        ret = C_KZG_BADARGS;
+        goto out;
+    }
+
+    /* Check if it's possible to recover */
+    if (num_cells < CELLS_PER_BLOB) {
+        ret = C_KZG_BADARGS;
+        goto out;
+    }
+
+    /* Check that cell indices are valid */
+    for (size_t i = 0; i < num_cells; i++) {
+        if (cell_indices[i] >= CELLS_PER_EXT_BLOB) {
+            ret = C_KZG_BADARGS;
+            goto out;
+        }
+    }
+
+    /* Do allocations */
+    ret = new_fr_array(&recovered_cells_fr, FIELD_ELEMENTS_PER_EXT_BLOB);
+    if (ret != C_KZG_OK) goto out;
+    ret = new_g1_array(&recovered_proofs_g1, CELLS_PER_EXT_BLOB);
+    if (ret != C_KZG_OK) goto out;
+
+    /* Initialize all cells as missing */
+    for (size_t i = 0; i < FIELD_ELEMENTS_PER_EXT_BLOB; i++) {
+        recovered_cells_fr[i] = FR_NULL;
+    }
+
+    /* Populate recovered_cells_fr with available cells at the right places */
+    for (size_t i = 0; i < num_cells; i++) {
+        size_t index = cell_indices[i] * FIELD_ELEMENTS_PER_CELL;
+        for (size_t j = 0; j < FIELD_ELEMENTS_PER_CELL; j++) {
+            fr_t *ptr = &recovered_cells_fr[index + j];
+
+            /*
+             * Check if the field has already been set. If it has, there was a duplicate cell index
+             * and we can return an error. The compiler will optimize this and the overhead is
+             * practically zero.
+             */
+            if (!fr_is_null(ptr)) {
+                ret = C_KZG_BADARGS;
+                goto out;
+            }
+
+            /* Convert the untrusted input bytes to a field element */
+            size_t offset = j * BYTES_PER_FIELD_ELEMENT;
+            ret = bytes_to_bls_field(ptr, (const Bytes32 *)&cells[i].bytes[offset]);
+            if (ret != C_KZG_OK) goto out;
+        }
+    }
+
+    if (num_cells == CELLS_PER_EXT_BLOB) {
+        /* Nothing to recover, copy the cells */
+        memcpy(recovered_cells, cells, CELLS_PER_EXT_BLOB * sizeof(Cell));
+    } else {
+        /* Perform cell recovery */
+        ret = recover_cells(recovered_cells_fr, cell_indices, num_cells, recovered_cells_fr, s);
+        if (ret != C_KZG_OK) goto out;
+
+        /* Convert the recovered data points to byte-form */
+        for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+            for (size_t j = 0; j < FIELD_ELEMENTS_PER_CELL; j++) {
+                size_t index = i * FIELD_ELEMENTS_PER_CELL + j;
+                size_t offset = j * BYTES_PER_FIELD_ELEMENT;
+                bytes_from_bls_field(
+                    (Bytes32 *)&recovered_cells[i].bytes[offset], &recovered_cells_fr[index]
+                );
+            }
+        }
+    }
+
+    if (recovered_proofs != NULL) {
+        /* The proofs need the FK20 columns, which a verification profile loads on first use */
+        ret = get_prover_settings(&s, s, true);
+        if (ret != C_KZG_OK) goto out;
+
+        /*
+         * Instead of converting the cells to a blob and back, we can just treat the cells as a
+         * polynomial. We are done with the fr-form recovered cells and we can safely mutate the
+         * array.
+         */
+        ret = poly_lagrange_to_monomial(
+            recovered_cells_fr, recovered_cells_fr, FIELD_ELEMENTS_PER_EXT_BLOB, s
+        );
+        if (ret != C_KZG_OK) goto out;
+
+        /* Compute the proofs, only uses the first half of the polynomial */
+        ret = compute_fk20_cell_proofs(recovered_proofs_g1, recovered_cells_fr, s);
+        if (ret != C_KZG_OK) goto out;
+
+        /* Bit-reverse the proofs */
+        ret = bit_reversal_permutation(recovered_proofs_g1, sizeof(g1_t), CELLS_PER_EXT_BLOB);
+        if (ret != C_KZG_OK) goto out;
+
+        /* Convert all of the proofs to byte-form */
+        for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+            bytes_from_g1(&recovered_proofs[i], &recovered_proofs_g1[i]);
+        }
+    }
+
+out:
+    c_kzg_free(recovered_cells_fr);
+    c_kzg_free(recovered_proofs_g1);
+    return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Verify
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Helper function to compare two commitments.
+ *
+ * @param[in]   a   The first commitment
+ * @param[in]   b   The second commitment
+ *
+ * @return True if the commitments are the same, otherwise false.
+ */
+static bool commitments_equal(const Bytes48 *a, const Bytes48 *b) {
+    return memcmp(a->bytes, b->bytes, BYTES_PER_COMMITMENT) == 0;
+}
+
+/**
+ * Helper function to copy one commitment's bytes to another.
+ *
+ * @param[in]   dst The destination commitment
+ * @param[in]   src The source commitment
+ */
+static void commitments_copy(Bytes48 *dst, const Bytes48 *src) {
+    memcpy(dst->bytes, src->bytes, BYTES_PER_COMMITMENT);
+}
+
+/**
+ * Hash a commitment for deduplicate_commitments().
+ *
+ * @param[in]   commitment  The commitment to hash
+ *
+ * @return A hash of all of the commitment's bytes.
+ *
+ * @remark This is not keyed, so a batch crafted to collide only makes deduplication as slow as
+ * comparing every pair of commitments.
+ */
+static uint64_t commitment_hash(const Bytes48 *commitment) {
+    uint64_t word, hash = 0;
+    for (size_t i = 0; i < BYTES_PER_COMMITMENT; i += sizeof(uint64_t)) {
+        memcpy(&word, &commitment->bytes[i], sizeof(uint64_t));
+        hash = (hash ^ word) * 0x9e3779b97f4a7c15;
+    }
+    return hash ^ (hash >> 32);
+}
+
+/**
+ * Convert a list of commitments with potential duplicates to a list of unique commitments. Also
+ * returns a list of indices which point to those new unique commitments.
+ *
+ * @param[in,out]   commitments_out Updated to only contain unique commitments
+ * @param[out]      indices_out     Used as map between old/new commitments
+ * @param[in,out]   count_out       Number of commitments before and after
+ *
+ * @remark The input arrays are re-used.
+ * @remark The number of commitments/indices must be the same.
+ * @remark The length of `indices_out` is unchanged.
+ * @remark `count_out` is updated to be the number of unique commitments.
+ * @remark The unique commitments are found with a hash table, so this takes linear time.
+ */
+static C_KZG_RET deduplicate_commitments(
+    Bytes48 *commitments_out, uint64_t *indices_out, size_t *count_out
+) {
+    C_KZG_RET ret;
+    uint64_t *slots = NULL;
+    size_t num_slots = 1;
+    size_t new_count = 0;
+
+    /* Bail early if there are no commitments */
+    if (*count_out == 0) return C_KZG_OK;
+
+    /* Keep the table at most half full, so that the probe sequences stay short */
+    while (num_slots < 2 * *count_out) {
+        num_slots <<= 1;
+    }
+
+    /* Each slot holds one plus the index of a unique commitment, or zero if it is empty */
+    ret = c_kzg_calloc((void **)&slots, num_slots, sizeof(uint64_t));
+    if (ret != C_KZG_OK) return ret;
+
+    /* Create list of unique commitments & indices to them */
+    for (size_t i = 0; i < *count_out; i++) {
+        size_t slot = (size_t)commitment_hash(&commitments_out[i]) & (num_slots - 1);
+        while (slots[slot] != 0) {
+            if (commitments_equal(&commitments_out[slots[slot] - 1], &commitments_out[i])) break;
+            slot = (slot + 1) & (num_slots - 1);
+        }
+
+        if (slots[slot] != 0) {
+            /* This commitment already exists */
+            indices_out[i] = slots[slot] - 1;
+        } else {
+            /* This is a new commitment */
+            commitments_copy(&commitments_out[new_count], &commitments_out[i]);
+            indices_out[i] = new_count;
+            slots[slot] = ++new_count;
+        }
+    }
+
+    /* Update the count */
+    *count_out = new_count;
+
+    c_kzg_free(slots);
+    return C_KZG_OK;
+}
+
+/**
+ * Compute random linear combination challenge scalars for verify_cell_kzg_proof_batch. In this, we
+ * must hash EVERYTHING that the prover can control.
+ *
+ * @param[out]  r_powers_out        The output challenges, length `num_cells`
+ * @param[in]   commitments_bytes   The input commitments, length `num_commitments`
+ * @param[in]   num_commitments     The number of commitments
+ * @param[in]   commitment_indices  The cell commitment indices, length `num_cells`
+ * @param[in]   cell_indices        The cell indices, length `num_cells`
+ * @param[in]   cells               The cell, length `num_cells`
+ * @param[in]   proofs_bytes        The cell proof, length `num_cells`
+ * @param[in]   num_cells           The number of cells
+ */
+static C_KZG_RET compute_r_powers_for_verify_cell_kzg_proof_batch(
+    fr_t *r_powers_out,
+    const Bytes48 *commitments_bytes,
+    size_t num_commitments,
+    const uint64_t *commitment_indices,
+    const uint64_t *cell_indices,
+    const Cell *cells,
+    const Bytes48 *proofs_bytes,
+    uint64_t num_cells
+) {
+    C_KZG_RET ret;
+    uint8_t *bytes = NULL;
+    Bytes32 r_bytes;
+    fr_t r;
+
+    /* Calculate the size of the data we're going to hash */
+    size_t input_size = DOMAIN_STR_LENGTH                          /* The domain separator */
+                        + sizeof(uint64_t)                         /* FIELD_ELEMENTS_PER_CELL */
+                        + sizeof(uint64_t)                         /* num_commitments */
+                        + sizeof(uint64_t)                         /* num_cells */
+                        + (num_commitments * BYTES_PER_COMMITMENT) /* commitment_bytes */
+                        + (num_cells * sizeof(uint64_t))           /* commitment_indices */
+                        + (num_cells * sizeof(uint64_t))           /* cell_indices */
+                        + (num_cells * BYTES_PER_CELL)             /* cells */
+                        + (num_cells * BYTES_PER_PROOF);           /* proofs_bytes */
+
+    /* Allocate space to copy this data into */
+    ret = c_kzg_malloc((void **)&bytes, input_size);
+    if (ret != C_KZG_OK) goto out;
+
+    /* Pointer tracking `bytes` for writing on top of it */
+    uint8_t *offset = bytes;
+
+    /* Ensure that the domain string is the correct length */
+    assert(strlen(RANDOM_CHALLENGE_DOMAIN_VERIFY_CELL_KZG_PROOF_BATCH) == DOMAIN_STR_LENGTH);
+
+    /* Copy domain separator */
+    memcpy(offset, RANDOM_CHALLENGE_DOMAIN_VERIFY_CELL_KZG_PROOF_BATCH, DOMAIN_STR_LENGTH);
+    offset += DOMAIN_STR_LENGTH;
+
+    /* Copy field elements per cell */
+    bytes_from_uint64(offset, FIELD_ELEMENTS_PER_CELL);
+    offset += sizeof(uint64_t);
+
+    /* Copy number of commitments */
+    bytes_from_uint64(offset, num_commitments);
+    offset += sizeof(uint64_t);
+
+    /* Copy number of cells */
+    bytes_from_uint64(offset, num_cells);
+    offset += sizeof(uint64_t);
+
+    for (size_t i = 0; i < num_commitments; i++) {
+        /* Copy commitment */
+        memcpy(offset, &commitments_bytes[i], BYTES_PER_COMMITMENT);
+        offset += BYTES_PER_COMMITMENT;
+    }
+
+    for (size_t i = 0; i < num_cells; i++) {
+        /* Copy row id */
+        bytes_from_uint64(offset, commitment_indices[i]);
+        offset += sizeof(uint64_t);
+
+        /* Copy column id */
+        bytes_from_uint64(offset, cell_indices[i]);
+        offset += sizeof(uint64_t);
+
+        /* Copy cell */
+        memcpy(offset, &cells[i], BYTES_PER_CELL);
+        offset += BYTES_PER_CELL;
+
+        /* Copy proof */
+        memcpy(offset, &proofs_bytes[i], BYTES_PER_PROOF);
+        offset += BYTES_PER_PROOF;
+    }
+
+    /* Now let's create the challenge! */
+    blst_sha256(r_bytes.bytes, bytes, input_size);
+    hash_to_bls_field(&r, &r_bytes);
+
+    /* Raise power of r for each cell */
+    compute_powers(r_powers_out, &r, num_cells);
+
+    /* Make sure we wrote the entire buffer */
+    assert(offset == bytes + input_size);
+
+out:
+    c_kzg_free(bytes);
+    return ret;
+}
+
+/**
+ * Compute the sum of the commitments weighted by the powers of r.
+ *
+ * @param[out]  sum_of_commitments_out  The resulting G1 sum of the commitments
+ * @param[in]   commitments_g1          Array of unique commitments, length `num_commitments`
+ * @param[in]   commitment_indices      Indices mapping to unique commitments, length `num_cells`
+ * @param[in]   r_powers                Array of powers of r used for weighting, length `num_cells`
+ * @param[in]   num_commitments         The number of unique commitments
+ * @param[in]   num_cells               The number of cells
+ * @param[in]   s                       The trusted setup
+ */
+static C_KZG_RET compute_weighted_sum_of_commitments(
+    g1_t *sum_of_commitments_out,
+    const g1_t *commitments_g1,
+    const uint64_t *commitment_indices,
+    const fr_t *r_powers,
+    size_t num_commitments,
+    uint64_t num_cells,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+    fr_t *commitment_weights = NULL;
+
+    ret = new_fr_array(&commitment_weights, num_commitments);
+    if (ret != C_KZG_OK) goto out;
+
+    /* Initialize the weights to zero */
+    for (size_t i = 0; i < num_commitments; i++) {
+        commitment_weights[i] = FR_ZERO;
+    }
+
+    /* Update commitment weights */
+    for (uint64_t i = 0; i < num_cells; i++) {
+        blst_fr_add(
+            &commitment_weights[commitment_indices[i]],
+            &commitment_weights[commitment_indices[i]],
+            &r_powers[i]
+        );
+    }
+
+    /* Compute commitment sum */
+    ret = g1_lincomb_fast(
+        sum_of_commitments_out, commitments_g1, commitment_weights, num_commitments, s
+    );
+    if (ret != C_KZG_OK) goto out;
+
+out:
+    c_kzg_free(commitment_weights);
+    return ret;
+}
+
+/**
+ * Compute the inverse coset factor h_k^{-1},
+ *  where `h_k` is the coset factor for cell with index `k`.
+ *
+ * @param[out]  inv_coset_factor_out    Pointer to store the computed inverse coset factor
+ * @param[in]   cell_index              The index of the cell
+ * @param[in]   s                       The trusted setup
+ */
+static void get_inv_coset_shift_for_cell(
+    fr_t *inv_coset_factor_out, uint64_t cell_index, const KZGSettings *s
+) {
+    /*
+     * Get the cell index in reverse-bit order.
+     * This index points to this cell's coset factor h_k in the roots_of_unity array.
+     */
+    uint64_t cell_idx_rbl = reverse_bits_limited(CELLS_PER_EXT_BLOB, cell_index);
+
+    /*
+     * Observe that for every element in roots_of_unity, we can find its inverse by
+     * accessing its reflected element.
+     *
+     * For example, consider a multiplicative subgroup with eight elements:
+     *   roots = {w^0, w^1, w^2, ... w^7, w^0}
+     * For a root of unity in roots[i], we can find its inverse in roots[-i].
+     */
+    assert(cell_idx_rbl <= FIELD_ELEMENTS_PER_EXT_BLOB);
+    uint64_t inv_coset_factor_idx = FIELD_ELEMENTS_PER_EXT_BLOB - cell_idx_rbl;
+
+    /* Get h_k^{-1} using the index */
+    assert(inv_coset_factor_idx < FIELD_ELEMENTS_PER_EXT_BLOB + 1);
+    *inv_coset_factor_out = s->roots_of_unity[inv_coset_factor_idx];
+}
+
+/**
+ * Compute h_k^{n}, where `h_k` is the coset factor for cell with index `k`.
+ *
+ * @param[out]  coset_factor_out    Pointer to store h_k^{n}
+ * @param[in]   cell_index          The index of the cell
+ * @param[in]   s                   The trusted setup
+ */
+static void get_coset_shift_pow_for_cell(
+    fr_t *coset_factor_out, uint64_t cell_index, const KZGSettings *s
+) {
+    /*
+     * Get the cell index in reverse-bit order.
+     * This index points to this cell's coset factor h_k in the roots_of_unity array.
+     */
+    uint64_t cell_idx_rbl = reverse_bits_limited(CELLS_PER_EXT_BLOB, cell_index);
+
+    /*
+     * Get the index to h_k^n in the roots_of_unity array.
+     *
+     * Multiplying the index of h_k by n, effectively raises h_k to the n-th power,
+     * because advancing in the roots_of_unity array corresponds to increasing exponents.
+     */
+    uint64_t h_k_pow_idx = cell_idx_rbl * FIELD_ELEMENTS_PER_CELL;
+
+    /* Get h_k^n using the index */
+    assert(h_k_pow_idx < FIELD_ELEMENTS_PER_EXT_BLOB + 1);
+    *coset_factor_out = s->roots_of_unity[h_k_pow_idx];
+}
+
+/**
+ * Aggregate columns, compute the sum of interpolation polynomials, and commit to the result.
+ *
+ * This function computes `RLI = [sum_k r^k interpolation_poly_k(s)]` from the spec.
+ *
+ * @param[out]  commitment_out  Commitment to the aggregated interpolation poly
+ * @param[in]   r_powers        Precomputed powers of the random challenge, length `num_cells`
+ * @param[in]   cell_indices    Indices of the cells, length `num_cells`
+ * @param[in]   cells_fr        The decoded cells, `num_cells * FIELD_ELEMENTS_PER_CELL` elements
+ * @param[in]   num_cells       Number of cells
+ * @param[in]   s               The trusted setup
+ */
+static C_KZG_RET compute_commitment_to_aggregated_interpolation_poly(
+    g1_t *commitment_out,
+    const fr_t *r_powers,
+    const uint64_t *cell_indices,
+    const fr_t *cells_fr,
+    uint64_t num_cells,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+    bool *is_cell_used = NULL;
+    fr_t *aggregated_column_cells = NULL;
+    fr_t *column_interpolation_poly = NULL;
+    fr_t *aggregated_interpolation_poly = NULL;
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Array allocations
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    ret = new_bool_array(&is_cell_used, CELLS_PER_EXT_BLOB);
+    if (ret != C_KZG_OK) goto out;
+    ret = new_fr_array(&aggregated_column_cells, FIELD_ELEMENTS_PER_EXT_BLOB);
+    if (ret != C_KZG_OK) goto out;
+    ret = new_fr_array(&column_interpolation_poly, FIELD_ELEMENTS_PER_CELL);
+    if (ret != C_KZG_OK) goto out;
+    ret = new_fr_array(&aggregated_interpolation_poly, FIELD_ELEMENTS_PER_CELL);
+    if (ret != C_KZG_OK) goto out;
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Aggregate cells from the same column
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /* Start with zeroed out columns */
+    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+        for (size_t j = 0; j < FIELD_ELEMENTS_PER_CELL; j++) {
+            size_t index = i * FIELD_ELEMENTS_PER_CELL + j;
+            aggregated_column_cells[index] = FR_ZERO;
+        }
+    }
+
+    /*
+     * Vertically collapse cells of the 2D matrix into a single array: `aggregated_column_cells`.
+     *
+     * For each provided cell, go over its field elements, and scale them by the appropriate power
+     * of r. Then aggregate all field elements on the same vertical slice into a single array.
+     */
+    for (uint64_t cell_index = 0; cell_index < num_cells; cell_index++) {
+        /* Determine which column this cell belongs to */
+        uint64_t column_index = cell_indices[cell_index];
+
+        /* Iterate over every field element of this cell: scale it and aggregate it */
+        for (size_t fr_index = 0; fr_index < FIELD_ELEMENTS_PER_CELL; fr_index++) {
+            fr_t scaled_fr;
+
+            /* Scale the field element by the appropriate power of r */
+            const fr_t *original_fr = &cells_fr[cell_index * FIELD_ELEMENTS_PER_CELL + fr_index];
+            blst_fr_mul(&scaled_fr, original_fr, &r_powers[cell_index]);
+
+            /* Figure out the right index for this field element within the extended array */
+            size_t array_index = column_index * FIELD_ELEMENTS_PER_CELL + fr_index;
+            /* Aggregate the scaled field element into the array */
+            blst_fr_add(
+                &aggregated_column_cells[array_index],
+                &aggregated_column_cells[array_index],
+                &scaled_fr
+            );
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Determine which cells are used
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /* Start with false values */
+    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+        is_cell_used[i] = false;
+    }
+
+    /* Mark each cell index as used */
+    for (uint64_t i = 0; i < num_cells; i++) {
+        is_cell_used[cell_indices[i]] = true;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Compute interpolation polynomials using the aggregated cells
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /* Start with a zeroed out poly */
+    for (size_t i = 0; i < FIELD_ELEMENTS_PER_CELL; i++) {
+        aggregated_interpolation_poly[i] = FR_ZERO;
+    }
+
+    /* Interpolate each column */
+    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+        /* We can skip columns without any cells */
+        if (!is_cell_used[i]) continue;
+
+        /* Offset to the first cell for this column */
+        size_t index = i * FIELD_ELEMENTS_PER_CELL;
+
+        /*
+         * Reach into the big array and permute the right column.
+         * No need to copy the data, we are not gonna use them again.
+         */
+        ret = bit_reversal_permutation(
+            &aggregated_column_cells[index], sizeof(fr_t), FIELD_ELEMENTS_PER_CELL
+        );
+        if (ret != C_KZG_OK) goto out;
+
+        /*
+         * Get interpolation polynomial for this column. To do so we first do an IDFT over the roots
+         * of unity and then we scale the coefficients by the coset factor. We can't do an IDFT
+         * directly over the coset because it's not a subgroup.
+         */
+        ret = fr_ifft(
+            column_interpolation_poly, &aggregated_column_cells[index], FIELD_ELEMENTS_PER_CELL, s
+        );
+        if (ret != C_KZG_OK) goto out;
+
+        /* Shift the poly by h_k^{-1} where h_k is the coset factor for this cell */
+        fr_t inv_coset_factor;
+        get_inv_coset_shift_for_cell(&inv_coset_factor, i, s);
+        shift_poly(column_interpolation_poly, FIELD_ELEMENTS_PER_CELL, &inv_coset_factor);
+
+        /* Update the aggregated poly */
+        for (size_t k = 0; k < FIELD_ELEMENTS_PER_CELL; k++) {
+            blst_fr_add(
+                &aggregated_interpolation_poly[k],
+                &aggregated_interpolation_poly[k],
+                &column_interpolation_poly[k]
+            );
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Commit to the aggregated interpolation polynomial
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    ret = g1_lincomb_fast(
+        commitment_out,
+        s->g1_values_monomial,
+        aggregated_interpolation_poly,
+        FIELD_ELEMENTS_PER_CELL,
+        s
+    );
+    if (ret != C_KZG_OK) goto out;
+
+out:
+    c_kzg_free(is_cell_used);
+    c_kzg_free(aggregated_column_cells);
+    c_kzg_free(column_interpolation_poly);
+    c_kzg_free(aggregated_interpolation_poly);
+    return ret;
+}
 
 /**
- * Compute h_k^{n}, where `h_k` is the coset factor for cell with index `k`.
+ * Commit to the sum of the scaled interpolation polynomials of some cells.
  *
- * @param[out]  coset_factor_out    Pointer to store h_k^{n}
- * @param[in]   cell_index          The index of the cell
+ * This gives the same result as compute_commitment_to_aggregated_interpolation_poly(), since the
+ * interpolation is linear, but only adds up polynomials which were interpolated once before.
+ *
+ * @param[out]  commitment_out      Commitment to the aggregated interpolation poly
+ * @param[in]   interpolation_polys The scaled interpolation polynomials of the cells,
+ *                                  `num_cells * FIELD_ELEMENTS_PER_CELL` coefficients
+ * @param[in]   num_cells           Number of cells
  * @param[in]   s                   The trusted setup
  */
-static void get_coset_shift_pow_for_cell(
-    fr_t *coset_factor_out, uint64_t cell_index, const KZGSettings *s
+static C_KZG_RET commit_to_summed_interpolation_polys(
+    g1_t *commitment_out, const fr_t *interpolation_polys, uint64_t num_cells, const KZGSettings *s
 ) {
-    /*
-     * Get the cell index in reverse-bit order.
-     * This index points to this cell's coset factor h_k in the roots_of_unity array.
-     */
-    uint64_t cell_idx_rbl = reverse_bits_limited(CELLS_PER_EXT_BLOB, cell_index);
+    fr_t sum[FIELD_ELEMENTS_PER_CELL];
+
+    for (size_t k = 0; k < FIELD_ELEMENTS_PER_CELL; k++) {
+        sum[k] = FR_ZERO;
+    }
+    for (uint64_t i = 0; i < num_cells; i++) {
+        const fr_t *poly = &interpolation_polys[i * FIELD_ELEMENTS_PER_CELL];
+        for (size_t k = 0; k < FIELD_ELEMENTS_PER_CELL; k++) {
+            blst_fr_add(&sum[k], &sum[k], &poly[k]);
+        }
+    }
+
+    return g1_lincomb_fast(commitment_out, s->g1_values_monomial, sum, FIELD_ELEMENTS_PER_CELL, s);
+}
+
+/**
+ * Compute the two random linear combinations of the proofs.
+ *
+ * The proofs are combined once with the powers of r, and once with the powers of r scaled by the
+ * coset factors. Both use the same points, so one g1_lincomb_fast_multi() call converts them to
+ * affine form once for both.
+ *
+ * @param[out]  proof_lincomb_out       The resulting G1 sum of the proofs scaled by powers of r
+ * @param[out]  weighted_proof_sum_out  The resulting G1 sum of the proofs scaled by coset factors
+ * @param[in]   proofs_g1               Array of proofs, length `num_cells`
+ * @param[in]   r_powers                Array of powers of r used for weighting, length `num_cells`
+ * @param[in]   cell_indices            Array of cell indices, length `num_cells`
+ * @param[in]   num_cells               The number of cells
+ * @param[in]   s                       The trusted setup
+ */
+static C_KZG_RET compute_weighted_sums_of_proofs(
+    g1_t *proof_lincomb_out,
+    g1_t *weighted_proof_sum_out,
+    const g1_t *proofs_g1,
+    const fr_t *r_powers,
+    const uint64_t *cell_indices,
+    uint64_t num_cells,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+    fr_t *weights = NULL;
+    g1_t sums[2];
+
+    /* The first half holds the powers of r, the second half the weighted powers of r */
+    ret = new_fr_array(&weights, 2 * num_cells);
+    if (ret != C_KZG_OK) goto out;
+
+    for (uint64_t i = 0; i < num_cells; i++) {
+        /* Get scaling factor h_k^n where h_k is the coset factor for this cell */
+        fr_t h_k_pow;
+        get_coset_shift_pow_for_cell(&h_k_pow, cell_indices[i], s);
+
+        /* Scale the power of r by h_k^n */
+        weights[i] = r_powers[i];
+        blst_fr_mul(&weights[num_cells + i], &r_powers[i], &h_k_pow);
+    }
+
+    ret = g1_lincomb_fast_multi(sums, proofs_g1, weights, num_cells, 2, s);
+    if (ret != C_KZG_OK) goto out;
+
+    *proof_lincomb_out = sums[0];
+    *weighted_proof_sum_out = sums[1];
+
+out:
+    c_kzg_free(weights);
+    return ret;
+}
+
+/**
+ * Compute the two sides of the pairing check for a range of a batch of cell proofs.
+ *
+ * The range is valid if e(lhs, G2) == e(proof_lincomb, [s^n]).
+ *
+ * @param[out]  lhs_out             The commitments, less the interpolation polynomials, plus the
+ *                                  proofs scaled by the coset factors
+ * @param[out]  proof_lincomb_out   The proofs scaled by the powers of r
+ * @param[in]   b                   The batch
+ * @param[in]   lo                  The first cell of the range
+ * @param[in]   hi                  One past the last cell of the range
+ */
+static C_KZG_RET compute_cell_proof_range_sums(
+    g1_t *lhs_out, g1_t *proof_lincomb_out, const CellProofBatch *b, size_t lo, size_t hi
+) {
+    C_KZG_RET ret;
+    const uint64_t *cell_indices = &b->cell_indices[lo];
+    const fr_t *r_powers = &b->r_powers[lo];
+    size_t num_cells = hi - lo;
+    g1_t interpolation_poly_commit;
+    g1_t weighted_sum_of_proofs;
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Compute random linear combinations of the proofs
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /* The plain one, and the one with the proofs scaled by the coset factors */
+    ret = compute_weighted_sums_of_proofs(
+        proof_lincomb_out,
+        &weighted_sum_of_proofs,
+        &b->proofs_g1[lo],
+        r_powers,
+        cell_indices,
+        num_cells,
+        b->s
+    );
+    if (ret != C_KZG_OK) goto out;
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Compute sum of the commitments
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    ret = compute_weighted_sum_of_commitments(
+        lhs_out,
+        b->commitments_g1,
+        &b->commitment_indices[lo],
+        r_powers,
+        b->num_commitments,
+        num_cells,
+        b->s
+    );
+    if (ret != C_KZG_OK) goto out;
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Commit to aggregated interpolation polynomial
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    if (b->interpolation_polys != NULL) {
+        /* Sum the interpolation polynomials of the cells, and commit */
+        ret = commit_to_summed_interpolation_polys(
+            &interpolation_poly_commit,
+            &b->interpolation_polys[lo * FIELD_ELEMENTS_PER_CELL],
+            num_cells,
+            b->s
+        );
+    } else {
+        /* Aggregate cells from same columns, sum interpolation polynomials, and commit */
+        ret = compute_commitment_to_aggregated_interpolation_poly(
+            &interpolation_poly_commit,
+            r_powers,
+            cell_indices,
+            &b->cells_fr[lo * FIELD_ELEMENTS_PER_CELL],
+            num_cells,
+            b->s
+        );
+    }
+    if (ret != C_KZG_OK) goto out;
+
+    /* Subtract commitment from sum by adding the negated commitment */
+    blst_p1_cneg(&interpolation_poly_commit, true);
+    blst_p1_add(lhs_out, lhs_out, &interpolation_poly_commit);
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Add the sum of the proofs scaled by the coset factors
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    blst_p1_add(lhs_out, lhs_out, &weighted_sum_of_proofs);
+
+out:
+    return ret;
+}
+
+/**
+ * Find where a range of a batch of cell proofs is in the bisection of the batch.
+ *
+ * @param[out]  parent_lo   The first cell of the range which was split to get this one
+ * @param[out]  parent_hi   One past the last cell of that range
+ * @param[in]   n           The number of cells in the batch
+ * @param[in]   lo          The first cell of the range
+ * @param[in]   hi          One past the last cell of the range
+ *
+ * @return The number of times the batch was split to get the range, zero for the whole batch.
+ */
+static size_t get_cell_range_depth(
+    size_t *parent_lo, size_t *parent_hi, size_t n, size_t lo, size_t hi
+) {
+    size_t depth = 0, a = 0, b = n;
+
+    *parent_lo = 0;
+    *parent_hi = n;
+    while (a != lo || b != hi) {
+        size_t mid = a + (b - a) / 2;
+        *parent_lo = a;
+        *parent_hi = b;
+        if (hi <= mid) {
+            b = mid;
+        } else {
+            a = mid;
+        }
+        depth++;
+    }
+    return depth;
+}
+
+/**
+ * Get the two sides of the pairing check for a range of a batch of cell proofs, without any MSMs.
+ *
+ * The weights are the same for every range, so the sums of a range are those of the range it was
+ * split from, less those of its left half. The bisection checks the left half of a range before
+ * the right half, so the right half is found this way, and so is an unchecked range which it was
+ * split from.
+ *
+ * @param[out]  lhs_out             The side which is paired with G2
+ * @param[out]  proof_lincomb_out   The side which is paired with [s^n]
+ * @param[in]   b                   The batch, with the sums of the ranges checked before
+ * @param[in]   lo                  The first cell of the range
+ * @param[in]   hi                  One past the last cell of the range
+ *
+ * @return True if the sums were found, false if the range has to be computed.
+ */
+static bool find_cell_range_sums(
+    g1_t *lhs_out, g1_t *proof_lincomb_out, const CellProofBatch *b, size_t lo, size_t hi
+) {
+    size_t parent_lo, parent_hi;
+    size_t depth = get_cell_range_depth(&parent_lo, &parent_hi, b->num_cells, lo, hi);
+    CellRangeSums *sums = &b->range_sums[depth];
+    g1_t left_lhs, left_proof_lincomb;
+
+    if (sums->lo == lo && sums->hi == hi) {
+        *lhs_out = sums->lhs;
+        *proof_lincomb_out = sums->proof_lincomb;
+        return true;
+    }
+
+    /* Only the right half of a range, with its left half checked, can be found */
+    if (depth == 0 || lo == parent_lo) return false;
+    if (sums->lo != parent_lo || sums->hi != lo) return false;
+    left_lhs = sums->lhs;
+    left_proof_lincomb = sums->proof_lincomb;
+    if (!find_cell_range_sums(lhs_out, proof_lincomb_out, b, parent_lo, parent_hi)) return false;
+
+    blst_p1_cneg(&left_lhs, true);
+    blst_p1_add_or_double(lhs_out, lhs_out, &left_lhs);
+    blst_p1_cneg(&left_proof_lincomb, true);
+    blst_p1_add_or_double(proof_lincomb_out, proof_lincomb_out, &left_proof_lincomb);
+
+    /* Keep them, in place of the left half which is not needed anymore */
+    sums->lo = lo;
+    sums->hi = hi;
+    sums->lhs = *lhs_out;
+    sums->proof_lincomb = *proof_lincomb_out;
+    return true;
+}
+
+/**
+ * Check a range of a batch of cell proofs, with the weights for the whole batch.
+ *
+ * @param[out]  ok      True if the proofs in the range are valid, otherwise false
+ * @param[in]   batch   The batch, a CellProofBatch
+ * @param[in]   lo      The first cell of the range
+ * @param[in]   hi      One past the last cell of the range
+ */
+static C_KZG_RET check_cell_proof_range(bool *ok, const void *batch, size_t lo, size_t hi) {
+    C_KZG_RET ret;
+    const CellProofBatch *b = batch;
+    g1_t final_g1_sum;
+    g1_t proof_lincomb;
+    g2_t power_of_s = b->s->g2_values_monomial[FIELD_ELEMENTS_PER_CELL];
+
+    *ok = false;
+
+    if (b->range_sums == NULL) {
+        ret = compute_cell_proof_range_sums(&final_g1_sum, &proof_lincomb, b, lo, hi);
+        if (ret != C_KZG_OK) return ret;
+    } else if (!find_cell_range_sums(&final_g1_sum, &proof_lincomb, b, lo, hi)) {
+        size_t parent_lo, parent_hi;
+        size_t depth = get_cell_range_depth(&parent_lo, &parent_hi, b->num_cells, lo, hi);
+
+        ret = compute_cell_proof_range_sums(&final_g1_sum, &proof_lincomb, b, lo, hi);
+        if (ret != C_KZG_OK) return ret;
+
+        /* Keep them, for finding the right half and the ranges split from this one */
+        b->range_sums[depth].lo = lo;
+        b->range_sums[depth].hi = hi;
+        b->range_sums[depth].lhs = final_g1_sum;
+        b->range_sums[depth].proof_lincomb = proof_lincomb;
+    }
+
+    /* Do the final pairing check */
+    *ok = pairings_verify(&final_g1_sum, blst_p2_generator(), &proof_lincomb, &power_of_s);
+    return C_KZG_OK;
+}
+
+/**
+ * Free the arrays owned by a batch of cell proofs.
+ *
+ * @param[in,out]   batch   The batch
+ */
+static void free_cell_proof_batch(CellProofBatch *batch) {
+    c_kzg_free(batch->range_sums);
+    c_kzg_free(batch->interpolation_polys);
+    c_kzg_free(batch->cells_fr);
+    c_kzg_free(batch->r_powers);
+    c_kzg_free(batch->proofs_g1);
+    c_kzg_free(batch->commitments_g1);
+}
+
+/**
+ * Decode a batch of cell proofs and derive the weights to combine them with.
+ *
+ * @param[out]  batch               The batch, to free with free_cell_proof_batch() in any case
+ * @param[in]   commitments_bytes   The commitments, length `num_commitments`
+ * @param[in]   num_commitments     The number of commitments
+ * @param[in]   commitment_indices  The index of each cell's commitment, length `num_cells`
+ * @param[in]   cell_indices        The indices for the cells, length `num_cells`
+ * @param[in]   cells               The cells to check, length `num_cells`
+ * @param[in]   proofs_bytes        The proofs for the cells, length `num_cells`
+ * @param[in]   num_cells           The number of cells provided, which is not zero
+ * @param[in]   s                   The trusted setup
+ *
+ * @remark The batch refers to the index arrays, which must outlive it.
+ * @remark The cells are decoded here once, so that checking ranges of the batch reuses them.
+ */
+static C_KZG_RET new_cell_proof_batch(
+    CellProofBatch *batch,
+    const Bytes48 *commitments_bytes,
+    size_t num_commitments,
+    const uint64_t *commitment_indices,
+    const uint64_t *cell_indices,
+    const Cell *cells,
+    const Bytes48 *proofs_bytes,
+    uint64_t num_cells,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+
+    batch->commitments_g1 = NULL;
+    batch->num_commitments = num_commitments;
+    batch->commitment_indices = commitment_indices;
+    batch->cell_indices = cell_indices;
+    batch->cells_fr = NULL;
+    batch->interpolation_polys = NULL;
+    batch->proofs_g1 = NULL;
+    batch->r_powers = NULL;
+    batch->num_cells = num_cells;
+    batch->range_sums = NULL;
+    batch->s = s;
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Array allocations
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    ret = new_fr_array(&batch->r_powers, num_cells);
+    if (ret != C_KZG_OK) goto out;
+    ret = new_g1_array(&batch->proofs_g1, num_cells);
+    if (ret != C_KZG_OK) goto out;
+    ret = new_g1_array(&batch->commitments_g1, num_commitments);
+    if (ret != C_KZG_OK) goto out;
+    ret = new_fr_array(&batch->cells_fr, num_cells * FIELD_ELEMENTS_PER_CELL);
+    if (ret != C_KZG_OK) goto out;
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Compute powers of r, and extract KZG proofs and commitments out of input bytes
+    ////////////////////////////////////////////////////////////////////////////////////////////////
 
     /*
-     * Get the index to h_k^n in the roots_of_unity array.
-     *
-     * Multiplying the index of h_k by n, effectively raises h_k to the n-th power,
-     * because advancing in the roots_of_unity array corresponds to increasing exponents.
+     * Derive random factors for the linear combination. The exponents start with 0. That is, they
+     * are r^0, r^1, r^2, r^3, and so on.
      */
-    uint64_t h_k_pow_idx = cell_idx_rbl * FIELD_ELEMENTS_PER_CELL;
+    ret = compute_r_powers_for_verify_cell_kzg_proof_batch(
+        batch->r_powers,
+        commitments_bytes,
+        num_commitments,
+        commitment_indices,
+        cell_indices,
+        cells,
+        proofs_bytes,
+        num_cells
+    );
+    if (ret != C_KZG_OK) goto out;
 
-    /* Get h_k^n using the index */
-    assert(h_k_pow_idx < FIELD_ELEMENTS_PER_EXT_BLOB + 1);
-    *coset_factor_out = s->roots_of_unity[h_k_pow_idx];
+    /* There should be a proof for each cell */
+    for (size_t i = 0; i < num_cells; i++) {
+        ret = bytes_to_kzg_proof(&batch->proofs_g1[i], &proofs_bytes[i]);
+        if (ret != C_KZG_OK) goto out;
+    }
+
+    /* Convert & validate commitments */
+    for (size_t i = 0; i < num_commitments; i++) {
+        ret = bytes_to_kzg_commitment(&batch->commitments_g1[i], &commitments_bytes[i]);
+        if (ret != C_KZG_OK) goto out;
+    }
+
+    /* Convert & validate the field elements of the cells */
+    for (size_t i = 0; i < num_cells; i++) {
+        for (size_t j = 0; j < FIELD_ELEMENTS_PER_CELL; j++) {
+            ret = bytes_to_bls_field(
+                &batch->cells_fr[i * FIELD_ELEMENTS_PER_CELL + j],
+                (const Bytes32 *)&cells[i].bytes[j * BYTES_PER_FIELD_ELEMENT]
+            );
+            if (ret != C_KZG_OK) goto out;
+        }
+    }
+
+out:
+    return ret;
 }
 
 /**
- * Aggregate columns, compute the sum of interpolation polynomials, and commit to the result.
+ * Replace the decoded cells of a batch with their interpolation polynomials, scaled by the powers
+ * of r.
  *
- * This function computes `RLI = [sum_k r^k interpolation_poly_k(s)]` from the spec.
+ * The aggregated interpolation polynomial of a range of the batch is then the sum of those of its
+ * cells. So the checks of a bisection only add up polynomials, rather than aggregating the columns
+ * and interpolating them again for every range.
  *
- * @param[out]  commitment_out  Commitment to the aggregated interpolation poly
- * @param[in]   r_powers        Precomputed powers of the random challenge, length `num_cells`
- * @param[in]   cell_indices    Indices of the cells, length `num_cells`
- * @param[in]   cells           Array of cells, length `num_cells`
- * @param[in]   num_cells       Number of cells
- * @param[in]   s               The trusted setup
+ * @param[in,out]   batch       The batch, with its decoded cells
+ * @param[in]       num_cells   The number of cells in the batch
+ */
+static C_KZG_RET interpolate_cell_proof_batch(CellProofBatch *batch, uint64_t num_cells) {
+    C_KZG_RET ret;
+    fr_t column[FIELD_ELEMENTS_PER_CELL];
+    fr_t inv_coset_factor;
+
+    for (uint64_t i = 0; i < num_cells; i++) {
+        fr_t *cell = &batch->cells_fr[i * FIELD_ELEMENTS_PER_CELL];
+
+        /* Interpolate over the roots of unity, then shift by h_k^{-1}, as for a whole column */
+        ret = bit_reversal_permutation(cell, sizeof(fr_t), FIELD_ELEMENTS_PER_CELL);
+        if (ret != C_KZG_OK) return ret;
+        ret = fr_ifft(column, cell, FIELD_ELEMENTS_PER_CELL, batch->s);
+        if (ret != C_KZG_OK) return ret;
+        get_inv_coset_shift_for_cell(&inv_coset_factor, batch->cell_indices[i], batch->s);
+        shift_poly(column, FIELD_ELEMENTS_PER_CELL, &inv_coset_factor);
+
+        for (size_t k = 0; k < FIELD_ELEMENTS_PER_CELL; k++) {
+            blst_fr_mul(&cell[k], &column[k], &batch->r_powers[i]);
+        }
+    }
+
+    batch->interpolation_polys = batch->cells_fr;
+    batch->cells_fr = NULL;
+    return C_KZG_OK;
+}
+
+/**
+ * Helper function for the verify_cell_kzg_proof_batch() variants.
+ *
+ * @param[out]  ok                  True if the proofs are valid
+ * @param[out]  invalid_out         The indices of the invalid proofs, or NULL to not find them
+ * @param[out]  num_invalid_out     The number of invalid proofs, or NULL with `invalid_out`
+ * @param[in]   commitments_bytes   The commitments, length `num_commitments`
+ * @param[in]   num_commitments     The number of commitments
+ * @param[in]   commitment_indices  The index of each cell's commitment, length `num_cells`
+ * @param[in]   cell_indices        The indices for the cells, length `num_cells`
+ * @param[in]   cells               The cells to check, length `num_cells`
+ * @param[in]   proofs_bytes        The proofs for the cells, length `num_cells`
+ * @param[in]   num_cells           The number of cells provided, which is not zero
+ * @param[in]   s                   The trusted setup
+ *
+ * @remark If the batch fails and `invalid_out` is not NULL, the invalid proofs are found by
+ * bisection, reusing the decoded points, the weights, and the interpolation polynomials. The right
+ * half of a range is checked without any MSMs, from the sums of the range and of its left half.
  */
-static C_KZG_RET compute_commitment_to_aggregated_interpolation_poly(
-    g1_t *commitment_out,
-    const fr_t *r_powers,
+static C_KZG_RET verify_cell_kzg_proof_batch_impl(
+    bool *ok,
+    uint64_t *invalid_out,
+    uint64_t *num_invalid_out,
+    const Bytes48 *commitments_bytes,
+    size_t num_commitments,
+    const uint64_t *commitment_indices,
     const uint64_t *cell_indices,
     const Cell *cells,
+    const Bytes48 *proofs_bytes,
     uint64_t num_cells,
     const KZGSettings *s
 ) {
     C_KZG_RET ret;
-    bool *is_cell_used = NULL;
-    fr_t *aggregated_column_cells = NULL;
-    fr_t *column_interpolation_poly = NULL;
-    fr_t *aggregated_interpolation_poly = NULL;
+    CellProofBatch batch;
 
-    ////////////////////////////////////////////////////////////////////////////////////////////////
-    // Array allocations
-    ////////////////////////////////////////////////////////////////////////////////////////////////
+    *ok = false;
+    if (invalid_out != NULL) *num_invalid_out = 0;
 
-    ret = new_bool_array(&is_cell_used, CELLS_PER_EXT_BLOB);
-    if (ret != C_KZG_OK) goto out;
-    ret = new_fr_array(&aggregated_column_cells, FIELD_ELEMENTS_PER_EXT_BLOB);
-    if (ret != C_KZG_OK) goto out;
-    ret = new_fr_array(&column_interpolation_poly, FIELD_ELEMENTS_PER_CELL);
-    if (ret != C_KZG_OK) goto out;
-    ret = new_fr_array(&aggregated_interpolation_poly, FIELD_ELEMENTS_PER_CELL);
+    ret = new_cell_proof_batch(
+        &batch,
+        commitments_bytes,
+        num_commitments,
+        commitment_indices,
+        cell_indices,
+        cells,
+        proofs_bytes,
+        num_cells,
+        s
+    );
     if (ret != C_KZG_OK) goto out;
 
-    ////////////////////////////////////////////////////////////////////////////////////////////////
-    // Aggregate cells from the same column
-    ////////////////////////////////////////////////////////////////////////////////////////////////
-
-    /* Start with zeroed out columns */
-    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
-        for (size_t j = 0; j < FIELD_ELEMENTS_PER_CELL; j++) {
-            size_t index = i * FIELD_ELEMENTS_PER_CELL + j;
-            aggregated_column_cells[index] = FR_ZERO;
-        }
+    /* A bisection splits the batch at most 64 times, and the empty ranges match none of them */
+    if (invalid_out != NULL) {
+        ret = c_kzg_calloc((void **)&batch.range_sums, 64 + 1, sizeof(CellRangeSums));
+        if (ret != C_KZG_OK) goto out;
     }
 
-    /*
-     * Vertically collapse cells of the 2D matrix into a single array: `aggregated_column_cells`.
-     *
-     * For each provided cell, go over its field elements, and scale them by the appropriate power
-     * of r. Then aggregate all field elements on the same vertical slice into a single array.
-     */
-    for (uint64_t cell_index = 0; cell_index < num_cells; cell_index++) {
-        /* Determine which column this cell belongs to */
-        uint64_t column_index = cell_indices[cell_index];
+    /* Check the whole batch, and if it fails, find the invalid proofs */
+    ret = check_cell_proof_range(ok, &batch, 0, num_cells);
+    if (ret != C_KZG_OK || *ok || invalid_out == NULL) goto out;
 
-        /* Iterate over every field element of this cell: scale it and aggregate it */
-        for (size_t fr_index = 0; fr_index < FIELD_ELEMENTS_PER_CELL; fr_index++) {
-            fr_t original_fr, scaled_fr;
+    ret = interpolate_cell_proof_batch(&batch, num_cells);
+    if (ret != C_KZG_OK) goto out;
+    ret = locate_invalid_items(
+        invalid_out, num_invalid_out, check_cell_proof_range, &batch, num_cells
+    );
 
-            /* Get the field element at this offset */
-            size_t offset = fr_index * BYTES_PER_FIELD_ELEMENT;
-            ret = bytes_to_bls_field(
-                &original_fr, (const Bytes32 *)&cells[cell_index].bytes[offset]
-            );
-            if (ret != C_KZG_OK) goto out;
+out:
+    free_cell_proof_batch(&batch);
+    return ret;
+}
 
-            /* Scale the field element by the appropriate power of r */
-            blst_fr_mul(&scaled_fr, &original_fr, &r_powers[cell_index]);
+/**
+ * Check the cell indices, and convert the commitments of the cells to an array of unique
+ * commitments and the index of each cell's commitment in it.
+ *
+ * @param[out]  unique_out          The unique commitments, length `num_cells`
+ * @param[out]  indices_out         The index of each cell's commitment, length `num_cells`
+ * @param[out]  num_unique_out      The number of unique commitments
+ * @param[in]   commitments_bytes   The commitments for the cells, length `num_cells`
+ * @param[in]   cell_indices        The indices for the cells, length `num_cells`
+ * @param[in]   num_cells           The number of cells provided, which is not zero
+ *
+ * @remark Free both arrays afterwards, whether or not this succeeds.
+ */
+static C_KZG_RET get_unique_commitments(
+    Bytes48 **unique_out,
+    uint64_t **indices_out,
+    size_t *num_unique_out,
+    const Bytes48 *commitments_bytes,
+    const uint64_t *cell_indices,
+    uint64_t num_cells
+) {
+    C_KZG_RET ret;
 
-            /* Figure out the right index for this field element within the extended array */
-            size_t array_index = column_index * FIELD_ELEMENTS_PER_CELL + fr_index;
-            /* Aggregate the scaled field element into the array */
-            blst_fr_add(
-                &aggregated_column_cells[array_index],
-                &aggregated_column_cells[array_index],
-                &scaled_fr
-            );
-        }
-    }
+    *unique_out = NULL;
+    *indices_out = NULL;
 
     ////////////////////////////////////////////////////////////////////////////////////////////////
-    // Determine which cells are used
+    // Sanity checks
     ////////////////////////////////////////////////////////////////////////////////////////////////
 
-    /* Start with false values */
-    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
-        is_cell_used[i] = false;
-    }
-
-    /* Mark each cell index as used */
-    for (uint64_t i = 0; i < num_cells; i++) {
-        is_cell_used[cell_indices[i]] = true;
+    for (size_t i = 0; i < num_cells; i++) {
+        /* Make sure column index is valid */
+        if (cell_indices[i] >= CELLS_PER_EXT_BLOB) return C_KZG_BADARGS;
     }
 
     ////////////////////////////////////////////////////////////////////////////////////////////////
-    // Compute interpolation polynomials using the aggregated cells
+    // Deduplicate commitments
     ////////////////////////////////////////////////////////////////////////////////////////////////
 
-    /* Start with a zeroed out poly */
-    for (size_t i = 0; i < FIELD_ELEMENTS_PER_CELL; i++) {
-        aggregated_interpolation_poly[i] = FR_ZERO;
-    }
-
-    /* Interpolate each column */
-    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
-        /* We can skip columns without any cells */
-        if (!is_cell_used[i]) continue;
+    ret = c_kzg_calloc((void **)unique_out, num_cells, sizeof(Bytes48));
+    if (ret != C_KZG_OK) return ret;
+    ret = c_kzg_calloc((void **)indices_out, num_cells, sizeof(uint64_t));
+    if (ret != C_KZG_OK) return ret;
 
-        /* Offset to the first cell for this column */
-        size_t index = i * FIELD_ELEMENTS_PER_CELL;
+    /*
+     * Convert the array of cell commitments to an array of unique commitments and an array of
+     * indices to those unique commitments. We do this before the array allocations for the batch
+     * because we need to know how many commitment weights there will be.
+     */
+    *num_unique_out = num_cells;
+    memcpy(*unique_out, commitments_bytes, num_cells * sizeof(Bytes48));
+    return deduplicate_commitments(*unique_out, *indices_out, num_unique_out);
+}
 
-        /*
-         * Reach into the big array and permute the right column.
-         * No need to copy the data, we are not gonna use them again.
-         */
-        ret = bit_reversal_permutation(
-            &aggregated_column_cells[index], sizeof(fr_t), FIELD_ELEMENTS_PER_CELL
-        );
-        if (ret != C_KZG_OK) goto out;
+/**
+ * Helper function for verify_cell_kzg_proof_batch() and verify_cell_kzg_proof_batch_locate():
+ * deduplicate the commitments, then verify.
+ *
+ * @param[out]  ok                  True if the proofs are valid
+ * @param[out]  invalid_out         The indices of the invalid proofs, or NULL to not find them
+ * @param[out]  num_invalid_out     The number of invalid proofs, or NULL with `invalid_out`
+ * @param[in]   commitments_bytes   The commitments for the cells, length `num_cells`
+ * @param[in]   cell_indices        The indices for the cells, length `num_cells`
+ * @param[in]   cells               The cells to check, length `num_cells`
+ * @param[in]   proofs_bytes        The proofs for the cells, length `num_cells`
+ * @param[in]   num_cells           The number of cells provided
+ * @param[in]   s                   The trusted setup
+ */
+static C_KZG_RET verify_cell_kzg_proof_batch_dedup(
+    bool *ok,
+    uint64_t *invalid_out,
+    uint64_t *num_invalid_out,
+    const Bytes48 *commitments_bytes,
+    const uint64_t *cell_indices,
+    const Cell *cells,
+    const Bytes48 *proofs_bytes,
+    uint64_t num_cells,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+    size_t num_commitments;
 
-        /*
-         * Get interpolation polynomial for this column. To do so we first do an IDFT over the roots
-         * of unity and then we scale the coefficients by the coset factor. We can't do an IDFT
-         * directly over the coset because it's not a subgroup.
-         */
-        ret = fr_ifft(
-            column_interpolation_poly, &aggregated_column_cells[index], FIELD_ELEMENTS_PER_CELL, s
-        );
-        if (ret != C_KZG_OK) goto out;
+    /* Arrays */
+    Bytes48 *unique_commitments = NULL;
+    uint64_t *commitment_indices = NULL;
 
-        /* Shift the poly by h_k^{-1} where h_k is the coset factor for this cell */
-        fr_t inv_coset_factor;
-        get_inv_coset_shift_for_cell(&inv_coset_factor, i, s);
-        shift_poly(column_interpolation_poly, FIELD_ELEMENTS_PER_CELL, &inv_coset_factor);
+    *ok = false;
+    if (invalid_out != NULL) *num_invalid_out = 0;
 
-        /* Update the aggregated poly */
-        for (size_t k = 0; k < FIELD_ELEMENTS_PER_CELL; k++) {
-            blst_fr_add(
-                &aggregated_interpolation_poly[k],
-                &aggregated_interpolation_poly[k],
-                &column_interpolation_poly[k]
-            );
-        }
+    /* Exit early if we are given zero cells */
+    if (num_cells == 0) {
+        *ok = true;
+        return C_KZG_OK;
     }
 
-    ////////////////////////////////////////////////////////////////////////////////////////////////
-    // Commit to the aggregated interpolation polynomial
-    ////////////////////////////////////////////////////////////////////////////////////////////////
-
-    ret = g1_lincomb_fast(
-        commitment_out,
-        s->g1_values_monomial,
-        aggregated_interpolation_poly,
-        FIELD_ELEMENTS_PER_CELL
+    ret = get_unique_commitments(
+        &unique_commitments,
+        &commitment_indices,
+        &num_commitments,
+        commitments_bytes,
+        cell_indices,
+        num_cells
     );
     if (ret != C_KZG_OK) goto out;
 
+    ret = verify_cell_kzg_proof_batch_impl(
+        ok,
+        invalid_out,
+        num_invalid_out,
+        unique_commitments,
+        num_commitments,
+        commitment_indices,
+        cell_indices,
+        cells,
+        proofs_bytes,
+        num_cells,
+        s
+    );
+
 out:
-    c_kzg_free(is_cell_used);
-    c_kzg_free(aggregated_column_cells);
-    c_kzg_free(column_interpolation_poly);
-    c_kzg_free(aggregated_interpolation_poly);
+    c_kzg_free(unique_commitments);
+    c_kzg_free(commitment_indices);
     return ret;
 }
 
 /**
- * Compute weighted sum of proofs.
+ * Given some cells, verify that their proofs are valid.
  *
- * @param[out]  weighted_proof_lincomb  The resulting G1 sum of the proofs scaled by coset factors
- * @param[in]   proofs_g1               Array of proofs, length `num_cells`
- * @param[in]   r_powers                Array of powers of r used for weighting, length `num_cells`
- * @param[in]   cell_indices            Array of cell indices, length `num_cells`
- * @param[in]   num_cells               The number of cells
- * @param[in]   s                       The trusted setup
+ * @param[out]  ok                  True if the proofs are valid
+ * @param[in]   commitments_bytes   The commitments for the cells, length `num_cells`
+ * @param[in]   cell_indices        The indices for the cells, length `num_cells`
+ * @param[in]   cells               The cells to check, length `num_cells`
+ * @param[in]   proofs_bytes        The proofs for the cells, length `num_cells`
+ * @param[in]   num_cells           The number of cells provided
+ * @param[in]   s                   The trusted setup
  */
-static C_KZG_RET computed_weighted_sum_of_proofs(
-    g1_t *weighted_proof_sum_out,
-    const g1_t *proofs_g1,
-    const fr_t *r_powers,
+C_KZG_RET verify_cell_kzg_proof_batch(
+    bool *ok,
+    const Bytes48 *commitments_bytes,
     const uint64_t *cell_indices,
+    const Cell *cells,
+    const Bytes48 *proofs_bytes,
     uint64_t num_cells,
     const KZGSettings *s
 ) {
-    C_KZG_RET ret;
-    fr_t *weighted_powers_of_r = NULL;
-
-    ret = new_fr_array(&weighted_powers_of_r, num_cells);
-    if (ret != C_KZG_OK) goto out;
-
-    for (uint64_t i = 0; i < num_cells; i++) {
-        /* Get scaling factor h_k^n where h_k is the coset factor for this cell */
-        fr_t h_k_pow;
-        get_coset_shift_pow_for_cell(&h_k_pow, cell_indices[i], s);
-
-        /* Scale the power of r by h_k^n */
-        blst_fr_mul(&weighted_powers_of_r[i], &r_powers[i], &h_k_pow);
-    }
-
-    ret = g1_lincomb_fast(weighted_proof_sum_out, proofs_g1, weighted_powers_of_r, num_cells);
+    return verify_cell_kzg_proof_batch_dedup(
+        ok, NULL, NULL, commitments_bytes, cell_indices, cells, proofs_bytes, num_cells, s
+    );
+}
 
-out:
-    c_kzg_free(weighted_powers_of_r);
-    return ret;
+/**
+ * Same as verify_cell_kzg_proof_batch(), but if the batch fails, also find which proofs are
+ * invalid.
+ *
+ * @param[out]  ok                  True if the proofs are valid
+ * @param[out]  invalid_out         The indices of the invalid proofs, in order, length up to
+ *                                  `num_cells`
+ * @param[out]  num_invalid_out     The number of invalid proofs
+ * @param[in]   commitments_bytes   The commitments for the cells, length `num_cells`
+ * @param[in]   cell_indices        The indices for the cells, length `num_cells`
+ * @param[in]   cells               The cells to check, length `num_cells`
+ * @param[in]   proofs_bytes        The proofs for the cells, length `num_cells`
+ * @param[in]   num_cells           The number of cells provided
+ * @param[in]   s                   The trusted setup
+ *
+ * @remark The invalid proofs are found by bisection, which reuses the decoded proofs and
+ * commitments and the random challenge. With a few invalid proofs, this takes a number of
+ * pairings which is logarithmic in `num_cells`.
+ * @remark Like verify_cell_kzg_proof_batch(), this returns C_KZG_BADARGS if any input cannot be
+ * decoded, rather than reporting it as invalid.
+ */
+C_KZG_RET verify_cell_kzg_proof_batch_locate(
+    bool *ok,
+    uint64_t *invalid_out,
+    uint64_t *num_invalid_out,
+    const Bytes48 *commitments_bytes,
+    const uint64_t *cell_indices,
+    const Cell *cells,
+    const Bytes48 *proofs_bytes,
+    uint64_t num_cells,
+    const KZGSettings *s
+) {
+    return verify_cell_kzg_proof_batch_dedup(
+        ok,
+        invalid_out,
+        num_invalid_out,
+        commitments_bytes,
+        cell_indices,
+        cells,
+        proofs_bytes,
+        num_cells,
+        s
+    );
 }
 
 /**
- * Given some cells, verify that their proofs are valid.
+ * Same as verify_cell_kzg_proof_batch(), but with each commitment given once and referred to by
+ * index, as in a data column sidecar. This skips deduplicating the commitments.
  *
  * @param[out]  ok                  True if the proofs are valid
- * @param[in]   commitments_bytes   The commitments for the cells, length `num_cells`
+ * @param[in]   commitments_bytes   The commitments, length `num_commitments`
+ * @param[in]   num_commitments     The number of commitments
+ * @param[in]   commitment_indices  The index in `commitments_bytes` of each cell's commitment,
+ *                                  length `num_cells`
  * @param[in]   cell_indices        The indices for the cells, length `num_cells`
  * @param[in]   cells               The cells to check, length `num_cells`
  * @param[in]   proofs_bytes        The proofs for the cells, length `num_cells`
  * @param[in]   num_cells           The number of cells provided
  * @param[in]   s                   The trusted setup
+ *
+ * @remark This gives the same result as verify_cell_kzg_proof_batch() with the commitments of the
+ * cells spelled out. If the commitments are unique and in order of first use, it is also the same
+ * check, with the same random challenge.
  */
-C_KZG_RET verify_cell_kzg_proof_batch(
+C_KZG_RET verify_cell_kzg_proof_batch_unique(
     bool *ok,
     const Bytes48 *commitments_bytes,
+    uint64_t num_commitments,
+    const uint64_t *commitment_indices,
     const uint64_t *cell_indices,
     const Cell *cells,
     const Bytes48 *proofs_bytes,
     uint64_t num_cells,
     const KZGSettings *s
 ) {
-    C_KZG_RET ret;
-    g1_t interpolation_poly_commit;
-    g1_t final_g1_sum;
-    g1_t proof_lincomb;
-    g1_t weighted_sum_of_proofs;
-    g2_t power_of_s = s->g2_values_monomial[FIELD_ELEMENTS_PER_CELL];
-    size_t num_commitments;
-
-    /* Arrays */
-    Bytes48 *unique_commitments = NULL;
-    uint64_t *commitment_indices = NULL;
-    fr_t *r_powers = NULL;
-    g1_t *proofs_g1 = NULL;
-
     *ok = false;
 
     /* Exit early if we are given zero cells */
@@ -828,119 +2095,424 @@ C_KZG_RET verify_cell_kzg_proof_batch(
         return C_KZG_OK;
     }
 
-    ////////////////////////////////////////////////////////////////////////////////////////////////
-    // Sanity checks
-    ////////////////////////////////////////////////////////////////////////////////////////////////
-
     for (size_t i = 0; i < num_cells; i++) {
-        /* Make sure column index is valid */
+        /* Make sure column and commitment indices are valid */
         if (cell_indices[i] >= CELLS_PER_EXT_BLOB) return C_KZG_BADARGS;
+        if (commitment_indices[i] >= num_commitments) return C_KZG_BADARGS;
     }
 
-    ////////////////////////////////////////////////////////////////////////////////////////////////
-    // Deduplicate commitments
-    ////////////////////////////////////////////////////////////////////////////////////////////////
+    return verify_cell_kzg_proof_batch_impl(
+        ok,
+        NULL,
+        NULL,
+        commitments_bytes,
+        num_commitments,
+        commitment_indices,
+        cell_indices,
+        cells,
+        proofs_bytes,
+        num_cells,
+        s
+    );
+}
 
-    ret = c_kzg_calloc((void **)&unique_commitments, num_cells, sizeof(Bytes48));
-    if (ret != C_KZG_OK) goto out;
-    ret = c_kzg_calloc((void **)&commitment_indices, num_cells, sizeof(uint64_t));
-    if (ret != C_KZG_OK) goto out;
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Streaming Verification
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    /*
-     * Convert the array of cell commitments to an array of unique commitments and an array of
-     * indices to those unique commitments. We do this before the array allocations section below
-     * because we need to know how many commitment weights there will be.
-     */
-    num_commitments = num_cells;
-    memcpy(unique_commitments, commitments_bytes, num_cells * sizeof(Bytes48));
-    deduplicate_commitments(unique_commitments, commitment_indices, &num_commitments);
+/**
+ * Start verifying cell proofs which arrive over time, such as data column sidecars.
+ *
+ * @param[out]  out     The accumulator
+ * @param[in]   s       The trusted setup
+ *
+ * @remark Add cells with add_to_cell_proof_accumulator(), check them all with one pairing with
+ * finalize_cell_proof_accumulator(), and free afterwards with free_cell_proof_accumulator().
+ */
+C_KZG_RET new_cell_proof_accumulator(CellProofAccumulator **out, const KZGSettings *s) {
+    C_KZG_RET ret;
+    CellProofAccumulator *acc = NULL;
 
-    ////////////////////////////////////////////////////////////////////////////////////////////////
-    // Array allocations
-    ////////////////////////////////////////////////////////////////////////////////////////////////
+    /* Ensure that the domain string is the correct length */
+    assert(strlen(RANDOM_CHALLENGE_DOMAIN_CELL_PROOF_ACCUMULATOR) == DOMAIN_STR_LENGTH);
+
+    ret = c_kzg_malloc((void **)&acc, sizeof(CellProofAccumulator));
+    if (ret != C_KZG_OK) return ret;
+
+    acc->s = s;
+    acc->lhs_sum = G1_IDENTITY;
+    acc->proof_sum = G1_IDENTITY;
+    acc->num_added = 0;
+    blst_sha256(
+        acc->digest.bytes,
+        (const uint8_t *)RANDOM_CHALLENGE_DOMAIN_CELL_PROOF_ACCUMULATOR,
+        DOMAIN_STR_LENGTH
+    );
 
-    ret = new_fr_array(&r_powers, num_cells);
-    if (ret != C_KZG_OK) goto out;
-    ret = new_g1_array(&proofs_g1, num_cells);
-    if (ret != C_KZG_OK) goto out;
+    *out = acc;
+    return C_KZG_OK;
+}
 
-    ////////////////////////////////////////////////////////////////////////////////////////////////
-    // Compute powers of r, and extract KZG proofs out of input bytes
-    ////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Free an accumulator.
+ *
+ * @param[in,out]   acc     The accumulator to free, set to NULL
+ *
+ * @remark This does nothing if `*acc` is NULL.
+ */
+void free_cell_proof_accumulator(CellProofAccumulator **acc) {
+    CellProofAccumulator *a = *acc;
+    if (a == NULL) return;
+    *acc = NULL;
+    c_kzg_free(a);
+}
 
-    /*
-     * Derive random factors for the linear combination. The exponents start with 0. That is, they
-     * are r^0, r^1, r^2, r^3, and so on.
-     */
-    ret = compute_r_powers_for_verify_cell_kzg_proof_batch(
-        r_powers,
+/**
+ * Add cells to be verified, such as the cells of one data column sidecar.
+ *
+ * The proofs and commitments are decoded, and the cells are reduced to the two sides of a pairing
+ * check, as in verify_cell_kzg_proof_batch(). Those are added to the accumulator's two running
+ * sums, so it takes the same memory however many cells are added, and the arrays can be reused as
+ * soon as this returns.
+ *
+ * @param[in,out]   acc                 The accumulator
+ * @param[in]       commitments_bytes   The commitments for the cells, length `num_cells`
+ * @param[in]       cell_indices        The indices for the cells, length `num_cells`
+ * @param[in]       cells               The cells to check, length `num_cells`
+ * @param[in]       proofs_bytes        The proofs for the cells, length `num_cells`
+ * @param[in]       num_cells           The number of cells provided
+ *
+ * @remark If this fails, for example with C_KZG_BADARGS for a proof which cannot be decoded, the
+ * accumulator is left as it was.
+ */
+C_KZG_RET add_to_cell_proof_accumulator(
+    CellProofAccumulator *acc,
+    const Bytes48 *commitments_bytes,
+    const uint64_t *cell_indices,
+    const Cell *cells,
+    const Bytes48 *proofs_bytes,
+    uint64_t num_cells
+) {
+    C_KZG_RET ret;
+    size_t num_commitments;
+    CellProofBatch batch;
+    g1_t lhs, proof_lincomb, weighted;
+    fr_t weight;
+    uint8_t bytes[sizeof(Bytes32) + 2 * sizeof(Bytes48)];
+
+    /* Arrays */
+    Bytes48 *unique_commitments = NULL;
+    uint64_t *commitment_indices = NULL;
+
+    /* There is nothing to do for zero cells */
+    if (num_cells == 0) return C_KZG_OK;
+
+    /* Nothing has been allocated yet */
+    batch.commitments_g1 = NULL;
+    batch.cells_fr = NULL;
+    batch.interpolation_polys = NULL;
+    batch.proofs_g1 = NULL;
+    batch.r_powers = NULL;
+    batch.range_sums = NULL;
+
+    ret = get_unique_commitments(
+        &unique_commitments,
+        &commitment_indices,
+        &num_commitments,
+        commitments_bytes,
+        cell_indices,
+        num_cells
+    );
+    if (ret != C_KZG_OK) goto out;
+
+    ret = new_cell_proof_batch(
+        &batch,
         unique_commitments,
         num_commitments,
         commitment_indices,
         cell_indices,
         cells,
         proofs_bytes,
-        num_cells
+        num_cells,
+        acc->s
     );
     if (ret != C_KZG_OK) goto out;
 
-    /* There should be a proof for each cell */
-    for (size_t i = 0; i < num_cells; i++) {
-        ret = bytes_to_kzg_proof(&proofs_g1[i], &proofs_bytes[i]);
-        if (ret != C_KZG_OK) goto out;
+    ret = compute_cell_proof_range_sums(&lhs, &proof_lincomb, &batch, 0, num_cells);
+    if (ret != C_KZG_OK) goto out;
+
+    /* Hash the two sides into the digest, then weight them with a challenge taken from it */
+    memcpy(bytes, acc->digest.bytes, sizeof(Bytes32));
+    bytes_from_g1((Bytes48 *)&bytes[sizeof(Bytes32)], &lhs);
+    bytes_from_g1((Bytes48 *)&bytes[sizeof(Bytes32) + sizeof(Bytes48)], &proof_lincomb);
+    blst_sha256(acc->digest.bytes, bytes, sizeof(bytes));
+    hash_to_bls_field(&weight, &acc->digest);
+
+    g1_mul(&weighted, &lhs, &weight);
+    blst_p1_add_or_double(&acc->lhs_sum, &acc->lhs_sum, &weighted);
+    g1_mul(&weighted, &proof_lincomb, &weight);
+    blst_p1_add_or_double(&acc->proof_sum, &acc->proof_sum, &weighted);
+    acc->num_added++;
+
+out:
+    free_cell_proof_batch(&batch);
+    c_kzg_free(unique_commitments);
+    c_kzg_free(commitment_indices);
+    return ret;
+}
+
+/**
+ * Verify all of the cells added to an accumulator, with one pairing.
+ *
+ * @param[out]  ok      True if all of the proofs are valid, otherwise false
+ * @param[in]   acc     The accumulator
+ *
+ * @remark This accepts if nothing has been added. The accumulator is not changed, so more cells
+ * can be added and this called again.
+ */
+C_KZG_RET finalize_cell_proof_accumulator(bool *ok, const CellProofAccumulator *acc) {
+    g2_t power_of_s = acc->s->g2_values_monomial[FIELD_ELEMENTS_PER_CELL];
+
+    /* Exit early if nothing has been added */
+    if (acc->num_added == 0) {
+        *ok = true;
+        return C_KZG_OK;
     }
 
-    ////////////////////////////////////////////////////////////////////////////////////////////////
-    // Compute random linear combination of the proofs
-    ////////////////////////////////////////////////////////////////////////////////////////////////
+    /* Do the final pairing check */
+    *ok = pairings_verify(&acc->lhs_sum, blst_p2_generator(), &acc->proof_sum, &power_of_s);
+    return C_KZG_OK;
+}
 
-    ret = g1_lincomb_fast(&proof_lincomb, proofs_g1, r_powers, num_cells);
-    if (ret != C_KZG_OK) goto out;
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Context Variants
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    ////////////////////////////////////////////////////////////////////////////////////////////////
-    // Compute sum of the commitments
-    ////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Same as compute_cells_and_kzg_proofs(), but takes the temporaries from a context.
+ *
+ * @param[in,out]   ctx     The scratch context for this thread
+ */
+C_KZG_RET compute_cells_and_kzg_proofs_ctx(
+    KZGContext *ctx, Cell *cells, KZGProof *proofs, const Blob *blob, const KZGSettings *s
+) {
+    C_KZG_RET ret;
 
-    ret = compute_weighted_sum_of_commitments(
-        &final_g1_sum, unique_commitments, commitment_indices, r_powers, num_commitments, num_cells
-    );
-    if (ret != C_KZG_OK) goto out;
+    ret = enter_kzg_context(ctx);
+    if (ret != C_KZG_OK) return ret;
+    ret = compute_cells_and_kzg_proofs(cells, proofs, blob, s);
+    leave_kzg_context(ctx);
+    return ret;
+}
 
-    ////////////////////////////////////////////////////////////////////////////////////////////////
-    // Commit to aggregated interpolation polynomial
-    ////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Same as compute_cells_and_kzg_proofs_batch(), but takes the temporaries from a context.
+ *
+ * @param[in,out]   ctx     The scratch context for this thread
+ */
+C_KZG_RET compute_cells_and_kzg_proofs_batch_ctx(
+    KZGContext *ctx,
+    Cell *cells,
+    KZGProof *proofs,
+    const Blob *blobs,
+    uint64_t num_blobs,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
 
-    /* Aggregate cells from same columns, sum interpolation polynomials, and commit */
-    ret = compute_commitment_to_aggregated_interpolation_poly(
-        &interpolation_poly_commit, r_powers, cell_indices, cells, num_cells, s
-    );
-    if (ret != C_KZG_OK) goto out;
+    ret = enter_kzg_context(ctx);
+    if (ret != C_KZG_OK) return ret;
+    ret = compute_cells_and_kzg_proofs_batch(cells, proofs, blobs, num_blobs, s);
+    leave_kzg_context(ctx);
+    return ret;
+}
 
-    /* Subtract commitment from sum by adding the negated commitment */
-    blst_p1_cneg(&interpolation_poly_commit, true);
-    blst_p1_add(&final_g1_sum, &final_g1_sum, &interpolation_poly_commit);
+/**
+ * Same as compute_blob_sidecar(), but takes the temporaries from a context.
+ *
+ * @param[in,out]   ctx     The scratch context for this thread
+ */
+C_KZG_RET compute_blob_sidecar_ctx(
+    KZGContext *ctx,
+    KZGCommitment *commitment_out,
+    KZGProof *proof_out,
+    Cell *cells,
+    KZGProof *proofs,
+    const Blob *blob,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
 
-    ////////////////////////////////////////////////////////////////////////////////////////////////
-    // Compute sum of the proofs scaled by the coset factors
-    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ret = enter_kzg_context(ctx);
+    if (ret != C_KZG_OK) return ret;
+    ret = compute_blob_sidecar(commitment_out, proof_out, cells, proofs, blob, s);
+    leave_kzg_context(ctx);
+    return ret;
+}
+
+/**
+ * Same as compute_cells_for_indices(), but takes the temporaries from a context.
+ *
+ * @param[in,out]   ctx     The scratch context for this thread
+ */
+C_KZG_RET compute_cells_for_indices_ctx(
+    KZGContext *ctx,
+    Cell *cells,
+    const Blob *blob,
+    const uint64_t *cell_indices,
+    uint64_t num_cells,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+
+    ret = enter_kzg_context(ctx);
+    if (ret != C_KZG_OK) return ret;
+    ret = compute_cells_for_indices(cells, blob, cell_indices, num_cells, s);
+    leave_kzg_context(ctx);
+    return ret;
+}
+
+/**
+ * Same as compute_cell_kzg_proofs_for_indices(), but takes the temporaries from a context.
+ *
+ * @param[in,out]   ctx     The scratch context for this thread
+ */
+C_KZG_RET compute_cell_kzg_proofs_for_indices_ctx(
+    KZGContext *ctx,
+    KZGProof *proofs,
+    const Blob *blob,
+    const uint64_t *cell_indices,
+    uint64_t num_cells,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+
+    ret = enter_kzg_context(ctx);
+    if (ret != C_KZG_OK) return ret;
+    ret = compute_cell_kzg_proofs_for_indices(proofs, blob, cell_indices, num_cells, s);
+    leave_kzg_context(ctx);
+    return ret;
+}
+
+/**
+ * Same as recover_cells_and_kzg_proofs(), but takes the temporaries from a context.
+ *
+ * @param[in,out]   ctx     The scratch context for this thread
+ */
+C_KZG_RET recover_cells_and_kzg_proofs_ctx(
+    KZGContext *ctx,
+    Cell *recovered_cells,
+    KZGProof *recovered_proofs,
+    const uint64_t *cell_indices,
+    const Cell *cells,
+    uint64_t num_cells,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
 
-    ret = computed_weighted_sum_of_proofs(
-        &weighted_sum_of_proofs, proofs_g1, r_powers, cell_indices, num_cells, s
+    ret = enter_kzg_context(ctx);
+    if (ret != C_KZG_OK) return ret;
+    ret = recover_cells_and_kzg_proofs(
+        recovered_cells, recovered_proofs, cell_indices, cells, num_cells, s
     );
-    if (ret != C_KZG_OK) goto out;
+    leave_kzg_context(ctx);
+    return ret;
+}
 
-    blst_p1_add(&final_g1_sum, &final_g1_sum, &weighted_sum_of_proofs);
+/**
+ * Same as verify_cell_kzg_proof_batch(), but takes the temporaries from a context.
+ *
+ * @param[in,out]   ctx     The scratch context for this thread
+ */
+C_KZG_RET verify_cell_kzg_proof_batch_ctx(
+    KZGContext *ctx,
+    bool *ok,
+    const Bytes48 *commitments_bytes,
+    const uint64_t *cell_indices,
+    const Cell *cells,
+    const Bytes48 *proofs_bytes,
+    uint64_t num_cells,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
 
-    ////////////////////////////////////////////////////////////////////////////////////////////////
-    // Do the final pairing check
-    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ret = enter_kzg_context(ctx);
+    if (ret != C_KZG_OK) return ret;
+    ret = verify_cell_kzg_proof_batch(
+        ok, commitments_bytes, cell_indices, cells, proofs_bytes, num_cells, s
+    );
+    leave_kzg_context(ctx);
+    return ret;
+}
 
-    *ok = pairings_verify(&final_g1_sum, blst_p2_generator(), &proof_lincomb, &power_of_s);
+/**
+ * Same as verify_cell_kzg_proof_batch_locate(), but takes the temporaries from a context.
+ *
+ * @param[in,out]   ctx     The scratch context for this thread
+ */
+C_KZG_RET verify_cell_kzg_proof_batch_locate_ctx(
+    KZGContext *ctx,
+    bool *ok,
+    uint64_t *invalid_out,
+    uint64_t *num_invalid_out,
+    const Bytes48 *commitments_bytes,
+    const uint64_t *cell_indices,
+    const Cell *cells,
+    const Bytes48 *proofs_bytes,
+    uint64_t num_cells,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
 
-out:
-    c_kzg_free(unique_commitments);
-    c_kzg_free(commitment_indices);
-    c_kzg_free(r_powers);
-    c_kzg_free(proofs_g1);
+    ret = enter_kzg_context(ctx);
+    if (ret != C_KZG_OK) return ret;
+    ret = verify_cell_kzg_proof_batch_locate(
+        ok,
+        invalid_out,
+        num_invalid_out,
+        commitments_bytes,
+        cell_indices,
+        cells,
+        proofs_bytes,
+        num_cells,
+        s
+    );
+    leave_kzg_context(ctx);
+    return ret;
+}
+
+/**
+ * Same as verify_cell_kzg_proof_batch_unique(), but takes the temporaries from a context.
+ *
+ * @param[in,out]   ctx     The scratch context for this thread
+ */
+C_KZG_RET verify_cell_kzg_proof_batch_unique_ctx(
+    KZGContext *ctx,
+    bool *ok,
+    const Bytes48 *commitments_bytes,
+    uint64_t num_commitments,
+    const uint64_t *commitment_indices,
+    const uint64_t *cell_indices,
+    const Cell *cells,
+    const Bytes48 *proofs_bytes,
+    uint64_t num_cells,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+
+    ret = enter_kzg_context(ctx);
+    if (ret != C_KZG_OK) return ret;
+    ret = verify_cell_kzg_proof_batch_unique(
+        ok,
+        commitments_bytes,
+        num_commitments,
+        commitment_indices,
+        cell_indices,
+        cells,
+        proofs_bytes,
+        num_cells,
+        s
+    );
+    leave_kzg_context(ctx);
     return ret;
 }
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "common/alloc.h"
 #include "common/bytes.h"
 #include "common/ret.h"
 #include "eip4844/blob.h"
@@ -23,6 +24,13 @@
 #include "eip7594/cell.h"
 #include "setup/settings.h"
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Types
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** Cell proofs to verify together later, see new_cell_proof_accumulator(). */
+typedef struct CellProofAccumulator CellProofAccumulator;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Public Functions
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -35,6 +43,55 @@ C_KZG_RET compute_cells_and_kzg_proofs(
     Cell *cells, KZGProof *proofs, const Blob *blob, const KZGSettings *s
 );
 
+C_KZG_RET compute_cells_and_kzg_proofs_batch(
+    Cell *cells, KZGProof *proofs, const Blob *blobs, uint64_t num_blobs, const KZGSettings *s
+);
+
+C_KZG_RET compute_cells_and_kzg_proofs_poly(
+    Cell *cells, KZGProof *proofs, KZGPolynomial *poly, const KZGSettings *s
+);
+
+C_KZG_RET compute_blob_sidecar(
+    KZGCommitment *commitment_out,
+    KZGProof *proof_out,
+    Cell *cells,
+    KZGProof *proofs,
+    const Blob *blob,
+    const KZGSettings *s
+);
+
+C_KZG_RET compute_cells_for_indices(
+    Cell *cells,
+    const Blob *blob,
+    const uint64_t *cell_indices,
+    uint64_t num_cells,
+    const KZGSettings *s
+);
+
+C_KZG_RET compute_cells_for_indices_poly(
+    Cell *cells,
+    KZGPolynomial *poly,
+    const uint64_t *cell_indices,
+    uint64_t num_cells,
+    const KZGSettings *s
+);
+
+C_KZG_RET compute_cell_kzg_proofs_for_indices(
+    KZGProof *proofs,
+    const Blob *blob,
+    const uint64_t *cell_indices,
+    uint64_t num_cells,
+    const KZGSettings *s
+);
+
+C_KZG_RET compute_cell_kzg_proofs_for_indices_poly(
+    KZGProof *proofs,
+    KZGPolynomial *poly,
+    const uint64_t *cell_indices,
+    uint64_t num_cells,
+    const KZGSettings *s
+);
+
 C_KZG_RET recover_cells_and_kzg_proofs(
     Cell *recovered_cells,
     KZGProof *recovered_proofs,
@@ -54,6 +111,132 @@ C_KZG_RET verify_cell_kzg_proof_batch(
     const KZGSettings *s
 );
 
+C_KZG_RET verify_cell_kzg_proof_batch_locate(
+    bool *ok,
+    uint64_t *invalid_out,
+    uint64_t *num_invalid_out,
+    const Bytes48 *commitments_bytes,
+    const uint64_t *cell_indices,
+    const Cell *cells,
+    const Bytes48 *proofs_bytes,
+    uint64_t num_cells,
+    const KZGSettings *s
+);
+
+C_KZG_RET verify_cell_kzg_proof_batch_unique(
+    bool *ok,
+    const Bytes48 *commitments_bytes,
+    uint64_t num_commitments,
+    const uint64_t *commitment_indices,
+    const uint64_t *cell_indices,
+    const Cell *cells,
+    const Bytes48 *proofs_bytes,
+    uint64_t num_cells,
+    const KZGSettings *s
+);
+
+C_KZG_RET new_cell_proof_accumulator(CellProofAccumulator **out, const KZGSettings *s);
+void free_cell_proof_accumulator(CellProofAccumulator **acc);
+
+C_KZG_RET add_to_cell_proof_accumulator(
+    CellProofAccumulator *acc,
+    const Bytes48 *commitments_bytes,
+    const uint64_t *cell_indices,
+    const Cell *cells,
+    const Bytes48 *proofs_bytes,
+    uint64_t num_cells
+);
+
+C_KZG_RET finalize_cell_proof_accumulator(bool *ok, const CellProofAccumulator *acc);
+
+C_KZG_RET compute_cells_and_kzg_proofs_ctx(
+    KZGContext *ctx, Cell *cells, KZGProof *proofs, const Blob *blob, const KZGSettings *s
+);
+
+C_KZG_RET compute_cells_and_kzg_proofs_batch_ctx(
+    KZGContext *ctx,
+    Cell *cells,
+    KZGProof *proofs,
+    const Blob *blobs,
+    uint64_t num_blobs,
+    const KZGSettings *s
+);
+
+C_KZG_RET compute_blob_sidecar_ctx(
+    KZGContext *ctx,
+    KZGCommitment *commitment_out,
+    KZGProof *proof_out,
+    Cell *cells,
+    KZGProof *proofs,
+    const Blob *blob,
+    const KZGSettings *s
+);
+
+C_KZG_RET compute_cells_for_indices_ctx(
+    KZGContext *ctx,
+    Cell *cells,
+    const Blob *blob,
+    const uint64_t *cell_indices,
+    uint64_t num_cells,
+    const KZGSettings *s
+);
+
+C_KZG_RET compute_cell_kzg_proofs_for_indices_ctx(
+    KZGContext *ctx,
+    KZGProof *proofs,
+    const Blob *blob,
+    const uint64_t *cell_indices,
+    uint64_t num_cells,
+    const KZGSettings *s
+);
+
+C_KZG_RET recover_cells_and_kzg_proofs_ctx(
+    KZGContext *ctx,
+    Cell *recovered_cells,
+    KZGProof *recovered_proofs,
+    const uint64_t *cell_indices,
+    const Cell *cells,
+    uint64_t num_cells,
+    const KZGSettings *s
+);
+
+C_KZG_RET verify_cell_kzg_proof_batch_ctx(
+    KZGContext *ctx,
+    bool *ok,
+    const Bytes48 *commitments_bytes,
+    const uint64_t *cell_indices,
+    const Cell *cells,
+    const Bytes48 *proofs_bytes,
+    uint64_t num_cells,
+    const KZGSettings *s
+);
+
+C_KZG_RET verify_cell_kzg_proof_batch_locate_ctx(
+    KZGContext *ctx,
+    bool *ok,
+    uint64_t *invalid_out,
+    uint64_t *num_invalid_out,
+    const Bytes48 *commitments_bytes,
+    const uint64_t *cell_indices,
+    const Cell *cells,
+    const Bytes48 *proofs_bytes,
+    uint64_t num_cells,
+    const KZGSettings *s
+);
+
+C_KZG_RET verify_cell_kzg_proof_batch_unique_ctx(
+    KZGContext *ctx,
+    bool *ok,
+    const Bytes48 *commitments_bytes,
+    uint64_t num_commitments,
+    const uint64_t *commitment_indices,
+    const uint64_t *cell_indices,
+    const Cell *cells,
+    const Bytes48 *proofs_bytes,
+    uint64_t num_cells,
+    const KZGSettings *s
+);
+
 #ifdef __cplusplus
 }
 #endif
@@ -17,9 +17,12 @@
 #include "eip7594/fk20.h"
 #include "common/alloc.h"
 #include "common/lincomb.h"
+#include "common/pages.h"
 #include "eip7594/cell.h"
 #include "eip7594/fft.h"
+#include "setup/prover.h"
 
+#include <stdint.h> /* For uint8_t */
 #include <stdlib.h> /* For NULL */
 
 /**
@@ -136,17 +139,58 @@ static void circulant_coeffs_stride(fr_t *out, const fr_t *in, size_t offset) {
  * the code is supposed to work also for l=1, which is the case of FK20 regular (single) proofs.
  */
 C_KZG_RET compute_fk20_cell_proofs(g1_t *out, const fr_t *poly, const KZGSettings *s) {
+    const fr_t *polys[1] = {poly};
+    return compute_fk20_cell_proofs_multi(out, polys, 1, s);
+}
+
+/**
+ * Compute FK20 cell-proofs for several polynomials at once.
+ *
+ * This does the same as compute_fk20_cell_proofs() for each polynomial, but the step 5 MSMs are
+ * done row by row rather than polynomial by polynomial. All of the MSMs for a row use the same
+ * precomputed table (or the same points, with Pippenger), so it is read from memory once per row
+ * rather than once per row and polynomial. With precomputation the tables are far larger than the
+ * caches, so this makes a large difference when computing proofs for many blobs.
+ *
+ * @param[out]  out         An array of `num_polys * CELLS_PER_EXT_BLOB` proofs, one set per poly
+ * @param[in]   polys       Array of polynomials, each FIELD_ELEMENTS_PER_BLOB coefficients
+ * @param[in]   num_polys   The number of polynomials
+ * @param[in]   s           The trusted setup
+ *
+ * @remark This needs `num_polys` times more scratch memory than a single polynomial, about 300 KiB
+ * per polynomial, so callers should split very large batches into groups.
+ */
+C_KZG_RET compute_fk20_cell_proofs_multi(
+    g1_t *out, const fr_t *const *polys, size_t num_polys, const KZGSettings *s
+) {
     C_KZG_RET ret;
     size_t circulant_domain_size;
 
     blst_scalar *scalars = NULL;
-    fr_t **coeffs = NULL;
+    fr_t *coeffs = NULL;
     fr_t *circulant_coeffs = NULL;     /* The vectors c_i */
     fr_t *circulant_coeffs_fft = NULL; /* The vectors w_i */
     g1_t *v = NULL;
     g1_t *u = NULL;
+    g1_t *row_sums = NULL;
     limb_t *scratch = NULL;
-    bool precompute = s->wbits != 0;
+    const FK20Tables *tables;
+    bool precompute;
+    const uint8_t *local_block = NULL;
+    uint64_t epoch;
+
+    /* Nothing to do */
+    if (num_polys == 0) return C_KZG_OK;
+
+    /* The tables may be replaced by another thread, but not until this call releases them */
+    tables = acquire_fk20_tables(&epoch, s);
+    precompute = tables != NULL;
+
+    /* Use the copy of the tables on this thread's NUMA node, if there are copies */
+    if (precompute && tables->num_nodes != 0) {
+        size_t node = current_numa_node();
+        if (node < tables->num_nodes) local_block = tables->node_blocks[node];
+    }
 
     /*
      * Note: this constant 2 is not related to LOG_EXPANSION_FACTOR. Instead, it is to produce a
@@ -159,41 +203,41 @@ C_KZG_RET compute_fk20_cell_proofs(g1_t *out, const fr_t *poly, const KZGSetting
     if (ret != C_KZG_OK) goto out;
     ret = new_fr_array(&circulant_coeffs_fft, circulant_domain_size);
     if (ret != C_KZG_OK) goto out;
-    ret = new_g1_array(&u, circulant_domain_size);
+    ret = new_g1_array(&u, num_polys * circulant_domain_size);
     if (ret != C_KZG_OK) goto out;
     ret = new_g1_array(&v, circulant_domain_size);
     if (ret != C_KZG_OK) goto out;
+    ret = new_g1_array(&row_sums, num_polys);
+    if (ret != C_KZG_OK) goto out;
 
     if (precompute) {
         /* Allocations for fixed-base MSM */
-        ret = c_kzg_malloc((void **)&scratch, s->scratch_size);
+        size_t scratch_size = blst_p1s_mult_wbits_scratch_sizeof(FIELD_ELEMENTS_PER_CELL);
+        ret = c_kzg_malloc((void **)&scratch, scratch_size);
         if (ret != C_KZG_OK) goto out;
         ret = c_kzg_calloc((void **)&scalars, FIELD_ELEMENTS_PER_CELL, sizeof(blst_scalar));
         if (ret != C_KZG_OK) goto out;
     }
 
-    /* Allocate 2d array for coefficients by column */
-    ret = c_kzg_calloc((void **)&coeffs, circulant_domain_size, sizeof(void *));
+    /*
+     * Allocate the coefficients, by row then polynomial. So the coefficients that row j uses for
+     * polynomial k start at index (j * num_polys + k) * FIELD_ELEMENTS_PER_CELL, and the
+     * coefficients for all of the polynomials in a row are next to each other.
+     */
+    ret = new_fr_array(&coeffs, circulant_domain_size * num_polys * FIELD_ELEMENTS_PER_CELL);
     if (ret != C_KZG_OK) goto out;
-    for (size_t i = 0; i < circulant_domain_size; i++) {
-        ret = new_fr_array(&coeffs[i], FIELD_ELEMENTS_PER_CELL);
-        if (ret != C_KZG_OK) goto out;
-    }
-
-    /* Initialize values to zero */
-    for (size_t i = 0; i < circulant_domain_size; i++) {
-        u[i] = G1_IDENTITY;
-    }
 
     /* Phase 1, step 4: Compute the w_i columns */
-    for (size_t i = 0; i < FIELD_ELEMENTS_PER_CELL; i++) {
-        /* Select the coefficients c_i of poly that form the i-th circulant matrix */
-        circulant_coeffs_stride(circulant_coeffs, poly, i);
-        /* Apply FFT to get w_i */
-        ret = fr_fft(circulant_coeffs_fft, circulant_coeffs, circulant_domain_size, s);
-        if (ret != C_KZG_OK) goto out;
-        for (size_t j = 0; j < circulant_domain_size; j++) {
-            coeffs[j][i] = circulant_coeffs_fft[j];
+    for (size_t k = 0; k < num_polys; k++) {
+        for (size_t i = 0; i < FIELD_ELEMENTS_PER_CELL; i++) {
+            /* Select the coefficients c_i of poly that form the i-th circulant matrix */
+            circulant_coeffs_stride(circulant_coeffs, polys[k], i);
+            /* Apply FFT to get w_i */
+            ret = fr_fft(circulant_coeffs_fft, circulant_coeffs, circulant_domain_size, s);
+            if (ret != C_KZG_OK) goto out;
+            for (size_t j = 0; j < circulant_domain_size; j++) {
+                coeffs[(j * num_polys + k) * FIELD_ELEMENTS_PER_CELL + i] = circulant_coeffs_fft[j];
+            }
         }
     }
 
@@ -207,68 +251,85 @@ C_KZG_RET compute_fk20_cell_proofs(g1_t *out, const fr_t *poly, const KZGSetting
      *      size l with precomputation.
      *   2) Pippenger MSM without precompution: the y_i vectors are stored in s->x_ext_fft_columns
      *      then each component of the u vector is just an MSM of size l.
+     *
+     * The choice is made per row, since rows may be without a table to save memory. Each row's
+     * MSMs are done for every polynomial before moving on, while the row's bases are in cache.
      */
     for (size_t i = 0; i < circulant_domain_size; i++) {
-        if (precompute) {
-            /* Transform the field elements to 255-bit scalars */
-            for (size_t j = 0; j < FIELD_ELEMENTS_PER_CELL; j++) {
-                blst_scalar_from_fr(&scalars[j], &coeffs[i][j]);
+        const fr_t *row_coeffs = &coeffs[i * num_polys * FIELD_ELEMENTS_PER_CELL];
+        if (precompute && tables->tables[i] != NULL) {
+            const blst_p1_affine *table = tables->tables[i];
+            if (local_block != NULL) {
+                /* The copies have the same layout as the block */
+                size_t offset = (size_t)((const uint8_t *)table - (const uint8_t *)tables->block);
+                table = (const blst_p1_affine *)(const void *)(local_block + offset);
             }
-            const byte *scalars_arg[2] = {(byte *)scalars, NULL};
+            for (size_t k = 0; k < num_polys; k++) {
+                /* Transform the field elements to 255-bit scalars */
+                for (size_t j = 0; j < FIELD_ELEMENTS_PER_CELL; j++) {
+                    blst_scalar_from_fr(
+                        &scalars[j], &row_coeffs[k * FIELD_ELEMENTS_PER_CELL + j]
+                    );
+                }
+                const byte *scalars_arg[2] = {(byte *)scalars, NULL};
 
-            /* A fixed-base MSM with precomputation */
-            blst_p1s_mult_wbits(
-                &u[i],
-                s->tables[i],
-                s->wbits,
-                FIELD_ELEMENTS_PER_CELL,
-                scalars_arg,
-                BITS_PER_FIELD_ELEMENT,
-                scratch
-            );
+                /* A fixed-base MSM with precomputation */
+                blst_p1s_mult_wbits(
+                    &row_sums[k],
+                    table,
+                    tables->wbits[i],
+                    FIELD_ELEMENTS_PER_CELL,
+                    scalars_arg,
+                    BITS_PER_FIELD_ELEMENT,
+                    scratch
+                );
+            }
         } else {
-            /* A pretty fast MSM without precomputation */
-            ret = g1_lincomb_fast(
-                &u[i], s->x_ext_fft_columns[i], coeffs[i], FIELD_ELEMENTS_PER_CELL
+            /* A pretty fast MSM without precomputation, sharing the conversion of the points */
+            ret = g1_lincomb_fast_multi(
+                row_sums, s->x_ext_fft_columns[i], row_coeffs, FIELD_ELEMENTS_PER_CELL, num_polys, s
             );
             if (ret != C_KZG_OK) goto out;
         }
+        for (size_t k = 0; k < num_polys; k++) {
+            u[k * circulant_domain_size + i] = row_sums[k];
+        }
     }
 
-    /*
-     * Phase 1, step 6: Apply the inverse FFT to the u vector.
-     *
-     * The result is almost the final v vector: the second half of the vector should be set to the
-     * identity elements (commitments to zero coefficients). The v polynomial actually has degree
-     * r-1, which is guaranteed by setting the last r+1 elements of c_i vectors to be identities.
-     */
-    ret = g1_ifft(v, u, circulant_domain_size, s);
-    if (ret != C_KZG_OK) goto out;
+    for (size_t k = 0; k < num_polys; k++) {
+        /*
+         * Phase 1, step 6: Apply the inverse FFT to the u vector.
+         *
+         * The result is almost the final v vector: the second half of the vector should be set to
+         * the identity elements (commitments to zero coefficients). The v polynomial actually has
+         * degree r-1, which is guaranteed by setting the last r+1 elements of c_i vectors to be
+         * identities.
+         */
+        ret = g1_ifft(v, &u[k * circulant_domain_size], circulant_domain_size, s);
+        if (ret != C_KZG_OK) goto out;
 
-    /*
-     * Zero the second half of v to get the polynomial of degree r.
-     * We do not need to zero the r-th element as it is guaranteed to be zero.
-     */
-    for (size_t i = CELLS_PER_BLOB; i < circulant_domain_size; i++) {
-        v[i] = G1_IDENTITY;
-    }
+        /*
+         * Zero the second half of v to get the polynomial of degree r.
+         * We do not need to zero the r-th element as it is guaranteed to be zero.
+         */
+        for (size_t i = CELLS_PER_BLOB; i < circulant_domain_size; i++) {
+            v[i] = G1_IDENTITY;
+        }
 
-    /* Phase 2: Evaluate the polynomial v(X) at n points */
-    ret = g1_fft(out, v, CELLS_PER_EXT_BLOB, s);
-    if (ret != C_KZG_OK) goto out;
+        /* Phase 2: Evaluate the polynomial v(X) at n points */
+        ret = g1_fft(&out[k * CELLS_PER_EXT_BLOB], v, CELLS_PER_EXT_BLOB, s);
+        if (ret != C_KZG_OK) goto out;
+    }
 
 out:
     c_kzg_free(scalars);
-    if (coeffs != NULL) {
-        for (size_t i = 0; i < circulant_domain_size; i++) {
-            c_kzg_free(coeffs[i]);
-        }
-        c_kzg_free(coeffs);
-    }
+    c_kzg_free(coeffs);
     c_kzg_free(circulant_coeffs);
     c_kzg_free(circulant_coeffs_fft);
     c_kzg_free(v);
     c_kzg_free(u);
+    c_kzg_free(row_sums);
     c_kzg_free(scratch);
+    release_fk20_tables(s, epoch);
     return ret;
 }
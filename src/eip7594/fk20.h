@@ -30,6 +30,9 @@ extern "C" {
 #endif
 
 C_KZG_RET compute_fk20_cell_proofs(g1_t *out, const fr_t *p, const KZGSettings *s);
+C_KZG_RET compute_fk20_cell_proofs_multi(
+    g1_t *out, const fr_t *const *polys, size_t num_polys, const KZGSettings *s
+);
 
 #ifdef __cplusplus
 }
@@ -16,9 +16,11 @@
 
 #include "poly.h"
 #include "common/alloc.h"
+#include "common/atomic.h"
 #include "common/ec.h"
 #include "common/ret.h"
 #include "common/utils.h"
+#include "eip4844/polynomial.h"
 #include "eip7594/fft.h"
 #include "setup/settings.h"
 
@@ -78,3 +80,38 @@ out:
     c_kzg_free(lagrange_brp);
     return ret;
 }
+
+/**
+ * Get the monomial form of a parsed blob, computing it the first time that a call needs it.
+ *
+ * @param[out]      out     The polynomial in monomial form, FIELD_ELEMENTS_PER_EXT_BLOB
+ *                          coefficients of which the upper half is zero
+ * @param[in,out]   poly    The parsed blob, which keeps the result
+ * @param[in]       s       The trusted setup
+ *
+ * @remark This is safe to call from several threads: if they race, each computes the monomial
+ * form but only one of them is kept.
+ */
+C_KZG_RET get_poly_monomial(const fr_t **out, KZGPolynomial *poly, const KZGSettings *s) {
+    C_KZG_RET ret;
+    fr_t *monomial = NULL;
+
+    *out = atomic_load_ptr((void **)&poly->monomial);
+    if (*out != NULL) return C_KZG_OK;
+
+    /* The upper half stays zero, for evaluating over the extended domain */
+    ret = new_fr_array(&monomial, FIELD_ELEMENTS_PER_EXT_BLOB);
+    if (ret != C_KZG_OK) return ret;
+    ret = poly_lagrange_to_monomial(monomial, poly->evaluations, FIELD_ELEMENTS_PER_BLOB, s);
+    if (ret != C_KZG_OK) {
+        c_kzg_free(monomial);
+        return ret;
+    }
+
+    if (!atomic_cas_ptr((void **)&poly->monomial, NULL, monomial)) {
+        /* Another thread finished first, use its result instead */
+        c_kzg_free(monomial);
+    }
+    *out = atomic_load_ptr((void **)&poly->monomial);
+    return C_KZG_OK;
+}
@@ -18,6 +18,7 @@
 
 #include "common/fr.h"
 #include "common/ret.h"
+#include "eip4844/eip4844.h"
 #include "setup/settings.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -34,6 +35,8 @@ C_KZG_RET poly_lagrange_to_monomial(
     fr_t *monomial_out, const fr_t *lagrange, size_t len, const KZGSettings *s
 );
 
+C_KZG_RET get_poly_monomial(const fr_t **out, KZGPolynomial *poly, const KZGSettings *s);
+
 #ifdef __cplusplus
 }
 #endif
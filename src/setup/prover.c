@@ -0,0 +1,358 @@
+/*
+ * Copyright 2024 Benjamin Edgington
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "setup/prover.h"
+#include "common/alloc.h"
+#include "common/atomic.h"
+#include "setup/setup.h"
+
+#include <stdbool.h> /* For bool */
+#include <stddef.h>  /* For NULL */
+#include <string.h>  /* For memcpy */
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Types
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** What a verification profile needs to load the rest of the setup when a call needs it. */
+struct LazyProver {
+    /** The compressed points: g1 monomial, g1 Lagrange, then g2 monomial. */
+    uint8_t *bytes;
+    /** The number of bytes in each of the g1 arrays. */
+    uint64_t num_g1_bytes;
+    /** The number of bytes in the g2 array. */
+    uint64_t num_g2_bytes;
+    /** The precompute value to load the rest of the setup with. */
+    uint64_t precompute;
+    /** The setup with the Lagrange points, NULL until a commit-only call needs it. */
+    KZGSettings *committer;
+    /** The fully loaded setup, NULL until a call needs it. */
+    KZGSettings *prover;
+    /** Non-zero while a thread loads one of the setups, so that the others wait for it. */
+    uint64_t loading;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helper Functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Load the setup kept for a verification profile, with another profile.
+ *
+ * @param[out]  out     The loaded setup
+ * @param[in]   lazy    The kept setup
+ * @param[in]   s       The setup with the verification profile, to copy the MSM strategy from
+ * @param[in]   profile KZG_PROFILE_FULL, or KZG_PROFILE_VERIFY_AND_COMMIT for the Lagrange points
+ *
+ * @remark Free afterwards with free_trusted_setup() and c_kzg_free().
+ */
+static C_KZG_RET load_lazy_prover(
+    KZGSettings **out, const LazyProver *lazy, const KZGSettings *s, uint64_t profile
+) {
+    C_KZG_RET ret;
+    KZGSettings *prover = NULL;
+
+    ret = c_kzg_calloc((void **)&prover, 1, sizeof(KZGSettings));
+    if (ret != C_KZG_OK) return ret;
+
+    ret = load_trusted_setup_profile(
+        prover,
+        lazy->bytes,
+        lazy->num_g1_bytes,
+        lazy->bytes + lazy->num_g1_bytes,
+        lazy->num_g1_bytes,
+        lazy->bytes + 2 * lazy->num_g1_bytes,
+        lazy->num_g2_bytes,
+        lazy->precompute,
+        profile
+    );
+    if (ret != C_KZG_OK) {
+        c_kzg_free(prover);
+        return ret;
+    }
+    prover->naive_threshold = s->naive_threshold;
+
+    /* Calls never ask this setup for more than it has, so it needs no copy of the points */
+    free_lazy_prover(&prover->lazy);
+
+    *out = prover;
+    return C_KZG_OK;
+}
+
+/**
+ * Get the loaded setup which has what a call needs, if there is one yet.
+ *
+ * @param[in]   lazy        The kept setup
+ * @param[in]   needs_fk20  Whether the call needs the fully loaded setup
+ *
+ * @return The setup, NULL if it is not loaded yet.
+ */
+static KZGSettings *find_lazy_prover(LazyProver *lazy, bool needs_fk20) {
+    /* Once the full setup is loaded, it serves every call */
+    KZGSettings *prover = atomic_load_ptr((void **)&lazy->prover);
+    if (prover == NULL && !needs_fk20) {
+        prover = atomic_load_ptr((void **)&lazy->committer);
+    }
+    return prover;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Lazy Provers
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Keep what a verification profile needs to load the rest of the setup later.
+ *
+ * @param[out]  out                 The new lazy prover
+ * @param[in]   g1_monomial_bytes   Array of G1 points in monomial form
+ * @param[in]   g1_lagrange_bytes   Array of G1 points in Lagrange form
+ * @param[in]   num_g1_bytes        Number of bytes in each of the G1 arrays
+ * @param[in]   g2_monomial_bytes   Array of G2 points in monomial form
+ * @param[in]   num_g2_bytes        Number of bytes in the G2 array
+ * @param[in]   precompute          The precompute value for load_trusted_setup()
+ *
+ * @remark Free afterwards with free_lazy_prover().
+ */
+C_KZG_RET new_lazy_prover(
+    LazyProver **out,
+    const uint8_t *g1_monomial_bytes,
+    const uint8_t *g1_lagrange_bytes,
+    uint64_t num_g1_bytes,
+    const uint8_t *g2_monomial_bytes,
+    uint64_t num_g2_bytes,
+    uint64_t precompute
+) {
+    C_KZG_RET ret;
+    LazyProver *lazy = NULL;
+
+    ret = c_kzg_calloc((void **)&lazy, 1, sizeof(LazyProver));
+    if (ret != C_KZG_OK) goto out;
+    ret = c_kzg_malloc((void **)&lazy->bytes, 2 * num_g1_bytes + num_g2_bytes);
+    if (ret != C_KZG_OK) goto out;
+
+    memcpy(lazy->bytes, g1_monomial_bytes, num_g1_bytes);
+    memcpy(lazy->bytes + num_g1_bytes, g1_lagrange_bytes, num_g1_bytes);
+    memcpy(lazy->bytes + 2 * num_g1_bytes, g2_monomial_bytes, num_g2_bytes);
+    lazy->num_g1_bytes = num_g1_bytes;
+    lazy->num_g2_bytes = num_g2_bytes;
+    lazy->precompute = precompute;
+    lazy->committer = NULL;
+    lazy->prover = NULL;
+
+    *out = lazy;
+    lazy = NULL;
+
+out:
+    free_lazy_prover(&lazy);
+    return ret;
+}
+
+/**
+ * Free a lazy prover, and the setup it loaded if any.
+ *
+ * @param[in,out]   lazy    The lazy prover to free, set to NULL
+ *
+ * @remark This does nothing if `*lazy` is NULL.
+ */
+void free_lazy_prover(LazyProver **lazy) {
+    LazyProver *l = *lazy;
+    if (l == NULL) return;
+    *lazy = NULL;
+    if (l->committer != NULL) {
+        free_trusted_setup(l->committer);
+        c_kzg_free(l->committer);
+    }
+    if (l->prover != NULL) {
+        free_trusted_setup(l->prover);
+        c_kzg_free(l->prover);
+    }
+    c_kzg_free(l->bytes);
+    c_kzg_free(l);
+}
+
+/**
+ * Get the setup to use for a call which computes commitments or proofs.
+ *
+ * For a setup with the full profile, this is the setup itself. For a verification profile, the
+ * rest of the setup is loaded the first time that a call needs it. A call which only needs the G1
+ * points in Lagrange form loads just those, and the FK20 columns and tables are left for the first
+ * call which computes cell proofs. This is safe to call from several threads: one of them loads
+ * the setup while the others wait for it.
+ *
+ * @param[out]  out         The setup to use
+ * @param[in]   s           The trusted setup
+ * @param[in]   needs_fk20  Whether the call computes cell proofs or needs all of the G1 points in
+ *                          monomial form, rather than only needing the G1 points in Lagrange form
+ */
+C_KZG_RET get_prover_settings(const KZGSettings **out, const KZGSettings *s, bool needs_fk20) {
+    C_KZG_RET ret = C_KZG_OK;
+    LazyProver *lazy = s->lazy;
+    KZGSettings *prover;
+    KZGContext *ctx;
+
+    *out = s;
+    if (lazy == NULL) return C_KZG_OK;
+    if (!needs_fk20 && s->g1_values_lagrange_brp != NULL) return C_KZG_OK;
+
+    prover = find_lazy_prover(lazy, needs_fk20);
+    if (prover != NULL) {
+        *out = prover;
+        return C_KZG_OK;
+    }
+
+    /* The setup outlives this call, so it must not come from a `_ctx` call's context */
+    ctx = suspend_kzg_context();
+
+    /* Load the setup once, rather than once for every thread which gets here first */
+    while (!atomic_cas_u64(&lazy->loading, 0, 1)) {
+        yield_thread();
+    }
+    prover = find_lazy_prover(lazy, needs_fk20);
+    if (prover == NULL) {
+        uint64_t profile = needs_fk20 ? KZG_PROFILE_FULL : KZG_PROFILE_VERIFY_AND_COMMIT;
+        ret = load_lazy_prover(&prover, lazy, s, profile);
+        if (ret == C_KZG_OK) {
+            atomic_store_ptr((void **)(needs_fk20 ? &lazy->prover : &lazy->committer), prover);
+        }
+    }
+    atomic_sub_u64(&lazy->loading, 1);
+
+    resume_kzg_context(ctx);
+    if (ret != C_KZG_OK) return ret;
+
+    *out = prover;
+    return C_KZG_OK;
+}
+
+/**
+ * Get the setup which holds the FK20 columns and tables, so that they can be changed.
+ *
+ * @param[out]  out     The setup to change
+ * @param[in]   s       The trusted setup
+ *
+ * @remark For a verification profile, this loads the rest of the setup if it is not loaded yet.
+ */
+C_KZG_RET get_mutable_prover_settings(KZGSettings **out, KZGSettings *s) {
+    C_KZG_RET ret;
+    const KZGSettings *prover;
+
+    *out = s;
+    if (s->lazy == NULL) return C_KZG_OK;
+
+    ret = get_prover_settings(&prover, s, true);
+    if (ret != C_KZG_OK) return ret;
+    *out = s->lazy->prover;
+    return C_KZG_OK;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// FK20 Table Functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * The FK20 tables can be replaced while other threads compute proofs with them. Readers never wait:
+ * a reader counts itself in the current epoch, and reads the tables pointer once. The thread which
+ * replaces the tables stores the new pointer, moves on to the next epoch, and waits until no reader
+ * is left in the old epoch before freeing the old tables. A reader which starts after that sees the
+ * new pointer. Only one thread replaces the tables at a time, so at most two epochs have readers.
+ */
+
+/**
+ * Start reading the FK20 tables of a setup.
+ *
+ * @param[out]  epoch_out   The epoch to pass to release_fk20_tables()
+ * @param[in]   s           The setup, with the FK20 columns
+ *
+ * @return The tables, NULL if there are none. They stay valid until release_fk20_tables().
+ */
+const FK20Tables *acquire_fk20_tables(uint64_t *epoch_out, const KZGSettings *s) {
+    TableEpochs *epochs = s->table_epochs;
+    uint64_t epoch;
+
+    *epoch_out = 0;
+    if (epochs == NULL) return s->tables;
+
+    /* Count this reader in the current epoch, again if the epoch changed in the meantime */
+    while (true) {
+        epoch = atomic_load_u64(&epochs->epoch);
+        atomic_add_u64(&epochs->readers[epoch % 2], 1);
+        if (atomic_load_u64(&epochs->epoch) == epoch) break;
+        atomic_sub_u64(&epochs->readers[epoch % 2], 1);
+    }
+
+    *epoch_out = epoch;
+    return atomic_load_ptr((void *const *)&s->tables);
+}
+
+/**
+ * Finish reading the FK20 tables of a setup.
+ *
+ * @param[in]   s       The setup
+ * @param[in]   epoch   The epoch from acquire_fk20_tables()
+ */
+void release_fk20_tables(const KZGSettings *s, uint64_t epoch) {
+    if (s->table_epochs == NULL) return;
+    atomic_sub_u64(&s->table_epochs->readers[epoch % 2], 1);
+}
+
+/**
+ * Become the only thread which replaces the FK20 tables of a setup, waiting for any other.
+ *
+ * @param[in,out]   s   The setup
+ */
+void lock_fk20_tables(KZGSettings *s) {
+    if (s->table_epochs == NULL) return;
+    while (!atomic_cas_u64(&s->table_epochs->writer, 0, 1)) {
+        yield_thread();
+    }
+}
+
+/**
+ * Let other threads replace the FK20 tables of a setup again.
+ *
+ * @param[in,out]   s   The setup, locked with lock_fk20_tables()
+ */
+void unlock_fk20_tables(KZGSettings *s) {
+    if (s->table_epochs == NULL) return;
+    atomic_sub_u64(&s->table_epochs->writer, 1);
+}
+
+/**
+ * Replace the FK20 tables of a setup, once no reader can be using the old ones.
+ *
+ * @param[in,out]   s       The setup, locked with lock_fk20_tables()
+ * @param[in]       tables  The new tables, or NULL for none
+ *
+ * @return The old tables, which the caller frees.
+ */
+FK20Tables *swap_fk20_tables(KZGSettings *s, FK20Tables *tables) {
+    TableEpochs *epochs = s->table_epochs;
+    FK20Tables *old = s->tables;
+    uint64_t epoch;
+
+    if (epochs == NULL) {
+        s->tables = tables;
+        return old;
+    }
+
+    /* Readers from the next epoch on see the new tables, wait for those from this one */
+    atomic_store_ptr((void **)&s->tables, tables);
+    epoch = atomic_add_u64(&epochs->epoch, 1);
+    while (atomic_load_u64(&epochs->readers[epoch % 2]) != 0) {
+        yield_thread();
+    }
+    return old;
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2024 Benjamin Edgington
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "common/ret.h"
+#include "setup/settings.h"
+
+#include <stdbool.h> /* For bool */
+#include <stdint.h>  /* For uint8_t & uint64_t */
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Public Functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+C_KZG_RET new_lazy_prover(
+    LazyProver **out,
+    const uint8_t *g1_monomial_bytes,
+    const uint8_t *g1_lagrange_bytes,
+    uint64_t num_g1_bytes,
+    const uint8_t *g2_monomial_bytes,
+    uint64_t num_g2_bytes,
+    uint64_t precompute
+);
+void free_lazy_prover(LazyProver **lazy);
+C_KZG_RET get_prover_settings(const KZGSettings **out, const KZGSettings *s, bool needs_fk20);
+C_KZG_RET get_mutable_prover_settings(KZGSettings **out, KZGSettings *s);
+const FK20Tables *acquire_fk20_tables(uint64_t *epoch_out, const KZGSettings *s);
+void release_fk20_tables(const KZGSettings *s, uint64_t epoch);
+void lock_fk20_tables(KZGSettings *s);
+void unlock_fk20_tables(KZGSettings *s);
+FK20Tables *swap_fk20_tables(KZGSettings *s, FK20Tables *tables);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,47 @@
+/*
+ * Copyright 2024 Benjamin Edgington
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "common/fr.h"
+#include "eip4844/blob.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Macros
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The root of unity associated with FIELD_ELEMENTS_PER_EXT_BLOB, which generates the others.
+ *
+ * @remark This is tied to LOG_EXPANSION_FACTOR = 1, i.e., if the expansion factor changes, the
+ * tables must be generated again.
+ */
+#define ROOT_OF_UNITY (ROOTS_OF_UNITY[1])
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Constants
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * The roots of unity for the subgroup of size FIELD_ELEMENTS_PER_EXT_BLOB, in Montgomery form.
+ *
+ * These are generated by scripts/generate_roots_of_unity.py into setup/roots.c, so that they are
+ * in read-only memory, shared between processes, and there to use before a setup is loaded. The
+ * arrays of every KZGSettings point to them.
+ */
+extern const fr_t ROOTS_OF_UNITY[FIELD_ELEMENTS_PER_EXT_BLOB + 1];
+extern const fr_t BRP_ROOTS_OF_UNITY[FIELD_ELEMENTS_PER_EXT_BLOB];
+extern const fr_t REVERSE_ROOTS_OF_UNITY[FIELD_ELEMENTS_PER_EXT_BLOB + 1];
@@ -16,13 +16,99 @@
 
 #pragma once
 
+#include "common/bytes.h"
 #include "common/ec.h"
 #include "common/fr.h"
 
+#include <stdint.h> /* For uint64_t */
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Macros
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** Put the FK20 tables on huge pages, see set_table_placement(). */
+#define KZG_TABLES_HUGE_PAGES 1
+
+/** Copy the FK20 tables to every NUMA node, see set_table_placement(). */
+#define KZG_TABLES_NUMA_REPLICAS 2
+
+/** Load everything, see load_trusted_setup_profile(). */
+#define KZG_PROFILE_FULL 0
+
+/** Load only what verification needs, see load_trusted_setup_profile(). */
+#define KZG_PROFILE_VERIFY 1
+
+/** Load what verification and commitments need, see load_trusted_setup_profile(). */
+#define KZG_PROFILE_VERIFY_AND_COMMIT 2
+
+/** The number of g1 points in a trusted setup. */
+#define NUM_G1_POINTS FIELD_ELEMENTS_PER_BLOB
+
+/** The number of g2 points in a trusted setup. */
+#define NUM_G2_POINTS 65
+
+/** The alignment of the arrays in the settings slab, and of the FK20 tables, a cache line. */
+#define SLAB_ALIGNMENT 64
+
+/** It seems that blst limits the window size for fixed-base MSMs to 15. */
+#define MAX_WBITS 15
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Types
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * The choices made when computing multi-scalar multiplications.
+ *
+ * The best choices depend on the machine, see autotune_msm_strategy(). This is a plain structure so
+ * that a strategy can be saved and later restored with set_msm_strategy().
+ */
+typedef struct {
+    /** MSMs with fewer points than this are computed naively instead of with Pippenger. */
+    uint64_t naive_threshold;
+    /** The window size for the FK20 fixed-base MSM tables, or zero to use Pippenger instead. */
+    uint64_t wbits;
+} MSMStrategy;
+
+/** The precomputed tables for the FK20 fixed-base MSMs, one per circulant row. */
+typedef struct {
+    /** The table for each row, NULL for rows which use Pippenger instead. */
+    blst_p1_affine **tables;
+    /** The window size of each row's table, zero for rows without a table. */
+    size_t *wbits;
+    /** The memory holding every row's table, NULL if the tables are in a shared mapping. */
+    void *block;
+    /** The number of bytes in the block. */
+    size_t block_size;
+    /** The size of the block's mapping, zero if it is from the heap. */
+    size_t mapped_size;
+    /** The number of NUMA nodes with their own copy of the block, zero if there are no copies. */
+    size_t num_nodes;
+    /** The copy of the block for each node, the first is the block itself. */
+    void **node_blocks;
+    /** The size of each copy's mapping, zero if it is from the heap. */
+    size_t *node_mapped_sizes;
+} FK20Tables;
+
+/**
+ * What lets the FK20 tables be replaced while other threads compute proofs, see setup/prover.c.
+ *
+ * Each call which reads the tables counts itself as a reader of the current epoch, and the thread
+ * which replaces the tables starts a new epoch, then waits for the readers of the old one before
+ * freeing the old tables.
+ */
+typedef struct {
+    /** The epoch, incremented each time the tables are replaced. */
+    uint64_t epoch;
+    /** The number of calls reading the tables which started in an even and in an odd epoch. */
+    uint64_t readers[2];
+    /** One while a thread is replacing the tables, so that only one does at a time. */
+    uint64_t writer;
+} TableEpochs;
+
+/** What a verification profile keeps to load the rest of the setup, see setup/prover.c. */
+typedef struct LazyProver LazyProver;
+
 /** Stores the setup and parameters needed for computing KZG proofs. */
 typedef struct {
     /**
@@ -30,8 +116,9 @@ typedef struct {
      *
      * The array contains `FIELD_ELEMENTS_PER_EXT_BLOB + 1` elements.
      * The array starts and ends with Fr::one().
+     * It is compiled in, like the other two arrays of roots, and is shared by every setup.
      */
-    fr_t *roots_of_unity;
+    const fr_t *roots_of_unity;
     /**
      * Roots of unity for the subgroup of size `FIELD_ELEMENTS_PER_EXT_BLOB` in bit-reversed order.
      *
@@ -41,7 +128,7 @@ typedef struct {
      *
      * The array contains `FIELD_ELEMENTS_PER_EXT_BLOB` elements.
      */
-    fr_t *brp_roots_of_unity;
+    const fr_t *brp_roots_of_unity;
     /**
      * Roots of unity for the subgroup of size `FIELD_ELEMENTS_PER_EXT_BLOB` in reversed order.
      *
@@ -52,7 +139,7 @@ typedef struct {
      * The array contains `FIELD_ELEMENTS_PER_EXT_BLOB + 1` elements.
      * The array starts and ends with Fr::one().
      */
-    fr_t *reverse_roots_of_unity;
+    const fr_t *reverse_roots_of_unity;
     /**
      * G1 group elements from the trusted setup in monomial form.
      * The array contains `NUM_G1_POINTS = FIELD_ELEMENTS_PER_BLOB` elements.
@@ -70,10 +157,26 @@ typedef struct {
     g2_t *g2_values_monomial;
     /** Data used during FK20 proof generation. */
     g1_t **x_ext_fft_columns;
-    /** The precomputed tables for fixed-base MSM. */
-    blst_p1_affine **tables;
-    /** The window size for the fixed-base MSM. */
+    /** The single allocation which holds all of the arrays above. */
+    void *slab;
+    /** The rest of the setup for a verification profile, NULL for the full profile. */
+    LazyProver *lazy;
+    /** The shared file the arrays are in when attached with attach_shared_settings(), or NULL. */
+    void *mapping;
+    /** The size of the mapping, zero if it was read into the heap instead. */
+    size_t mapping_size;
+    /** The precomputed tables for fixed-base MSM, NULL if there are none. */
+    FK20Tables *tables;
+    /** What synchronizes replacing the tables with reading them, NULL without FK20 columns. */
+    TableEpochs *table_epochs;
+    /** Where the tables are placed in memory, a combination of the KZG_TABLES_* flags. */
+    uint64_t table_placement;
+    /** The window size for the fixed-base MSM, the largest one if rows use different sizes. */
     size_t wbits;
     /** The scratch size for the fixed-base MSM. */
     size_t scratch_size;
+    /** MSMs with fewer points than this are computed naively instead of with Pippenger. */
+    size_t naive_threshold;
+    /** A hash of the trusted setup's compressed points, see load_precomputed_settings(). */
+    Bytes32 setup_hash;
 } KZGSettings;
@@ -16,15 +16,20 @@
 
 #include "setup/setup.h"
 #include "common/alloc.h"
+#include "common/lincomb.h"
+#include "common/pages.h"
 #include "common/utils.h"
 #include "eip7594/eip7594.h"
 #include "eip7594/fft.h"
+#include "setup/prover.h"
+#include "setup/roots.h"
 
 #include <assert.h>   /* For assert */
-#include <inttypes.h> /* For SCNu64 */
+#include <inttypes.h> /* For UINT64_MAX */
 #include <stdio.h>    /* For FILE */
 #include <stdlib.h>   /* For NULL */
-#include <string.h>   /* For memcpy */
+#include <string.h>   /* For memcpy & memset */
+#include <time.h>     /* For clock */
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Macros
@@ -36,120 +41,176 @@
 /** The number of bytes in a g2 point. */
 #define BYTES_PER_G2 96
 
-/** The number of g1 points in a trusted setup. */
-#define NUM_G1_POINTS FIELD_ELEMENTS_PER_BLOB
+/** The number of bytes in an uncompressed g1 point. */
+#define BYTES_PER_G1_UNCOMPRESSED (2 * BYTES_PER_G1)
 
-/** The number of g2 points in a trusted setup. */
-#define NUM_G2_POINTS 65
+/** The number of bytes in an uncompressed g2 point. */
+#define BYTES_PER_G2_UNCOMPRESSED (2 * BYTES_PER_G2)
+
+/** The number of bytes of all of the compressed points in a trusted setup. */
+#define TRUSTED_SETUP_POINTS_SIZE (2 * NUM_G1_POINTS * BYTES_PER_G1 + NUM_G2_POINTS * BYTES_PER_G2)
+
+/** The number of bytes before the points in a binary trusted setup file. */
+#define TRUSTED_SETUP_BINARY_HEADER_SIZE 24
+
+/** The number of bytes in a binary trusted setup file. */
+#define TRUSTED_SETUP_BINARY_SIZE (TRUSTED_SETUP_BINARY_HEADER_SIZE + TRUSTED_SETUP_POINTS_SIZE)
+
+/** The number of bytes in a binary trusted setup with uncompressed points. */
+#define TRUSTED_SETUP_UNCOMPRESSED_SIZE \
+    (TRUSTED_SETUP_BINARY_HEADER_SIZE + 2 * TRUSTED_SETUP_POINTS_SIZE)
+
+/** The size of the first block read from a trusted setup file, the blocks double after that. */
+#define FILE_READ_BLOCK_SIZE ((size_t)1024 * 1024)
+
+/** A value in HEX_DIGIT_VALUES for characters which are not hex digits. */
+#define HEX_DIGIT_INVALID 0x10
+
+/** A value in HEX_DIGIT_VALUES for whitespace, which is not a hex digit either. */
+#define HEX_DIGIT_SPACE 0x30
+
+/** The smallest window size worth spending a memory budget on, smaller ones lose to Pippenger. */
+#define MIN_BUDGET_WBITS 4
+
+/** The minimum number of clock ticks to spend on each measurement when autotuning. */
+#define AUTOTUNE_MIN_TICKS (CLOCKS_PER_SEC / 50)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Constants
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/** The bytes which a binary trusted setup file starts with. */
+static const uint8_t TRUSTED_SETUP_BINARY_MAGIC[8] = {'k', 'z', 'g', 's', 'e', 't', 'u', 'p'};
+
+/** The bytes which a binary trusted setup with uncompressed points starts with. */
+static const uint8_t TRUSTED_SETUP_UNCOMPRESSED_MAGIC[8] = {'k', 'z', 'g', 'a', 'f', 'f', 'i', 'n'};
+
 /**
- * This is the root of unity associated with FIELD_ELEMENTS_PER_EXT_BLOB.
- *
- * Compute this constant with the scripts below:
- *
- * @code{.py}
- * import math
- *
- * FIELD_ELEMENTS_PER_EXT_BLOB = 8192
- * PRIMITIVE_ROOT_OF_UNITY = 7
- * BLS_MODULUS = 52435875175126190479447740508185965837690552500527637822603658699938581184513
- *
- * order = int(math.log2(FIELD_ELEMENTS_PER_EXT_BLOB))
- * root_of_unity = pow(PRIMITIVE_ROOT_OF_UNITY, (BLS_MODULUS - 1) // (2**order), BLS_MODULUS)
- * uint64s = [(root_of_unity >> (64 * i)) & 0xFFFFFFFFFFFFFFFF for i in range(4)]
- * values = [f"0x{uint64:016x}L" for uint64 in uint64s]
- * print(f"{{{', '.join(values)}}}")
- * @endcode
- *
- * Then paste the output into the following:
- *
- * @code{.c}
- * fr_t root_of_unity;
- * uint64_t values[4] = <output-from-python>;
- * blst_fr_from_uint64(&root_of_unity, values);
- * for (size_t i = 0; i < 4; i++)
- *     printf("%#018llxL,\n", root_of_unity.l[i]);
- * @endcode
- *
- * @remark this constant is tied to LOG_EXPANSION_FACTOR = 1, i.e., if the expansion
- * factor changes, this constant is no longer correct.
+ * The value of each character as a hex digit. Characters which are not hex digits are
+ * HEX_DIGIT_INVALID, or HEX_DIGIT_SPACE for whitespace.
  */
-static const fr_t ROOT_OF_UNITY = {
-    0xa33d279ff0ccffc9L, 0x41fac79f59e91972L, 0x065d227fead1139bL, 0x71db41abda03e055L
+static const uint8_t HEX_DIGIT_VALUES[256] = {
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x30, 0x30, 0x30,
+    0x30, 0x30, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x30, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10,
 };
 
+/** The MSM lengths at which autotuning compares the naive method with Pippenger's. */
+static const size_t AUTOTUNE_LENGTHS[] = {2, 3, 4, 6, 8, 12, 16, 24, 32, 48, 64};
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Trusted Setup Functions
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 /**
- * Generate powers of a root of unity in the field.
+ * Reserve a region at the end of the settings slab.
  *
- * @param[out]  out     The roots of unity (length `width + 1`)
- * @param[in]   root    A root of unity
- * @param[in]   width   One less than the size of `out`
+ * @param[in,out]   slab_size   The size of the slab so far, increased by the region
+ * @param[in]       size        The number of bytes in the region
  *
- * @remark `root` must be such that `root ^ width` is equal to one, but no smaller power of `root`
- * is equal to one.
+ * @return The offset of the region, which starts on a cache line.
  */
-static C_KZG_RET expand_root_of_unity(fr_t *out, const fr_t *root, size_t width) {
-    size_t i;
-
-    /* We assume it's at least two */
-    if (width < 2) {
-        return C_KZG_BADARGS;
-    }
-
-    /* We know what these will be */
-    out[0] = FR_ONE;
-    out[1] = *root;
+static size_t reserve_slab_region(size_t *slab_size, size_t size) {
+    size_t offset = *slab_size;
+    *slab_size += (size + SLAB_ALIGNMENT - 1) & ~(size_t)(SLAB_ALIGNMENT - 1);
+    return offset;
+}
 
-    /* Compute powers of root */
-    for (i = 2; i <= width; i++) {
-        blst_fr_mul(&out[i], &out[i - 1], root);
-        if (fr_is_one(&out[i])) break;
+/**
+ * Allocate the arrays of a trusted setup, all in one slab.
+ *
+ * The arrays are laid out one after the other, each starting on a cache line, in the order that
+ * they are declared. The FK20 columns follow the array of pointers to them, with the column of each
+ * row right after the column of the previous row. The FK20 tables are not part of the slab, since
+ * they can be replaced after loading, but the TableEpochs which synchronizes replacing them is.
+ *
+ * Verification profiles leave out the arrays that they do not need: all but the first
+ * FIELD_ELEMENTS_PER_CELL monomial G1 points, the FK20 columns, and for KZG_PROFILE_VERIFY the
+ * Lagrange G1 points. Their pointers stay NULL.
+ *
+ * @param[in,out]   s       The trusted setup, with all of its array pointers NULL
+ * @param[in]       profile The KZG_PROFILE_* value the setup is loaded with
+ *
+ * @remark The slab is zeroed, and freed with free_trusted_setup().
+ */
+static C_KZG_RET alloc_settings_slab(KZGSettings *s, uint64_t profile) {
+    C_KZG_RET ret;
+    size_t slab_size = 0;
+    uint8_t *base;
+    bool full = profile == KZG_PROFILE_FULL;
+    size_t num_g1_monomial = full ? NUM_G1_POINTS : FIELD_ELEMENTS_PER_CELL;
+    size_t num_g1_lagrange = profile == KZG_PROFILE_VERIFY ? 0 : NUM_G1_POINTS;
+    size_t num_columns = full ? CELLS_PER_EXT_BLOB : 0;
+
+    size_t g1_monomial_offset = reserve_slab_region(&slab_size, num_g1_monomial * sizeof(g1_t));
+    size_t g1_lagrange_offset = reserve_slab_region(&slab_size, num_g1_lagrange * sizeof(g1_t));
+    size_t g2_monomial_offset = reserve_slab_region(&slab_size, NUM_G2_POINTS * sizeof(g2_t));
+    size_t columns_offset = reserve_slab_region(&slab_size, num_columns * sizeof(g1_t *));
+    size_t column_data_offset = reserve_slab_region(
+        &slab_size, num_columns * FIELD_ELEMENTS_PER_CELL * sizeof(g1_t)
+    );
+    size_t table_epochs_offset = reserve_slab_region(&slab_size, full ? sizeof(TableEpochs) : 0);
+
+    /* Allocate a little more, so that the slab can start on a cache line */
+    ret = c_kzg_calloc(&s->slab, 1, slab_size + SLAB_ALIGNMENT);
+    if (ret != C_KZG_OK) return ret;
+    base = (uint8_t *)s->slab +
+           (SLAB_ALIGNMENT - (uintptr_t)s->slab % SLAB_ALIGNMENT) % SLAB_ALIGNMENT;
+
+    s->g1_values_monomial = (g1_t *)(void *)(base + g1_monomial_offset);
+    s->g2_values_monomial = (g2_t *)(void *)(base + g2_monomial_offset);
+    if (num_g1_lagrange != 0) {
+        s->g1_values_lagrange_brp = (g1_t *)(void *)(base + g1_lagrange_offset);
     }
+    if (num_columns == 0) return C_KZG_OK;
 
-    /* We expect the last entry to be one */
-    if (i != width || !fr_is_one(&out[width])) {
-        return C_KZG_BADARGS;
+    s->x_ext_fft_columns = (g1_t **)(void *)(base + columns_offset);
+    for (size_t i = 0; i < num_columns; i++) {
+        size_t column_offset = column_data_offset + i * FIELD_ELEMENTS_PER_CELL * sizeof(g1_t);
+        s->x_ext_fft_columns[i] = (g1_t *)(void *)(base + column_offset);
     }
-
+    s->table_epochs = (TableEpochs *)(void *)(base + table_epochs_offset);
     return C_KZG_OK;
 }
 
 /**
- * Initialize the roots of unity.
+ * Free the precomputed tables for the FK20 fixed-base MSMs.
  *
- * @param[out]  s   Pointer to KZGSettings
+ * @param[in,out]   tables  The tables to free, set to NULL
+ *
+ * @remark This does nothing if `*tables` is NULL.
  */
-static C_KZG_RET compute_roots_of_unity(KZGSettings *s) {
-    C_KZG_RET ret;
-
-    /* Populate the roots of unity */
-    ret = expand_root_of_unity(s->roots_of_unity, &ROOT_OF_UNITY, FIELD_ELEMENTS_PER_EXT_BLOB);
-    if (ret != C_KZG_OK) goto out;
-
-    /* Copy all but the last root to the roots of unity */
-    memcpy(s->brp_roots_of_unity, s->roots_of_unity, sizeof(fr_t) * FIELD_ELEMENTS_PER_EXT_BLOB);
-
-    /* Apply the bit reversal permutation to the roots of unity */
-    ret = bit_reversal_permutation(
-        s->brp_roots_of_unity, sizeof(fr_t), FIELD_ELEMENTS_PER_EXT_BLOB
-    );
-    if (ret != C_KZG_OK) goto out;
-
-    /* Populate reverse roots of unity */
-    for (size_t i = 0; i <= FIELD_ELEMENTS_PER_EXT_BLOB; i++) {
-        s->reverse_roots_of_unity[i] = s->roots_of_unity[FIELD_ELEMENTS_PER_EXT_BLOB - i];
+static void free_fk20_tables(FK20Tables **tables) {
+    if (*tables == NULL) return;
+    /* The first node's copy is the block itself */
+    for (size_t n = 1; n < (*tables)->num_nodes; n++) {
+        free_pages((*tables)->node_blocks[n], (*tables)->node_mapped_sizes[n]);
     }
-
-out:
-    return ret;
+    c_kzg_free((*tables)->node_blocks);
+    c_kzg_free((*tables)->node_mapped_sizes);
+    free_pages((*tables)->block, (*tables)->mapped_size);
+    c_kzg_free((*tables)->tables);
+    c_kzg_free((*tables)->wbits);
+    c_kzg_free(*tables);
 }
 
 /**
@@ -161,32 +222,25 @@ out:
  */
 void free_trusted_setup(KZGSettings *s) {
     if (s == NULL) return;
-    c_kzg_free(s->brp_roots_of_unity);
-    c_kzg_free(s->roots_of_unity);
-    c_kzg_free(s->reverse_roots_of_unity);
-    c_kzg_free(s->g1_values_monomial);
-    c_kzg_free(s->g1_values_lagrange_brp);
-    c_kzg_free(s->g2_values_monomial);
-
-    /*
-     * If for whatever reason we accidentally call free_trusted_setup() on an uninitialized
-     * structure, we don't want to deference these 2d arrays. Without these NULL checks, it's
-     * possible for there to be a segmentation fault via null pointer dereference.
-     */
-    if (s->x_ext_fft_columns != NULL) {
-        for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
-            c_kzg_free(s->x_ext_fft_columns[i]);
-        }
-    }
-    if (s->tables != NULL) {
-        for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
-            c_kzg_free(s->tables[i]);
-        }
-    }
-    c_kzg_free(s->x_ext_fft_columns);
-    c_kzg_free(s->tables);
+    free_fk20_tables(&s->tables);
+    free_lazy_prover(&s->lazy);
+
+    /* All of the arrays are in the slab or the mapping, so free them once and forget them */
+    c_kzg_free(s->slab);
+    free_pages(s->mapping, s->mapping_size);
+    s->mapping = NULL;
+    s->mapping_size = 0;
+    s->roots_of_unity = NULL;
+    s->brp_roots_of_unity = NULL;
+    s->reverse_roots_of_unity = NULL;
+    s->g1_values_monomial = NULL;
+    s->g1_values_lagrange_brp = NULL;
+    s->g2_values_monomial = NULL;
+    s->x_ext_fft_columns = NULL;
+    s->table_epochs = NULL;
     s->wbits = 0;
     s->scratch_size = 0;
+    s->naive_threshold = 0;
 }
 
 /**
@@ -230,6 +284,221 @@ out:
     return ret;
 }
 
+/**
+ * Allocate the precomputed tables for the FK20 fixed-base MSMs, without filling them in.
+ *
+ * The tables for all rows are put in one block of memory, each starting on a cache line. With
+ * KZG_TABLES_NUMA_REPLICAS, the block is placed on the first NUMA node, and the copies for the
+ * other nodes are allocated by copy_fk20_tables_to_nodes() once it has been filled in.
+ *
+ * @param[out]  tables_out  The new tables
+ * @param[in]   row_wbits   The window size for each row, zero for no table, CELLS_PER_EXT_BLOB
+ * @param[in]   placement   The KZG_TABLES_* flags for where to put the tables
+ *
+ * @remark Free afterwards with free_fk20_tables().
+ */
+static C_KZG_RET alloc_fk20_tables(
+    FK20Tables **tables_out, const size_t *row_wbits, uint64_t placement
+) {
+    C_KZG_RET ret;
+    FK20Tables *tables = NULL;
+    size_t offsets[CELLS_PER_EXT_BLOB];
+    size_t block_size = 0;
+    bool huge_pages = (placement & KZG_TABLES_HUGE_PAGES) != 0;
+    bool replicas = (placement & KZG_TABLES_NUMA_REPLICAS) != 0;
+
+    /* Lay out the tables, each starting on a cache line */
+    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+        offsets[i] = block_size;
+        if (row_wbits[i] == 0) continue;
+        block_size += blst_p1s_mult_wbits_precompute_sizeof(row_wbits[i], FIELD_ELEMENTS_PER_CELL);
+        block_size = (block_size + SLAB_ALIGNMENT - 1) & ~(size_t)(SLAB_ALIGNMENT - 1);
+    }
+
+    ret = c_kzg_calloc((void **)&tables, 1, sizeof(FK20Tables));
+    if (ret != C_KZG_OK) goto out;
+    ret = c_kzg_calloc((void **)&tables->tables, CELLS_PER_EXT_BLOB, sizeof(void *));
+    if (ret != C_KZG_OK) goto out;
+    ret = c_kzg_calloc((void **)&tables->wbits, CELLS_PER_EXT_BLOB, sizeof(size_t));
+    if (ret != C_KZG_OK) goto out;
+
+    ret = new_pages(
+        &tables->block,
+        &tables->mapped_size,
+        block_size,
+        huge_pages,
+        replicas ? 0 : ANY_NUMA_NODE
+    );
+    if (ret != C_KZG_OK) goto out;
+    tables->block_size = block_size;
+
+    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+        if (row_wbits[i] == 0) continue;
+        tables->tables[i] = (blst_p1_affine *)(void *)((uint8_t *)tables->block + offsets[i]);
+        tables->wbits[i] = row_wbits[i];
+    }
+
+    *tables_out = tables;
+    tables = NULL;
+
+out:
+    free_fk20_tables(&tables);
+    return ret;
+}
+
+/**
+ * Copy filled in FK20 tables to every other NUMA node, if they should be.
+ *
+ * @param[in,out]   tables      The tables, from alloc_fk20_tables()
+ * @param[in]       placement   The KZG_TABLES_* flags the tables were allocated with
+ *
+ * @remark This does nothing unless KZG_TABLES_NUMA_REPLICAS is set and there are several nodes.
+ */
+static C_KZG_RET copy_fk20_tables_to_nodes(FK20Tables *tables, uint64_t placement) {
+    C_KZG_RET ret;
+    size_t num_nodes;
+    bool huge_pages = (placement & KZG_TABLES_HUGE_PAGES) != 0;
+
+    if ((placement & KZG_TABLES_NUMA_REPLICAS) == 0) return C_KZG_OK;
+    num_nodes = numa_node_count();
+    if (num_nodes < 2) return C_KZG_OK;
+
+    ret = c_kzg_calloc((void **)&tables->node_blocks, num_nodes, sizeof(void *));
+    if (ret != C_KZG_OK) return ret;
+    ret = c_kzg_calloc((void **)&tables->node_mapped_sizes, num_nodes, sizeof(size_t));
+    if (ret != C_KZG_OK) return ret;
+    tables->node_blocks[0] = tables->block;
+    tables->num_nodes = num_nodes;
+
+    for (size_t n = 1; n < num_nodes; n++) {
+        ret = new_pages(
+            &tables->node_blocks[n],
+            &tables->node_mapped_sizes[n],
+            tables->block_size,
+            huge_pages,
+            n
+        );
+        if (ret != C_KZG_OK) return ret;
+        /* This first touches the pages, after they have been bound to the node */
+        memcpy(tables->node_blocks[n], tables->block, tables->block_size);
+    }
+    return C_KZG_OK;
+}
+
+/**
+ * Compute the precomputed tables for the FK20 fixed-base MSMs.
+ *
+ * @param[out]  tables_out  The new tables
+ * @param[in]   row_wbits   The window size for each row, zero for no table, CELLS_PER_EXT_BLOB
+ * @param[in]   s           The trusted setup, with `x_ext_fft_columns` initialized
+ *
+ * @remark The tables are placed as set by set_table_placement().
+ * @remark Free afterwards with free_fk20_tables().
+ */
+static C_KZG_RET new_fk20_tables(
+    FK20Tables **tables_out, const size_t *row_wbits, const KZGSettings *s
+) {
+    C_KZG_RET ret;
+    FK20Tables *tables = NULL;
+    blst_p1_affine *p_affine = NULL;
+
+    /* Allocate space for precomputed tables */
+    ret = alloc_fk20_tables(&tables, row_wbits, s->table_placement);
+    if (ret != C_KZG_OK) goto out;
+
+    /* Allocate space for points in affine representation */
+    ret = c_kzg_calloc((void **)&p_affine, FIELD_ELEMENTS_PER_CELL, sizeof(blst_p1_affine));
+    if (ret != C_KZG_OK) goto out;
+
+    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+        size_t wbits = row_wbits[i];
+        if (wbits == 0) continue;
+
+        /* Transform the points to affine representation */
+        const blst_p1 *p_arg[2] = {s->x_ext_fft_columns[i], NULL};
+        blst_p1s_to_affine(p_affine, p_arg, FIELD_ELEMENTS_PER_CELL);
+        const blst_p1_affine *points_arg[2] = {p_affine, NULL};
+
+        /* Compute table for fixed-base MSM */
+        blst_p1s_mult_wbits_precompute(
+            tables->tables[i], wbits, points_arg, FIELD_ELEMENTS_PER_CELL
+        );
+    }
+
+    ret = copy_fk20_tables_to_nodes(tables, s->table_placement);
+    if (ret != C_KZG_OK) goto out;
+
+    *tables_out = tables;
+    tables = NULL;
+
+out:
+    free_fk20_tables(&tables);
+    c_kzg_free(p_affine);
+    return ret;
+}
+
+/**
+ * Put new FK20 tables in place of the current ones, and free the current ones.
+ *
+ * @param[in,out]   s       The trusted setup, locked with lock_fk20_tables()
+ * @param[in]       tables  The new tables, or NULL for none
+ *
+ * @remark This waits for calls which are using the current tables, see swap_fk20_tables().
+ */
+static void install_fk20_tables(KZGSettings *s, FK20Tables *tables) {
+    FK20Tables *old = swap_fk20_tables(s, tables);
+    free_fk20_tables(&old);
+
+    s->wbits = 0;
+    s->scratch_size = 0;
+    if (tables == NULL) return;
+    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+        if (tables->wbits[i] > s->wbits) s->wbits = tables->wbits[i];
+    }
+    s->scratch_size = blst_p1s_mult_wbits_scratch_sizeof(FIELD_ELEMENTS_PER_CELL);
+}
+
+/**
+ * Replace the precomputed tables for the FK20 fixed-base MSMs.
+ *
+ * This is safe while other threads compute proofs with `s`. They keep using the current tables
+ * until the new ones are computed, and the current tables are freed once they are done with them.
+ *
+ * @param[in,out]   s           The trusted setup
+ * @param[in]       row_wbits   The window size for each row, zero for no table, CELLS_PER_EXT_BLOB
+ *
+ * @remark Nothing is computed if the rows already have these window sizes.
+ * @remark On failure, `s` is left unchanged.
+ */
+static C_KZG_RET replace_fk20_tables(KZGSettings *s, const size_t *row_wbits) {
+    C_KZG_RET ret = C_KZG_OK;
+    FK20Tables *tables = NULL;
+    bool changed = false;
+    size_t max_wbits = 0;
+
+    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+        if (row_wbits[i] > max_wbits) max_wbits = row_wbits[i];
+    }
+
+    /* Other threads which replace the tables wait, those which compute proofs do not */
+    lock_fk20_tables(s);
+    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+        if (row_wbits[i] != (s->tables == NULL ? 0 : s->tables->wbits[i])) changed = true;
+    }
+    if (!changed) goto out;
+
+    /* Compute the new tables first, in case that fails */
+    if (max_wbits != 0) {
+        ret = new_fk20_tables(&tables, row_wbits, s);
+        if (ret != C_KZG_OK) goto out;
+    }
+    install_fk20_tables(s, tables);
+
+out:
+    unlock_fk20_tables(s);
+    return ret;
+}
+
 /**
  * Initialize fields for FK20 multi-proof computations.
  *
@@ -240,7 +509,7 @@ static C_KZG_RET init_fk20_multi_settings(KZGSettings *s) {
     size_t circulant_domain_size;
     g1_t *x = NULL;
     g1_t *points = NULL;
-    blst_p1_affine *p_affine = NULL;
+    size_t row_wbits[CELLS_PER_EXT_BLOB];
     bool precompute = s->wbits != 0;
 
     /*
@@ -261,14 +530,6 @@ static C_KZG_RET init_fk20_multi_settings(KZGSettings *s) {
     ret = new_g1_array(&points, circulant_domain_size);
     if (ret != C_KZG_OK) goto out;
 
-    /* Allocate space for array of pointers, this is a 2D array */
-    ret = c_kzg_calloc((void **)&s->x_ext_fft_columns, circulant_domain_size, sizeof(void *));
-    if (ret != C_KZG_OK) goto out;
-    for (size_t i = 0; i < circulant_domain_size; i++) {
-        ret = new_g1_array(&s->x_ext_fft_columns[i], FIELD_ELEMENTS_PER_CELL);
-        if (ret != C_KZG_OK) goto out;
-    }
-
     for (size_t offset = 0; offset < FIELD_ELEMENTS_PER_CELL; offset++) {
         /* Compute x, sections of the g1 values */
         size_t start = FIELD_ELEMENTS_PER_BLOB - FIELD_ELEMENTS_PER_CELL - 1 - offset;
@@ -289,54 +550,31 @@ static C_KZG_RET init_fk20_multi_settings(KZGSettings *s) {
     }
 
     if (precompute) {
-        /* Allocate space for precomputed tables */
-        ret = c_kzg_calloc((void **)&s->tables, circulant_domain_size, sizeof(void *));
-        if (ret != C_KZG_OK) goto out;
-
-        /* Allocate space for points in affine representation */
-        ret = c_kzg_calloc((void **)&p_affine, FIELD_ELEMENTS_PER_CELL, sizeof(blst_p1_affine));
-        if (ret != C_KZG_OK) goto out;
-
-        /* Calculate the size of each table, this can be re-used */
-        size_t table_size = blst_p1s_mult_wbits_precompute_sizeof(
-            s->wbits, FIELD_ELEMENTS_PER_CELL
-        );
-
+        /* Every row uses the same window size */
         for (size_t i = 0; i < circulant_domain_size; i++) {
-            /* Transform the points to affine representation */
-            const blst_p1 *p_arg[2] = {s->x_ext_fft_columns[i], NULL};
-            blst_p1s_to_affine(p_affine, p_arg, FIELD_ELEMENTS_PER_CELL);
-            const blst_p1_affine *points_arg[2] = {p_affine, NULL};
-
-            /* Allocate space for the table */
-            ret = c_kzg_malloc((void **)&s->tables[i], table_size);
-            if (ret != C_KZG_OK) goto out;
-
-            /* Compute table for fixed-base MSM */
-            blst_p1s_mult_wbits_precompute(
-                s->tables[i], s->wbits, points_arg, FIELD_ELEMENTS_PER_CELL
-            );
+            row_wbits[i] = s->wbits;
         }
-
-        /* Calculate the size of the scratch */
-        s->scratch_size = blst_p1s_mult_wbits_scratch_sizeof(FIELD_ELEMENTS_PER_CELL);
+        ret = replace_fk20_tables(s, row_wbits);
+        if (ret != C_KZG_OK) goto out;
     }
 
 out:
     c_kzg_free(x);
     c_kzg_free(points);
-    c_kzg_free(p_affine);
     return ret;
 }
 
 /**
  * Basic sanity check that the trusted setup was loaded in Lagrange form.
  *
- * @param[in]   s   Pointer to the stored trusted setup data
- * @param[in]   n1  Number of G1 points in the trusted setup
- * @param[in]   n2  Number of G2 points in the trusted setup
+ * @param[in]   g1_lagrange The G1 points in Lagrange form, before bit-reversal
+ * @param[in]   g2_monomial The G2 points in monomial form
+ * @param[in]   n1          Number of G1 points in the trusted setup
+ * @param[in]   n2          Number of G2 points in the trusted setup
  */
-static C_KZG_RET is_trusted_setup_in_lagrange_form(const KZGSettings *s, size_t n1, size_t n2) {
+static C_KZG_RET is_trusted_setup_in_lagrange_form(
+    const g1_t *g1_lagrange, const g2_t *g2_monomial, size_t n1, size_t n2
+) {
     /* Trusted setup is too small; we can't work with this */
     if (n1 < 2 || n2 < 2) {
         return C_KZG_BADARGS;
@@ -349,10 +587,7 @@ static C_KZG_RET is_trusted_setup_in_lagrange_form(const KZGSettings *s, size_t
      * If so, error out since we want the trusted setup in Lagrange form.
      */
     bool is_monomial_form = pairings_verify(
-        &s->g1_values_lagrange_brp[1],
-        &s->g2_values_monomial[0],
-        &s->g1_values_lagrange_brp[0],
-        &s->g2_values_monomial[1]
+        &g1_lagrange[1], &g2_monomial[0], &g1_lagrange[0], &g2_monomial[1]
     );
     return is_monomial_form ? C_KZG_BADARGS : C_KZG_OK;
 }
@@ -370,9 +605,88 @@ static void init_settings(KZGSettings *out) {
     out->g1_values_lagrange_brp = NULL;
     out->g2_values_monomial = NULL;
     out->x_ext_fft_columns = NULL;
+    out->slab = NULL;
+    out->lazy = NULL;
+    out->mapping = NULL;
+    out->mapping_size = 0;
     out->tables = NULL;
+    out->table_epochs = NULL;
+    out->table_placement = 0;
     out->wbits = 0;
     out->scratch_size = 0;
+    out->naive_threshold = DEFAULT_NAIVE_THRESHOLD;
+    memset(&out->setup_hash, 0, sizeof(Bytes32));
+}
+
+/**
+ * Hash the compressed points of a trusted setup.
+ *
+ * This is the SHA-256 of the SHA-256 of each of the three arrays, one after the other, so that it
+ * identifies the trusted setup regardless of how it is loaded.
+ *
+ * @param[out]  out                 The hash
+ * @param[in]   g1_monomial_bytes   Array of G1 points in monomial form
+ * @param[in]   g1_lagrange_bytes   Array of G1 points in Lagrange form
+ * @param[in]   g2_monomial_bytes   Array of G2 points in monomial form
+ */
+static void hash_trusted_setup(
+    Bytes32 *out,
+    const uint8_t *g1_monomial_bytes,
+    const uint8_t *g1_lagrange_bytes,
+    const uint8_t *g2_monomial_bytes
+) {
+    uint8_t hashes[3 * sizeof(Bytes32)];
+
+    blst_sha256(&hashes[0], g1_monomial_bytes, NUM_G1_POINTS * BYTES_PER_G1);
+    blst_sha256(&hashes[sizeof(Bytes32)], g1_lagrange_bytes, NUM_G1_POINTS * BYTES_PER_G1);
+    blst_sha256(&hashes[2 * sizeof(Bytes32)], g2_monomial_bytes, NUM_G2_POINTS * BYTES_PER_G2);
+    blst_sha256(out->bytes, hashes, sizeof(hashes));
+}
+
+/**
+ * Convert compressed G1 points to projective form.
+ *
+ * @param[out]  out     The points
+ * @param[in]   bytes   The compressed points, BYTES_PER_G1 each
+ * @param[in]   n       The number of points
+ */
+static C_KZG_RET g1_points_from_bytes(g1_t *out, const uint8_t *bytes, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        blst_p1_affine g1_affine;
+        BLST_ERROR err = blst_p1_uncompress(&g1_affine, &bytes[BYTES_PER_G1 * i]);
+        if (err != BLST_SUCCESS) return C_KZG_BADARGS;
+        blst_p1_from_affine(&out[i], &g1_affine);
+    }
+    return C_KZG_OK;
+}
+
+/**
+ * Compute everything which is derived from the points of a trusted setup.
+ *
+ * @param[in,out]   out     The trusted setup, with its points loaded and Lagrange points in order
+ * @param[in]       profile The KZG_PROFILE_* value the setup is loaded with
+ */
+static C_KZG_RET init_derived_settings(KZGSettings *out, uint64_t profile) {
+    C_KZG_RET ret;
+
+    /* The roots of unity are the same for every setup, so they are compiled in */
+    out->roots_of_unity = ROOTS_OF_UNITY;
+    out->brp_roots_of_unity = BRP_ROOTS_OF_UNITY;
+    out->reverse_roots_of_unity = REVERSE_ROOTS_OF_UNITY;
+
+    if (out->g1_values_lagrange_brp != NULL) {
+        /* Bit reverse the Lagrange form points */
+        ret = bit_reversal_permutation(out->g1_values_lagrange_brp, sizeof(g1_t), NUM_G1_POINTS);
+        if (ret != C_KZG_OK) return ret;
+    }
+
+    if (profile == KZG_PROFILE_FULL) {
+        /* Setup for FK20 proof computation */
+        ret = init_fk20_multi_settings(out);
+        if (ret != C_KZG_OK) return ret;
+    }
+
+    return C_KZG_OK;
 }
 
 /**
@@ -398,8 +712,57 @@ C_KZG_RET load_trusted_setup(
     const uint8_t *g2_monomial_bytes,
     uint64_t num_g2_monomial_bytes,
     uint64_t precompute
+) {
+    return load_trusted_setup_profile(
+        out,
+        g1_monomial_bytes,
+        num_g1_monomial_bytes,
+        g1_lagrange_bytes,
+        num_g1_lagrange_bytes,
+        g2_monomial_bytes,
+        num_g2_monomial_bytes,
+        precompute,
+        KZG_PROFILE_FULL
+    );
+}
+
+/**
+ * Load trusted setup into a KZGSettings, building only what a profile needs.
+ *
+ * With KZG_PROFILE_FULL, this is the same as load_trusted_setup(). The verification profiles build
+ * what verifying needs: the roots of unity, the G2 points, and the first FIELD_ELEMENTS_PER_CELL G1
+ * points in monomial form. KZG_PROFILE_VERIFY_AND_COMMIT also builds the G1 points in Lagrange
+ * form, for commitments and EIP-4844 proofs. Everything else, including the FK20 columns and
+ * tables, is built the first time a call needs it, from a copy of the compressed points.
+ *
+ * @param[out]  out                     Pointer to the stored trusted setup
+ * @param[in]   g1_monomial_bytes       Array of G1 points in monomial form
+ * @param[in]   num_g1_monomial_bytes   Number of g1 monomial bytes
+ * @param[in]   g1_lagrange_bytes       Array of G1 points in Lagrange form
+ * @param[in]   num_g1_lagrange_bytes   Number of g1 Lagrange bytes
+ * @param[in]   g2_monomial_bytes       Array of G2 points in monomial form
+ * @param[in]   num_g2_monomial_bytes   Number of g2 monomial bytes
+ * @param[in]   precompute              Configurable value between 0-15
+ * @param[in]   profile                 One of the KZG_PROFILE_* values
+ *
+ * @remark The G1 points which are not built are not checked until they are, so a call which needs
+ * them can fail with C_KZG_BADARGS if they are invalid.
+ * @remark Free afterwards use with free_trusted_setup().
+ */
+C_KZG_RET load_trusted_setup_profile(
+    KZGSettings *out,
+    const uint8_t *g1_monomial_bytes,
+    uint64_t num_g1_monomial_bytes,
+    const uint8_t *g1_lagrange_bytes,
+    uint64_t num_g1_lagrange_bytes,
+    const uint8_t *g2_monomial_bytes,
+    uint64_t num_g2_monomial_bytes,
+    uint64_t precompute,
+    uint64_t profile
 ) {
     C_KZG_RET ret;
+    g1_t g1_lagrange_check[2];
+    const g1_t *g1_lagrange;
 
     /*
      * Initialize all fields to null/zero so that if there's an error, we can can call
@@ -408,19 +771,11 @@ C_KZG_RET load_trusted_setup(
     init_settings(out);
 
     /* It seems that blst limits the input to 15 */
-    if (precompute > 15) {
+    if (precompute > MAX_WBITS || profile > KZG_PROFILE_VERIFY_AND_COMMIT) {
         ret = C_KZG_BADARGS;
         goto out_error;
     }
 
-    /*
-     * This is the window size for the windowed multiplication in proof generation. The larger wbits
-     * is, the faster the MSM will be, but the size of the precomputed table will grow
-     * exponentially. With 8 bits, the tables are 96 MiB; with 9 bits, the tables are 192 MiB and so
-     * forth. From our testing, there are diminishing returns after 8 bits.
-     */
-    out->wbits = precompute;
-
     /* Sanity check in case this is called directly */
     if (num_g1_monomial_bytes != NUM_G1_POINTS * BYTES_PER_G1 ||
         num_g1_lagrange_bytes != NUM_G1_POINTS * BYTES_PER_G1 ||
@@ -429,40 +784,52 @@ C_KZG_RET load_trusted_setup(
         goto out_error;
     }
 
+    /* Identify the trusted setup, for precomputed settings files */
+    hash_trusted_setup(&out->setup_hash, g1_monomial_bytes, g1_lagrange_bytes, g2_monomial_bytes);
+
+    if (profile == KZG_PROFILE_FULL) {
+        /*
+         * This is the window size for the windowed multiplication in proof generation. The larger
+         * wbits is, the faster the MSM will be, but the size of the precomputed table will grow
+         * exponentially. With 8 bits, the tables are 96 MiB; with 9 bits, the tables are 192 MiB
+         * and so forth. From our testing, there are diminishing returns after 8 bits.
+         */
+        out->wbits = precompute;
+    } else {
+        /* Keep the points, to build the rest when it is needed */
+        ret = new_lazy_prover(
+            &out->lazy,
+            g1_monomial_bytes,
+            g1_lagrange_bytes,
+            NUM_G1_POINTS * BYTES_PER_G1,
+            g2_monomial_bytes,
+            NUM_G2_POINTS * BYTES_PER_G2,
+            precompute
+        );
+        if (ret != C_KZG_OK) goto out_error;
+    }
+
     /* Allocate all of our arrays */
-    ret = new_fr_array(&out->brp_roots_of_unity, FIELD_ELEMENTS_PER_EXT_BLOB);
-    if (ret != C_KZG_OK) goto out_error;
-    ret = new_fr_array(&out->roots_of_unity, FIELD_ELEMENTS_PER_EXT_BLOB + 1);
-    if (ret != C_KZG_OK) goto out_error;
-    ret = new_fr_array(&out->reverse_roots_of_unity, FIELD_ELEMENTS_PER_EXT_BLOB + 1);
-    if (ret != C_KZG_OK) goto out_error;
-    ret = new_g1_array(&out->g1_values_monomial, NUM_G1_POINTS);
-    if (ret != C_KZG_OK) goto out_error;
-    ret = new_g1_array(&out->g1_values_lagrange_brp, NUM_G1_POINTS);
-    if (ret != C_KZG_OK) goto out_error;
-    ret = new_g2_array(&out->g2_values_monomial, NUM_G2_POINTS);
+    ret = alloc_settings_slab(out, profile);
     if (ret != C_KZG_OK) goto out_error;
 
-    /* Convert all g1 monomial bytes to g1 points */
-    for (size_t i = 0; i < NUM_G1_POINTS; i++) {
-        blst_p1_affine g1_affine;
-        BLST_ERROR err = blst_p1_uncompress(&g1_affine, &g1_monomial_bytes[BYTES_PER_G1 * i]);
-        if (err != BLST_SUCCESS) {
-            ret = C_KZG_BADARGS;
-            goto out_error;
-        }
-        blst_p1_from_affine(&out->g1_values_monomial[i], &g1_affine);
-    }
+    /* Convert all g1 monomial bytes to g1 points, or as many as the profile needs */
+    ret = g1_points_from_bytes(
+        out->g1_values_monomial,
+        g1_monomial_bytes,
+        profile == KZG_PROFILE_FULL ? NUM_G1_POINTS : FIELD_ELEMENTS_PER_CELL
+    );
+    if (ret != C_KZG_OK) goto out_error;
 
-    /* Convert all g1 Lagrange bytes to g1 points */
-    for (size_t i = 0; i < NUM_G1_POINTS; i++) {
-        blst_p1_affine g1_affine;
-        BLST_ERROR err = blst_p1_uncompress(&g1_affine, &g1_lagrange_bytes[BYTES_PER_G1 * i]);
-        if (err != BLST_SUCCESS) {
-            ret = C_KZG_BADARGS;
-            goto out_error;
-        }
-        blst_p1_from_affine(&out->g1_values_lagrange_brp[i], &g1_affine);
+    /* Convert all g1 Lagrange bytes to g1 points, or just enough to check the form */
+    if (out->g1_values_lagrange_brp != NULL) {
+        ret = g1_points_from_bytes(out->g1_values_lagrange_brp, g1_lagrange_bytes, NUM_G1_POINTS);
+        if (ret != C_KZG_OK) goto out_error;
+        g1_lagrange = out->g1_values_lagrange_brp;
+    } else {
+        ret = g1_points_from_bytes(g1_lagrange_check, g1_lagrange_bytes, 2);
+        if (ret != C_KZG_OK) goto out_error;
+        g1_lagrange = g1_lagrange_check;
     }
 
     /* Convert all g2 bytes to g2 points */
@@ -477,19 +844,12 @@ C_KZG_RET load_trusted_setup(
     }
 
     /* Make sure the trusted setup was loaded in Lagrange form */
-    ret = is_trusted_setup_in_lagrange_form(out, NUM_G1_POINTS, NUM_G2_POINTS);
-    if (ret != C_KZG_OK) goto out_error;
-
-    /* Compute roots of unity and permute the G1 trusted setup */
-    ret = compute_roots_of_unity(out);
-    if (ret != C_KZG_OK) goto out_error;
-
-    /* Bit reverse the Lagrange form points */
-    ret = bit_reversal_permutation(out->g1_values_lagrange_brp, sizeof(g1_t), NUM_G1_POINTS);
+    ret = is_trusted_setup_in_lagrange_form(
+        g1_lagrange, out->g2_values_monomial, NUM_G1_POINTS, NUM_G2_POINTS
+    );
     if (ret != C_KZG_OK) goto out_error;
 
-    /* Setup for FK20 proof computation */
-    ret = init_fk20_multi_settings(out);
+    ret = init_derived_settings(out, profile);
     if (ret != C_KZG_OK) goto out_error;
 
     goto out_success;
@@ -505,25 +865,191 @@ out_success:
 }
 
 /**
- * Load trusted setup from a file.
+ * Check whether a binary trusted setup starts with the given magic bytes.
  *
- * @param[out]  out         Pointer to the loaded trusted setup data
- * @param[in]   in          File handle for input
- * @param[in]   precompute  Configurable value between 0-15
+ * @param[in]   contents    The trusted setup
+ * @param[in]   size        The number of bytes in it
+ * @param[in]   magic       TRUSTED_SETUP_BINARY_MAGIC or TRUSTED_SETUP_UNCOMPRESSED_MAGIC
+ */
+static bool has_magic(const uint8_t *contents, size_t size, const uint8_t *magic) {
+    return size >= TRUSTED_SETUP_BINARY_HEADER_SIZE &&
+           memcmp(contents, magic, sizeof(TRUSTED_SETUP_BINARY_MAGIC)) == 0;
+}
+
+/**
+ * Read the rest of a file into memory, in large blocks.
+ *
+ * @param[out]  out         The contents, from the current position to the end
+ * @param[out]  size_out    The number of bytes read
+ * @param[in]   in          The file
+ *
+ * @remark Free the contents afterwards with c_kzg_free().
+ */
+static C_KZG_RET read_file(uint8_t **out, size_t *size_out, FILE *in) {
+    C_KZG_RET ret;
+    uint8_t *buffer = NULL;
+    size_t capacity = FILE_READ_BLOCK_SIZE;
+    size_t size = 0;
+
+    ret = c_kzg_malloc((void **)&buffer, capacity);
+    if (ret != C_KZG_OK) goto out;
+
+    while (true) {
+        size += fread(&buffer[size], 1, capacity - size, in);
+        if (size < capacity) break;
+
+        /* The buffer is full, double it and continue */
+        uint8_t *larger = NULL;
+        ret = c_kzg_malloc((void **)&larger, 2 * capacity);
+        if (ret != C_KZG_OK) goto out;
+        memcpy(larger, buffer, size);
+        c_kzg_free(buffer);
+        buffer = larger;
+        capacity *= 2;
+    }
+    if (ferror(in)) {
+        ret = C_KZG_BADARGS;
+        goto out;
+    }
+
+    *out = buffer;
+    *size_out = size;
+    buffer = NULL;
+
+out:
+    c_kzg_free(buffer);
+    return ret;
+}
+
+/**
+ * Skip past whitespace in text.
+ *
+ * @param[in]       text    The text
+ * @param[in]       size    The number of characters in the text
+ * @param[in,out]   pos     The position in the text
+ */
+static void skip_whitespace(const uint8_t *text, size_t size, size_t *pos) {
+    while (*pos < size && (text[*pos] == ' ' || (text[*pos] >= '\t' && text[*pos] <= '\r'))) {
+        (*pos)++;
+    }
+}
+
+/**
+ * Parse a decimal number from text, after any whitespace.
+ *
+ * @param[out]      out     The number
+ * @param[in]       text    The text
+ * @param[in]       size    The number of characters in the text
+ * @param[in,out]   pos     The position in the text, moved past the number
+ */
+static C_KZG_RET parse_decimal(uint64_t *out, const uint8_t *text, size_t size, size_t *pos) {
+    uint64_t value = 0;
+    size_t start;
+
+    skip_whitespace(text, size, pos);
+    start = *pos;
+    while (*pos < size && text[*pos] >= '0' && text[*pos] <= '9') {
+        uint64_t digit = (uint64_t)(text[*pos] - '0');
+        if (value > (UINT64_MAX - digit) / 10) return C_KZG_BADARGS;
+        value = value * 10 + digit;
+        (*pos)++;
+    }
+    if (*pos == start) return C_KZG_BADARGS;
+
+    *out = value;
+    return C_KZG_OK;
+}
+
+/**
+ * Parse hex-encoded bytes from text, skipping any whitespace between the bytes.
+ *
+ * Runs of hex digits are decoded a pair at a time through HEX_DIGIT_VALUES, without a branch per
+ * digit, and only the end of a run checks for whitespace.
+ *
+ * @param[out]      out     The bytes
+ * @param[in]       n       The number of bytes
+ * @param[in]       text    The text
+ * @param[in]       size    The number of characters in the text
+ * @param[in,out]   pos     The position in the text, moved past the bytes
+ */
+static C_KZG_RET parse_hex_bytes(
+    uint8_t *out, size_t n, const uint8_t *text, size_t size, size_t *pos
+) {
+    size_t i = 0;
+
+    while (i < n) {
+        skip_whitespace(text, size, pos);
+
+        /* Decode as many pairs of digits as there are, up to the bytes still needed */
+        size_t run = (size - *pos) / 2;
+        if (run > n - i) run = n - i;
+        bool invalid = false;
+        size_t j = 0;
+        for (; j < run; j++) {
+            uint8_t high = HEX_DIGIT_VALUES[text[*pos + 2 * j]];
+            uint8_t low = HEX_DIGIT_VALUES[text[*pos + 2 * j + 1]];
+            if ((high | low) & HEX_DIGIT_INVALID) {
+                invalid = true;
+                break;
+            }
+            out[i + j] = (uint8_t)(high << 4 | low);
+        }
+        i += j;
+        *pos += 2 * j;
+
+        /* A run can only end at whitespace, which the next iteration skips */
+        if (i == n) break;
+        if (!invalid || HEX_DIGIT_VALUES[text[*pos]] != HEX_DIGIT_SPACE) return C_KZG_BADARGS;
+    }
+    return C_KZG_OK;
+}
+
+/**
+ * Load trusted setup from a file.
+ *
+ * @param[out]  out         Pointer to the loaded trusted setup data
+ * @param[in]   in          File handle for input
+ * @param[in]   precompute  Configurable value between 0-15
  *
  * @remark See also load_trusted_setup().
  * @remark The input file will not be closed.
  * @remark The file format is `n1 n2 g1_1 g1_2 ... g1_n1 g2_1 ... g2_n2` where the first two numbers
  * are in decimal and the remainder are hexstrings and any whitespace can be used as separators.
+ * Each byte is two hex digits.
+ * @remark The file can also be in the binary format written by save_trusted_setup_binary(), or
+ * hold the output of serialize_trusted_setup_uncompressed(), which is only loaded with the full
+ * profile.
  */
 C_KZG_RET load_trusted_setup_file(KZGSettings *out, FILE *in, uint64_t precompute) {
+    return load_trusted_setup_file_profile(out, in, precompute, KZG_PROFILE_FULL);
+}
+
+/**
+ * Load trusted setup from a file, with a profile.
+ *
+ * The file is read into memory in large blocks and then parsed, which is much faster than parsing
+ * it from the stream. Binary files need no parsing, their points are decompressed in place.
+ *
+ * @param[out]  out         Pointer to the loaded trusted setup data
+ * @param[in]   in          File handle for input
+ * @param[in]   precompute  Configurable value between 0-15
+ * @param[in]   profile     One of the KZG_PROFILE_* values
+ *
+ * @remark See also load_trusted_setup_profile() and load_trusted_setup_file().
+ * @remark The input file will not be closed.
+ */
+C_KZG_RET load_trusted_setup_file_profile(
+    KZGSettings *out, FILE *in, uint64_t precompute, uint64_t profile
+) {
     C_KZG_RET ret;
-    int num_matches;
+    uint8_t *contents = NULL;
+    size_t size, pos = 0;
     uint64_t num_g1_points;
     uint64_t num_g2_points;
-    uint8_t *g1_monomial_bytes = NULL;
-    uint8_t *g1_lagrange_bytes = NULL;
-    uint8_t *g2_monomial_bytes = NULL;
+    uint8_t *points = NULL;
+    const uint8_t *g1_monomial_bytes;
+    const uint8_t *g1_lagrange_bytes;
+    const uint8_t *g2_monomial_bytes;
 
     /*
      * Initialize all fields to null/zero so that if there's an error, we can can call
@@ -531,57 +1057,51 @@ C_KZG_RET load_trusted_setup_file(KZGSettings *out, FILE *in, uint64_t precomput
      */
     init_settings(out);
 
-    /* Allocate space for points */
-    ret = c_kzg_calloc((void **)&g1_monomial_bytes, NUM_G1_POINTS, BYTES_PER_G1);
-    if (ret != C_KZG_OK) goto out;
-    ret = c_kzg_calloc((void **)&g1_lagrange_bytes, NUM_G1_POINTS, BYTES_PER_G1);
+    ret = read_file(&contents, &size, in);
     if (ret != C_KZG_OK) goto out;
-    ret = c_kzg_calloc((void **)&g2_monomial_bytes, NUM_G2_POINTS, BYTES_PER_G2);
-    if (ret != C_KZG_OK) goto out;
-
-    /* Read the number of g1 points */
-    num_matches = fscanf(in, "%" SCNu64, &num_g1_points);
-    if (num_matches != 1 || num_g1_points != NUM_G1_POINTS) {
-        ret = C_KZG_BADARGS;
-        goto out;
-    }
 
-    /* Read the number of g2 points */
-    num_matches = fscanf(in, "%" SCNu64, &num_g2_points);
-    if (num_matches != 1 || num_g2_points != NUM_G2_POINTS) {
-        ret = C_KZG_BADARGS;
-        goto out;
-    }
-
-    /* Read all of the g1 points in Lagrange form, byte by byte */
-    for (size_t i = 0; i < NUM_G1_POINTS * BYTES_PER_G1; i++) {
-        num_matches = fscanf(in, "%2hhx", &g1_lagrange_bytes[i]);
-        if (num_matches != 1) {
+    if (has_magic(contents, size, TRUSTED_SETUP_UNCOMPRESSED_MAGIC)) {
+        /* A file is not a trusted source, so every point is checked */
+        if (profile != KZG_PROFILE_FULL) {
             ret = C_KZG_BADARGS;
             goto out;
         }
-    }
-
-    /* Read all of the g2 points in monomial form, byte by byte */
-    for (size_t i = 0; i < NUM_G2_POINTS * BYTES_PER_G2; i++) {
-        num_matches = fscanf(in, "%2hhx", &g2_monomial_bytes[i]);
-        if (num_matches != 1) {
+        ret = load_trusted_setup_uncompressed(out, contents, size, NULL, precompute);
+        goto out;
+    } else if (has_magic(contents, size, TRUSTED_SETUP_BINARY_MAGIC)) {
+        /* The binary format is the magic, the numbers of points, then the points in file order */
+        num_g1_points = bytes_to_uint64(&contents[sizeof(TRUSTED_SETUP_BINARY_MAGIC)]);
+        num_g2_points = bytes_to_uint64(&contents[sizeof(TRUSTED_SETUP_BINARY_MAGIC) + 8]);
+        if (num_g1_points != NUM_G1_POINTS || num_g2_points != NUM_G2_POINTS ||
+            size != TRUSTED_SETUP_BINARY_SIZE) {
             ret = C_KZG_BADARGS;
             goto out;
         }
-    }
-
-    /* Read all of the g1 points in monomial form, byte by byte */
-    /* Note: this is last because it is an extension for EIP-7594 */
-    for (size_t i = 0; i < NUM_G1_POINTS * BYTES_PER_G1; i++) {
-        num_matches = fscanf(in, "%2hhx", &g1_monomial_bytes[i]);
-        if (num_matches != 1) {
+        g1_lagrange_bytes = &contents[TRUSTED_SETUP_BINARY_HEADER_SIZE];
+    } else {
+        /* Read the numbers of g1 and g2 points */
+        ret = parse_decimal(&num_g1_points, contents, size, &pos);
+        if (ret != C_KZG_OK) goto out;
+        ret = parse_decimal(&num_g2_points, contents, size, &pos);
+        if (ret != C_KZG_OK) goto out;
+        if (num_g1_points != NUM_G1_POINTS || num_g2_points != NUM_G2_POINTS) {
             ret = C_KZG_BADARGS;
             goto out;
         }
+
+        /* Decode all of the points, they are in the same order as in the binary format */
+        ret = c_kzg_malloc((void **)&points, TRUSTED_SETUP_POINTS_SIZE);
+        if (ret != C_KZG_OK) goto out;
+        ret = parse_hex_bytes(points, TRUSTED_SETUP_POINTS_SIZE, contents, size, &pos);
+        if (ret != C_KZG_OK) goto out;
+        g1_lagrange_bytes = points;
     }
 
-    ret = load_trusted_setup(
+    /* Note: g1 monomial is last because it is an extension for EIP-7594 */
+    g2_monomial_bytes = g1_lagrange_bytes + NUM_G1_POINTS * BYTES_PER_G1;
+    g1_monomial_bytes = g2_monomial_bytes + NUM_G2_POINTS * BYTES_PER_G2;
+
+    ret = load_trusted_setup_profile(
         out,
         g1_monomial_bytes,
         NUM_G1_POINTS * BYTES_PER_G1,
@@ -589,12 +1109,727 @@ C_KZG_RET load_trusted_setup_file(KZGSettings *out, FILE *in, uint64_t precomput
         NUM_G1_POINTS * BYTES_PER_G1,
         g2_monomial_bytes,
         NUM_G2_POINTS * BYTES_PER_G2,
-        precompute
+        precompute,
+        profile
     );
 
 out:
-    c_kzg_free(g1_monomial_bytes);
-    c_kzg_free(g1_lagrange_bytes);
-    c_kzg_free(g2_monomial_bytes);
+    c_kzg_free(contents);
+    c_kzg_free(points);
+    return ret;
+}
+
+/**
+ * Serialize the points of a trusted setup in one of the binary formats.
+ *
+ * @param[out]  out         The serialized setup
+ * @param[out]  size_out    The number of bytes in it
+ * @param[in]   s           The trusted setup, with all of its points
+ * @param[in]   compressed  Whether to write compressed points, rather than uncompressed ones
+ *
+ * @remark Free the serialized setup afterwards with c_kzg_free().
+ */
+static C_KZG_RET serialize_trusted_setup(
+    uint8_t **out, size_t *size_out, const KZGSettings *s, bool compressed
+) {
+    C_KZG_RET ret;
+    uint8_t *contents = NULL;
+    g1_t *g1_lagrange = NULL;
+    blst_p1_affine *g1_affine = NULL;
+    blst_p2_affine *g2_affine = NULL;
+    size_t g1_size = compressed ? BYTES_PER_G1 : BYTES_PER_G1_UNCOMPRESSED;
+    size_t g2_size = compressed ? BYTES_PER_G2 : BYTES_PER_G2_UNCOMPRESSED;
+    size_t size = compressed ? TRUSTED_SETUP_BINARY_SIZE : TRUSTED_SETUP_UNCOMPRESSED_SIZE;
+    uint8_t *p;
+
+    ret = c_kzg_malloc((void **)&contents, size);
+    if (ret != C_KZG_OK) goto out;
+    ret = new_g1_array(&g1_lagrange, NUM_G1_POINTS);
+    if (ret != C_KZG_OK) goto out;
+    ret = c_kzg_calloc((void **)&g1_affine, NUM_G1_POINTS, sizeof(blst_p1_affine));
+    if (ret != C_KZG_OK) goto out;
+    ret = c_kzg_calloc((void **)&g2_affine, NUM_G2_POINTS, sizeof(blst_p2_affine));
+    if (ret != C_KZG_OK) goto out;
+
+    memcpy(
+        contents,
+        compressed ? TRUSTED_SETUP_BINARY_MAGIC : TRUSTED_SETUP_UNCOMPRESSED_MAGIC,
+        sizeof(TRUSTED_SETUP_BINARY_MAGIC)
+    );
+    bytes_from_uint64(&contents[sizeof(TRUSTED_SETUP_BINARY_MAGIC)], NUM_G1_POINTS);
+    bytes_from_uint64(&contents[sizeof(TRUSTED_SETUP_BINARY_MAGIC) + 8], NUM_G2_POINTS);
+    p = &contents[TRUSTED_SETUP_BINARY_HEADER_SIZE];
+
+    /* Undo the bit-reversal of the Lagrange points, it is its own inverse */
+    memcpy(g1_lagrange, s->g1_values_lagrange_brp, NUM_G1_POINTS * sizeof(g1_t));
+    ret = bit_reversal_permutation(g1_lagrange, sizeof(g1_t), NUM_G1_POINTS);
+    if (ret != C_KZG_OK) goto out;
+
+    /* Convert each array to affine with one inversion, then write its points */
+    const blst_p1 *g1_lagrange_arg[2] = {g1_lagrange, NULL};
+    blst_p1s_to_affine(g1_affine, g1_lagrange_arg, NUM_G1_POINTS);
+    for (size_t i = 0; i < NUM_G1_POINTS; i++, p += g1_size) {
+        if (compressed) blst_p1_affine_compress(p, &g1_affine[i]);
+        else blst_p1_affine_serialize(p, &g1_affine[i]);
+    }
+    const blst_p2 *g2_monomial_arg[2] = {s->g2_values_monomial, NULL};
+    blst_p2s_to_affine(g2_affine, g2_monomial_arg, NUM_G2_POINTS);
+    for (size_t i = 0; i < NUM_G2_POINTS; i++, p += g2_size) {
+        if (compressed) blst_p2_affine_compress(p, &g2_affine[i]);
+        else blst_p2_affine_serialize(p, &g2_affine[i]);
+    }
+    const blst_p1 *g1_monomial_arg[2] = {s->g1_values_monomial, NULL};
+    blst_p1s_to_affine(g1_affine, g1_monomial_arg, NUM_G1_POINTS);
+    for (size_t i = 0; i < NUM_G1_POINTS; i++, p += g1_size) {
+        if (compressed) blst_p1_affine_compress(p, &g1_affine[i]);
+        else blst_p1_affine_serialize(p, &g1_affine[i]);
+    }
+
+    *out = contents;
+    *size_out = size;
+    contents = NULL;
+
+out:
+    c_kzg_free(contents);
+    c_kzg_free(g1_lagrange);
+    c_kzg_free(g1_affine);
+    c_kzg_free(g2_affine);
+    return ret;
+}
+
+/**
+ * Save a trusted setup to a file in the binary format.
+ *
+ * The binary format holds the same points as the text format, compressed, so that loading it with
+ * load_trusted_setup_file() skips parsing text. It is the 8 bytes TRUSTED_SETUP_BINARY_MAGIC, the
+ * number of g1 points and of g2 points as 64-bit big-endian integers, then the g1 points in
+ * Lagrange form, the g2 points in monomial form and the g1 points in monomial form.
+ *
+ * @param[in]   s   The trusted setup
+ * @param[in]   out The file to write to
+ *
+ * @remark For a verification profile, this loads the rest of the setup first.
+ * @remark The output file will not be closed.
+ */
+C_KZG_RET save_trusted_setup_binary(const KZGSettings *s, FILE *out) {
+    C_KZG_RET ret;
+    uint8_t *contents = NULL;
+    size_t size;
+
+    /* All of the points are needed */
+    ret = get_prover_settings(&s, s, true);
+    if (ret != C_KZG_OK) goto out;
+
+    ret = serialize_trusted_setup(&contents, &size, s, true);
+    if (ret != C_KZG_OK) goto out;
+    if (fwrite(contents, 1, size, out) != size || fflush(out) != 0) {
+        ret = C_KZG_ERROR;
+        goto out;
+    }
+
+out:
+    c_kzg_free(contents);
+    return ret;
+}
+
+/**
+ * Serialize a trusted setup with uncompressed points, for load_trusted_setup_uncompressed().
+ *
+ * This is the binary format of save_trusted_setup_binary(), but starting with
+ * TRUSTED_SETUP_UNCOMPRESSED_MAGIC and with uncompressed points, which take twice the space but
+ * need no square roots to load.
+ *
+ * @param[out]  out         The serialized setup, TRUSTED_SETUP_UNCOMPRESSED_SIZE bytes
+ * @param[out]  hash_out    The SHA-256 of the serialized setup, to embed along with it
+ * @param[in]   s           The trusted setup
+ *
+ * @remark For a verification profile, this loads the rest of the setup first.
+ * @remark Free the serialized setup afterwards with c_kzg_free().
+ */
+C_KZG_RET serialize_trusted_setup_uncompressed(
+    uint8_t **out, Bytes32 *hash_out, const KZGSettings *s
+) {
+    C_KZG_RET ret;
+    size_t size;
+
+    /* All of the points are needed */
+    ret = get_prover_settings(&s, s, true);
+    if (ret != C_KZG_OK) return ret;
+
+    ret = serialize_trusted_setup(out, &size, s, false);
+    if (ret != C_KZG_OK) return ret;
+    blst_sha256(hash_out->bytes, *out, size);
+    return C_KZG_OK;
+}
+
+/**
+ * Convert uncompressed G1 points to projective form.
+ *
+ * @param[out]  out         The points
+ * @param[out]  compressed  The points compressed, for hashing the trusted setup
+ * @param[in]   bytes       The uncompressed points, BYTES_PER_G1_UNCOMPRESSED each
+ * @param[in]   n           The number of points
+ * @param[in]   trusted     Whether the points are known to be valid, so that they are not checked
+ */
+static C_KZG_RET g1_points_from_uncompressed_bytes(
+    g1_t *out, uint8_t *compressed, const uint8_t *bytes, size_t n, bool trusted
+) {
+    for (size_t i = 0; i < n; i++) {
+        const uint8_t *point = &bytes[BYTES_PER_G1_UNCOMPRESSED * i];
+        blst_p1_affine g1_affine;
+        if (trusted) {
+            /* The coordinates are big-endian x then y */
+            blst_fp_from_bendian(&g1_affine.x, point);
+            blst_fp_from_bendian(&g1_affine.y, &point[BYTES_PER_G1]);
+        } else {
+            if (blst_p1_deserialize(&g1_affine, point) != BLST_SUCCESS) return C_KZG_BADARGS;
+            if (!blst_p1_affine_in_g1(&g1_affine)) return C_KZG_BADARGS;
+        }
+        blst_p1_affine_compress(&compressed[BYTES_PER_G1 * i], &g1_affine);
+        blst_p1_from_affine(&out[i], &g1_affine);
+    }
+    return C_KZG_OK;
+}
+
+/**
+ * Convert uncompressed G2 points to projective form.
+ *
+ * @param[out]  out         The points
+ * @param[out]  compressed  The points compressed, for hashing the trusted setup
+ * @param[in]   bytes       The uncompressed points, BYTES_PER_G2_UNCOMPRESSED each
+ * @param[in]   n           The number of points
+ * @param[in]   trusted     Whether the points are known to be valid, so that they are not checked
+ */
+static C_KZG_RET g2_points_from_uncompressed_bytes(
+    g2_t *out, uint8_t *compressed, const uint8_t *bytes, size_t n, bool trusted
+) {
+    for (size_t i = 0; i < n; i++) {
+        const uint8_t *point = &bytes[BYTES_PER_G2_UNCOMPRESSED * i];
+        blst_p2_affine g2_affine;
+        if (trusted) {
+            /* The coordinates are big-endian x then y, with the imaginary part of each first */
+            blst_fp_from_bendian(&g2_affine.x.fp[1], point);
+            blst_fp_from_bendian(&g2_affine.x.fp[0], &point[BYTES_PER_G1]);
+            blst_fp_from_bendian(&g2_affine.y.fp[1], &point[2 * BYTES_PER_G1]);
+            blst_fp_from_bendian(&g2_affine.y.fp[0], &point[3 * BYTES_PER_G1]);
+        } else {
+            if (blst_p2_deserialize(&g2_affine, point) != BLST_SUCCESS) return C_KZG_BADARGS;
+            if (!blst_p2_affine_in_g2(&g2_affine)) return C_KZG_BADARGS;
+        }
+        blst_p2_affine_compress(&compressed[BYTES_PER_G2 * i], &g2_affine);
+        blst_p2_from_affine(&out[i], &g2_affine);
+    }
+    return C_KZG_OK;
+}
+
+/**
+ * Load trusted setup from uncompressed points, skipping the checks if they are known to be valid.
+ *
+ * Uncompressed points load without the square root that each compressed point needs. When the
+ * SHA-256 of `bytes` matches `trusted_hash`, the points are the ones which were hashed, so none of
+ * them are checked: not that they are on the curve, nor in the subgroup, nor that the setup is in
+ * Lagrange form. Otherwise every point is fully checked, including the subgroup checks which the
+ * other loaders leave out.
+ *
+ * @param[out]  out             Pointer to the stored trusted setup
+ * @param[in]   bytes           A setup from serialize_trusted_setup_uncompressed()
+ * @param[in]   num_bytes       The number of bytes, TRUSTED_SETUP_UNCOMPRESSED_SIZE
+ * @param[in]   trusted_hash    The SHA-256 of a known good setup, or NULL to check every point
+ * @param[in]   precompute      Configurable value between 0-15
+ *
+ * @remark The trusted hash must come from a trusted source, such as the binary itself, and not
+ * from the same place as the bytes.
+ * @remark Free afterwards use with free_trusted_setup().
+ */
+C_KZG_RET load_trusted_setup_uncompressed(
+    KZGSettings *out,
+    const uint8_t *bytes,
+    uint64_t num_bytes,
+    const Bytes32 *trusted_hash,
+    uint64_t precompute
+) {
+    C_KZG_RET ret;
+    uint8_t *compressed = NULL;
+    Bytes32 hash;
+    bool trusted = false;
+
+    /*
+     * Initialize all fields to null/zero so that if there's an error, we can can call
+     * free_trusted_setup() without worrying about freeing a random pointer.
+     */
+    init_settings(out);
+
+    if (precompute > MAX_WBITS || num_bytes != TRUSTED_SETUP_UNCOMPRESSED_SIZE ||
+        !has_magic(bytes, num_bytes, TRUSTED_SETUP_UNCOMPRESSED_MAGIC) ||
+        bytes_to_uint64(&bytes[sizeof(TRUSTED_SETUP_BINARY_MAGIC)]) != NUM_G1_POINTS ||
+        bytes_to_uint64(&bytes[sizeof(TRUSTED_SETUP_BINARY_MAGIC) + 8]) != NUM_G2_POINTS) {
+        ret = C_KZG_BADARGS;
+        goto out_error;
+    }
+
+    /* One hash of the whole setup stands in for checking every point */
+    if (trusted_hash != NULL) {
+        blst_sha256(hash.bytes, bytes, TRUSTED_SETUP_UNCOMPRESSED_SIZE);
+        trusted = memcmp(&hash, trusted_hash, sizeof(Bytes32)) == 0;
+    }
+
+    const uint8_t *g1_lagrange_bytes = &bytes[TRUSTED_SETUP_BINARY_HEADER_SIZE];
+    const uint8_t *g2_monomial_bytes = g1_lagrange_bytes +
+                                       NUM_G1_POINTS * BYTES_PER_G1_UNCOMPRESSED;
+    const uint8_t *g1_monomial_bytes = g2_monomial_bytes +
+                                       NUM_G2_POINTS * BYTES_PER_G2_UNCOMPRESSED;
+
+    out->wbits = precompute;
+    ret = alloc_settings_slab(out, KZG_PROFILE_FULL);
+    if (ret != C_KZG_OK) goto out_error;
+    ret = c_kzg_malloc((void **)&compressed, TRUSTED_SETUP_POINTS_SIZE);
+    if (ret != C_KZG_OK) goto out_error;
+
+    /* Convert the points, in the order of the compressed formats */
+    uint8_t *g1_lagrange_compressed = compressed;
+    uint8_t *g2_monomial_compressed = g1_lagrange_compressed + NUM_G1_POINTS * BYTES_PER_G1;
+    uint8_t *g1_monomial_compressed = g2_monomial_compressed + NUM_G2_POINTS * BYTES_PER_G2;
+    ret = g1_points_from_uncompressed_bytes(
+        out->g1_values_lagrange_brp,
+        g1_lagrange_compressed,
+        g1_lagrange_bytes,
+        NUM_G1_POINTS,
+        trusted
+    );
+    if (ret != C_KZG_OK) goto out_error;
+    ret = g2_points_from_uncompressed_bytes(
+        out->g2_values_monomial,
+        g2_monomial_compressed,
+        g2_monomial_bytes,
+        NUM_G2_POINTS,
+        trusted
+    );
+    if (ret != C_KZG_OK) goto out_error;
+    ret = g1_points_from_uncompressed_bytes(
+        out->g1_values_monomial,
+        g1_monomial_compressed,
+        g1_monomial_bytes,
+        NUM_G1_POINTS,
+        trusted
+    );
+    if (ret != C_KZG_OK) goto out_error;
+
+    if (!trusted) {
+        /* Make sure the trusted setup was loaded in Lagrange form */
+        ret = is_trusted_setup_in_lagrange_form(
+            out->g1_values_lagrange_brp, out->g2_values_monomial, NUM_G1_POINTS, NUM_G2_POINTS
+        );
+        if (ret != C_KZG_OK) goto out_error;
+    }
+
+    /* Identify the trusted setup the same way as when it is loaded from compressed points */
+    hash_trusted_setup(
+        &out->setup_hash, g1_monomial_compressed, g1_lagrange_compressed, g2_monomial_compressed
+    );
+
+    ret = init_derived_settings(out, KZG_PROFILE_FULL);
+    if (ret != C_KZG_OK) goto out_error;
+
+    goto out_success;
+
+out_error:
+    free_trusted_setup(out);
+out_success:
+    c_kzg_free(compressed);
+    return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// MSM Strategy Functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Get the average cost of an operation which was repeated since `start`.
+ *
+ * @param[in]   start       The clock value before the first repetition
+ * @param[in]   iterations  The number of repetitions
+ *
+ * @return The cost in millionths of a clock tick per repetition.
+ */
+static uint64_t cost_per_iteration(clock_t start, uint64_t iterations) {
+    clock_t elapsed = clock() - start;
+    return (uint64_t)elapsed * 1000000 / iterations;
+}
+
+/**
+ * Measure the cost of g1_lincomb_fast() with a given naive threshold.
+ *
+ * @param[out]  cost_out    The cost in millionths of a clock tick per MSM
+ * @param[in]   points      Array of G1 group elements, length `len`
+ * @param[in]   coeffs      Array of field elements, length `len`
+ * @param[in]   len         The number of group/field elements
+ * @param[in]   threshold   The naive threshold to use
+ * @param[in]   s           The trusted setup
+ */
+static C_KZG_RET time_lincomb(
+    uint64_t *cost_out,
+    const g1_t *points,
+    const fr_t *coeffs,
+    size_t len,
+    size_t threshold,
+    const KZGSettings *s
+) {
+    C_KZG_RET ret;
+    KZGSettings tuned = *s;
+    uint64_t iterations = 0;
+    g1_t out;
+
+    tuned.naive_threshold = threshold;
+
+    clock_t start = clock();
+    do {
+        ret = g1_lincomb_fast(&out, points, coeffs, len, &tuned);
+        if (ret != C_KZG_OK) return ret;
+        iterations++;
+    } while (clock() - start < AUTOTUNE_MIN_TICKS);
+
+    *cost_out = cost_per_iteration(start, iterations);
+    return C_KZG_OK;
+}
+
+/**
+ * Measure the cost of a fixed-base MSM over one FK20 column.
+ *
+ * @param[out]  cost_out    The cost in millionths of a clock tick per MSM
+ * @param[in]   column      The column of G1 group elements, length FIELD_ELEMENTS_PER_CELL
+ * @param[in]   coeffs      Array of field elements, length FIELD_ELEMENTS_PER_CELL
+ * @param[in]   wbits       The window size for the table
+ */
+static C_KZG_RET time_fixed_base(
+    uint64_t *cost_out, const g1_t *column, const fr_t *coeffs, size_t wbits
+) {
+    C_KZG_RET ret;
+    blst_p1_affine *p_affine = NULL;
+    blst_p1_affine *table = NULL;
+    blst_scalar *scalars = NULL;
+    limb_t *scratch = NULL;
+    uint64_t iterations = 0;
+    g1_t out;
+
+    /* Allocate space for arrays */
+    ret = c_kzg_calloc((void **)&p_affine, FIELD_ELEMENTS_PER_CELL, sizeof(blst_p1_affine));
+    if (ret != C_KZG_OK) goto out;
+    ret = c_kzg_calloc((void **)&scalars, FIELD_ELEMENTS_PER_CELL, sizeof(blst_scalar));
+    if (ret != C_KZG_OK) goto out;
+    ret = c_kzg_malloc(
+        (void **)&table, blst_p1s_mult_wbits_precompute_sizeof(wbits, FIELD_ELEMENTS_PER_CELL)
+    );
+    if (ret != C_KZG_OK) goto out;
+    ret = c_kzg_malloc(
+        (void **)&scratch, blst_p1s_mult_wbits_scratch_sizeof(FIELD_ELEMENTS_PER_CELL)
+    );
+    if (ret != C_KZG_OK) goto out;
+
+    /* Compute the table, in the same way as for the real tables */
+    const blst_p1 *p_arg[2] = {column, NULL};
+    blst_p1s_to_affine(p_affine, p_arg, FIELD_ELEMENTS_PER_CELL);
+    const blst_p1_affine *points_arg[2] = {p_affine, NULL};
+    blst_p1s_mult_wbits_precompute(table, wbits, points_arg, FIELD_ELEMENTS_PER_CELL);
+
+    /* Transform the field elements to 255-bit scalars */
+    for (size_t i = 0; i < FIELD_ELEMENTS_PER_CELL; i++) {
+        blst_scalar_from_fr(&scalars[i], &coeffs[i]);
+    }
+    const byte *scalars_arg[2] = {(byte *)scalars, NULL};
+
+    clock_t start = clock();
+    do {
+        blst_p1s_mult_wbits(
+            &out,
+            table,
+            wbits,
+            FIELD_ELEMENTS_PER_CELL,
+            scalars_arg,
+            BITS_PER_FIELD_ELEMENT,
+            scratch
+        );
+        iterations++;
+    } while (clock() - start < AUTOTUNE_MIN_TICKS);
+
+    *cost_out = cost_per_iteration(start, iterations);
+
+out:
+    c_kzg_free(p_affine);
+    c_kzg_free(table);
+    c_kzg_free(scalars);
+    c_kzg_free(scratch);
+    return ret;
+}
+
+/**
+ * Find the fastest MSM strategy on the current machine.
+ *
+ * This benchmarks the naive method against Pippenger's at a range of short lengths, and Pippenger's
+ * against the fixed-base method for each window size up to `max_wbits`, at the length of the FK20
+ * MSMs. The settings are not modified, apply the result with set_msm_strategy().
+ *
+ * @param[out]  out         The fastest strategy found
+ * @param[in]   s           The trusted setup
+ * @param[in]   max_wbits   The largest window size to consider, between 0-15
+ *
+ * @remark This takes roughly a second, plus the time needed to compute one table per window size.
+ * @remark The tables for a window size take 128 times the memory of the table benchmarked here,
+ * so `max_wbits` should be chosen with the memory available in mind.
+ * @remark Each table is benchmarked on its own, which is kinder to the caches than using all of
+ * them in turn. So a larger window size is only chosen if it is more than 10% faster.
+ */
+C_KZG_RET autotune_msm_strategy(MSMStrategy *out, const KZGSettings *s, uint64_t max_wbits) {
+    C_KZG_RET ret;
+    size_t num_lengths = sizeof(AUTOTUNE_LENGTHS) / sizeof(AUTOTUNE_LENGTHS[0]);
+    size_t threshold = AUTOTUNE_LENGTHS[num_lengths - 1] + 1;
+    uint64_t naive_cost, pippenger_cost;
+    uint64_t costs[MAX_WBITS + 1];
+    size_t wbits = 0;
+
+    if (max_wbits > MAX_WBITS) return C_KZG_BADARGS;
+
+    /* The benchmarks need the FK20 columns and all of the monomial points */
+    ret = get_prover_settings(&s, s, true);
+    if (ret != C_KZG_OK) return ret;
+
+    /*
+     * The roots of unity are as good as random scalars, and are what we have. Skip the first, which
+     * is one and would be unrealistically cheap to multiply by.
+     */
+    const fr_t *coeffs = &s->roots_of_unity[1];
+
+    /* Find the shortest length from which on Pippenger always beats the naive method */
+    for (size_t i = num_lengths; i > 0; i--) {
+        size_t len = AUTOTUNE_LENGTHS[i - 1];
+        ret = time_lincomb(&naive_cost, s->g1_values_monomial, coeffs, len, len + 1, s);
+        if (ret != C_KZG_OK) return ret;
+        ret = time_lincomb(&pippenger_cost, s->g1_values_monomial, coeffs, len, 2, s);
+        if (ret != C_KZG_OK) return ret;
+        if (pippenger_cost >= naive_cost) break;
+        threshold = len;
+    }
+
+    /* Compare the FK20 MSMs with and without precomputed tables */
+    const g1_t *column = s->x_ext_fft_columns[0];
+    ret = time_lincomb(&costs[0], column, coeffs, FIELD_ELEMENTS_PER_CELL, threshold, s);
+    if (ret != C_KZG_OK) return ret;
+    for (size_t w = 1; w <= max_wbits; w++) {
+        ret = time_fixed_base(&costs[w], column, coeffs, w);
+        if (ret != C_KZG_OK) return ret;
+        if (costs[w] < costs[wbits]) wbits = w;
+    }
+
+    /* Use the smallest window size which is within 10% of the fastest */
+    for (size_t w = 1; w < wbits; w++) {
+        if (costs[w] * 10 <= costs[wbits] * 11 && costs[w] < costs[0]) {
+            wbits = w;
+            break;
+        }
+    }
+
+    out->naive_threshold = threshold;
+    out->wbits = wbits;
+    return C_KZG_OK;
+}
+
+/**
+ * Get the MSM strategy which a trusted setup is using.
+ *
+ * @param[out]  out     The strategy in use
+ * @param[in]   s       The trusted setup
+ */
+void get_msm_strategy(MSMStrategy *out, const KZGSettings *s) {
+    out->naive_threshold = s->naive_threshold;
+    out->wbits = s->wbits;
+}
+
+/**
+ * Change the MSM strategy which a trusted setup uses.
+ *
+ * The FK20 tables are recomputed if the window size changes, which can take a while.
+ *
+ * @param[in,out]   s           The trusted setup
+ * @param[in]       strategy    The strategy to use, e.g. from autotune_msm_strategy()
+ *
+ * @remark For a verification profile, this loads the rest of the setup first.
+ * @remark This must not be called while `s` is in use by another thread.
+ * @remark On failure, `s` is left unchanged.
+ */
+C_KZG_RET set_msm_strategy(KZGSettings *s, const MSMStrategy *strategy) {
+    C_KZG_RET ret;
+    KZGSettings *prover;
+    size_t row_wbits[CELLS_PER_EXT_BLOB];
+
+    /* Pippenger needs at least two points, and blst limits the window size */
+    if (strategy->naive_threshold < 2 || strategy->wbits > MAX_WBITS) {
+        return C_KZG_BADARGS;
+    }
+
+    /* Only a setup with the FK20 columns has tables to change */
+    ret = get_mutable_prover_settings(&prover, s);
+    if (ret != C_KZG_OK) return ret;
+
+    /* Every row uses the same window size */
+    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+        row_wbits[i] = strategy->wbits;
+    }
+    ret = replace_fk20_tables(prover, row_wbits);
+    if (ret != C_KZG_OK) return ret;
+
+    prover->naive_threshold = strategy->naive_threshold;
+    s->naive_threshold = strategy->naive_threshold;
+    return C_KZG_OK;
+}
+
+/**
+ * Compute or drop the FK20 tables of a loaded trusted setup.
+ *
+ * This changes the `precompute` value which the setup was loaded with, without loading it again.
+ * It is safe to call while other threads use `s`: calls which compute proofs do not wait, they use
+ * the current tables until the new ones are in place. So a node can load with zero, which is quick
+ * and uses little memory, then call this on a thread of its own when it needs to compute proofs.
+ *
+ * @param[in,out]   s           The trusted setup
+ * @param[in]       precompute  Configurable value between 0-15, zero to drop the tables
+ *
+ * @remark Computing the tables takes about as long as loading with this `precompute` value.
+ * @remark The old tables are freed once the calls which were using them have returned.
+ * @remark For a verification profile, this loads the rest of the setup first.
+ * @remark On failure, `s` is left unchanged.
+ */
+C_KZG_RET set_precompute(KZGSettings *s, uint64_t precompute) {
+    C_KZG_RET ret;
+    KZGSettings *prover;
+    size_t row_wbits[CELLS_PER_EXT_BLOB];
+
+    if (precompute > MAX_WBITS) return C_KZG_BADARGS;
+
+    /* Only a setup with the FK20 columns has tables to change */
+    ret = get_mutable_prover_settings(&prover, s);
+    if (ret != C_KZG_OK) return ret;
+
+    /* Every row uses the same window size, as when loading */
+    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+        row_wbits[i] = (size_t)precompute;
+    }
+    return replace_fk20_tables(prover, row_wbits);
+}
+
+/**
+ * Choose and compute FK20 tables which fit in a memory budget.
+ *
+ * This is an alternative to the `precompute` parameter of load_trusted_setup(), for when the memory
+ * available falls between two window sizes. The largest window size for which every row's table
+ * fits is used, and the remainder of the budget is spent on giving some rows the next window size
+ * up. If the budget does not fit a table for every row, some rows get a table and the others use
+ * Pippenger.
+ *
+ * @param[in,out]   s       The trusted setup
+ * @param[in]       budget  The maximum number of bytes to use for the tables
+ *
+ * @remark Windows smaller than MIN_BUDGET_WBITS are not used, since they are slower than Pippenger.
+ * @remark For a verification profile, this loads the rest of the setup first.
+ * @remark Like set_precompute(), this is safe while other threads compute proofs with `s`.
+ * @remark On failure, `s` is left unchanged.
+ */
+C_KZG_RET set_precompute_budget(KZGSettings *s, uint64_t budget) {
+    C_KZG_RET ret;
+    KZGSettings *prover;
+    size_t row_wbits[CELLS_PER_EXT_BLOB];
+    size_t wbits = MIN_BUDGET_WBITS;
+    size_t num_upgraded;
+
+    /* Find the largest window size which fits for every row */
+    while (wbits < MAX_WBITS) {
+        uint64_t size = blst_p1s_mult_wbits_precompute_sizeof(wbits + 1, FIELD_ELEMENTS_PER_CELL);
+        if (size * CELLS_PER_EXT_BLOB > budget) break;
+        wbits++;
+    }
+
+    uint64_t table_size = blst_p1s_mult_wbits_precompute_sizeof(wbits, FIELD_ELEMENTS_PER_CELL);
+    if (table_size * CELLS_PER_EXT_BLOB > budget) {
+        /* Only some of the rows get a table */
+        num_upgraded = (size_t)(budget / table_size);
+        for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+            row_wbits[i] = i < num_upgraded ? wbits : 0;
+        }
+    } else {
+        /* Spend the remainder on larger tables for some of the rows */
+        uint64_t remainder = budget - table_size * CELLS_PER_EXT_BLOB;
+        num_upgraded = 0;
+        if (wbits < MAX_WBITS) {
+            uint64_t larger_size = blst_p1s_mult_wbits_precompute_sizeof(
+                wbits + 1, FIELD_ELEMENTS_PER_CELL
+            );
+            num_upgraded = (size_t)(remainder / (larger_size - table_size));
+        }
+        for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+            row_wbits[i] = i < num_upgraded ? wbits + 1 : wbits;
+        }
+    }
+
+    ret = get_mutable_prover_settings(&prover, s);
+    if (ret != C_KZG_OK) return ret;
+    return replace_fk20_tables(prover, row_wbits);
+}
+
+/**
+ * Change where the FK20 tables of a trusted setup are placed in memory.
+ *
+ * The tables are large and read in a pattern which misses the TLB often with 4 KiB pages, so they
+ * can be put on huge pages. On machines with several NUMA nodes, they can also be copied to every
+ * node, and each call reads the copy on the node it runs on.
+ *
+ * The placement applies to the current tables, which are moved, and to any computed later.
+ *
+ * @param[in,out]   s           The trusted setup
+ * @param[in]       placement   A combination of the KZG_TABLES_* flags, or zero for the heap
+ *
+ * @remark Huge pages and NUMA placement are only supported on Linux, elsewhere the flags are
+ * accepted but the tables stay on the heap.
+ * @remark Tables which are placed are mapped directly, rather than taken from set_kzg_allocator().
+ * @remark Replicas take the memory of the tables once per node.
+ * @remark Tables in a shared mapping, see attach_shared_settings(), cannot be moved.
+ * @remark For a verification profile, this loads the rest of the setup first.
+ * @remark Like set_precompute(), this is safe while other threads compute proofs with `s`.
+ * @remark On failure, `s` is left unchanged.
+ */
+C_KZG_RET set_table_placement(KZGSettings *s, uint64_t placement) {
+    C_KZG_RET ret;
+    FK20Tables *tables = NULL;
+
+    if ((placement & ~(uint64_t)(KZG_TABLES_HUGE_PAGES | KZG_TABLES_NUMA_REPLICAS)) != 0) {
+        return C_KZG_BADARGS;
+    }
+
+    /* Only a setup with the FK20 columns has tables to place */
+    ret = get_mutable_prover_settings(&s, s);
+    if (ret != C_KZG_OK) return ret;
+
+    lock_fk20_tables(s);
+
+    /* Tables in a shared mapping belong to every process which attached it */
+    if (s->tables != NULL && s->tables->block == NULL) {
+        ret = C_KZG_BADARGS;
+        goto out;
+    }
+
+    if (s->tables != NULL) {
+        /* Move the current tables, which is much faster than computing them again */
+        ret = alloc_fk20_tables(&tables, s->tables->wbits, placement);
+        if (ret != C_KZG_OK) goto out;
+        memcpy(tables->block, s->tables->block, s->tables->block_size);
+        ret = copy_fk20_tables_to_nodes(tables, placement);
+        if (ret != C_KZG_OK) goto out;
+
+        install_fk20_tables(s, tables);
+        tables = NULL;
+    }
+    s->table_placement = placement;
+    ret = C_KZG_OK;
+
+out:
+    unlock_fk20_tables(s);
+    free_fk20_tables(&tables);
     return ret;
 }
@@ -39,10 +39,43 @@ C_KZG_RET load_trusted_setup(
     uint64_t precompute
 );
 
+C_KZG_RET load_trusted_setup_profile(
+    KZGSettings *out,
+    const uint8_t *g1_monomial_bytes,
+    uint64_t num_g1_monomial_bytes,
+    const uint8_t *g1_lagrange_bytes,
+    uint64_t num_g1_lagrange_bytes,
+    const uint8_t *g2_monomial_bytes,
+    uint64_t num_g2_monomial_bytes,
+    uint64_t precompute,
+    uint64_t profile
+);
+
 C_KZG_RET load_trusted_setup_file(KZGSettings *out, FILE *in, uint64_t precompute);
+C_KZG_RET load_trusted_setup_file_profile(
+    KZGSettings *out, FILE *in, uint64_t precompute, uint64_t profile
+);
+C_KZG_RET save_trusted_setup_binary(const KZGSettings *s, FILE *out);
+C_KZG_RET serialize_trusted_setup_uncompressed(
+    uint8_t **out, Bytes32 *hash_out, const KZGSettings *s
+);
+C_KZG_RET load_trusted_setup_uncompressed(
+    KZGSettings *out,
+    const uint8_t *bytes,
+    uint64_t num_bytes,
+    const Bytes32 *trusted_hash,
+    uint64_t precompute
+);
 
 void free_trusted_setup(KZGSettings *s);
 
+C_KZG_RET autotune_msm_strategy(MSMStrategy *out, const KZGSettings *s, uint64_t max_wbits);
+void get_msm_strategy(MSMStrategy *out, const KZGSettings *s);
+C_KZG_RET set_msm_strategy(KZGSettings *s, const MSMStrategy *strategy);
+C_KZG_RET set_precompute(KZGSettings *s, uint64_t precompute);
+C_KZG_RET set_precompute_budget(KZGSettings *s, uint64_t budget);
+C_KZG_RET set_table_placement(KZGSettings *s, uint64_t placement);
+
 #ifdef __cplusplus
 }
 #endif
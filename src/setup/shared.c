@@ -0,0 +1,504 @@
+/*
+ * Copyright 2024 Benjamin Edgington
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "setup/shared.h"
+#include "common/alloc.h"
+#include "common/pages.h"
+#include "setup/prover.h"
+#include "setup/roots.h"
+#include "setup/setup.h"
+
+#include <stdbool.h> /* For bool */
+#include <stddef.h>  /* For size_t & NULL */
+#include <stdint.h>  /* For uint8_t & uint64_t */
+#include <string.h>  /* For memcmp & memset */
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Macros
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** The version of the precomputed settings layout, changed whenever the layout changes. */
+#define SHARED_SETTINGS_VERSION 3
+
+/** The multiplier for the checksum, a large odd constant with well mixed bits. */
+#define CHECKSUM_PRIME 0x9e3779b185ebca87ULL
+
+/** The number of independent lanes in the checksum, so that they can be computed in parallel. */
+#define CHECKSUM_LANES 4
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Types
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The header at the start of a precomputed settings file.
+ *
+ * Everything after the header is at an offset from the start of the file, so that the file can be
+ * mapped at any address. The arrays are stored exactly as they are in memory, so the file can only
+ * be attached on the same platform and by the same version of the library which saved it.
+ */
+typedef struct {
+    /** SHARED_SETTINGS_MAGIC. */
+    uint8_t magic[8];
+    /** SHARED_SETTINGS_VERSION. */
+    uint64_t version;
+    /** The size of an fr_t, which depends on the platform. */
+    uint64_t fr_size;
+    /** The size of a g1_t, which depends on the platform. */
+    uint64_t g1_size;
+    /** The size of a g2_t, which depends on the platform. */
+    uint64_t g2_size;
+    /** The size of the whole file. */
+    uint64_t file_size;
+    /** The checksum of the whole file, computed with this field set to zero. */
+    uint64_t checksum;
+    /** The hash of the trusted setup which the file was computed from. */
+    Bytes32 setup_hash;
+    /** MSMs with fewer points than this are computed naively instead of with Pippenger. */
+    uint64_t naive_threshold;
+    /** The offset of the G1 points in monomial form. */
+    uint64_t g1_monomial_offset;
+    /** The offset of the G1 points in Lagrange form and bit-reversed order. */
+    uint64_t g1_lagrange_offset;
+    /** The offset of the G2 points in monomial form. */
+    uint64_t g2_monomial_offset;
+    /** The offset of the FK20 columns, one after the other. */
+    uint64_t columns_offset;
+    /** The window size of each row's FK20 table, zero for rows without a table. */
+    uint64_t row_wbits[CELLS_PER_EXT_BLOB];
+    /** The offset of each row's FK20 table, zero for rows without a table. */
+    uint64_t row_table_offsets[CELLS_PER_EXT_BLOB];
+} SharedSettingsHeader;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Constants
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** The bytes which a precomputed settings file starts with. */
+static const uint8_t SHARED_SETTINGS_MAGIC[8] = {'c', 'k', 'z', 'g', 's', 'e', 't', 's'};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helper Functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Reserve an aligned region at the end of a file being laid out.
+ *
+ * @param[in,out]   file_size   The size of the file so far, grown by the region
+ * @param[in]       size        The number of bytes in the region
+ *
+ * @return The offset of the region.
+ */
+static uint64_t reserve_file_region(uint64_t *file_size, uint64_t size) {
+    uint64_t offset = (*file_size + SLAB_ALIGNMENT - 1) & ~(uint64_t)(SLAB_ALIGNMENT - 1);
+    *file_size = offset + size;
+    return offset;
+}
+
+/**
+ * Write a region of a file, padding with zeros up to its offset.
+ *
+ * @param[in]       out         The file
+ * @param[in,out]   position    The number of bytes written so far
+ * @param[in]       offset      The offset of the region, not before `position`
+ * @param[in]       data        The contents of the region
+ * @param[in]       size        The number of bytes in the region
+ */
+static C_KZG_RET write_file_region(
+    FILE *out, uint64_t *position, uint64_t offset, const void *data, size_t size
+) {
+    static const uint8_t zeros[SLAB_ALIGNMENT] = {0};
+
+    while (*position < offset) {
+        size_t padding = offset - *position < SLAB_ALIGNMENT ? (size_t)(offset - *position)
+                                                               : SLAB_ALIGNMENT;
+        if (fwrite(zeros, 1, padding, out) != padding) return C_KZG_ERROR;
+        *position += padding;
+    }
+    if (fwrite(data, 1, size, out) != size) return C_KZG_ERROR;
+    *position += size;
+    return C_KZG_OK;
+}
+
+/**
+ * Compute a checksum of some bytes.
+ *
+ * This catches files which were truncated, corrupted or partially written, at close to the speed
+ * of reading memory. It is not a cryptographic hash, and does not protect against tampering.
+ *
+ * @param[in]   bytes   The bytes
+ * @param[in]   n       The number of bytes
+ *
+ * @return The checksum.
+ */
+static uint64_t checksum_bytes(const uint8_t *bytes, size_t n) {
+    uint64_t lanes[CHECKSUM_LANES] = {1, 2, 3, 4};
+    uint64_t word, checksum;
+    size_t i = 0;
+
+    for (; i + CHECKSUM_LANES * sizeof(uint64_t) <= n; i += CHECKSUM_LANES * sizeof(uint64_t)) {
+        for (size_t l = 0; l < CHECKSUM_LANES; l++) {
+            memcpy(&word, &bytes[i + l * sizeof(uint64_t)], sizeof(uint64_t));
+            lanes[l] = (lanes[l] ^ word) * CHECKSUM_PRIME;
+            lanes[l] = (lanes[l] << 31) | (lanes[l] >> 33);
+        }
+    }
+    for (; i < n; i++) {
+        lanes[0] = (lanes[0] ^ bytes[i]) * CHECKSUM_PRIME;
+    }
+
+    checksum = n;
+    for (size_t l = 0; l < CHECKSUM_LANES; l++) {
+        checksum = (checksum ^ lanes[l]) * CHECKSUM_PRIME;
+        checksum ^= checksum >> 29;
+    }
+    return checksum;
+}
+
+/**
+ * Add the checksum of some bytes to a running checksum.
+ *
+ * @param[in,out]   checksum    The running checksum
+ * @param[in]       bytes       The bytes
+ * @param[in]       n           The number of bytes
+ */
+static void add_to_checksum(uint64_t *checksum, const void *bytes, size_t n) {
+    *checksum = (*checksum ^ checksum_bytes(bytes, n)) * CHECKSUM_PRIME;
+}
+
+/**
+ * Compute the checksum of a precomputed settings file.
+ *
+ * This covers the header, with its checksum set to zero, and every array in the order they are
+ * in the file. The padding between the arrays is not covered, since it is never read.
+ *
+ * @param[in]   header  The file's header
+ * @param[in]   s       The settings which the file holds, or which point into it
+ * @param[in]   tables  The FK20 tables of the settings
+ *
+ * @return The checksum.
+ */
+static uint64_t checksum_settings(
+    const SharedSettingsHeader *header, const KZGSettings *s, const FK20Tables *tables
+) {
+    SharedSettingsHeader copy = *header;
+    uint64_t checksum = 0;
+
+    copy.checksum = 0;
+    add_to_checksum(&checksum, &copy, sizeof(copy));
+    add_to_checksum(&checksum, s->g1_values_monomial, NUM_G1_POINTS * sizeof(g1_t));
+    add_to_checksum(&checksum, s->g1_values_lagrange_brp, NUM_G1_POINTS * sizeof(g1_t));
+    add_to_checksum(&checksum, s->g2_values_monomial, NUM_G2_POINTS * sizeof(g2_t));
+    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+        add_to_checksum(
+            &checksum, s->x_ext_fft_columns[i], FIELD_ELEMENTS_PER_CELL * sizeof(g1_t)
+        );
+    }
+    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+        if (header->row_wbits[i] == 0) continue;
+        add_to_checksum(
+            &checksum,
+            tables->tables[i],
+            blst_p1s_mult_wbits_precompute_sizeof(
+                (size_t)header->row_wbits[i], FIELD_ELEMENTS_PER_CELL
+            )
+        );
+    }
+    return checksum;
+}
+
+/**
+ * Check that a region is inside a precomputed settings file, after the header and aligned.
+ *
+ * @param[in]   header  The file's header
+ * @param[in]   offset  The offset of the region
+ * @param[in]   size    The number of bytes in the region
+ */
+static bool is_valid_region(const SharedSettingsHeader *header, uint64_t offset, uint64_t size) {
+    return offset >= sizeof(SharedSettingsHeader) && offset % SLAB_ALIGNMENT == 0 &&
+           offset <= header->file_size && size <= header->file_size - offset;
+}
+
+/**
+ * Check the header of a precomputed settings file.
+ *
+ * @param[in]   header      The file's header
+ * @param[in]   file_size   The size of the file
+ */
+static C_KZG_RET check_shared_settings_header(
+    const SharedSettingsHeader *header, uint64_t file_size
+) {
+    if (memcmp(header->magic, SHARED_SETTINGS_MAGIC, sizeof(SHARED_SETTINGS_MAGIC)) != 0 ||
+        header->version != SHARED_SETTINGS_VERSION || header->fr_size != sizeof(fr_t) ||
+        header->g1_size != sizeof(g1_t) || header->g2_size != sizeof(g2_t) ||
+        header->file_size != file_size || header->naive_threshold < 2) {
+        return C_KZG_BADARGS;
+    }
+
+    if (!is_valid_region(header, header->g1_monomial_offset, NUM_G1_POINTS * sizeof(g1_t)) ||
+        !is_valid_region(header, header->g1_lagrange_offset, NUM_G1_POINTS * sizeof(g1_t)) ||
+        !is_valid_region(header, header->g2_monomial_offset, NUM_G2_POINTS * sizeof(g2_t)) ||
+        !is_valid_region(
+            header,
+            header->columns_offset,
+            CELLS_PER_EXT_BLOB * FIELD_ELEMENTS_PER_CELL * sizeof(g1_t)
+        )) {
+        return C_KZG_BADARGS;
+    }
+
+    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+        uint64_t wbits = header->row_wbits[i];
+        if (wbits == 0) continue;
+        if (wbits > MAX_WBITS) return C_KZG_BADARGS;
+        uint64_t table_size = blst_p1s_mult_wbits_precompute_sizeof(
+            (size_t)wbits, FIELD_ELEMENTS_PER_CELL
+        );
+        if (!is_valid_region(header, header->row_table_offsets[i], table_size)) {
+            return C_KZG_BADARGS;
+        }
+    }
+
+    return C_KZG_OK;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Precomputed Settings
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Save a trusted setup, with everything computed from it, to a file.
+ *
+ * The file holds every array of the setup, including the FK20 columns and tables, as it is in
+ * memory. It can be loaded with load_precomputed_settings() instead of loading the trusted setup,
+ * which skips computing anything. Processes can also attach it with attach_shared_settings(), which
+ * maps it rather than copies it, so that they share one copy of the memory.
+ *
+ * @param[in]   s   The trusted setup
+ * @param[in]   out The file to write to, at its start
+ *
+ * @remark For POSIX shared memory, pass the stream from fdopen() on the descriptor from
+ * shm_open(). On Linux, a file on a tmpfs such as /dev/shm works the same.
+ * @remark For a verification profile, this loads the rest of the setup first.
+ * @remark The output file will not be closed.
+ */
+C_KZG_RET save_precomputed_settings(const KZGSettings *s, FILE *out) {
+    C_KZG_RET ret;
+    SharedSettingsHeader header;
+    uint64_t file_size = sizeof(SharedSettingsHeader);
+    uint64_t position = 0;
+    size_t column_size = FIELD_ELEMENTS_PER_CELL * sizeof(g1_t);
+    size_t table_sizes[CELLS_PER_EXT_BLOB];
+    const FK20Tables *tables;
+    uint64_t epoch;
+
+    /* All of the arrays are needed */
+    ret = get_prover_settings(&s, s, true);
+    if (ret != C_KZG_OK) return ret;
+
+    /* Keep the tables from being replaced while they are written */
+    tables = acquire_fk20_tables(&epoch, s);
+
+    /* Lay out the file */
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SHARED_SETTINGS_MAGIC, sizeof(SHARED_SETTINGS_MAGIC));
+    header.version = SHARED_SETTINGS_VERSION;
+    header.fr_size = sizeof(fr_t);
+    header.g1_size = sizeof(g1_t);
+    header.g2_size = sizeof(g2_t);
+    header.naive_threshold = s->naive_threshold;
+    header.setup_hash = s->setup_hash;
+    header.g1_monomial_offset = reserve_file_region(&file_size, NUM_G1_POINTS * sizeof(g1_t));
+    header.g1_lagrange_offset = reserve_file_region(&file_size, NUM_G1_POINTS * sizeof(g1_t));
+    header.g2_monomial_offset = reserve_file_region(&file_size, NUM_G2_POINTS * sizeof(g2_t));
+    header.columns_offset = reserve_file_region(&file_size, CELLS_PER_EXT_BLOB * column_size);
+    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+        table_sizes[i] = 0;
+        if (tables == NULL || tables->tables[i] == NULL) continue;
+        header.row_wbits[i] = tables->wbits[i];
+        table_sizes[i] = blst_p1s_mult_wbits_precompute_sizeof(
+            tables->wbits[i], FIELD_ELEMENTS_PER_CELL
+        );
+        header.row_table_offsets[i] = reserve_file_region(&file_size, table_sizes[i]);
+    }
+    header.file_size = file_size;
+    header.checksum = checksum_settings(&header, s, tables);
+
+    /* Write it in the same order */
+    ret = write_file_region(out, &position, 0, &header, sizeof(header));
+    if (ret != C_KZG_OK) goto out;
+    ret = write_file_region(
+        out,
+        &position,
+        header.g1_monomial_offset,
+        s->g1_values_monomial,
+        NUM_G1_POINTS * sizeof(g1_t)
+    );
+    if (ret != C_KZG_OK) goto out;
+    ret = write_file_region(
+        out,
+        &position,
+        header.g1_lagrange_offset,
+        s->g1_values_lagrange_brp,
+        NUM_G1_POINTS * sizeof(g1_t)
+    );
+    if (ret != C_KZG_OK) goto out;
+    ret = write_file_region(
+        out,
+        &position,
+        header.g2_monomial_offset,
+        s->g2_values_monomial,
+        NUM_G2_POINTS * sizeof(g2_t)
+    );
+    if (ret != C_KZG_OK) goto out;
+    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+        uint64_t offset = header.columns_offset + i * column_size;
+        ret = write_file_region(out, &position, offset, s->x_ext_fft_columns[i], column_size);
+        if (ret != C_KZG_OK) goto out;
+    }
+    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+        if (table_sizes[i] == 0) continue;
+        ret = write_file_region(
+            out, &position, header.row_table_offsets[i], tables->tables[i], table_sizes[i]
+        );
+        if (ret != C_KZG_OK) goto out;
+    }
+
+    ret = fflush(out) == 0 ? C_KZG_OK : C_KZG_ERROR;
+
+out:
+    release_fk20_tables(s, epoch);
+    return ret;
+}
+
+/**
+ * Attach to a trusted setup saved with save_precomputed_settings().
+ *
+ * The file is mapped read-only and shared, and the arrays of the setup point into it. Only a few
+ * small arrays of pointers are allocated, so this takes about as long as mapping the file.
+ *
+ * Only the header is checked, for processes which trust whoever saved the file. To also check the
+ * contents and which trusted setup the file is for, use load_precomputed_settings().
+ *
+ * @param[out]  out The attached trusted setup
+ * @param[in]   in  The file, which can be closed afterwards
+ *
+ * @remark The file must not be changed while it is attached.
+ * @remark Where files cannot be mapped, the file is read into the heap instead.
+ * @remark Returns C_KZG_BADARGS if the file was saved on another platform or by another version.
+ * @remark Free afterwards use with free_trusted_setup().
+ */
+C_KZG_RET attach_shared_settings(KZGSettings *out, FILE *in) {
+    C_KZG_RET ret;
+    const SharedSettingsHeader *header;
+    uint8_t *base;
+    size_t file_size;
+    FK20Tables *tables = NULL;
+    size_t max_wbits = 0;
+
+    memset(out, 0, sizeof(KZGSettings));
+
+    ret = map_file(&out->mapping, &out->mapping_size, &file_size, in);
+    if (ret != C_KZG_OK) goto out_error;
+    if (file_size < sizeof(SharedSettingsHeader)) {
+        ret = C_KZG_BADARGS;
+        goto out_error;
+    }
+    base = out->mapping;
+    header = (const SharedSettingsHeader *)(const void *)base;
+    ret = check_shared_settings_header(header, file_size);
+    if (ret != C_KZG_OK) goto out_error;
+
+    /* Point the arrays into the file, the roots of unity are compiled in */
+    out->roots_of_unity = ROOTS_OF_UNITY;
+    out->brp_roots_of_unity = BRP_ROOTS_OF_UNITY;
+    out->reverse_roots_of_unity = REVERSE_ROOTS_OF_UNITY;
+    out->g1_values_monomial = (g1_t *)(void *)(base + header->g1_monomial_offset);
+    out->g1_values_lagrange_brp = (g1_t *)(void *)(base + header->g1_lagrange_offset);
+    out->g2_values_monomial = (g2_t *)(void *)(base + header->g2_monomial_offset);
+    out->naive_threshold = (size_t)header->naive_threshold;
+    out->setup_hash = header->setup_hash;
+
+    /* The column pointers are local, the slab holds them and what synchronizes the tables */
+    ret = c_kzg_calloc(&out->slab, 1, CELLS_PER_EXT_BLOB * sizeof(g1_t *) + sizeof(TableEpochs));
+    if (ret != C_KZG_OK) goto out_error;
+    out->x_ext_fft_columns = out->slab;
+    out->table_epochs = (TableEpochs *)(void *)&out->x_ext_fft_columns[CELLS_PER_EXT_BLOB];
+    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+        size_t offset = header->columns_offset + i * FIELD_ELEMENTS_PER_CELL * sizeof(g1_t);
+        out->x_ext_fft_columns[i] = (g1_t *)(void *)(base + offset);
+    }
+
+    /* So are the table pointers, the tables stay in the file */
+    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+        if (header->row_wbits[i] > max_wbits) max_wbits = (size_t)header->row_wbits[i];
+    }
+    if (max_wbits != 0) {
+        ret = c_kzg_calloc((void **)&tables, 1, sizeof(FK20Tables));
+        if (ret != C_KZG_OK) goto out_error;
+        out->tables = tables;
+        ret = c_kzg_calloc((void **)&tables->tables, CELLS_PER_EXT_BLOB, sizeof(void *));
+        if (ret != C_KZG_OK) goto out_error;
+        ret = c_kzg_calloc((void **)&tables->wbits, CELLS_PER_EXT_BLOB, sizeof(size_t));
+        if (ret != C_KZG_OK) goto out_error;
+        for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+            if (header->row_wbits[i] == 0) continue;
+            uint8_t *table = base + header->row_table_offsets[i];
+            tables->tables[i] = (blst_p1_affine *)(void *)table;
+            tables->wbits[i] = (size_t)header->row_wbits[i];
+        }
+        out->wbits = max_wbits;
+        out->scratch_size = blst_p1s_mult_wbits_scratch_sizeof(FIELD_ELEMENTS_PER_CELL);
+    }
+
+    return C_KZG_OK;
+
+out_error:
+    free_trusted_setup(out);
+    return ret;
+}
+
+/**
+ * Load a trusted setup saved with save_precomputed_settings().
+ *
+ * This is attach_shared_settings(), plus a check of the file's checksum and of the trusted setup
+ * it was computed from. The check reads the whole file once, which is much faster than computing
+ * its contents, so a file cached from an earlier start can be used safely.
+ *
+ * @param[out]  out         The loaded trusted setup
+ * @param[in]   in          The file, which can be closed afterwards
+ * @param[in]   setup_hash  The `setup_hash` of the expected trusted setup, or NULL for any
+ *
+ * @remark Returns C_KZG_BADARGS if the file is damaged, is for another trusted setup, or was saved
+ * on another platform or by another version. The caller can then load the trusted setup and save
+ * the file again.
+ * @remark Free afterwards use with free_trusted_setup().
+ */
+C_KZG_RET load_precomputed_settings(KZGSettings *out, FILE *in, const Bytes32 *setup_hash) {
+    C_KZG_RET ret;
+    const SharedSettingsHeader *header;
+
+    ret = attach_shared_settings(out, in);
+    if (ret != C_KZG_OK) return ret;
+    header = out->mapping;
+
+    if (checksum_settings(header, out, out->tables) != header->checksum ||
+        (setup_hash != NULL &&
+         memcmp(&header->setup_hash, setup_hash, sizeof(Bytes32)) != 0)) {
+        free_trusted_setup(out);
+        return C_KZG_BADARGS;
+    }
+    return C_KZG_OK;
+}
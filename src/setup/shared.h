@@ -0,0 +1,38 @@
+/*
+ * Copyright 2024 Benjamin Edgington
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "common/ret.h"
+#include "setup/settings.h"
+
+#include <stdio.h> /* For FILE */
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Public Functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+C_KZG_RET save_precomputed_settings(const KZGSettings *s, FILE *out);
+C_KZG_RET attach_shared_settings(KZGSettings *out, FILE *in);
+C_KZG_RET load_precomputed_settings(KZGSettings *out, FILE *in, const Bytes32 *setup_hash);
+
+#ifdef __cplusplus
+}
+#endif
@@ -8,6 +8,10 @@
 #include <stdio.h>
 #include <string.h>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#endif
+
 #ifdef PROFILE
 #include <gperftools/profiler.h>
 #endif
@@ -105,7 +109,7 @@ static void get_rand_uint64(uint64_t *out) {
     memcpy(out, b.bytes, sizeof(*out));
 }
 
-static void eval_poly(fr_t *out, fr_t *poly_coefficients, fr_t *x) {
+static void eval_poly(fr_t *out, fr_t *poly_coefficients, const fr_t *x) {
     *out = poly_coefficients[FIELD_ELEMENTS_PER_BLOB - 1];
     for (size_t i = FIELD_ELEMENTS_PER_BLOB - 1; i > 0; i--) {
         blst_fr_mul(out, out, x);
@@ -113,7 +117,7 @@ static void eval_poly(fr_t *out, fr_t *poly_coefficients, fr_t *x) {
     }
 }
 
-static void eval_extended_poly(fr_t *out, fr_t *poly_coefficients, fr_t *x) {
+static void eval_extended_poly(fr_t *out, fr_t *poly_coefficients, const fr_t *x) {
     *out = poly_coefficients[FIELD_ELEMENTS_PER_EXT_BLOB - 1];
     for (size_t i = FIELD_ELEMENTS_PER_EXT_BLOB - 1; i > 0; i--) {
         blst_fr_mul(out, out, x);
@@ -121,6 +125,42 @@ static void eval_extended_poly(fr_t *out, fr_t *poly_coefficients, fr_t *x) {
     }
 }
 
+/**
+ * Generate powers of a root of unity in the field.
+ *
+ * @param[out]  out     The roots of unity (length `width + 1`)
+ * @param[in]   root    A root of unity
+ * @param[in]   width   One less than the size of `out`
+ *
+ * @remark `root` must be such that `root ^ width` is equal to one, but no smaller power of `root`
+ * is equal to one.
+ */
+static C_KZG_RET expand_root_of_unity(fr_t *out, const fr_t *root, size_t width) {
+    size_t i;
+
+    /* We assume it's at least two */
+    if (width < 2) {
+        return C_KZG_BADARGS;
+    }
+
+    /* We know what these will be */
+    out[0] = FR_ONE;
+    out[1] = *root;
+
+    /* Compute powers of root */
+    for (i = 2; i <= width; i++) {
+        blst_fr_mul(&out[i], &out[i - 1], root);
+        if (fr_is_one(&out[i])) break;
+    }
+
+    /* We expect the last entry to be one */
+    if (i != width || !fr_is_one(&out[width])) {
+        return C_KZG_BADARGS;
+    }
+
+    return C_KZG_OK;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Tests for memory allocation functions
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -939,12 +979,99 @@ static void test_g1_lincomb__verify_consistent(void) {
 
     g1_lincomb_naive(&check, points, scalars, 128);
 
-    ret = g1_lincomb_fast(&out, points, scalars, 128);
+    ret = g1_lincomb_fast(&out, points, scalars, 128, &s);
     ASSERT_EQUALS(ret, C_KZG_OK);
 
     ASSERT("pippenger matches naive MSM", blst_p1_is_equal(&out, &check));
 }
 
+static void test_g1_lincomb__sparse_scalars(void) {
+    C_KZG_RET ret;
+    g1_t points[128], out, check;
+    fr_t scalars[128];
+
+    /* Only a handful of terms are non-zero, one of which has a point at infinity */
+    for (size_t i = 0; i < 128; i++) {
+        get_rand_g1(&points[i]);
+        scalars[i] = FR_ZERO;
+    }
+    for (size_t i = 0; i < 128; i += 23) {
+        get_rand_fr(&scalars[i]);
+    }
+    points[46] = G1_IDENTITY;
+
+    g1_lincomb_naive(&check, points, scalars, 128);
+
+    ret = g1_lincomb_fast(&out, points, scalars, 128, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT("sparse pippenger matches naive MSM", blst_p1_is_equal(&out, &check));
+
+    /* All of the terms are zero */
+    for (size_t i = 0; i < 128; i++) {
+        scalars[i] = FR_ZERO;
+    }
+    ret = g1_lincomb_fast(&out, points, scalars, 128, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT("zero pippenger is the identity", blst_p1_is_inf(&out));
+}
+
+static void test_g1_lincomb__short_scalars(void) {
+    C_KZG_RET ret;
+    g1_t points[128], out, check;
+    fr_t scalars[128];
+    uint64_t value;
+
+    /* Mostly single-byte scalars, with a few full-width ones mixed in */
+    for (size_t i = 0; i < 128; i++) {
+        get_rand_g1(&points[i]);
+        get_rand_uint64(&value);
+        if (i % 17 == 3) {
+            get_rand_fr(&scalars[i]);
+        } else {
+            fr_from_uint64(&scalars[i], value & 0xff);
+        }
+    }
+
+    g1_lincomb_naive(&check, points, scalars, 128);
+
+    ret = g1_lincomb_fast(&out, points, scalars, 128, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT("mixed pippenger matches naive MSM", blst_p1_is_equal(&out, &check));
+
+    /* Only 64-bit scalars */
+    for (size_t i = 0; i < 128; i++) {
+        get_rand_uint64(&value);
+        fr_from_uint64(&scalars[i], value);
+    }
+
+    g1_lincomb_naive(&check, points, scalars, 128);
+
+    ret = g1_lincomb_fast(&out, points, scalars, 128, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT("short pippenger matches naive MSM", blst_p1_is_equal(&out, &check));
+}
+
+static void test_g1_lincomb_fast_multi__verify_consistent(void) {
+    C_KZG_RET ret;
+    g1_t points[128], out[3], check;
+    fr_t scalars[3 * 128];
+
+    for (size_t i = 0; i < 128; i++) {
+        get_rand_g1(&points[i]);
+        get_rand_fr(&scalars[i]);
+        get_rand_fr(&scalars[128 + i]);
+        scalars[256 + i] = i % 5 == 0 ? scalars[i] : FR_ZERO;
+    }
+
+    ret = g1_lincomb_fast_multi(out, points, scalars, 128, 3, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    for (size_t j = 0; j < 3; j++) {
+        g1_lincomb_naive(&check, points, &scalars[j * 128], 128);
+        ASSERT("multi pippenger matches naive MSM", blst_p1_is_equal(&out[j], &check));
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Tests for evaluate_polynomial_in_evaluation_form
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1765,6 +1892,7 @@ static void test_coset_fft(void) {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 static void test_deduplicate_commitments__one_duplicate(void) {
+    C_KZG_RET ret;
     Bytes48 commitments[4];
     uint64_t indices[4];
     size_t count = 4;
@@ -1774,7 +1902,8 @@ static void test_deduplicate_commitments__one_duplicate(void) {
     memset(&commitments[2], 0, sizeof(Bytes48)); /* Duplicate */
     memset(&commitments[3], 3, sizeof(Bytes48));
 
-    deduplicate_commitments(commitments, indices, &count);
+    ret = deduplicate_commitments(commitments, indices, &count);
+    ASSERT_EQUALS(ret, C_KZG_OK);
 
     ASSERT_EQUALS(count, 3);
     ASSERT_EQUALS(indices[0], 0);
@@ -1784,6 +1913,7 @@ static void test_deduplicate_commitments__one_duplicate(void) {
 }
 
 static void test_deduplicate_commitments__no_duplicates(void) {
+    C_KZG_RET ret;
     Bytes48 commitments[4];
     uint64_t indices[4];
     size_t count = 4;
@@ -1793,7 +1923,8 @@ static void test_deduplicate_commitments__no_duplicates(void) {
     memset(&commitments[2], 2, sizeof(Bytes48));
     memset(&commitments[3], 3, sizeof(Bytes48));
 
-    deduplicate_commitments(commitments, indices, &count);
+    ret = deduplicate_commitments(commitments, indices, &count);
+    ASSERT_EQUALS(ret, C_KZG_OK);
 
     ASSERT_EQUALS(count, 4);
     ASSERT_EQUALS(indices[0], 0);
@@ -1803,6 +1934,7 @@ static void test_deduplicate_commitments__no_duplicates(void) {
 }
 
 static void test_deduplicate_commitments__all_duplicates(void) {
+    C_KZG_RET ret;
     Bytes48 commitments[4];
     uint64_t indices[4];
     size_t count = 4;
@@ -1812,7 +1944,8 @@ static void test_deduplicate_commitments__all_duplicates(void) {
     memset(&commitments[2], 0, sizeof(Bytes48)); /* Duplicate */
     memset(&commitments[3], 0, sizeof(Bytes48)); /* Duplicate */
 
-    deduplicate_commitments(commitments, indices, &count);
+    ret = deduplicate_commitments(commitments, indices, &count);
+    ASSERT_EQUALS(ret, C_KZG_OK);
 
     ASSERT_EQUALS(count, 1);
     ASSERT_EQUALS(indices[0], 0);
@@ -1822,28 +1955,58 @@ static void test_deduplicate_commitments__all_duplicates(void) {
 }
 
 static void test_deduplicate_commitments__no_commitments(void) {
+    C_KZG_RET ret;
     Bytes48 *commitments = NULL;
     uint64_t *indices = NULL;
     size_t count = 0;
 
-    deduplicate_commitments(commitments, indices, &count);
+    ret = deduplicate_commitments(commitments, indices, &count);
+    ASSERT_EQUALS(ret, C_KZG_OK);
 
     ASSERT_EQUALS(count, 0);
 }
 
 static void test_deduplicate_commitments__one_commitment(void) {
+    C_KZG_RET ret;
     Bytes48 commitments[1];
     uint64_t indices[1];
     size_t count = 1;
 
     memset(&commitments[0], 0, sizeof(Bytes48));
 
-    deduplicate_commitments(commitments, indices, &count);
+    ret = deduplicate_commitments(commitments, indices, &count);
+    ASSERT_EQUALS(ret, C_KZG_OK);
 
     ASSERT_EQUALS(count, 1);
     ASSERT_EQUALS(indices[0], 0);
 }
 
+static void test_deduplicate_commitments__many_commitments(void) {
+    C_KZG_RET ret;
+    Bytes48 commitments[1000], check[1000];
+    uint64_t indices[1000];
+    size_t count = 1000;
+
+    /* Each of 72 commitments in turn, as in a batch of columns */
+    for (size_t i = 0; i < count; i++) {
+        if (i < 72) {
+            get_rand_g1_bytes(&check[i]);
+        } else {
+            check[i] = check[i % 72];
+        }
+    }
+    memcpy(commitments, check, sizeof(check));
+
+    ret = deduplicate_commitments(commitments, indices, &count);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    ASSERT_EQUALS(count, 72);
+    for (size_t i = 0; i < 1000; i++) {
+        ASSERT_EQUALS(indices[i], i % 72);
+        ASSERT("commitment is kept", commitments_equal(&commitments[indices[i]], &check[i]));
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Tests for coset shift factors
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -2073,156 +2236,2057 @@ static void test_verify_cell_kzg_proof_batch__succeeds_random_blob(void) {
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
-// Profiling Functions
+// Tests for MSM strategy
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-#ifdef PROFILE
-static void profile_blob_to_kzg_commitment(void) {
-    Blob blob;
-    KZGCommitment c;
+static void test_autotune_msm_strategy__succeeds(void) {
+    C_KZG_RET ret;
+    MSMStrategy strategy;
 
-    get_rand_blob(&blob);
+    /* Keep the window sizes small so that this is quick */
+    ret = autotune_msm_strategy(&strategy, &s, 3);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT("threshold is at least two", strategy.naive_threshold >= 2);
+    ASSERT("window size is at most the maximum", strategy.wbits <= 3);
+}
 
-    ProfilerStart("blob_to_kzg_commitment.prof");
-    for (size_t i = 0; i < 1000; i++) {
-        blob_to_kzg_commitment(&c, &blob, &s);
-    }
-    ProfilerStop();
+static void test_autotune_msm_strategy__fails_wbits_too_big(void) {
+    C_KZG_RET ret;
+    MSMStrategy strategy;
+
+    ret = autotune_msm_strategy(&strategy, &s, 16);
+    ASSERT_EQUALS(ret, C_KZG_BADARGS);
 }
 
-static void profile_compute_kzg_proof(void) {
+static void test_set_msm_strategy__same_results(void) {
+    C_KZG_RET ret;
     Blob blob;
-    Bytes32 z, y_out;
-    KZGProof proof_out;
+    Cell cells[CELLS_PER_EXT_BLOB];
+    KZGProof proofs[CELLS_PER_EXT_BLOB], check_proofs[CELLS_PER_EXT_BLOB];
+    KZGCommitment commitment, check_commitment;
+    MSMStrategy original, strategy;
+    int diff;
 
     get_rand_blob(&blob);
-    get_rand_field_element(&z);
+    ret = blob_to_kzg_commitment(&check_commitment, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = compute_cells_and_kzg_proofs(NULL, check_proofs, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
 
-    ProfilerStart("compute_kzg_proof.prof");
-    for (size_t i = 0; i < 100; i++) {
-        compute_kzg_proof(&proof_out, &y_out, &blob, &z, &s);
-    }
-    ProfilerStop();
-}
+    /* Switch to fixed-base MSMs and a different threshold */
+    get_msm_strategy(&original, &s);
+    strategy.naive_threshold = 16;
+    strategy.wbits = 2;
+    ret = set_msm_strategy(&s, &strategy);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    get_msm_strategy(&strategy, &s);
+    ASSERT_EQUALS(strategy.naive_threshold, 16);
+    ASSERT_EQUALS(strategy.wbits, 2);
 
-static void profile_compute_blob_kzg_proof(void) {
-    Blob blob;
-    Bytes48 commitment;
-    KZGProof out;
+    ret = blob_to_kzg_commitment(&commitment, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = compute_cells_and_kzg_proofs(cells, proofs, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
 
-    get_rand_blob(&blob);
-    get_rand_g1_bytes(&commitment);
+    /* Switch back before checking, so that other tests are unaffected */
+    ret = set_msm_strategy(&s, &original);
+    ASSERT_EQUALS(ret, C_KZG_OK);
 
-    ProfilerStart("compute_blob_kzg_proof.prof");
-    for (size_t i = 0; i < 10; i++) {
-        compute_blob_kzg_proof(&out, &blob, &commitment, &s);
-    }
-    ProfilerStop();
+    diff = memcmp(&commitment, &check_commitment, sizeof(KZGCommitment));
+    ASSERT_EQUALS(diff, 0);
+    diff = memcmp(proofs, check_proofs, sizeof(proofs));
+    ASSERT_EQUALS(diff, 0);
 }
 
-static void profile_verify_kzg_proof(void) {
-    Bytes32 z, y;
-    Bytes48 commitment, proof;
-    bool out;
+static void test_set_msm_strategy__fails_bad_strategy(void) {
+    C_KZG_RET ret;
+    MSMStrategy original, strategy;
 
-    get_rand_g1_bytes(&commitment);
-    get_rand_field_element(&z);
-    get_rand_field_element(&y);
-    get_rand_g1_bytes(&proof);
+    get_msm_strategy(&original, &s);
 
-    ProfilerStart("verify_kzg_proof.prof");
-    for (size_t i = 0; i < 5000; i++) {
-        verify_kzg_proof(&out, &commitment, &z, &y, &proof, &s);
-    }
-    ProfilerStop();
+    strategy.naive_threshold = 1;
+    strategy.wbits = 0;
+    ret = set_msm_strategy(&s, &strategy);
+    ASSERT_EQUALS(ret, C_KZG_BADARGS);
+
+    strategy.naive_threshold = 8;
+    strategy.wbits = 16;
+    ret = set_msm_strategy(&s, &strategy);
+    ASSERT_EQUALS(ret, C_KZG_BADARGS);
+
+    /* Nothing should have changed */
+    get_msm_strategy(&strategy, &s);
+    ASSERT_EQUALS(strategy.naive_threshold, original.naive_threshold);
+    ASSERT_EQUALS(strategy.wbits, original.wbits);
 }
 
-static void profile_verify_blob_kzg_proof(void) {
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tests for set_precompute_budget
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void test_set_precompute_budget__same_results(void) {
+    C_KZG_RET ret;
     Blob blob;
-    Bytes48 commitment, proof;
-    bool out;
+    KZGProof proofs[CELLS_PER_EXT_BLOB], check_proofs[CELLS_PER_EXT_BLOB];
+    size_t num_tables = 0, num_larger = 0;
+    int diff;
 
     get_rand_blob(&blob);
-    get_rand_g1_bytes(&commitment);
-    get_rand_g1_bytes(&proof);
+    ret = compute_cells_and_kzg_proofs(NULL, check_proofs, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
 
-    ProfilerStart("verify_blob_kzg_proof.prof");
-    for (size_t i = 0; i < 5000; i++) {
-        verify_blob_kzg_proof(&out, &blob, &commitment, &proof, &s);
+    /* Half of the 6 MiB needed for a table with 4-bit windows in every row */
+    ret = set_precompute_budget(&s, 3 * 1024 * 1024);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT("there are tables", s.tables != NULL);
+    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+        if (s.tables->tables[i] != NULL) num_tables++;
     }
-    ProfilerStop();
-}
+    ASSERT_EQUALS(num_tables, CELLS_PER_EXT_BLOB / 2);
 
-static void profile_verify_blob_kzg_proof_batch(void) {
-    const int n = 4;
-    Blob blobs[n];
-    Bytes48 commitments[n];
-    Bytes48 proofs[n];
-    bool out;
+    ret = compute_cells_and_kzg_proofs(NULL, proofs, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    diff = memcmp(proofs, check_proofs, sizeof(proofs));
+    ASSERT_EQUALS(diff, 0);
 
-    for (size_t i = 0; i < n; i++) {
-        get_rand_blob(&blobs[i]);
-        get_rand_g1_bytes(&commitments[i]);
-        get_rand_g1_bytes(&proofs[i]);
+    /* Enough for every row, and 5-bit windows in some of them */
+    ret = set_precompute_budget(&s, 7 * 1024 * 1024);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT_EQUALS(s.wbits, 5);
+    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+        ASSERT("every row has a table", s.tables->tables[i] != NULL);
+        if (s.tables->wbits[i] == 5) num_larger++;
     }
+    ASSERT("some rows have larger tables", num_larger > 0 && num_larger < CELLS_PER_EXT_BLOB);
 
-    ProfilerStart("verify_blob_kzg_proof_batch.prof");
-    for (size_t i = 0; i < 1000; i++) {
-        verify_blob_kzg_proof_batch(&out, blobs, commitments, proofs, n, &s);
-    }
-    ProfilerStop();
-}
+    ret = compute_cells_and_kzg_proofs(NULL, proofs, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    diff = memcmp(proofs, check_proofs, sizeof(proofs));
+    ASSERT_EQUALS(diff, 0);
 
-static void profile_compute_cells_and_kzg_proofs(void) {
-    Blob blob;
-    Cell cells[CELLS_PER_EXT_BLOB];
-    KZGProof proofs[CELLS_PER_EXT_BLOB];
+    /* A budget too small for any table removes them */
+    ret = set_precompute_budget(&s, 0);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT("there are no tables", s.tables == NULL);
+    ASSERT_EQUALS(s.wbits, 0);
+}
 
-    /* Get a random blob */
-    get_rand_blob(&blob);
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tests for compute_cells_and_kzg_proofs_batch
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    ProfilerStart("compute_cells_and_kzg_proofs.prof");
-    for (size_t i = 0; i < 5; i++) {
-        compute_cells_and_kzg_proofs(cells, proofs, &blob, &s);
-    }
-    ProfilerStop();
-}
+static void check_cells_and_kzg_proofs_batch(const Blob *blobs, size_t num_blobs) {
+    C_KZG_RET ret;
+    Cell *cells = NULL;
+    KZGProof *proofs = NULL;
+    Bytes48 *commitments = NULL;
+    uint64_t *cell_indices = NULL;
+    KZGCommitment commitment;
+    size_t num_cells = num_blobs * CELLS_PER_EXT_BLOB;
+    bool ok;
+    int diff;
 
-static void profile_recover_cells_and_kzg_proofs(void) {
-    Blob blob;
-    uint64_t cell_indices[CELLS_PER_EXT_BLOB];
-    Cell cells[CELLS_PER_EXT_BLOB];
+    ret = c_kzg_calloc((void **)&cells, num_cells, sizeof(Cell));
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = c_kzg_calloc((void **)&proofs, num_cells, sizeof(KZGProof));
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = c_kzg_calloc((void **)&commitments, num_cells, sizeof(Bytes48));
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = c_kzg_calloc((void **)&cell_indices, num_cells, sizeof(uint64_t));
+    ASSERT_EQUALS(ret, C_KZG_OK);
 
-    /*
-     * NOTE: this profiling function only cares about cell recovery since the proofs will always be
-     * recomputed. If we included proof computation, it would drown out cell recovery.
-     */
+    ret = compute_cells_and_kzg_proofs_batch(cells, proofs, blobs, num_blobs, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
 
-    /* Get a random blob */
-    get_rand_blob(&blob);
+    for (size_t i = 0; i < num_blobs; i++) {
+        size_t offset = i * CELLS_PER_EXT_BLOB;
 
-    /* Compute cells */
-    compute_cells_and_kzg_proofs(cells, NULL, &blob, &s);
+        /* The first half of the cells is the blob itself */
+        diff = memcmp(&cells[offset], &blobs[i], CELLS_PER_BLOB * sizeof(Cell));
+        ASSERT_EQUALS(diff, 0);
 
-    /* Initialize cell indices */
-    for (size_t i = 0; i < CELLS_PER_EXT_BLOB / 2; i++) {
-        cell_indices[i] = i;
+        /* Commit without FK20, to check the cells and proofs against */
+        ret = blob_to_kzg_commitment(&commitment, &blobs[i], &s);
+        ASSERT_EQUALS(ret, C_KZG_OK);
+        for (size_t j = 0; j < CELLS_PER_EXT_BLOB; j++) {
+            commitments[offset + j] = commitment;
+            cell_indices[offset + j] = j;
+        }
     }
 
-    ProfilerStart("recover_cells_and_kzg_proofs.prof");
-    for (size_t i = 0; i < 5; i++) {
-        recover_cells_and_kzg_proofs(cells, NULL, cell_indices, cells, CELLS_PER_EXT_BLOB / 2, &s);
-    }
-    ProfilerStop();
+    ret = verify_cell_kzg_proof_batch(&ok, commitments, cell_indices, cells, proofs, num_cells, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT("the cells and proofs are valid", ok);
+
+    c_kzg_free(cells);
+    c_kzg_free(proofs);
+    c_kzg_free(commitments);
+    c_kzg_free(cell_indices);
 }
 
-static void profile_verify_cell_kzg_proof_batch(void) {
+static void test_compute_cells_and_kzg_proofs_batch__same_results(void) {
     C_KZG_RET ret;
-    bool ok;
-    Blob blob;
-    KZGCommitment commitment;
-    KZGCommitment commitments[CELLS_PER_EXT_BLOB];
-    uint64_t cell_indices[CELLS_PER_EXT_BLOB];
+    Blob blobs[3];
+
+    for (size_t i = 0; i < 3; i++) {
+        get_rand_blob(&blobs[i]);
+    }
+
+    /* Without tables, then with tables for half of the rows */
+    check_cells_and_kzg_proofs_batch(blobs, 3);
+    ret = set_precompute_budget(&s, 3 * 1024 * 1024);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    check_cells_and_kzg_proofs_batch(blobs, 3);
+    ret = set_precompute_budget(&s, 0);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+}
+
+static void test_compute_cells_and_kzg_proofs_batch__no_blobs(void) {
+    C_KZG_RET ret;
+    Cell cell;
+    KZGProof proof;
+
+    ret = compute_cells_and_kzg_proofs_batch(&cell, &proof, NULL, 0, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = compute_cells_and_kzg_proofs_batch(NULL, NULL, NULL, 0, &s);
+    ASSERT_EQUALS(ret, C_KZG_BADARGS);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tests for KZGContext
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void test_kzg_context__same_results(void) {
+    C_KZG_RET ret;
+    KZGContext ctx;
+    Blob blob;
+    Cell cells[CELLS_PER_EXT_BLOB], check_cells[CELLS_PER_EXT_BLOB];
+    KZGProof proofs[CELLS_PER_EXT_BLOB], check_proofs[CELLS_PER_EXT_BLOB];
+    KZGCommitment commitment, check_commitment;
+    void *buffer;
+    bool ok;
+    int diff;
+
+    get_rand_blob(&blob);
+    ret = compute_cells_and_kzg_proofs(check_cells, check_proofs, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = blob_to_kzg_commitment(&check_commitment, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    /* Start with nothing, so the first call has to use the heap */
+    ret = init_kzg_context(&ctx, 0);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    for (int i = 0; i < 3; i++) {
+        ret = compute_cells_and_kzg_proofs_ctx(&ctx, cells, proofs, &blob, &s);
+        ASSERT_EQUALS(ret, C_KZG_OK);
+        diff = memcmp(cells, check_cells, sizeof(cells));
+        ASSERT_EQUALS(diff, 0);
+        diff = memcmp(proofs, check_proofs, sizeof(proofs));
+        ASSERT_EQUALS(diff, 0);
+    }
+
+    /* The arena is big enough now, so it must not grow again */
+    buffer = ctx.buffer;
+    ASSERT("the arena has grown", ctx.capacity >= ctx.peak && ctx.capacity > 0);
+    ret = compute_cells_and_kzg_proofs_ctx(&ctx, cells, proofs, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT("the arena was reused", ctx.buffer == buffer);
+
+    /* Smaller calls fit in the same arena */
+    ret = blob_to_kzg_commitment_ctx(&ctx, &commitment, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    diff = memcmp(&commitment, &check_commitment, sizeof(commitment));
+    ASSERT_EQUALS(diff, 0);
+    ret = verify_cell_kzg_proof_batch_ctx(
+        &ctx, &ok, &commitment, (const uint64_t[]){0}, cells, proofs, 1, &s
+    );
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT("the proof is valid", ok);
+    ASSERT("the arena was reused", ctx.buffer == buffer);
+
+    free_kzg_context(&ctx);
+}
+
+static void test_kzg_context__other_variants(void) {
+    C_KZG_RET ret;
+    KZGContext ctx;
+    Blob blob, updated_blob;
+    Cell cells[CELLS_PER_EXT_BLOB], some_cells[2];
+    KZGProof proofs[CELLS_PER_EXT_BLOB], some_proofs[2], proof, check_proof;
+    KZGProof multi_proofs[2], check_multi_proofs[2];
+    KZGCommitment commitment, updated, check_commitment;
+    Bytes32 zs[2], ys[2], check_ys[2], old_field, new_field;
+    Bytes48 bad_proofs[2];
+    uint64_t cell_indices[2] = {3, 77}, commitment_indices[2] = {0, 0}, index = 5;
+    uint64_t invalid[2], num_invalid;
+    bool ok;
+    int diff;
+
+    get_rand_blob(&blob);
+    ret = compute_cells_and_kzg_proofs(cells, proofs, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = blob_to_kzg_commitment(&check_commitment, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = init_kzg_context(&ctx, 0);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    /* The sidecar and the cells and proofs at some indices */
+    ret = compute_blob_sidecar_ctx(&ctx, &commitment, &proof, cells, proofs, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    diff = memcmp(&commitment, &check_commitment, sizeof(commitment));
+    ASSERT_EQUALS(diff, 0);
+    ret = compute_blob_kzg_proof(&check_proof, &blob, &commitment, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    diff = memcmp(&proof, &check_proof, sizeof(proof));
+    ASSERT_EQUALS(diff, 0);
+    ret = compute_cells_for_indices_ctx(&ctx, some_cells, &blob, cell_indices, 2, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = compute_cell_kzg_proofs_for_indices_ctx(&ctx, some_proofs, &blob, cell_indices, 2, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    for (size_t i = 0; i < 2; i++) {
+        diff = memcmp(&some_cells[i], &cells[cell_indices[i]], sizeof(Cell));
+        ASSERT_EQUALS(diff, 0);
+        diff = memcmp(&some_proofs[i], &proofs[cell_indices[i]], sizeof(KZGProof));
+        ASSERT_EQUALS(diff, 0);
+    }
+
+    /* Proofs at several points */
+    get_rand_field_element(&zs[0]);
+    get_rand_field_element(&zs[1]);
+    ret = compute_kzg_proofs_multi(check_multi_proofs, check_ys, &blob, zs, 2, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = compute_kzg_proofs_multi_ctx(&ctx, multi_proofs, ys, &blob, zs, 2, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    diff = memcmp(multi_proofs, check_multi_proofs, sizeof(multi_proofs));
+    ASSERT_EQUALS(diff, 0);
+    diff = memcmp(ys, check_ys, sizeof(check_ys));
+    ASSERT_EQUALS(diff, 0);
+
+    /* The commitment after changing one field element */
+    updated_blob = blob;
+    old_field = *(Bytes32 *)&blob.bytes[index * BYTES_PER_FIELD_ELEMENT];
+    get_rand_field_element(&new_field);
+    *(Bytes32 *)&updated_blob.bytes[index * BYTES_PER_FIELD_ELEMENT] = new_field;
+    ret = blob_to_kzg_commitment(&check_commitment, &updated_blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = update_kzg_commitment_ctx(
+        &ctx, &updated, &commitment, &index, &old_field, &new_field, 1, &s
+    );
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    diff = memcmp(&updated, &check_commitment, sizeof(updated));
+    ASSERT_EQUALS(diff, 0);
+
+    /* The commitment is not a proof for the blob */
+    ret = verify_blob_kzg_proof_batch_locate_ctx(
+        &ctx, &ok, invalid, &num_invalid, &updated_blob, &updated, &updated, 1, &s
+    );
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT_EQUALS(ok, false);
+    ASSERT_EQUALS(num_invalid, 1);
+    ASSERT_EQUALS(invalid[0], 0);
+
+    /* The first proof is not a proof for the second cell */
+    bad_proofs[0] = proofs[cell_indices[0]];
+    bad_proofs[1] = proofs[cell_indices[0]];
+    ret = verify_cell_kzg_proof_batch_locate_ctx(
+        &ctx,
+        &ok,
+        invalid,
+        &num_invalid,
+        (const Bytes48[]){commitment, commitment},
+        cell_indices,
+        some_cells,
+        bad_proofs,
+        2,
+        &s
+    );
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT_EQUALS(ok, false);
+    ASSERT_EQUALS(num_invalid, 1);
+    ASSERT_EQUALS(invalid[0], 1);
+    ret = verify_cell_kzg_proof_batch_unique_ctx(
+        &ctx, &ok, &commitment, 1, commitment_indices, cell_indices, some_cells, some_proofs, 2, &s
+    );
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT("the proofs are valid", ok);
+
+    free_kzg_context(&ctx);
+}
+
+static void test_kzg_context__fails_nested(void) {
+    C_KZG_RET ret;
+    KZGContext ctx, other;
+
+    ret = init_kzg_context(&ctx, 1024);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = init_kzg_context(&other, 1024);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    ret = enter_kzg_context(&ctx);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = enter_kzg_context(&other);
+    ASSERT_EQUALS(ret, C_KZG_BADARGS);
+    leave_kzg_context(&ctx);
+
+    ret = enter_kzg_context(NULL);
+    ASSERT_EQUALS(ret, C_KZG_BADARGS);
+
+    free_kzg_context(&ctx);
+    free_kzg_context(&other);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tests for set_kzg_allocator
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    size_t allocs;
+    size_t frees;
+    size_t aligned;
+} AllocatorCounts;
+
+static void *counting_malloc(void *opaque, size_t size, size_t alignment) {
+    AllocatorCounts *counts = (AllocatorCounts *)opaque;
+    counts->allocs++;
+    if (alignment != 0) counts->aligned++;
+    return malloc(size);
+}
+
+static void counting_free(void *opaque, void *p) {
+    AllocatorCounts *counts = (AllocatorCounts *)opaque;
+    counts->frees++;
+    free(p);
+}
+
+static void test_set_kzg_allocator__used_for_everything(void) {
+    C_KZG_RET ret;
+    AllocatorCounts counts = {0, 0, 0};
+    KZGAllocator allocator = {counting_malloc, NULL, counting_free, &counts};
+    KZGContext ctx;
+    Blob blob;
+    KZGProof proofs[CELLS_PER_EXT_BLOB], check_proofs[CELLS_PER_EXT_BLOB];
+    size_t allocs;
+    int diff;
+
+    get_rand_blob(&blob);
+    ret = compute_cells_and_kzg_proofs(NULL, check_proofs, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    ret = set_kzg_allocator(&allocator);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    /* Temporaries, with the zeroing done by the library */
+    ret = compute_cells_and_kzg_proofs(NULL, proofs, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    diff = memcmp(proofs, check_proofs, sizeof(proofs));
+    ASSERT_EQUALS(diff, 0);
+    ASSERT("temporaries were allocated", counts.allocs > 0);
+    ASSERT("large ones have a hint", counts.aligned > 0);
+    ASSERT_EQUALS(counts.allocs, counts.frees);
+
+    /* Tables in the trusted setup */
+    allocs = counts.allocs;
+    ret = set_precompute_budget(&s, 3 * 1024 * 1024);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT("tables were allocated", counts.allocs > allocs);
+    ret = set_precompute_budget(&s, 0);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT_EQUALS(counts.allocs, counts.frees);
+
+    /* The arena of a context */
+    allocs = counts.allocs;
+    ret = init_kzg_context(&ctx, 1024);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT_EQUALS(counts.allocs, allocs + 1);
+    free_kzg_context(&ctx);
+    ASSERT_EQUALS(counts.allocs, counts.frees);
+
+    ret = set_kzg_allocator(NULL);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    /* Allocators without a free function are rejected */
+    allocator.free_fn = NULL;
+    ret = set_kzg_allocator(&allocator);
+    ASSERT_EQUALS(ret, C_KZG_BADARGS);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tests for set_table_placement
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void test_set_table_placement__same_results(void) {
+    C_KZG_RET ret;
+    Blob blob;
+    KZGProof proofs[CELLS_PER_EXT_BLOB], check_proofs[CELLS_PER_EXT_BLOB];
+    int diff;
+
+    get_rand_blob(&blob);
+    ret = compute_cells_and_kzg_proofs(NULL, check_proofs, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    /* Move existing tables */
+    ret = set_precompute_budget(&s, 3 * 1024 * 1024);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = set_table_placement(&s, KZG_TABLES_HUGE_PAGES | KZG_TABLES_NUMA_REPLICAS);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = compute_cells_and_kzg_proofs(NULL, proofs, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    diff = memcmp(proofs, check_proofs, sizeof(proofs));
+    ASSERT_EQUALS(diff, 0);
+
+    /* Compute new tables with the placement */
+    ret = set_precompute_budget(&s, 7 * 1024 * 1024);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = compute_cells_and_kzg_proofs(NULL, proofs, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    diff = memcmp(proofs, check_proofs, sizeof(proofs));
+    ASSERT_EQUALS(diff, 0);
+
+    /* Move them back to the heap */
+    ret = set_table_placement(&s, 0);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT_EQUALS(s.tables->mapped_size, 0);
+    ret = compute_cells_and_kzg_proofs(NULL, proofs, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    diff = memcmp(proofs, check_proofs, sizeof(proofs));
+    ASSERT_EQUALS(diff, 0);
+
+    ret = set_precompute_budget(&s, 0);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+}
+
+static void test_set_table_placement__fails_unknown_flag(void) {
+    C_KZG_RET ret;
+
+    ret = set_table_placement(&s, 4);
+    ASSERT_EQUALS(ret, C_KZG_BADARGS);
+    ASSERT_EQUALS(s.table_placement, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tests for the settings slab
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void test_settings_slab__arrays_are_aligned_and_adjacent(void) {
+    const void *arrays[] = {
+        s.g1_values_monomial,
+        s.g1_values_lagrange_brp,
+        s.g2_values_monomial,
+        s.x_ext_fft_columns,
+    };
+
+    ASSERT("there is a slab", s.slab != NULL);
+    for (size_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++) {
+        ASSERT("the array is in the slab", (uintptr_t)arrays[i] >= (uintptr_t)s.slab);
+        ASSERT_EQUALS((uintptr_t)arrays[i] % 64, 0);
+        if (i > 0) ASSERT("arrays are in order", arrays[i] > arrays[i - 1]);
+    }
+
+    /* Each row's column follows the previous one */
+    for (size_t i = 1; i < CELLS_PER_EXT_BLOB; i++) {
+        ASSERT_EQUALS(s.x_ext_fft_columns[i], s.x_ext_fft_columns[i - 1] + FIELD_ELEMENTS_PER_CELL);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tests for load_trusted_setup_file_profile
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static C_KZG_RET load_profile_settings(KZGSettings *out, uint64_t profile) {
+    C_KZG_RET ret;
+    FILE *fp = fopen("trusted_setup.txt", "r");
+    if (fp == NULL) return C_KZG_ERROR;
+    ret = load_trusted_setup_file_profile(out, fp, 0, profile);
+    fclose(fp);
+    return ret;
+}
+
+static void test_load_trusted_setup_file_profile__verify_only(void) {
+    C_KZG_RET ret;
+    KZGSettings v;
+    Blob blob;
+    KZGCommitment c, check_c;
+    KZGProof proof;
+    Cell *cells = NULL, *check_cells = NULL;
+    KZGProof *proofs = NULL, *check_proofs = NULL;
+    uint64_t cell_indices[2] = {0, 5};
+    Bytes48 commitments[2];
+    bool ok;
+    int diff;
+
+    ret = load_profile_settings(&v, KZG_PROFILE_VERIFY);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT("the Lagrange points are not loaded", v.g1_values_lagrange_brp == NULL);
+    ASSERT("the FK20 columns are not loaded", v.x_ext_fft_columns == NULL);
+    ASSERT("the rest is kept", v.lazy != NULL);
+
+    /* Verifying works without the rest of the setup */
+    get_rand_blob(&blob);
+    ret = blob_to_kzg_commitment(&c, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = compute_blob_kzg_proof(&proof, &blob, &c, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = verify_blob_kzg_proof(&ok, &blob, &c, &proof, &v);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT("the proof is valid", ok);
+
+    ret = c_kzg_calloc((void **)&cells, CELLS_PER_EXT_BLOB, sizeof(Cell));
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = c_kzg_calloc((void **)&check_cells, CELLS_PER_EXT_BLOB, sizeof(Cell));
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = c_kzg_calloc((void **)&proofs, CELLS_PER_EXT_BLOB, sizeof(KZGProof));
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = c_kzg_calloc((void **)&check_proofs, CELLS_PER_EXT_BLOB, sizeof(KZGProof));
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    ret = compute_cells_and_kzg_proofs(check_cells, check_proofs, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    memcpy(&commitments[0], &c, sizeof(Bytes48));
+    memcpy(&commitments[1], &c, sizeof(Bytes48));
+    memcpy(&cells[0], &check_cells[0], sizeof(Cell));
+    memcpy(&cells[1], &check_cells[5], sizeof(Cell));
+    memcpy(&proofs[0], &check_proofs[0], sizeof(KZGProof));
+    memcpy(&proofs[1], &check_proofs[5], sizeof(KZGProof));
+    ret = verify_cell_kzg_proof_batch(&ok, commitments, cell_indices, cells, proofs, 2, &v);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT("the cell proofs are valid", ok);
+
+    /* Committing loads the Lagrange points only, with the same results */
+    ret = blob_to_kzg_commitment(&check_c, &blob, &v);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    diff = memcmp(&c, &check_c, sizeof(KZGCommitment));
+    ASSERT_EQUALS(diff, 0);
+    ASSERT("the Lagrange points are loaded", v.lazy->committer != NULL);
+    ASSERT("the FK20 columns are not loaded", v.lazy->prover == NULL);
+
+    /* Computing cell proofs loads the rest of the setup */
+    ret = compute_cells_and_kzg_proofs(cells, proofs, &blob, &v);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT("the FK20 columns are loaded", v.lazy->prover != NULL);
+    diff = memcmp(cells, check_cells, CELLS_PER_EXT_BLOB * sizeof(Cell));
+    ASSERT_EQUALS(diff, 0);
+    diff = memcmp(proofs, check_proofs, CELLS_PER_EXT_BLOB * sizeof(KZGProof));
+    ASSERT_EQUALS(diff, 0);
+
+    c_kzg_free(cells);
+    c_kzg_free(check_cells);
+    c_kzg_free(proofs);
+    c_kzg_free(check_proofs);
+    free_trusted_setup(&v);
+    ASSERT("lazy prover is null after free", v.lazy == NULL);
+}
+
+static void test_load_trusted_setup_file_profile__loads_outside_context(void) {
+    C_KZG_RET ret;
+    KZGSettings v;
+    KZGContext ctx;
+    Blob blob;
+    KZGCommitment c, check_c;
+    KZGProof proof, check_proof;
+    int diff;
+
+    ret = load_profile_settings(&v, KZG_PROFILE_VERIFY);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = init_kzg_context(&ctx, 1024);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    get_rand_blob(&blob);
+    ret = blob_to_kzg_commitment(&check_c, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = compute_blob_kzg_proof(&check_proof, &blob, &check_c, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    /* The first call which needs the rest of the setup goes through a context */
+    ret = blob_to_kzg_commitment_ctx(&ctx, &c, &blob, &v);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    diff = memcmp(&c, &check_c, sizeof(KZGCommitment));
+    ASSERT_EQUALS(diff, 0);
+    ASSERT("the rest of the setup is loaded", v.lazy->committer != NULL);
+    ASSERT(
+        "the rest of the setup is not in the context", !context_owns(&ctx, v.lazy->committer)
+    );
+
+    /* Another call through the context reuses its arena */
+    ret = compute_blob_kzg_proof_ctx(&ctx, &proof, &blob, &c, &v);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    diff = memcmp(&proof, &check_proof, sizeof(KZGProof));
+    ASSERT_EQUALS(diff, 0);
+
+    /* The loaded setup is still intact for a plain call */
+    ret = blob_to_kzg_commitment(&c, &blob, &v);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    diff = memcmp(&c, &check_c, sizeof(KZGCommitment));
+    ASSERT_EQUALS(diff, 0);
+
+    /* Freeing the setup with no active context frees heap memory only */
+    free_trusted_setup(&v);
+    free_kzg_context(&ctx);
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+
+/** A thread which commits to a blob with a verification profile, as one of the first calls. */
+typedef struct {
+    const KZGSettings *settings;
+    const Blob *blob;
+    const KZGCommitment *check_commitment;
+    uint64_t failures;
+} FirstCommitter;
+
+static void *commit_with_profile(void *arg) {
+    FirstCommitter *committer = arg;
+    KZGCommitment commitment;
+    C_KZG_RET ret;
+
+    ret = blob_to_kzg_commitment(&commitment, committer->blob, committer->settings);
+    if (ret != C_KZG_OK ||
+        memcmp(&commitment, committer->check_commitment, sizeof(KZGCommitment)) != 0) {
+        committer->failures++;
+    }
+    return NULL;
+}
+
+static void test_load_trusted_setup_file_profile__first_calls_race(void) {
+    C_KZG_RET ret;
+    KZGSettings v;
+    Blob blob;
+    KZGCommitment check_c;
+    FirstCommitter committers[4];
+    pthread_t threads[4];
+    int err;
+
+    ret = load_profile_settings(&v, KZG_PROFILE_VERIFY);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    get_rand_blob(&blob);
+    ret = blob_to_kzg_commitment(&check_c, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    /* Every thread needs the Lagrange points, which one of them loads */
+    for (size_t i = 0; i < 4; i++) {
+        committers[i].settings = &v;
+        committers[i].blob = &blob;
+        committers[i].check_commitment = &check_c;
+        committers[i].failures = 0;
+        err = pthread_create(&threads[i], NULL, commit_with_profile, &committers[i]);
+        ASSERT_EQUALS(err, 0);
+    }
+    for (size_t i = 0; i < 4; i++) {
+        err = pthread_join(threads[i], NULL);
+        ASSERT_EQUALS(err, 0);
+        ASSERT("the commitment matched", committers[i].failures == 0);
+    }
+
+    ASSERT("the Lagrange points are loaded", v.lazy->committer != NULL);
+    ASSERT("the FK20 columns are not loaded", v.lazy->prover == NULL);
+    ASSERT_EQUALS(v.lazy->loading, 0);
+
+    free_trusted_setup(&v);
+}
+
+#endif
+
+static void test_load_trusted_setup_file_profile__verify_and_commit(void) {
+    C_KZG_RET ret;
+    KZGSettings v;
+    Blob blob;
+    KZGCommitment c, check_c;
+    int diff;
+
+    ret = load_profile_settings(&v, KZG_PROFILE_VERIFY_AND_COMMIT);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT("the Lagrange points are loaded", v.g1_values_lagrange_brp != NULL);
+    ASSERT("the FK20 columns are not loaded", v.x_ext_fft_columns == NULL);
+
+    get_rand_blob(&blob);
+    ret = blob_to_kzg_commitment(&c, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = blob_to_kzg_commitment(&check_c, &blob, &v);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    diff = memcmp(&c, &check_c, sizeof(KZGCommitment));
+    ASSERT_EQUALS(diff, 0);
+
+    free_trusted_setup(&v);
+}
+
+static void test_load_trusted_setup_file_profile__bad_profile_fails(void) {
+    C_KZG_RET ret;
+    KZGSettings v;
+
+    ret = load_profile_settings(&v, KZG_PROFILE_VERIFY_AND_COMMIT + 1);
+    ASSERT_EQUALS(ret, C_KZG_BADARGS);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tests for attach_shared_settings
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void test_attach_shared_settings__same_results(void) {
+    C_KZG_RET ret;
+    KZGSettings shared;
+    FILE *fp;
+    Blob blob;
+    KZGCommitment c, check_c;
+    Cell *cells = NULL, *check_cells = NULL;
+    KZGProof *proofs = NULL, *check_proofs = NULL;
+    int diff;
+
+    /* Give some of the rows a table, so that tables are shared too */
+    ret = set_precompute_budget(&s, 3 * 1024 * 1024);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    fp = tmpfile();
+    ASSERT("the file was created", fp != NULL);
+    ret = save_precomputed_settings(&s, fp);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = attach_shared_settings(&shared, fp);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    fclose(fp);
+
+    ASSERT("the tables are shared", shared.tables != NULL);
+    ASSERT_EQUALS(shared.wbits, s.wbits);
+    ASSERT_EQUALS(shared.naive_threshold, s.naive_threshold);
+    diff = memcmp(shared.g1_values_lagrange_brp, s.g1_values_lagrange_brp, sizeof(g1_t));
+    ASSERT_EQUALS(diff, 0);
+
+    get_rand_blob(&blob);
+    ret = blob_to_kzg_commitment(&c, &blob, &shared);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = blob_to_kzg_commitment(&check_c, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    diff = memcmp(&c, &check_c, sizeof(KZGCommitment));
+    ASSERT_EQUALS(diff, 0);
+
+    ret = c_kzg_calloc((void **)&cells, CELLS_PER_EXT_BLOB, sizeof(Cell));
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = c_kzg_calloc((void **)&check_cells, CELLS_PER_EXT_BLOB, sizeof(Cell));
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = c_kzg_calloc((void **)&proofs, CELLS_PER_EXT_BLOB, sizeof(KZGProof));
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = c_kzg_calloc((void **)&check_proofs, CELLS_PER_EXT_BLOB, sizeof(KZGProof));
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    ret = compute_cells_and_kzg_proofs(cells, proofs, &blob, &shared);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = compute_cells_and_kzg_proofs(check_cells, check_proofs, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    diff = memcmp(cells, check_cells, CELLS_PER_EXT_BLOB * sizeof(Cell));
+    ASSERT_EQUALS(diff, 0);
+    diff = memcmp(proofs, check_proofs, CELLS_PER_EXT_BLOB * sizeof(KZGProof));
+    ASSERT_EQUALS(diff, 0);
+
+    c_kzg_free(cells);
+    c_kzg_free(check_cells);
+    c_kzg_free(proofs);
+    c_kzg_free(check_proofs);
+    free_trusted_setup(&shared);
+    ret = set_precompute_budget(&s, 0);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+}
+
+static void test_attach_shared_settings__bad_file_fails(void) {
+    C_KZG_RET ret;
+    KZGSettings shared;
+    FILE *fp;
+    uint8_t zero = 0;
+
+    /* Corrupt the first byte of the magic */
+    fp = tmpfile();
+    ASSERT("the file was created", fp != NULL);
+    ret = save_precomputed_settings(&s, fp);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    fseek(fp, 0, SEEK_SET);
+    fwrite(&zero, 1, 1, fp);
+    fflush(fp);
+    ret = attach_shared_settings(&shared, fp);
+    ASSERT_EQUALS(ret, C_KZG_BADARGS);
+    fclose(fp);
+
+    /* A file which is too short to have a header */
+    fp = tmpfile();
+    ASSERT("the file was created", fp != NULL);
+    fwrite(&zero, 1, 1, fp);
+    fflush(fp);
+    ret = attach_shared_settings(&shared, fp);
+    ASSERT_EQUALS(ret, C_KZG_BADARGS);
+    fclose(fp);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tests for load_precomputed_settings
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void test_load_precomputed_settings__checks_contents(void) {
+    C_KZG_RET ret;
+    KZGSettings loaded;
+    Bytes32 other_hash;
+    FILE *fp;
+    long end;
+    uint8_t last;
+    int diff;
+
+    fp = tmpfile();
+    ASSERT("the file was created", fp != NULL);
+    ret = save_precomputed_settings(&s, fp);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    /* The file loads for its own trusted setup */
+    ret = load_precomputed_settings(&loaded, fp, &s.setup_hash);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    diff = memcmp(&loaded.setup_hash, &s.setup_hash, sizeof(Bytes32));
+    ASSERT_EQUALS(diff, 0);
+    free_trusted_setup(&loaded);
+
+    /* But not for another one */
+    other_hash = s.setup_hash;
+    other_hash.bytes[0] ^= 1;
+    ret = load_precomputed_settings(&loaded, fp, &other_hash);
+    ASSERT_EQUALS(ret, C_KZG_BADARGS);
+
+    /* Flip a bit at the end of the file, the header is still fine */
+    fseek(fp, 0, SEEK_END);
+    end = ftell(fp);
+    fseek(fp, end - 1, SEEK_SET);
+    last = (uint8_t)fgetc(fp);
+    last ^= 1;
+    fseek(fp, end - 1, SEEK_SET);
+    fwrite(&last, 1, 1, fp);
+    fflush(fp);
+    ret = attach_shared_settings(&loaded, fp);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    free_trusted_setup(&loaded);
+    ret = load_precomputed_settings(&loaded, fp, NULL);
+    ASSERT_EQUALS(ret, C_KZG_BADARGS);
+
+    fclose(fp);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tests for save_trusted_setup_binary
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void test_save_trusted_setup_binary__loads_the_same(void) {
+    C_KZG_RET ret;
+    KZGSettings loaded;
+    FILE *fp;
+    int diff;
+
+    fp = tmpfile();
+    ASSERT("the file was created", fp != NULL);
+    ret = save_trusted_setup_binary(&s, fp);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    rewind(fp);
+    ret = load_trusted_setup_file(&loaded, fp, 0);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    fclose(fp);
+
+    /* The points are the same, so is the hash of the trusted setup */
+    diff = memcmp(&loaded.setup_hash, &s.setup_hash, sizeof(Bytes32));
+    ASSERT_EQUALS(diff, 0);
+    diff = memcmp(
+        loaded.g1_values_lagrange_brp, s.g1_values_lagrange_brp, NUM_G1_POINTS * sizeof(g1_t)
+    );
+    ASSERT_EQUALS(diff, 0);
+    diff = memcmp(loaded.g1_values_monomial, s.g1_values_monomial, NUM_G1_POINTS * sizeof(g1_t));
+    ASSERT_EQUALS(diff, 0);
+    diff = memcmp(loaded.g2_values_monomial, s.g2_values_monomial, NUM_G2_POINTS * sizeof(g2_t));
+    ASSERT_EQUALS(diff, 0);
+
+    free_trusted_setup(&loaded);
+}
+
+static void test_load_trusted_setup_file__bad_text_fails(void) {
+    C_KZG_RET ret;
+    KZGSettings loaded;
+    FILE *fp;
+
+    /* A byte with a single hex digit */
+    fp = tmpfile();
+    ASSERT("the file was created", fp != NULL);
+    fputs("4096 65\na 00\n", fp);
+    rewind(fp);
+    ret = load_trusted_setup_file(&loaded, fp, 0);
+    ASSERT_EQUALS(ret, C_KZG_BADARGS);
+    fclose(fp);
+
+    /* Too few points */
+    fp = tmpfile();
+    ASSERT("the file was created", fp != NULL);
+    fputs("4096 65\n0a0b0c\n", fp);
+    rewind(fp);
+    ret = load_trusted_setup_file(&loaded, fp, 0);
+    ASSERT_EQUALS(ret, C_KZG_BADARGS);
+    fclose(fp);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tests for load_trusted_setup_uncompressed
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void test_load_trusted_setup_uncompressed__loads_the_same(void) {
+    C_KZG_RET ret;
+    KZGSettings loaded;
+    uint8_t *bytes = NULL;
+    Bytes32 hash, wrong_hash;
+    int diff;
+
+    ret = serialize_trusted_setup_uncompressed(&bytes, &hash, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    /* With the right hash, without a hash, and with a wrong one which means checking every point */
+    memcpy(&wrong_hash, &hash, sizeof(Bytes32));
+    wrong_hash.bytes[0] ^= 1;
+    const Bytes32 *hashes[] = {&hash, NULL, &wrong_hash};
+    for (size_t i = 0; i < 3; i++) {
+        ret = load_trusted_setup_uncompressed(
+            &loaded, bytes, TRUSTED_SETUP_UNCOMPRESSED_SIZE, hashes[i], 0
+        );
+        ASSERT_EQUALS(ret, C_KZG_OK);
+
+        diff = memcmp(&loaded.setup_hash, &s.setup_hash, sizeof(Bytes32));
+        ASSERT_EQUALS(diff, 0);
+        diff = memcmp(
+            loaded.g1_values_lagrange_brp, s.g1_values_lagrange_brp, NUM_G1_POINTS * sizeof(g1_t)
+        );
+        ASSERT_EQUALS(diff, 0);
+        diff = memcmp(
+            loaded.g1_values_monomial, s.g1_values_monomial, NUM_G1_POINTS * sizeof(g1_t)
+        );
+        ASSERT_EQUALS(diff, 0);
+        diff = memcmp(
+            loaded.g2_values_monomial, s.g2_values_monomial, NUM_G2_POINTS * sizeof(g2_t)
+        );
+        ASSERT_EQUALS(diff, 0);
+
+        free_trusted_setup(&loaded);
+    }
+
+    c_kzg_free(bytes);
+}
+
+static void test_load_trusted_setup_uncompressed__bad_point_fails(void) {
+    C_KZG_RET ret;
+    KZGSettings loaded;
+    uint8_t *bytes = NULL;
+    Bytes32 hash;
+    FILE *fp;
+
+    ret = serialize_trusted_setup_uncompressed(&bytes, &hash, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    /* Move the last g1 point off the curve, which the hash no longer vouches for */
+    bytes[TRUSTED_SETUP_UNCOMPRESSED_SIZE - 1] ^= 1;
+    ret = load_trusted_setup_uncompressed(
+        &loaded, bytes, TRUSTED_SETUP_UNCOMPRESSED_SIZE, &hash, 0
+    );
+    ASSERT_EQUALS(ret, C_KZG_BADARGS);
+
+    /* From a file, every point is checked */
+    fp = tmpfile();
+    ASSERT("the file was created", fp != NULL);
+    fwrite(bytes, 1, TRUSTED_SETUP_UNCOMPRESSED_SIZE, fp);
+    rewind(fp);
+    ret = load_trusted_setup_file(&loaded, fp, 0);
+    ASSERT_EQUALS(ret, C_KZG_BADARGS);
+    fclose(fp);
+
+    c_kzg_free(bytes);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tests for the roots of unity tables
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void test_roots_of_unity__tables_match_computed(void) {
+    C_KZG_RET ret;
+    fr_t *roots = NULL;
+    int diff;
+
+    ret = new_fr_array(&roots, FIELD_ELEMENTS_PER_EXT_BLOB + 1);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    ret = expand_root_of_unity(roots, &ROOT_OF_UNITY, FIELD_ELEMENTS_PER_EXT_BLOB);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    diff = memcmp(roots, ROOTS_OF_UNITY, (FIELD_ELEMENTS_PER_EXT_BLOB + 1) * sizeof(fr_t));
+    ASSERT_EQUALS(diff, 0);
+
+    for (size_t i = 0; i <= FIELD_ELEMENTS_PER_EXT_BLOB; i++) {
+        bool ok = fr_equal(&REVERSE_ROOTS_OF_UNITY[i], &roots[FIELD_ELEMENTS_PER_EXT_BLOB - i]);
+        ASSERT_EQUALS(ok, true);
+    }
+
+    ret = bit_reversal_permutation(roots, sizeof(fr_t), FIELD_ELEMENTS_PER_EXT_BLOB);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    diff = memcmp(roots, BRP_ROOTS_OF_UNITY, FIELD_ELEMENTS_PER_EXT_BLOB * sizeof(fr_t));
+    ASSERT_EQUALS(diff, 0);
+
+    c_kzg_free(roots);
+}
+
+static void test_roots_of_unity__settings_point_to_tables(void) {
+    ASSERT("the roots are shared", s.roots_of_unity == ROOTS_OF_UNITY);
+    ASSERT("the roots are shared", s.brp_roots_of_unity == BRP_ROOTS_OF_UNITY);
+    ASSERT("the roots are shared", s.reverse_roots_of_unity == REVERSE_ROOTS_OF_UNITY);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tests for set_precompute
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void test_set_precompute__upgrades_and_drops_tables(void) {
+    C_KZG_RET ret;
+    Blob blob;
+    KZGProof proofs[CELLS_PER_EXT_BLOB], check_proofs[CELLS_PER_EXT_BLOB];
+    uint64_t epoch = s.table_epochs->epoch;
+    int diff;
+
+    get_rand_blob(&blob);
+    ret = compute_cells_and_kzg_proofs(NULL, check_proofs, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    ret = set_precompute(&s, 4);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT("there are tables", s.tables != NULL);
+    ASSERT_EQUALS(s.wbits, 4);
+    ASSERT_EQUALS(s.table_epochs->epoch, epoch + 1);
+
+    ret = compute_cells_and_kzg_proofs(NULL, proofs, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    diff = memcmp(proofs, check_proofs, sizeof(proofs));
+    ASSERT_EQUALS(diff, 0);
+
+    /* The same value changes nothing */
+    ret = set_precompute(&s, 4);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT_EQUALS(s.table_epochs->epoch, epoch + 1);
+
+    /* Every call has stopped reading the tables */
+    ASSERT_EQUALS(s.table_epochs->readers[0], 0);
+    ASSERT_EQUALS(s.table_epochs->readers[1], 0);
+    ASSERT_EQUALS(s.table_epochs->writer, 0);
+
+    ret = set_precompute(&s, 0);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT("there are no tables", s.tables == NULL);
+    ASSERT_EQUALS(s.wbits, 0);
+    ASSERT_EQUALS(s.table_epochs->epoch, epoch + 2);
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+
+/** What a thread which computes proofs while the tables are swapped checks its results against. */
+typedef struct {
+    const Blob *blob;
+    const KZGProof *check_proofs;
+    /** Set to non-NULL once the tables are no longer swapped. */
+    void *done;
+    uint64_t rounds;
+    uint64_t failures;
+} TableSwapReader;
+
+static void *compute_proofs_while_swapping(void *arg) {
+    TableSwapReader *reader = arg;
+    KZGProof proofs[CELLS_PER_EXT_BLOB];
+    C_KZG_RET ret;
+
+    /* Keep going until the swaps are over, and at least once */
+    do {
+        ret = compute_cells_and_kzg_proofs(NULL, proofs, reader->blob, &s);
+        if (ret != C_KZG_OK ||
+            memcmp(proofs, reader->check_proofs, CELLS_PER_EXT_BLOB * sizeof(KZGProof)) != 0) {
+            reader->failures++;
+        }
+        reader->rounds++;
+    } while (atomic_load_ptr(&reader->done) == NULL);
+    return NULL;
+}
+
+static void test_set_precompute__swaps_while_computing(void) {
+    C_KZG_RET ret;
+    Blob blob;
+    KZGProof check_proofs[CELLS_PER_EXT_BLOB];
+    TableSwapReader readers[2];
+    pthread_t threads[2];
+    int err;
+
+    get_rand_blob(&blob);
+    ret = compute_cells_and_kzg_proofs(NULL, check_proofs, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    for (size_t i = 0; i < 2; i++) {
+        readers[i].blob = &blob;
+        readers[i].check_proofs = check_proofs;
+        readers[i].done = NULL;
+        readers[i].rounds = 0;
+        readers[i].failures = 0;
+        err = pthread_create(&threads[i], NULL, compute_proofs_while_swapping, &readers[i]);
+        ASSERT_EQUALS(err, 0);
+    }
+
+    /* Compute and drop the tables while the other threads use them */
+    for (size_t i = 0; i < 2; i++) {
+        ret = set_precompute(&s, 8);
+        ASSERT_EQUALS(ret, C_KZG_OK);
+        ret = set_precompute(&s, 0);
+        ASSERT_EQUALS(ret, C_KZG_OK);
+    }
+
+    for (size_t i = 0; i < 2; i++) {
+        atomic_store_ptr(&readers[i].done, &readers[i]);
+        err = pthread_join(threads[i], NULL);
+        ASSERT_EQUALS(err, 0);
+        ASSERT("every proof matched", readers[i].failures == 0);
+        ASSERT("the thread computed proofs", readers[i].rounds > 0);
+    }
+
+    /* Every call has stopped reading the tables */
+    ASSERT("there are no tables", s.tables == NULL);
+    ASSERT_EQUALS(s.table_epochs->readers[0], 0);
+    ASSERT_EQUALS(s.table_epochs->readers[1], 0);
+}
+
+#endif
+
+static void test_set_precompute__fails_too_large(void) {
+    C_KZG_RET ret;
+
+    ret = set_precompute(&s, 16);
+    ASSERT_EQUALS(ret, C_KZG_BADARGS);
+    ASSERT("there are no tables", s.tables == NULL);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tests for KZGPolynomial
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void test_kzg_polynomial__same_results(void) {
+    C_KZG_RET ret;
+    KZGPolynomial *poly = NULL;
+    Blob blob;
+    Bytes32 z, y, check_y;
+    Cell cells[CELLS_PER_EXT_BLOB], check_cells[CELLS_PER_EXT_BLOB];
+    KZGProof proof, check_proof;
+    KZGProof proofs[CELLS_PER_EXT_BLOB], check_proofs[CELLS_PER_EXT_BLOB];
+    KZGCommitment commitment, check_commitment;
+    int diff;
+
+    get_rand_blob(&blob);
+    get_rand_field_element(&z);
+    ret = new_kzg_polynomial(&poly, &blob);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    ret = blob_to_kzg_commitment(&check_commitment, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = blob_to_kzg_commitment_poly(&commitment, poly, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    diff = memcmp(&commitment, &check_commitment, sizeof(KZGCommitment));
+    ASSERT_EQUALS(diff, 0);
+
+    ret = compute_kzg_proof(&check_proof, &check_y, &blob, &z, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = compute_kzg_proof_poly(&proof, &y, poly, &z, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    diff = memcmp(&proof, &check_proof, sizeof(KZGProof));
+    ASSERT_EQUALS(diff, 0);
+    diff = memcmp(&y, &check_y, sizeof(Bytes32));
+    ASSERT_EQUALS(diff, 0);
+
+    ret = compute_blob_kzg_proof(&check_proof, &blob, &commitment, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = compute_blob_kzg_proof_poly(&proof, poly, &commitment, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    diff = memcmp(&proof, &check_proof, sizeof(KZGProof));
+    ASSERT_EQUALS(diff, 0);
+
+    ret = compute_cells_and_kzg_proofs(check_cells, check_proofs, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    /* The second call uses the monomial form kept by the first */
+    for (int i = 0; i < 2; i++) {
+        ret = compute_cells_and_kzg_proofs_poly(cells, proofs, poly, &s);
+        ASSERT_EQUALS(ret, C_KZG_OK);
+        diff = memcmp(cells, check_cells, sizeof(cells));
+        ASSERT_EQUALS(diff, 0);
+        diff = memcmp(proofs, check_proofs, sizeof(proofs));
+        ASSERT_EQUALS(diff, 0);
+    }
+
+    free_kzg_polynomial(&poly);
+    ASSERT("polynomial is null after free", poly == NULL);
+
+    /* Freeing it again does nothing */
+    free_kzg_polynomial(&poly);
+}
+
+static void test_kzg_polynomial__invalid_blob_fails(void) {
+    C_KZG_RET ret;
+    KZGPolynomial *poly = NULL;
+    Blob blob;
+
+    get_rand_blob(&blob);
+    /* The first field element is larger than the modulus */
+    memset(blob.bytes, 0xff, BYTES_PER_FIELD_ELEMENT);
+
+    ret = new_kzg_polynomial(&poly, &blob);
+    ASSERT_EQUALS(ret, C_KZG_BADARGS);
+    ASSERT_EQUALS(poly == NULL, true);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tests for compute_blob_sidecar
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void test_compute_blob_sidecar__same_results(void) {
+    C_KZG_RET ret;
+    Blob blob;
+    Cell cells[CELLS_PER_EXT_BLOB], check_cells[CELLS_PER_EXT_BLOB];
+    KZGProof proof, check_proof;
+    KZGProof proofs[CELLS_PER_EXT_BLOB], check_proofs[CELLS_PER_EXT_BLOB];
+    KZGCommitment commitment, check_commitment;
+    KZGSettings v;
+    uint64_t profiles[2] = {KZG_PROFILE_VERIFY, KZG_PROFILE_VERIFY_AND_COMMIT};
+    bool ok;
+    int diff;
+
+    get_rand_blob(&blob);
+    ret = blob_to_kzg_commitment(&check_commitment, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = compute_blob_kzg_proof(&check_proof, &blob, &check_commitment, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = compute_cells_and_kzg_proofs(check_cells, check_proofs, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    /* The full setup, then each verification profile, which loads the rest of the setup */
+    for (size_t i = 0; i <= 2; i++) {
+        const KZGSettings *settings = &s;
+        if (i > 0) {
+            ret = load_profile_settings(&v, profiles[i - 1]);
+            ASSERT_EQUALS(ret, C_KZG_OK);
+            settings = &v;
+        }
+
+        ret = compute_blob_sidecar(&commitment, &proof, cells, proofs, &blob, settings);
+        ASSERT_EQUALS(ret, C_KZG_OK);
+        diff = memcmp(&commitment, &check_commitment, sizeof(KZGCommitment));
+        ASSERT_EQUALS(diff, 0);
+        diff = memcmp(&proof, &check_proof, sizeof(KZGProof));
+        ASSERT_EQUALS(diff, 0);
+        diff = memcmp(cells, check_cells, sizeof(cells));
+        ASSERT_EQUALS(diff, 0);
+        diff = memcmp(proofs, check_proofs, sizeof(proofs));
+        ASSERT_EQUALS(diff, 0);
+
+        ret = verify_blob_kzg_proof(&ok, &blob, &commitment, &proof, settings);
+        ASSERT_EQUALS(ret, C_KZG_OK);
+        ASSERT("the blob proof is valid", ok);
+
+        if (i > 0) free_trusted_setup(&v);
+    }
+}
+
+static void test_compute_blob_sidecar__invalid_blob_fails(void) {
+    C_KZG_RET ret;
+    Blob blob;
+    Cell cells[CELLS_PER_EXT_BLOB];
+    KZGProof proof, proofs[CELLS_PER_EXT_BLOB];
+    KZGCommitment commitment;
+
+    get_rand_blob(&blob);
+    memset(blob.bytes, 0xff, BYTES_PER_FIELD_ELEMENT);
+
+    ret = compute_blob_sidecar(&commitment, &proof, cells, proofs, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_BADARGS);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tests for compute_kzg_proofs_multi
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void test_compute_kzg_proofs_multi__same_results(void) {
+    C_KZG_RET ret;
+    Blob blob;
+    /* More than one group, with two of the points inside the domain */
+    Bytes32 zs[POINTS_PER_PROOF_GROUP + 3], ys[POINTS_PER_PROOF_GROUP + 3], check_y;
+    KZGProof proofs[POINTS_PER_PROOF_GROUP + 3], check_proof;
+    size_t n = POINTS_PER_PROOF_GROUP + 3;
+    int diff;
+
+    get_rand_blob(&blob);
+    for (size_t i = 0; i < n; i++) {
+        get_rand_field_element(&zs[i]);
+    }
+    bytes_from_bls_field(&zs[1], &s.brp_roots_of_unity[0]);
+    bytes_from_bls_field(&zs[POINTS_PER_PROOF_GROUP + 1], &s.brp_roots_of_unity[123]);
+
+    ret = compute_kzg_proofs_multi(proofs, ys, &blob, zs, n, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    for (size_t i = 0; i < n; i++) {
+        ret = compute_kzg_proof(&check_proof, &check_y, &blob, &zs[i], &s);
+        ASSERT_EQUALS(ret, C_KZG_OK);
+        diff = memcmp(&proofs[i], &check_proof, sizeof(KZGProof));
+        ASSERT_EQUALS(diff, 0);
+        diff = memcmp(&ys[i], &check_y, sizeof(Bytes32));
+        ASSERT_EQUALS(diff, 0);
+    }
+}
+
+static void test_compute_kzg_proofs_multi__invalid_point_fails(void) {
+    C_KZG_RET ret;
+    Blob blob;
+    Bytes32 zs[2], ys[2];
+    KZGProof proofs[2];
+
+    get_rand_blob(&blob);
+    get_rand_field_element(&zs[0]);
+    /* This is larger than the modulus */
+    memset(&zs[1], 0xff, sizeof(Bytes32));
+
+    ret = compute_kzg_proofs_multi(proofs, ys, &blob, zs, 2, &s);
+    ASSERT_EQUALS(ret, C_KZG_BADARGS);
+    ret = compute_kzg_proofs_multi(proofs, ys, &blob, zs, 0, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tests for update_kzg_commitment
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void test_update_kzg_commitment__same_as_recommitting(void) {
+    C_KZG_RET ret;
+    Blob blob;
+    KZGCommitment commitment, updated, check_commitment;
+    uint64_t indices[] = {0, 17, 4095, 17};
+    Bytes32 old_fields[4], new_fields[4];
+    int diff;
+
+    get_rand_blob(&blob);
+    ret = blob_to_kzg_commitment(&commitment, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    /* Index 17 changes twice, one change after the other */
+    for (size_t i = 0; i < 4; i++) {
+        Bytes32 *field = (Bytes32 *)&blob.bytes[indices[i] * BYTES_PER_FIELD_ELEMENT];
+        old_fields[i] = *field;
+        get_rand_field_element(&new_fields[i]);
+        *field = new_fields[i];
+    }
+
+    ret = blob_to_kzg_commitment(&check_commitment, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = update_kzg_commitment(&updated, &commitment, indices, old_fields, new_fields, 4, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    diff = memcmp(&updated, &check_commitment, sizeof(KZGCommitment));
+    ASSERT_EQUALS(diff, 0);
+
+    /* No changes gives the same commitment */
+    ret = update_kzg_commitment(&updated, &commitment, indices, old_fields, new_fields, 0, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    diff = memcmp(&updated, &commitment, sizeof(KZGCommitment));
+    ASSERT_EQUALS(diff, 0);
+}
+
+static void test_update_kzg_commitment__index_out_of_range_fails(void) {
+    C_KZG_RET ret;
+    Blob blob;
+    KZGCommitment commitment, updated;
+    uint64_t index = FIELD_ELEMENTS_PER_BLOB;
+    Bytes32 old_field, new_field;
+
+    get_rand_blob(&blob);
+    ret = blob_to_kzg_commitment(&commitment, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    get_rand_field_element(&old_field);
+    get_rand_field_element(&new_field);
+
+    ret = update_kzg_commitment(&updated, &commitment, &index, &old_field, &new_field, 1, &s);
+    ASSERT_EQUALS(ret, C_KZG_BADARGS);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tests for compute_cells_for_indices
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void test_compute_cells_for_indices__same_cells(void) {
+    C_KZG_RET ret;
+    Blob blob;
+    Cell cells[CELLS_PER_EXT_BLOB], check_cells[CELLS_PER_EXT_BLOB];
+    uint64_t indices[CELLS_PER_EXT_BLOB];
+    int diff;
+
+    get_rand_blob(&blob);
+    ret = compute_cells_and_kzg_proofs(check_cells, NULL, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    /* In reverse, so that the order of the output follows the order of the indices */
+    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+        indices[i] = CELLS_PER_EXT_BLOB - 1 - i;
+    }
+
+    /* A few cells, one coset at a time, then all of them with the full FFT */
+    uint64_t counts[] = {1, MAX_CELLS_FOR_COSET_FFT, CELLS_PER_EXT_BLOB};
+    for (size_t c = 0; c < 3; c++) {
+        ret = compute_cells_for_indices(cells, &blob, indices, counts[c], &s);
+        ASSERT_EQUALS(ret, C_KZG_OK);
+        for (size_t i = 0; i < counts[c]; i++) {
+            diff = memcmp(&cells[i], &check_cells[indices[i]], sizeof(Cell));
+            ASSERT_EQUALS(diff, 0);
+        }
+    }
+}
+
+static void test_compute_cells_for_indices__index_out_of_range_fails(void) {
+    C_KZG_RET ret;
+    Blob blob;
+    Cell cells[2];
+    uint64_t indices[] = {0, CELLS_PER_EXT_BLOB};
+
+    get_rand_blob(&blob);
+    ret = compute_cells_for_indices(cells, &blob, indices, 2, &s);
+    ASSERT_EQUALS(ret, C_KZG_BADARGS);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tests for compute_cell_kzg_proofs_for_indices
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void test_compute_cell_kzg_proofs_for_indices__same_proofs(void) {
+    C_KZG_RET ret;
+    Blob blob;
+    KZGProof proofs[CELLS_PER_EXT_BLOB], check_proofs[CELLS_PER_EXT_BLOB];
+    uint64_t indices[MAX_CELLS_FOR_DIRECT_PROOFS + 1];
+    int diff;
+
+    /* Out of order and spread over the cells */
+    for (size_t i = 0; i <= MAX_CELLS_FOR_DIRECT_PROOFS; i++) {
+        indices[i] = (i * 37 + 5) % CELLS_PER_EXT_BLOB;
+    }
+
+    get_rand_blob(&blob);
+    ret = compute_cells_and_kzg_proofs(NULL, check_proofs, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    /* Directly, then with FK20 */
+    uint64_t counts[] = {1, MAX_CELLS_FOR_DIRECT_PROOFS, MAX_CELLS_FOR_DIRECT_PROOFS + 1};
+    for (size_t c = 0; c < 3; c++) {
+        ret = compute_cell_kzg_proofs_for_indices(proofs, &blob, indices, counts[c], &s);
+        ASSERT_EQUALS(ret, C_KZG_OK);
+        for (size_t i = 0; i < counts[c]; i++) {
+            diff = memcmp(&proofs[i], &check_proofs[indices[i]], sizeof(KZGProof));
+            ASSERT_EQUALS(diff, 0);
+        }
+    }
+}
+
+static void test_compute_cell_kzg_proofs_for_indices__index_out_of_range_fails(void) {
+    C_KZG_RET ret;
+    Blob blob;
+    KZGProof proofs[2];
+    uint64_t indices[] = {0, CELLS_PER_EXT_BLOB};
+
+    get_rand_blob(&blob);
+    ret = compute_cell_kzg_proofs_for_indices(proofs, &blob, indices, 2, &s);
+    ASSERT_EQUALS(ret, C_KZG_BADARGS);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tests for verify_cell_kzg_proof_batch_unique
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void test_verify_cell_kzg_proof_batch_unique__same_as_batch(void) {
+    C_KZG_RET ret;
+    bool ok, check_ok;
+    Blob blobs[2];
+    KZGCommitment unique[2];
+    Bytes48 commitments[2 * CELLS_PER_EXT_BLOB];
+    uint64_t commitment_indices[2 * CELLS_PER_EXT_BLOB], cell_indices[2 * CELLS_PER_EXT_BLOB];
+    Cell cells[2 * CELLS_PER_EXT_BLOB];
+    KZGProof proofs[2 * CELLS_PER_EXT_BLOB];
+
+    for (size_t b = 0; b < 2; b++) {
+        get_rand_blob(&blobs[b]);
+        ret = blob_to_kzg_commitment(&unique[b], &blobs[b], &s);
+        ASSERT_EQUALS(ret, C_KZG_OK);
+        ret = compute_cells_and_kzg_proofs(
+            &cells[b * CELLS_PER_EXT_BLOB], &proofs[b * CELLS_PER_EXT_BLOB], &blobs[b], &s
+        );
+        ASSERT_EQUALS(ret, C_KZG_OK);
+        for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+            commitments[b * CELLS_PER_EXT_BLOB + i] = unique[b];
+            commitment_indices[b * CELLS_PER_EXT_BLOB + i] = b;
+            cell_indices[b * CELLS_PER_EXT_BLOB + i] = i;
+        }
+    }
+
+    ret = verify_cell_kzg_proof_batch_unique(
+        &ok,
+        unique,
+        2,
+        commitment_indices,
+        cell_indices,
+        cells,
+        proofs,
+        2 * CELLS_PER_EXT_BLOB,
+        &s
+    );
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT_EQUALS(ok, true);
+
+    /* A wrong cell fails both ways */
+    cells[CELLS_PER_EXT_BLOB + 3].bytes[31] ^= 1;
+    ret = verify_cell_kzg_proof_batch_unique(
+        &ok,
+        unique,
+        2,
+        commitment_indices,
+        cell_indices,
+        cells,
+        proofs,
+        2 * CELLS_PER_EXT_BLOB,
+        &s
+    );
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = verify_cell_kzg_proof_batch(
+        &check_ok, commitments, cell_indices, cells, proofs, 2 * CELLS_PER_EXT_BLOB, &s
+    );
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT_EQUALS(ok, false);
+    ASSERT_EQUALS(check_ok, false);
+}
+
+static void test_verify_cell_kzg_proof_batch_unique__bad_commitment_index_fails(void) {
+    C_KZG_RET ret;
+    bool ok;
+    Bytes48 commitment;
+    uint64_t commitment_index = 1, cell_index = 0;
+    Cell cell;
+    KZGProof proof;
+
+    get_rand_g1_bytes(&commitment);
+    get_rand_g1_bytes(&proof);
+    memset(&cell, 0, sizeof(Cell));
+
+    ret = verify_cell_kzg_proof_batch_unique(
+        &ok, &commitment, 1, &commitment_index, &cell_index, &cell, &proof, 1, &s
+    );
+    ASSERT_EQUALS(ret, C_KZG_BADARGS);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tests for the batch _locate variants
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void test_verify_blob_kzg_proof_batch_locate__finds_invalid(void) {
+    C_KZG_RET ret;
+    bool ok;
+    const size_t n = 5;
+    Blob blobs[5];
+    KZGCommitment commitments[5];
+    KZGProof proofs[5], proof;
+    uint64_t invalid[5], num_invalid;
+
+    for (size_t i = 0; i < n; i++) {
+        get_rand_blob(&blobs[i]);
+        ret = blob_to_kzg_commitment(&commitments[i], &blobs[i], &s);
+        ASSERT_EQUALS(ret, C_KZG_OK);
+        ret = compute_blob_kzg_proof(&proofs[i], &blobs[i], &commitments[i], &s);
+        ASSERT_EQUALS(ret, C_KZG_OK);
+    }
+
+    /* A valid batch has no invalid proofs */
+    ret = verify_blob_kzg_proof_batch_locate(
+        &ok, invalid, &num_invalid, blobs, commitments, proofs, n, &s
+    );
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT_EQUALS(ok, true);
+    ASSERT_EQUALS(num_invalid, 0);
+
+    /* Swapping two proofs makes both invalid */
+    proof = proofs[1];
+    proofs[1] = proofs[3];
+    proofs[3] = proof;
+    ret = verify_blob_kzg_proof_batch_locate(
+        &ok, invalid, &num_invalid, blobs, commitments, proofs, n, &s
+    );
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT_EQUALS(ok, false);
+    ASSERT_EQUALS(num_invalid, 2);
+    ASSERT_EQUALS(invalid[0], 1);
+    ASSERT_EQUALS(invalid[1], 3);
+
+    /* A single blob is checked on its own */
+    ret = verify_blob_kzg_proof_batch_locate(
+        &ok, invalid, &num_invalid, &blobs[3], &commitments[3], &proofs[3], 1, &s
+    );
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT_EQUALS(ok, false);
+    ASSERT_EQUALS(num_invalid, 1);
+    ASSERT_EQUALS(invalid[0], 0);
+}
+
+static void test_verify_cell_kzg_proof_batch_locate__finds_invalid(void) {
+    C_KZG_RET ret;
+    bool ok;
+    Blob blob;
+    Bytes48 commitments[CELLS_PER_EXT_BLOB];
+    uint64_t cell_indices[CELLS_PER_EXT_BLOB];
+    Cell cells[CELLS_PER_EXT_BLOB];
+    KZGProof proofs[CELLS_PER_EXT_BLOB];
+    uint64_t invalid[CELLS_PER_EXT_BLOB], num_invalid;
+
+    get_rand_blob(&blob);
+    ret = blob_to_kzg_commitment(&commitments[0], &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = compute_cells_and_kzg_proofs(cells, proofs, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    for (size_t i = 0; i < CELLS_PER_EXT_BLOB; i++) {
+        commitments[i] = commitments[0];
+        cell_indices[i] = i;
+    }
+
+    /* A valid batch has no invalid proofs */
+    ret = verify_cell_kzg_proof_batch_locate(
+        &ok, invalid, &num_invalid, commitments, cell_indices, cells, proofs, CELLS_PER_EXT_BLOB, &s
+    );
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT_EQUALS(ok, true);
+    ASSERT_EQUALS(num_invalid, 0);
+
+    /* Break two cells */
+    cells[5].bytes[31] ^= 1;
+    cells[100].bytes[31] ^= 1;
+    ret = verify_cell_kzg_proof_batch_locate(
+        &ok, invalid, &num_invalid, commitments, cell_indices, cells, proofs, CELLS_PER_EXT_BLOB, &s
+    );
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT_EQUALS(ok, false);
+    ASSERT_EQUALS(num_invalid, 2);
+    ASSERT_EQUALS(invalid[0], 5);
+    ASSERT_EQUALS(invalid[1], 100);
+}
+
+static void test_verify_cell_kzg_proof_batch_locate__shared_columns(void) {
+    C_KZG_RET ret;
+    bool ok;
+    Blob blobs[2];
+    Bytes48 blob_commitments[2];
+    Cell blob_cells[2 * CELLS_PER_EXT_BLOB];
+    KZGProof blob_proofs[2 * CELLS_PER_EXT_BLOB];
+    Bytes48 commitments[16];
+    uint64_t cell_indices[16];
+    Cell cells[16];
+    KZGProof proofs[16];
+    uint64_t invalid[16], num_invalid;
+
+    for (size_t b = 0; b < 2; b++) {
+        get_rand_blob(&blobs[b]);
+        ret = blob_to_kzg_commitment(&blob_commitments[b], &blobs[b], &s);
+        ASSERT_EQUALS(ret, C_KZG_OK);
+        ret = compute_cells_and_kzg_proofs(
+            &blob_cells[b * CELLS_PER_EXT_BLOB], &blob_proofs[b * CELLS_PER_EXT_BLOB], &blobs[b], &s
+        );
+        ASSERT_EQUALS(ret, C_KZG_OK);
+    }
+
+    /* The same eight columns of both blobs, so that the cells of a range share columns */
+    for (size_t i = 0; i < 16; i++) {
+        size_t b = i % 2, column = (i / 2) * 11;
+        commitments[i] = blob_commitments[b];
+        cell_indices[i] = column;
+        cells[i] = blob_cells[b * CELLS_PER_EXT_BLOB + column];
+        proofs[i] = blob_proofs[b * CELLS_PER_EXT_BLOB + column];
+    }
+
+    /* Break a cell, and give another cell the proof of its neighbour in the same column */
+    cells[3].bytes[31] ^= 1;
+    proofs[10] = proofs[11];
+    ret = verify_cell_kzg_proof_batch_locate(
+        &ok, invalid, &num_invalid, commitments, cell_indices, cells, proofs, 16, &s
+    );
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT_EQUALS(ok, false);
+    ASSERT_EQUALS(num_invalid, 2);
+    ASSERT_EQUALS(invalid[0], 3);
+    ASSERT_EQUALS(invalid[1], 10);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tests for CellProofAccumulator
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void test_cell_proof_accumulator__columns_one_by_one(void) {
+    C_KZG_RET ret;
+    bool ok;
+    const size_t num_blobs = 2, num_columns = 4;
+    Blob blobs[2];
+    Bytes48 commitments[2];
+    Cell cells[2 * CELLS_PER_EXT_BLOB];
+    KZGProof proofs[2 * CELLS_PER_EXT_BLOB];
+    Bytes48 column_commitments[2];
+    uint64_t column_indices[2];
+    Cell column_cells[2];
+    KZGProof column_proofs[2];
+    CellProofAccumulator *acc = NULL;
+
+    for (size_t b = 0; b < num_blobs; b++) {
+        get_rand_blob(&blobs[b]);
+        ret = blob_to_kzg_commitment(&commitments[b], &blobs[b], &s);
+        ASSERT_EQUALS(ret, C_KZG_OK);
+        ret = compute_cells_and_kzg_proofs(
+            &cells[b * CELLS_PER_EXT_BLOB], &proofs[b * CELLS_PER_EXT_BLOB], &blobs[b], &s
+        );
+        ASSERT_EQUALS(ret, C_KZG_OK);
+    }
+
+    ret = new_cell_proof_accumulator(&acc, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    /* Nothing added yet */
+    ret = finalize_cell_proof_accumulator(&ok, acc);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT_EQUALS(ok, true);
+
+    /* Add the columns one at a time, like sidecars, reusing the arrays */
+    for (size_t c = 0; c < num_columns; c++) {
+        uint64_t column = c * 29;
+        for (size_t b = 0; b < num_blobs; b++) {
+            column_commitments[b] = commitments[b];
+            column_indices[b] = column;
+            column_cells[b] = cells[b * CELLS_PER_EXT_BLOB + column];
+            column_proofs[b] = proofs[b * CELLS_PER_EXT_BLOB + column];
+        }
+        ret = add_to_cell_proof_accumulator(
+            acc, column_commitments, column_indices, column_cells, column_proofs, num_blobs
+        );
+        ASSERT_EQUALS(ret, C_KZG_OK);
+    }
+
+    ret = finalize_cell_proof_accumulator(&ok, acc);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT_EQUALS(ok, true);
+
+    /* A late column with a wrong cell fails the whole check */
+    column_cells[1].bytes[31] ^= 1;
+    ret = add_to_cell_proof_accumulator(
+        acc, column_commitments, column_indices, column_cells, column_proofs, num_blobs
+    );
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = finalize_cell_proof_accumulator(&ok, acc);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT_EQUALS(ok, false);
+
+    free_cell_proof_accumulator(&acc);
+}
+
+static void test_cell_proof_accumulator__bad_proof_leaves_it_unchanged(void) {
+    C_KZG_RET ret;
+    bool ok;
+    Blob blob;
+    Bytes48 commitment, bad_proof;
+    uint64_t cell_index = 7;
+    Cell cells[CELLS_PER_EXT_BLOB];
+    KZGProof proofs[CELLS_PER_EXT_BLOB];
+    CellProofAccumulator *acc = NULL;
+
+    get_rand_blob(&blob);
+    ret = blob_to_kzg_commitment(&commitment, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = compute_cells_and_kzg_proofs(cells, proofs, &blob, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    ret = new_cell_proof_accumulator(&acc, &s);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ret = add_to_cell_proof_accumulator(
+        acc, &commitment, &cell_index, &cells[cell_index], &proofs[cell_index], 1
+    );
+    ASSERT_EQUALS(ret, C_KZG_OK);
+
+    /* A proof which is not a point is rejected and not added */
+    memset(&bad_proof, 0xff, sizeof(bad_proof));
+    ret = add_to_cell_proof_accumulator(
+        acc, &commitment, &cell_index, &cells[cell_index], &bad_proof, 1
+    );
+    ASSERT_EQUALS(ret, C_KZG_BADARGS);
+
+    ret = finalize_cell_proof_accumulator(&ok, acc);
+    ASSERT_EQUALS(ret, C_KZG_OK);
+    ASSERT_EQUALS(ok, true);
+
+    free_cell_proof_accumulator(&acc);
+    ASSERT("accumulator is null after free", acc == NULL);
+
+    /* Freeing it again does nothing */
+    free_cell_proof_accumulator(&acc);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Profiling Functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef PROFILE
+static void profile_blob_to_kzg_commitment(void) {
+    Blob blob;
+    KZGCommitment c;
+
+    get_rand_blob(&blob);
+
+    ProfilerStart("blob_to_kzg_commitment.prof");
+    for (size_t i = 0; i < 1000; i++) {
+        blob_to_kzg_commitment(&c, &blob, &s);
+    }
+    ProfilerStop();
+}
+
+static void profile_compute_kzg_proof(void) {
+    Blob blob;
+    Bytes32 z, y_out;
+    KZGProof proof_out;
+
+    get_rand_blob(&blob);
+    get_rand_field_element(&z);
+
+    ProfilerStart("compute_kzg_proof.prof");
+    for (size_t i = 0; i < 100; i++) {
+        compute_kzg_proof(&proof_out, &y_out, &blob, &z, &s);
+    }
+    ProfilerStop();
+}
+
+static void profile_compute_blob_kzg_proof(void) {
+    Blob blob;
+    Bytes48 commitment;
+    KZGProof out;
+
+    get_rand_blob(&blob);
+    get_rand_g1_bytes(&commitment);
+
+    ProfilerStart("compute_blob_kzg_proof.prof");
+    for (size_t i = 0; i < 10; i++) {
+        compute_blob_kzg_proof(&out, &blob, &commitment, &s);
+    }
+    ProfilerStop();
+}
+
+static void profile_verify_kzg_proof(void) {
+    Bytes32 z, y;
+    Bytes48 commitment, proof;
+    bool out;
+
+    get_rand_g1_bytes(&commitment);
+    get_rand_field_element(&z);
+    get_rand_field_element(&y);
+    get_rand_g1_bytes(&proof);
+
+    ProfilerStart("verify_kzg_proof.prof");
+    for (size_t i = 0; i < 5000; i++) {
+        verify_kzg_proof(&out, &commitment, &z, &y, &proof, &s);
+    }
+    ProfilerStop();
+}
+
+static void profile_verify_blob_kzg_proof(void) {
+    Blob blob;
+    Bytes48 commitment, proof;
+    bool out;
+
+    get_rand_blob(&blob);
+    get_rand_g1_bytes(&commitment);
+    get_rand_g1_bytes(&proof);
+
+    ProfilerStart("verify_blob_kzg_proof.prof");
+    for (size_t i = 0; i < 5000; i++) {
+        verify_blob_kzg_proof(&out, &blob, &commitment, &proof, &s);
+    }
+    ProfilerStop();
+}
+
+static void profile_verify_blob_kzg_proof_batch(void) {
+    const int n = 4;
+    Blob blobs[n];
+    Bytes48 commitments[n];
+    Bytes48 proofs[n];
+    bool out;
+
+    for (size_t i = 0; i < n; i++) {
+        get_rand_blob(&blobs[i]);
+        get_rand_g1_bytes(&commitments[i]);
+        get_rand_g1_bytes(&proofs[i]);
+    }
+
+    ProfilerStart("verify_blob_kzg_proof_batch.prof");
+    for (size_t i = 0; i < 1000; i++) {
+        verify_blob_kzg_proof_batch(&out, blobs, commitments, proofs, n, &s);
+    }
+    ProfilerStop();
+}
+
+static void profile_compute_cells_and_kzg_proofs(void) {
+    Blob blob;
+    Cell cells[CELLS_PER_EXT_BLOB];
+    KZGProof proofs[CELLS_PER_EXT_BLOB];
+
+    /* Get a random blob */
+    get_rand_blob(&blob);
+
+    ProfilerStart("compute_cells_and_kzg_proofs.prof");
+    for (size_t i = 0; i < 5; i++) {
+        compute_cells_and_kzg_proofs(cells, proofs, &blob, &s);
+    }
+    ProfilerStop();
+}
+
+static void profile_compute_blob_sidecar(void) {
+    Blob blob;
+    KZGCommitment commitment;
+    KZGProof proof;
+    Cell cells[CELLS_PER_EXT_BLOB];
+    KZGProof proofs[CELLS_PER_EXT_BLOB];
+
+    /* Get a random blob */
+    get_rand_blob(&blob);
+
+    ProfilerStart("compute_blob_sidecar.prof");
+    for (size_t i = 0; i < 5; i++) {
+        compute_blob_sidecar(&commitment, &proof, cells, proofs, &blob, &s);
+    }
+    ProfilerStop();
+}
+
+static void profile_recover_cells_and_kzg_proofs(void) {
+    Blob blob;
+    uint64_t cell_indices[CELLS_PER_EXT_BLOB];
+    Cell cells[CELLS_PER_EXT_BLOB];
+
+    /*
+     * NOTE: this profiling function only cares about cell recovery since the proofs will always be
+     * recomputed. If we included proof computation, it would drown out cell recovery.
+     */
+
+    /* Get a random blob */
+    get_rand_blob(&blob);
+
+    /* Compute cells */
+    compute_cells_and_kzg_proofs(cells, NULL, &blob, &s);
+
+    /* Initialize cell indices */
+    for (size_t i = 0; i < CELLS_PER_EXT_BLOB / 2; i++) {
+        cell_indices[i] = i;
+    }
+
+    ProfilerStart("recover_cells_and_kzg_proofs.prof");
+    for (size_t i = 0; i < 5; i++) {
+        recover_cells_and_kzg_proofs(cells, NULL, cell_indices, cells, CELLS_PER_EXT_BLOB / 2, &s);
+    }
+    ProfilerStop();
+}
+
+static void profile_verify_cell_kzg_proof_batch(void) {
+    C_KZG_RET ret;
+    bool ok;
+    Blob blob;
+    KZGCommitment commitment;
+    KZGCommitment commitments[CELLS_PER_EXT_BLOB];
+    uint64_t cell_indices[CELLS_PER_EXT_BLOB];
     Cell cells[CELLS_PER_EXT_BLOB];
     KZGProof proofs[CELLS_PER_EXT_BLOB];
 
@@ -2329,6 +4393,9 @@ int main(void) {
     RUN(test_bit_reversal_permutation__n_is_one);
     RUN(test_compute_powers__succeeds_expected_powers);
     RUN(test_g1_lincomb__verify_consistent);
+    RUN(test_g1_lincomb__sparse_scalars);
+    RUN(test_g1_lincomb__short_scalars);
+    RUN(test_g1_lincomb_fast_multi__verify_consistent);
     RUN(test_evaluate_polynomial_in_evaluation_form__constant_polynomial);
     RUN(test_evaluate_polynomial_in_evaluation_form__constant_polynomial_in_range);
     RUN(test_evaluate_polynomial_in_evaluation_form__random_polynomial);
@@ -2365,12 +4432,90 @@ int main(void) {
     RUN(test_deduplicate_commitments__all_duplicates);
     RUN(test_deduplicate_commitments__no_commitments);
     RUN(test_deduplicate_commitments__one_commitment);
+    RUN(test_deduplicate_commitments__many_commitments);
     RUN(test_recover_cells_and_kzg_proofs__succeeds_random_blob);
     RUN(test_shift_factors__succeeds);
     RUN(test_compute_vanishing_polynomial_from_roots);
     RUN(test_vanishing_polynomial_for_missing_cells);
     RUN(test_verify_cell_kzg_proof_batch__succeeds_random_blob);
 
+    RUN(test_autotune_msm_strategy__succeeds);
+    RUN(test_autotune_msm_strategy__fails_wbits_too_big);
+    RUN(test_set_msm_strategy__same_results);
+    RUN(test_set_msm_strategy__fails_bad_strategy);
+
+    RUN(test_set_precompute_budget__same_results);
+
+    RUN(test_compute_cells_and_kzg_proofs_batch__same_results);
+    RUN(test_compute_cells_and_kzg_proofs_batch__no_blobs);
+
+    RUN(test_kzg_context__same_results);
+    RUN(test_kzg_context__other_variants);
+    RUN(test_kzg_context__fails_nested);
+
+    RUN(test_set_kzg_allocator__used_for_everything);
+
+    RUN(test_set_table_placement__same_results);
+    RUN(test_set_table_placement__fails_unknown_flag);
+
+    RUN(test_settings_slab__arrays_are_aligned_and_adjacent);
+
+    RUN(test_load_trusted_setup_file_profile__verify_only);
+    RUN(test_load_trusted_setup_file_profile__loads_outside_context);
+#if defined(__unix__) || defined(__APPLE__)
+    RUN(test_load_trusted_setup_file_profile__first_calls_race);
+#endif
+    RUN(test_load_trusted_setup_file_profile__verify_and_commit);
+    RUN(test_load_trusted_setup_file_profile__bad_profile_fails);
+
+    RUN(test_attach_shared_settings__same_results);
+    RUN(test_attach_shared_settings__bad_file_fails);
+
+    RUN(test_load_precomputed_settings__checks_contents);
+
+    RUN(test_save_trusted_setup_binary__loads_the_same);
+    RUN(test_load_trusted_setup_file__bad_text_fails);
+
+    RUN(test_load_trusted_setup_uncompressed__loads_the_same);
+    RUN(test_load_trusted_setup_uncompressed__bad_point_fails);
+
+    RUN(test_roots_of_unity__tables_match_computed);
+    RUN(test_roots_of_unity__settings_point_to_tables);
+
+    RUN(test_set_precompute__upgrades_and_drops_tables);
+#if defined(__unix__) || defined(__APPLE__)
+    RUN(test_set_precompute__swaps_while_computing);
+#endif
+    RUN(test_set_precompute__fails_too_large);
+
+    RUN(test_kzg_polynomial__same_results);
+    RUN(test_kzg_polynomial__invalid_blob_fails);
+
+    RUN(test_compute_blob_sidecar__same_results);
+    RUN(test_compute_blob_sidecar__invalid_blob_fails);
+
+    RUN(test_compute_kzg_proofs_multi__same_results);
+    RUN(test_compute_kzg_proofs_multi__invalid_point_fails);
+
+    RUN(test_update_kzg_commitment__same_as_recommitting);
+    RUN(test_update_kzg_commitment__index_out_of_range_fails);
+
+    RUN(test_compute_cells_for_indices__same_cells);
+    RUN(test_compute_cells_for_indices__index_out_of_range_fails);
+
+    RUN(test_compute_cell_kzg_proofs_for_indices__same_proofs);
+    RUN(test_compute_cell_kzg_proofs_for_indices__index_out_of_range_fails);
+
+    RUN(test_verify_cell_kzg_proof_batch_unique__same_as_batch);
+    RUN(test_verify_cell_kzg_proof_batch_unique__bad_commitment_index_fails);
+
+    RUN(test_verify_blob_kzg_proof_batch_locate__finds_invalid);
+    RUN(test_verify_cell_kzg_proof_batch_locate__finds_invalid);
+    RUN(test_verify_cell_kzg_proof_batch_locate__shared_columns);
+
+    RUN(test_cell_proof_accumulator__columns_one_by_one);
+    RUN(test_cell_proof_accumulator__bad_proof_leaves_it_unchanged);
+
     /*
      * These functions are only executed if we're profiling. To me, it makes sense to put these in
      * the testing file so we can re-use the helper functions. Additionally, it checks that whatever
@@ -2384,6 +4529,7 @@ int main(void) {
     profile_verify_blob_kzg_proof();
     profile_verify_blob_kzg_proof_batch();
     profile_compute_cells_and_kzg_proofs();
+    profile_compute_blob_sidecar();
     profile_recover_cells_and_kzg_proofs();
     profile_verify_cell_kzg_proof_batch();
 #endif